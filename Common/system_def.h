@@ -46,13 +46,22 @@ typedef unsigned char       uint8,  uchar;
 typedef signed short        int16;
 typedef unsigned short      uint16, ushort;
 
+#ifdef HOST_SIM_BUILD   // Host PC (LP64) build:  'long' is 64 bits, 'int' is 32 bits
+typedef signed int          int32;
+typedef unsigned int        uint32;    // ulong is defined by <sys/types.h>
+#else
 typedef signed long         int32;
 typedef unsigned long       uint32, ulong;
+#endif
 
 typedef signed long long    int64;
 typedef unsigned long long  uint64;
 
+#ifdef HOST_SIM_BUILD
+typedef signed int          fixed_t;   // 32-bit fixed point
+#else
 typedef signed long         fixed_t;   // 32-bit fixed point
+#endif
 
 #ifndef bool
 typedef unsigned char       bool;
@@ -95,10 +104,10 @@ typedef void (* pfnvoid)(void);     // pointer to void function
 // Integer part:    18 bits, signed, max. range +/-128K
 // Fractional part: 14 bits, precision: +/-0.00005 (approx.)
 //
-#define IntToFixedPt(i)     (i << 14)                    // convert int to fixed-pt
+#define IntToFixedPt(i)     ((i) * 16384)                // convert int to fixed-pt
 #define FloatToFixed(r)     (fixed_t)(r * 16384)         // convert float (r) to fixed-pt
 #define FixedToFloat(z)     ((float)z / 16384)           // convert fixed-pt (z) to float
-#define IntegerPart(z)      (z >> 14)                    // get integer part of fixed-pt
+#define IntegerPart(z)      ((z) >> 14)                  // get integer part of fixed-pt
 #define FractionPart(z,n)   ((z & 0x3FFF) >> (14 - n))   // get n MS bits of fractional part
 #define MultiplyFixed(v,w)  ((v * w) >> 14)              // product of two fixed-pt numbers^
 #define LongMultiplyFixed(v,w)  (((int64)v * w) >> 14)   // product of two numbers > 4.0
@@ -111,10 +120,10 @@ typedef void (* pfnvoid)(void);     // pointer to void function
 // Integer part:    12 bits, signed, max. range +/-2047
 // Fractional part: 20 bits, precision: +/-0.000001 (approx.)
 //
-#define IntToFixedPt(i)     (i << 20)                    // convert int to fixed-pt
+#define IntToFixedPt(i)     ((i) * 1048576)              // convert int to fixed-pt
 #define FloatToFixed(r)     (fixed_t)(r * 1048576)       // convert float (r) to fixed-pt
 #define FixedToFloat(z)     ((float)z / 1048576)         // convert fixed-pt (z) to float
-#define IntegerPart(z)      (z >> 20)                    // get integer part of fixed-pt
+#define IntegerPart(z)      ((z) >> 20)                  // get integer part of fixed-pt
 #define FractionPart(z,n)   ((z & 0xFFFFF) >> (20 - n))  // get n MS bits of fractional part
 #define MultiplyFixed(v,w)  (((int64)v * w) >> 20)       // product of two fixed-pt numbers
 //
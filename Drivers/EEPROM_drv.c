@@ -65,6 +65,43 @@ int EepromWriteData( uint8 *pData, uint8 promBlock, uint8 promAddr, int nbytes )
 }
 
 
+/**
+ * Function to write one or more bytes of data (up to 16 bytes) sequentially to the EEPROM
+ * and initiate a programming cycle. All data must be within the same EEPROM page.
+ * Unlike EepromWriteData(), the function does not wait for the programming cycle to
+ * complete;  the caller should poll EepromIsBusy() before the next EEPROM access.
+ *
+ * Entry arg's: pData = pointer to source data (byte array)
+ *              promBlock = EEPROM block select (0, 1, 2, 3, ...)
+ *              promAddr = EEPROM beginning address for write (0..255)
+ *              nbytes = number of bytes to write (max = 16, not checked!)
+ *
+ * Returns:  ERROR (-1) if I2C bus error detected, else 0.
+ */
+int EepromWriteStart( uint8 *pData, uint8 promBlock, uint8 promAddr, int nbytes )
+{
+    int errcode = 0;
+
+    EEPROM_WRITE_ENABLE();                  // Set WP Low
+    promBlock = (promBlock & 7) << 1;       // Block # is b1:3 of control byte
+
+    if (I2C1MasterStart(0xA0 | promBlock))  // Control byte ACK'd -- Send write command
+    {
+        I2C1MasterSend(promAddr);
+        while (nbytes != 0)
+        {
+            I2C1MasterSend(*pData++); 
+            --nbytes;
+        }
+        Stop_I2C1();  // Terminate cmd string and initiate write cycle
+    }
+    else errcode = -1;  // I2C bus error or device not responding
+
+    EEPROM_WRITE_INHIBIT();  // Set WP High (or float)
+    return errcode;
+}
+
+
 /**
  * Function to read one or more bytes of data (up to 256 bytes) sequentially from the EEPROM.
  * Does not check if there is a programming cycle in progress.
@@ -171,6 +208,43 @@ int EepromWriteData( uint8 *pData, uint8 promBlock, uint8 promAddr, int nbytes )
 }
 
 
+/**
+ * Function to write one or more bytes of data (up to 16 bytes) sequentially to the EEPROM
+ * and initiate a programming cycle. All data must be within the same EEPROM page.
+ * Unlike EepromWriteData(), the function does not wait for the programming cycle to
+ * complete;  the caller should poll EepromIsBusy() before the next EEPROM access.
+ *
+ * Entry arg's: pData = pointer to source data (byte array)
+ *              promBlock = EEPROM block select (0, 1, 2, 3, ...)
+ *              promAddr = EEPROM beginning address for write (0..255)
+ *              nbytes = number of bytes to write (max = 16, not checked!)
+ *
+ * Returns:  ERROR (-1) if I2C bus error detected, else 0.
+ */
+int EepromWriteStart( uint8 *pData, uint8 promBlock, uint8 promAddr, int nbytes )
+{
+    int errcode = 0;
+
+    EEPROM_WRITE_ENABLE();                  // Set WP Low
+    promBlock = (promBlock & 7) << 1;       // Block # is b1:3 of control byte
+
+    if (I2C2MasterStart(0xA0 | promBlock))  // Control byte ACK'd -- Send write command
+    {
+        I2C2MasterSend(promAddr);
+        while (nbytes != 0)
+        {
+            I2C2MasterSend(*pData++); 
+            --nbytes;
+        }
+        Stop_I2C2();  // Terminate cmd string and initiate write cycle
+    }
+    else errcode = -1;  // I2C bus error or device not responding
+
+    EEPROM_WRITE_INHIBIT();  // Set WP High (or float)
+    return errcode;
+}
+
+
 /**
  * Function to read one or more bytes of data (up to 256 bytes) sequentially from the EEPROM.
  * Does not check if there is a programming cycle in progress.
@@ -23,6 +23,7 @@
 #endif
 
 int   EepromWriteData( uint8 *pData, uint8 promBlock, uint8 promAddr, int nbytes );
+int   EepromWriteStart( uint8 *pData, uint8 promBlock, uint8 promAddr, int nbytes );
 int   EepromReadData( uint8 *pData, uint8 promBlock, uint8 promAddr, int nbytes );
 uint8 EepromIsBusy( void );
 
@@ -59,34 +59,8 @@
 
 #define LCD_CHIPSELECT_ACTIVE_LOW    // Comment out if CS is active high
 
-#define LCD_DATA_DIRN_IN()     (TRISE |= 0x00FF)
-#define LCD_DATA_DIRN_OUT()    (TRISE &= ~0x00FF)
-#define LCD_DATA_INPUT()       (PORTE & 0x00FF)
-#define LCD_DATA_OUTPUT(d)     (LATE = d & 0x00FF)
-
-// Control (CTRL) signals...
-#define LCD_E_HIGH()           (LATDbits.LATD5 = 1)
-#define LCD_E_LOW()            (LATDbits.LATD5 = 0)
-#define LCD_RS_HIGH()          (LATDbits.LATD6 = 1)
-#define LCD_RS_LOW()           (LATDbits.LATD6 = 0)
-#define LCD_RW_HIGH()          (LATDbits.LATD7 = 1)
-#define LCD_RW_LOW()           (LATDbits.LATD7 = 0)
-#define LCD_RST_HIGH()         (LATFbits.LATF1 = 1)
-#define LCD_RST_LOW()          (LATFbits.LATF1 = 0)
-#define LCD_BACKLIGHT_HIGH()   (LATDbits.LATD4 = 1)
-#define LCD_BACKLIGHT_LOW()    (LATDbits.LATD4 = 0)
-
-#ifdef LCD_CHIPSELECT_ACTIVE_LOW  
-#define LCD_CS1_OFF()          (LATDbits.LATD8 = 1)
-#define LCD_CS1_ON()           (LATDbits.LATD8 = 0)
-#define LCD_CS2_OFF()          (LATDbits.LATD11 = 1)
-#define LCD_CS2_ON()           (LATDbits.LATD11 = 0)
-#else  // LCD_CHIPSELECT_ACTIVE_HIGH
-#define LCD_CS1_OFF()          (LATDbits.LATD8 = 0)
-#define LCD_CS1_ON()           (LATDbits.LATD8 = 1)
-#define LCD_CS2_OFF()          (LATDbits.LATD11 = 0)
-#define LCD_CS2_ON()           (LATDbits.LATD11 = 1)
-#endif
+// LCD I/O pin assignments are defined in the LCD controller driver header
+// (e.g. LCD_KS0108_drv.h), which does not include this file.
 
 //========================== Select other custom hardware ===============================
 //
@@ -107,6 +81,20 @@
 
 #define UART1_RXBUFSIZE      256   // RX FIFO buffer size, chars
 #define UART2_RXBUFSIZE      256
+
+// UART1 (MIDI IN) data is passed to the MIDI IN parser by this handler (remi_synth_main.c)
+#define UART1_RX_READY_HANDLER  MidiInputReadyHandler
+
+// UART1 RX using DMA -- not used:  the time of arrival of a message is then known only to
+// within one RTI tick (1ms poll, no idle-line timeout), whereas the RX interrupt gives it
+// to within one byte time (MIDI note timing).  See UART_drv.h.
+//#define UART1_RX_USING_DMA  1
+
+#if defined (SYNTH_MK3_MX440_MAM) && defined (UART1_RX_USING_DMA)
+#if UART1_RX_USING_DMA
+#error "UART1 RX DMA (channel 1) conflicts with the MK3 SPI DAC (DMA channels 1..3)"
+#endif
+#endif
 //
 //====================================================================
 
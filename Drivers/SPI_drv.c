@@ -15,6 +15,7 @@
 \*****************************************************************************/
 
 #include "../Common/Compiler.h"
+#include <sys/kmem.h>       // For KVA_TO_PA() -- DMA addresses
 #include "SPI_drv.h"
 
 static int spiMutex[5] = { 0, 0, 0, 0, 0 };   // up to 4 channels
@@ -62,6 +63,131 @@ void  SPI_Init(char channel, char clk_mode, unsigned int brg_val)
 }
 
 
+/*^
+ * Function sets up an SPI channel as a 16-bit master, for DMA-fed transmission with
+ * chip-select framing on the SS pin (SS2 = RG9 on PIC32MX340/440).  See SPI_DMA_TxStart().
+ *
+ * The SPI "framed" mode is not used, because the PIC32MX3xx/4xx frame sync pulse is only
+ * one clock period wide, whereas devices such as the MCP4921 DAC need the chip-select to
+ * be held active for the whole 16-bit word.
+ *
+ * Entry arg(s):  channel  = SPI channel (2 only)
+ *                clk_mode = SPI clock mode (0..3)
+ *                brg_val  = BRG reg value to set SPI clock freq.
+ *
+ * Data received on SDI is not used;  the RX overflow flag is ignored.
+ * The channel is locked (see SPILock) so that other drivers will not attempt to use it.
+ */
+void  SPI_DMA_TxInit(char channel, char clk_mode, unsigned int brg_val)
+{
+    if (channel == 2) 
+    {
+        TRISGbits.TRISG9 = 0;    // SS2 pin is output (chip-select)
+        LATGbits.LATG9 = 1;      // .. initially high (inactive)
+        SPI2BRG = brg_val;
+        SPI2STAT = 0;
+        SPI2CON = 0;
+        SPI2CONbits.MSTEN = 1;
+        SPI2CONbits.MODE16 = 1;  // 16-bit words
+        SPI2CONbits.MODE32 = 0;
+        SPI2CONbits.CKP = (clk_mode & 2) >> 1;  // = bit1
+        SPI2CONbits.CKE = (clk_mode & 1) ^ 1;   // = !bit0
+        SPI2CONbits.SMP = 1;
+        SPI2CON |= (1 << 15);    // SPI2CONbits.ON = 1;
+        spiMutex[2] = 1;         // Channel is dedicated to DMA transmit
+    }
+}
+
+
+/*^
+ * Function starts DMA transmission of 16-bit words from a circular buffer in RAM to the
+ * SPI TX buffer, one word per trigger IRQ event.  Three DMA channels are set up, all
+ * triggered by the same event and serviced in order of channel priority:
+ *
+ *   DMA channel 3 (priority 3):  writes the SS pin mask to LATGSET -- chip-select high
+ *   DMA channel 2 (priority 2):  writes the SS pin mask to LATGCLR -- chip-select low
+ *   DMA channel 1 (priority 1):  copies the next word from srcBuf[] to SPI2BUF
+ *
+ * The word sent in one trigger period is framed (latched by the slave) at the start of
+ * the next, so the slave output is updated at exactly regular intervals, with a delay of
+ * one period.  The trigger period must exceed the SPI word transfer time.
+ * The channels auto-enable, so the buffer is transmitted repeatedly until stopped.
+ * The caller keeps the buffer contents up to date, typically in step with another DMA
+ * channel driven by the same trigger IRQ.
+ *
+ * Entry arg(s):  channel  = SPI channel (2 only), set up by SPI_DMA_TxInit()
+ *                srcBuf   = source buffer address (virtual)
+ *                nbytes   = size of source buffer in bytes (max. 256)
+ *                trigIRQ  = IRQ number of the transfer start event, e.g. _TIMER_2_IRQ
+ */
+void  SPI_DMA_TxStart(char channel, void *srcBuf, int nbytes, int trigIRQ)
+{
+    static  uint32  chipSelectMask = (1 << 9);   // RG9 = SS2
+
+    if (channel != 2)  return;
+
+    DMACONbits.ON = 1;                        // Enable the DMA controller
+
+    DCH3CON = 0;                              // Chip-select high (end of frame)
+    DCH3CONbits.CHPRI = 3;
+    DCH3CONbits.CHAEN = 1;                    // Auto-enable (repeat continuously)
+    DCH3ECON = 0;
+    DCH3ECONbits.CHSIRQ = trigIRQ;
+    DCH3ECONbits.SIRQEN = 1;
+    DCH3SSA = KVA_TO_PA(&chipSelectMask);
+    DCH3DSA = KVA_TO_PA(&LATGSET);
+    DCH3SSIZ = 4;
+    DCH3DSIZ = 4;
+    DCH3CSIZ = 4;
+    DCH3INTCLR = 0x00FF00FF;                  // Clear all flags; no IRQs
+
+    DCH2CON = 0;                              // Chip-select low (start of frame)
+    DCH2CONbits.CHPRI = 2;
+    DCH2CONbits.CHAEN = 1;
+    DCH2ECON = 0;
+    DCH2ECONbits.CHSIRQ = trigIRQ;
+    DCH2ECONbits.SIRQEN = 1;
+    DCH2SSA = KVA_TO_PA(&chipSelectMask);
+    DCH2DSA = KVA_TO_PA(&LATGCLR);
+    DCH2SSIZ = 4;
+    DCH2DSIZ = 4;
+    DCH2CSIZ = 4;
+    DCH2INTCLR = 0x00FF00FF;
+
+    DCH1CON = 0;                              // Data word to SPI TX buffer
+    DCH1CONbits.CHPRI = 1;
+    DCH1CONbits.CHAEN = 1;
+    DCH1ECON = 0;
+    DCH1ECONbits.CHSIRQ = trigIRQ;
+    DCH1ECONbits.SIRQEN = 1;
+    DCH1SSA = KVA_TO_PA(srcBuf);
+    DCH1DSA = KVA_TO_PA(&SPI2BUF);
+    DCH1SSIZ = nbytes & 0xFF;                 // bytes (0 => 256)
+    DCH1DSIZ = 2;                             // SPI2BUF (16 bits)
+    DCH1CSIZ = 2;                             // 1 word per cell transfer
+    DCH1INTCLR = 0x00FF00FF;
+
+    DCH3CONbits.CHEN = 1;                     // Enable DMA channels
+    DCH2CONbits.CHEN = 1;
+    DCH1CONbits.CHEN = 1;
+}
+
+
+/*^
+ * Function stops the SPI TX DMA channels and sets the chip-select high (inactive).
+ * The SPI channel remains locked.
+ */
+void  SPI_DMA_TxStop(char channel)
+{
+    if (channel != 2)  return;
+
+    DCH1CONbits.CHEN = 0;
+    DCH2CONbits.CHEN = 0;
+    DCH3CONbits.CHEN = 0;
+    LATGbits.LATG9 = 1;
+}
+
+
 // Function performs a complete data exchange, i.e. transmits a byte on MOSI
 // while receiving a byte on MISO. The return value is the received byte.
 //
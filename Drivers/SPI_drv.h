@@ -69,6 +69,17 @@ void  SPIUnLock(unsigned int channel);
 #define SPI_Lock(ch)     SPILock(ch)
 #define SPI_UnLock(ch)   SPIUnLock(ch)
 
+// DMA-fed, framed transmit mode (SPI channel 2 only)...
+// The SPI channel is set up as a 16-bit master.  On each trigger event (e.g. a timer
+// period), DMA channels 1..3 drive the SS pin high (end of previous frame), drive it low
+// (start of frame), then copy the next 16-bit word from a circular buffer into the SPI
+// TX buffer.  Hence the slave device chip-select is framed without CPU involvement.
+// DMA channel 0 is not used (reserved for the audio PWM DAC).
+//
+void  SPI_DMA_TxInit(char channel, char clk_mode, unsigned int brg_val);
+void  SPI_DMA_TxStart(char channel, void *srcBuf, int nbytes, int trigIRQ);
+void  SPI_DMA_TxStop(char channel);
+
 // Deprecated functions required for compatibility with Microchip Library...
 //
 void  SPIPut(unsigned int channel, unsigned char data);
@@ -8,15 +8,25 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <sys/kmem.h>       // For KVA_TO_PA() -- DMA addresses
+
 #include "UART_drv.h"
 
 
-#if UART1_RX_INTERRUPT_DRIVEN
+#if UART1_RX_USING_DMA || UART1_RX_INTERRUPT_DRIVEN
 static  uint8   U1RxBuffer[UART1_RXBUFSIZE];    // UART1 serial input RX FIFO buffer
-static  uint8  *U1RxHead;                       // Pointer to next available unread char
-static  uint8  *U1RxTail;                       // Pointer to next free place for writing
-static  short   U1RxCount;                      // Number of unread chars in RX buffer
+static  volatile  uint16  U1RxHead;             // Index of next available unread char
 static  short   U1ErrCount;                     // UART1 Error count
+static  volatile  bool  U1RxDataLost;           // RX error since last UART1_RxErrorCheck()
+#if UART1_RX_USING_DMA  // Index of next free place for writing, from DMA dest. pointer
+#define U1RxTail  (DCH1DPTR & (UART1_RXBUFSIZE - 1))
+static  volatile  uint32  U1RxDmaLaps;          // Number of DMA buffer wraps (writer laps)
+static  volatile  uint32  U1RxReadCount;        // Total chars read (consumed), modulo 2^32
+static  uint32  UART1_RxWriteCount(void);
+static  void    UART1_RxOverrunCheck(void);
+#else
+static  volatile  uint16  U1RxTail;             // Index of next free place for writing
+#endif
 #endif
 
 #if UART1_TX_USING_QUEUE 
@@ -64,20 +74,47 @@ void  UART1_init(uint16 baudrate)
 	U1TxCount = 0;
 #endif
 
-#if UART1_RX_INTERRUPT_DRIVEN
+#if UART1_RX_USING_DMA
+    // DMA channel 1 setup -- Source: U1RXREG;  Destination: U1RxBuffer[] (circular)
+    UART1_RX_IRQ_DISABLE();  // RX IRQ event triggers DMA, not the CPU
+    IPC6bits.U1IP = 4;       // Error IRQ priority (must match ISR declaration IPL4)
+    U1RxHead = 0;
+    U1RxDmaLaps = 0;
+    U1RxReadCount = 0;
+    DMACONbits.ON = 1;                        // Enable the DMA controller
+    DCH1CON = 0;
+    DCH1CONbits.CHPRI = 1;                    // Lower priority than audio (DCH0)
+    DCH1CONbits.CHAEN = 1;                    // Auto-enable (buffer wraps around)
+    DCH1ECON = 0;
+    DCH1ECONbits.CHSIRQ = _UART1_RX_IRQ;      // Cell transfer start on RX data event
+    DCH1ECONbits.SIRQEN = 1;
+    DCH1SSA = KVA_TO_PA(&U1RXREG);
+    DCH1DSA = KVA_TO_PA(U1RxBuffer);
+    DCH1SSIZ = 1;                             // U1RXREG (8 bits)
+    DCH1DSIZ = UART1_RXBUFSIZE & 0xFF;        // bytes (0 => 256)
+    DCH1CSIZ = 1;                             // 1 byte per cell transfer
+    DCH1INTCLR = 0x00FF00FF;                  // Clear all flags and enables
+    DCH1INTbits.CHDHIE = 1;                   // IRQ on destination half full
+    DCH1INTbits.CHDDIE = 1;                   // IRQ on destination done (wrap)
+
+    IFS1bits.DMA1IF = 0;
+    IPC9bits.DMA1IP = 5;     // Same priority as RTI, which calls UART1_RxTickService()
+    UART1_RX_DMA_IRQ_ENABLE();
+    DCH1CONbits.CHEN = 1;    // Enable DMA channel
+    UART1_ERR_IRQ_ENABLE();
+
+#elif UART1_RX_INTERRUPT_DRIVEN
     UART1_RX_IRQ_DISABLE();
-    IPC6bits.U1IP = 3;       // IRQ priority
-    U1RxHead = U1RxBuffer;
-	U1RxTail = U1RxBuffer;
-	U1RxCount = 0;
+    IPC6bits.U1IP = 4;       // IRQ priority (must match ISR declaration IPL4)
+    U1RxHead = 0;
+	U1RxTail = 0;
     UART1_RX_IRQ_ENABLE();
     UART1_ERR_IRQ_ENABLE();
 #endif
 }
 
 
-#if UART1_RX_INTERRUPT_DRIVEN
-
+#if UART1_RX_USING_DMA || UART1_RX_INTERRUPT_DRIVEN
 /*
 *   UART#_RxDataAvail() - Checks receive buffer for data available.
 *
@@ -85,7 +122,7 @@ void  UART1_init(uint16 baudrate)
 */
 uint8  UART1_RxDataAvail(void)
 {
-    return (U1RxCount > 0);
+    return (U1RxHead != U1RxTail);
 }
 
 /*
@@ -95,6 +132,12 @@ uint8  UART1_RxDataAvail(void)
 */
 void  UART1_RxFlush(void)
 {
+#if UART1_RX_USING_DMA
+    UART1_RX_DMA_IRQ_DISABLE();
+    U1RxReadCount = UART1_RxWriteCount();
+    U1RxHead = U1RxTail;      // DMA empties the UART periph Rx FIFO
+    UART1_RX_DMA_IRQ_ENABLE();
+#else
     UART1_RX_IRQ_DISABLE();
 
     while (U1STAbits.URXDA)  // Clear UART periph Rx FIFO
@@ -102,11 +145,10 @@ void  UART1_RxFlush(void)
         dummy = U1RXREG;
     }
 
-    U1RxHead = U1RxBuffer;    // Clear RAM Rx FIFO buffer
-	U1RxTail = U1RxBuffer;
-	U1RxCount = 0;
+    U1RxHead = U1RxTail;      // Clear RAM Rx FIFO buffer
 
     UART1_RX_IRQ_ENABLE();
+#endif
 }
 
 /*
@@ -123,20 +165,57 @@ uint8  UART1_getch( void )
 {
     uint8  b = 0;
 
-    if (U1RxCount > 0)
+    if (U1RxHead != U1RxTail)
     {
-        UART1_RX_IRQ_DISABLE();  // hold off IRQ while accessing buffer
+        b = U1RxBuffer[U1RxHead];
+        U1RxHead = (U1RxHead + 1) & (UART1_RXBUFSIZE - 1);
+#if UART1_RX_USING_DMA
+        U1RxReadCount++;
+#endif
+    }
 
-        b = *U1RxHead++;
+    return  b;
+}
 
-        if ( U1RxHead >= (U1RxBuffer + UART1_RXBUFSIZE) )  // wrap
-			U1RxHead = U1RxBuffer;
-        U1RxCount--;
+/*
+*   UART#_RxPeekSpan() - Gets unread data in the UART RX input buffer, in place (no copy).
+*
+*   Entry arg:  ppData = address of pointer to be set to the first unread char
+*
+*   Returns:    Number of unread chars at *ppData, contiguous in the buffer (0 if none).
+*               If the unread data wraps around the end of the buffer, only the chars up
+*               to the end are included;  the rest are returned by the next call, after
+*               UART1_RxConsume().
+*/
+int  UART1_RxPeekSpan(const uint8 **ppData)
+{
+    uint16  head = U1RxHead;
+    uint16  tail = U1RxTail;
 
-        UART1_RX_IRQ_ENABLE();
-    }
+    *ppData = &U1RxBuffer[head];
 
-    return  b;
+    if (tail >= head)  return  (tail - head);
+    return  (UART1_RXBUFSIZE - head);  // span ends at end of buffer
+}
+
+/*
+*   UART#_RxUnreadCount() - Gets the number of unread chars in the UART RX input buffer,
+*   including any beyond the span returned by RxPeekSpan (buffer wrap).
+*/
+int  UART1_RxUnreadCount(void)
+{
+    return  (U1RxTail - U1RxHead) & (UART1_RXBUFSIZE - 1);
+}
+
+/*
+*   UART#_RxConsume() - Releases chars read in place (count <= value from RxPeekSpan).
+*/
+void  UART1_RxConsume(int count)
+{
+    U1RxHead = (U1RxHead + count) & (UART1_RXBUFSIZE - 1);
+#if UART1_RX_USING_DMA
+    U1RxReadCount += count;
+#endif
 }
 
 
@@ -149,35 +228,166 @@ int  UART1_getErrorCount(void)
     return  errcount;
 }
 
+/*
+*   UART#_RxErrorCheck() - Checks for loss of RX data, i.e. a receive error (overrun,
+*   framing error) or a byte discarded (RX buffer full), since the previous call.
+*   The RX data-ready handler can use this to resynchronize a message parser.
+*
+*   Returns:    TRUE if any RX data has been lost since the previous call, else FALSE.
+*/
+bool  UART1_RxErrorCheck(void)
+{
+    bool  lost = U1RxDataLost;
+
+    U1RxDataLost = FALSE;
 
+    return  lost;
+}
+
+#endif
+
+#if UART1_RX_USING_DMA
+/*
+*   UART1_RxTickService() - Signals data received to the RX data-ready handler, if any
+*   bytes are unread.
+*
+*   Called periodically (1ms RTI), so that bytes which do not reach the DMA buffer half
+*   full threshold are passed to the application within one tick of arrival.  Every byte
+*   unread at a call was received since the previous call (or DMA ISR), so the handler may
+*   date each byte from its position relative to the DMA write index.
+*   Must not be preempted by the DMA ISR (same IRQ priority), nor vice versa.
+*/
+void  UART1_RxTickService(void)
+{
+    UART1_RxOverrunCheck();
+
+#ifdef UART1_RX_READY_HANDLER
+    if (U1RxTail != U1RxHead)  UART1_RX_READY_HANDLER();
+#endif
+}
+
+
+/*
+*   UART1_RxWriteCount() - Gets the total number of chars written into the RX buffer by
+*   DMA (modulo 2^32), from the buffer wrap count and the DMA destination pointer.
+*   A wrap which has not yet been counted by the DMA ISR (IRQ pending) is allowed for.
+*   Must not be preempted by the DMA ISR.
+*/
+static  uint32  UART1_RxWriteCount(void)
+{
+    uint32  laps = U1RxDmaLaps;
+    uint32  tail = U1RxTail;
+
+    if (DCH1INTbits.CHDDIF && tail < (UART1_RXBUFSIZE / 2))  laps++;
+
+    return  (laps * UART1_RXBUFSIZE) + tail;
+}
+
+
+/*
+*   UART1_RxOverrunCheck() - Detects an RX buffer overrun, i.e. the DMA write index has
+*   lapped the read index, so unread chars have been overwritten.  The unread data is then
+*   unreliable, so it is discarded.  The overrun is counted as an error and signalled to
+*   the application (see UART1_RxErrorCheck), which should resynchronize its parser.
+*   Called by UART1_RxTickService() and the DMA ISR, ahead of the data-ready handler.
+*/
+static  void  UART1_RxOverrunCheck(void)
+{
+    uint32  written = UART1_RxWriteCount();
+
+    if ((written - U1RxReadCount) >= UART1_RXBUFSIZE)  // incl. buffer exactly full
+    {
+        U1ErrCount++;
+        U1RxDataLost = TRUE;
+        U1RxReadCount = written;
+        U1RxHead = written & (UART1_RXBUFSIZE - 1);
+    }
+}
+
+
+/*
+*   UART1 RX DMA Interrupt Service Routine
+*
+*   Raised when the RX buffer is half full or full (i.e. on every 128 bytes received),
+*   so that a continuous burst is passed to the application in blocks.
+*/
+void  __ISR(_DMA_1_VECTOR, IPL5AUTO)  UART1_RX_DMA_IRQ_Handler(void)
+{
+    uint32  flags = DCH1INT & 0x000000FF;
+
+    if (flags & _DCH1INT_CHDDIF_MASK)  U1RxDmaLaps++;  // Buffer wrapped
+    DCH1INTCLR = flags;        // Clear the channel IRQ flags seen (counted)
+    IFS1bits.DMA1IF = 0;
+
+    UART1_RxOverrunCheck();
+
+#ifdef UART1_RX_READY_HANDLER
+    UART1_RX_READY_HANDLER();
+#endif
+}
+
+
+/*
+*   UART1 Interrupt Service Routine -- RX errors only (received bytes are read by DMA)
+*/
+void  __ISR(_UART_1_VECTOR, IPL4AUTO)  UART1_IRQ_Handler(void)
+{
+    UART1_ERR_IRQ_CLEAR();
+
+    U1ErrCount++;
+    U1RxDataLost = TRUE;     // signalled to the handler with the next data (RTI or DMA ISR)
+        
+    if (U1STAbits.OERR)  U1STAbits.OERR = 0;  // Overrun stops RX until cleared
+}
+
+#elif UART1_RX_INTERRUPT_DRIVEN
 /*
 *   UART1 Interrupt Service Routine
 *
 *   Received bytes are placed into the RX FIFO buffer in data memory.
+*   If the buffer is full, bytes are discarded (counted as errors).
 *
 */
 void  __ISR(_UART_1_VECTOR, IPL4AUTO)  UART1_IRQ_Handler(void)
 {
     if (UART1_RX_IRQ_FLAG())
     {
+        uint16  tail;
+        uint8   b;
+
         UART1_RX_IRQ_CLEAR();
 
-        while (U1STAbits.URXDA && U1RxCount < UART1_RXBUFSIZE)
+        while (U1STAbits.URXDA)
         {
-            *U1RxTail++ = (uint8) U1RXREG;
-
-            if ( U1RxTail >= (U1RxBuffer + UART1_RXBUFSIZE) )  // wrap
-                U1RxTail = U1RxBuffer;
-            U1RxCount++;
+            b = (uint8) U1RXREG;
+            tail = (U1RxTail + 1) & (UART1_RXBUFSIZE - 1);
+
+            if (tail != U1RxHead)  // buffer not full
+            {
+                U1RxBuffer[U1RxTail] = b;
+                U1RxTail = tail;
+            }
+            else  
+            {
+                U1ErrCount++;
+                U1RxDataLost = TRUE;
+            }
         }
+#ifdef UART1_RX_READY_HANDLER
+        UART1_RX_READY_HANDLER();
+#endif
     }
     else  // if (UART1_ERR_IRQ_FLAG())  
     {
         UART1_ERR_IRQ_CLEAR();
     
         U1ErrCount++;
+        U1RxDataLost = TRUE;
         
-        // todo: Clear the *source* of the error ???
+        if (U1STAbits.OERR)  U1STAbits.OERR = 0;  // Overrun stops RX until cleared
+#ifdef UART1_RX_READY_HANDLER
+        UART1_RX_READY_HANDLER();   // Signal the error (see UART1_RxErrorCheck)
+#endif
     }
 }
 
@@ -270,6 +480,14 @@ void  UART1_putstr( char *pstr )
     }
 }
 
+/*
+|  UART#_TxQueueCount() - Returns the number of bytes in the Tx queue, not yet sent.
+*/
+int  UART1_TxQueueCount(void)
+{
+    return  U1TxCount;
+}
+
 /*
 |  UART# Tx Queue Handler...
 |  Routine called by the application to transmit a byte stored in the output queue.
@@ -8,19 +8,35 @@
 
 #include <sys/attribs.h>    // For interrupt handlers
 #include "../Common/system_def.h"
+#include "HardwareProfile.h"        // UART driver build options (platform/application)
 
 //================  UART DRIVER BUILD OPTIONS  ========================
 //
-#ifdef BUILD_REMI_SYNTH2_APP  // Application-specific config. 
-#define UART1_RX_INTERRUPT_DRIVEN  1
-#define UART2_RX_INTERRUPT_DRIVEN  1
-#define UART1_TX_USING_QUEUE  1
-#define UART2_TX_USING_QUEUE  0
-#endif
-
-// If any of these symbols are not already defined above,
+// The options are set in HardwareProfile.h.  In addition to those listed below...
+//
+// UART1_RX_USING_DMA (optional):
+// If 1, bytes received on UART1 are written into the circular RX buffer by DMA channel 1,
+// without a CPU interrupt per byte.  The application must call UART1_RxTickService()
+// periodically (e.g. 1ms RTI) to signal data received;  there is no idle-line timeout.
+// If the DMA write index laps the read index (RX buffer overrun), the unread data is
+// discarded and counted as an error (see UART1_RxErrorCheck).
+//
+// UART1_RX_READY_HANDLER (optional):
+// If defined, the named application function, of type void (void), is called when data
+// received on UART1 is ready to be read:
+//   DMA mode:  by the DMA ISR when the RX buffer is half full, or by UART1_RxTickService()
+//              if any bytes are unread;
+//   IRQ mode:  by the UART1 RX ISR, after the bytes in the hardware FIFO are buffered,
+//              and after a receive error.
+// The handler reads the data in place, using UART1_RxPeekSpan() and UART1_RxConsume().
+//
+// If any of these symbols are not already defined in HardwareProfile.h,
 // the following default settings will be applied...
 //
+#ifndef UART1_RX_USING_DMA
+#define UART1_RX_USING_DMA  0          // if 0, use RX interrupt or polled RX input
+#endif
+
 #ifndef UART1_RX_INTERRUPT_DRIVEN
 #define UART1_RX_INTERRUPT_DRIVEN  0   // if 0, use polled RX input
 #endif
@@ -46,7 +62,18 @@
 #endif
 
 #ifndef UART1_RXBUFSIZE
-#define UART1_RXBUFSIZE      256   // RX FIFO buffer size, chars
+#define UART1_RXBUFSIZE      256   // RX FIFO buffer size, chars (power of 2)
+#endif
+
+#if UART1_RX_USING_DMA && (UART1_RXBUFSIZE != 256)
+#error "UART1_RXBUFSIZE must be 256 for RX DMA (max. DMA destination size)"
+#endif
+
+#ifdef UART1_RX_READY_HANDLER
+#if !UART1_RX_USING_DMA && !UART1_RX_INTERRUPT_DRIVEN
+#error "UART1_RX_READY_HANDLER requires UART1_RX_INTERRUPT_DRIVEN or UART1_RX_USING_DMA"
+#endif
+void    UART1_RX_READY_HANDLER(void);
 #endif
 
 #ifndef UART2_RXBUFSIZE
@@ -65,6 +92,9 @@
 #define UART1_ERR_IRQ_CLEAR()    IFS0bits.U1EIF = 0  
 #define UART1_ERR_IRQ_FLAG()     (IFS0bits.U1EIF)
 
+#define UART1_RX_DMA_IRQ_DISABLE()  IEC1bits.DMA1IE = 0
+#define UART1_RX_DMA_IRQ_ENABLE()   IEC1bits.DMA1IE = 1
+
 #define UART2_RX_IRQ_DISABLE()   IEC1bits.U2RXIE = 0
 #define UART2_RX_IRQ_ENABLE()    IEC1bits.U2RXIE = 1
 #define UART2_RX_IRQ_CLEAR()     IFS1bits.U2RXIF = 0
@@ -79,11 +109,17 @@
 void   UART1_init( uint16 br );
 uint8  UART1_RxDataAvail(void);
 void   UART1_RxFlush(void);
+int    UART1_RxPeekSpan(const uint8 **ppData);
+void   UART1_RxConsume(int count);
+int    UART1_RxUnreadCount(void);
+void   UART1_RxTickService(void);
 uint8  UART1_getch( void );
 uint8  UART1_putch( uint8 b );
 void   UART1_putstr( char *pstr );
 void   UART1_TxQueueHandler();
+int    UART1_TxQueueCount(void);
 int    UART1_getErrorCount(void);
+bool   UART1_RxErrorCheck(void);
 
 void   UART2_init( uint16 br );
 uint8  UART2_RxDataAvail(void);
@@ -0,0 +1,322 @@
+/*
+ * ================================================================================================
+ *
+ * Module:       eeprom_journal_test.c
+ *
+ * Overview:     Host PC (Linux) test of the persistent data store (remi_synth_config.c):
+ *               write-behind of changes to g_Config and g_Preset via the EEPROM journal,
+ *               run against the EEPROM emulation in host_stubs.c.
+ *
+ *               1. Preset switching -- the Preset selection is changed many times, with
+ *                  the write-behind service running between changes, as on stage.  The
+ *                  data must survive a power cycle (re-read from EEPROM, journal replayed).
+ *                  EEPROM bytes written per save and the most writes to any one page are
+ *                  reported, for comparison with a rewrite of the whole data block image.
+ *
+ *               2. Random changes -- random bytes of g_Config and g_Preset are changed,
+ *                  with a random number of service ticks between changes, so that some
+ *                  changes are coalesced, some are written as journal records and some as
+ *                  data block pages, and the journal is compacted many times.  After each
+ *                  flush, the data re-read from EEPROM must equal the data in RAM.
+ *
+ *               3. Power failure -- after a series of changes, with some written, a power
+ *                  failure is simulated during a flush, leaving one write incomplete and the
+ *                  rest lost.  The data re-read from EEPROM must be valid, and each byte must
+ *                  hold a value it had before, during or after the series of changes.
+ *                  Changes made after the power failure must then be stored correctly
+ *                  (the journal recovers from an incomplete record).
+ *
+ * Usage:        eeprom_journal_test [-s <seed>] [-n <iterations>]
+ *
+ * Exit status is 0 if all tests pass, else 1.
+ *
+ * ================================================================================================
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../mp_remi_synth_mk2.X/remi_synth_main.h"
+#include "test_random.h"
+
+#define PRESET_CHANGES       500      // Preset selections in test 1
+#define SERVICE_TICKS_MAX    400      // Max. service calls (ms) between changes
+#define CHANGES_MAX           20      // Max. changes before power failure, test 3
+#define FULL_IMAGE_BYTES    (((sizeof(EepromBlock0_t) + 15) / 16) * 16)
+
+extern  void    HostEepromErase(void);
+extern  void    HostEepromPowerFail(int writesLeft);
+extern  uint32  HostEepromPageWrites(uint8 promBlock, uint8 page);
+
+static  EepromBlock0_t  m_ExpectConfig;       // Data expected after power cycle
+static  EepromBlock1_t  m_ExpectPreset;
+
+
+PRIVATE  void  RunService(int ticks)
+{
+    while (ticks-- > 0)  PersistentDataService();
+}
+
+
+/*
+ * Simulate an MCU reset:  clear the RAM copies of the data, then fetch and check the
+ * data from EEPROM, as done by Init_Application().  Returns FALSE if the check fails.
+ */
+PRIVATE  bool  PowerCycle(void)
+{
+    HostEepromPowerFail(-1);
+    memset(&g_Config, 0, sizeof(g_Config));
+    memset(&g_Preset, 0, sizeof(g_Preset));
+
+    return  CheckConfigData() && CheckPresetData();
+}
+
+
+PRIVATE  void  SaveExpected(void)
+{
+    memcpy(&m_ExpectConfig, &g_Config, sizeof(g_Config));
+    memcpy(&m_ExpectPreset, &g_Preset, sizeof(g_Preset));
+}
+
+
+PRIVATE  bool  DataAsExpected(void)
+{
+    return  memcmp(&m_ExpectConfig, &g_Config, sizeof(g_Config)) == 0
+        &&  memcmp(&m_ExpectPreset, &g_Preset, sizeof(g_Preset)) == 0;
+}
+
+
+/*
+ * Change a few random bytes of g_Config and/or g_Preset, excluding the check words
+ * (first and last 4 bytes), and mark the changes to be stored.
+ */
+PRIVATE  void  RandomChange(void)
+{
+    uint8  *pConfig = (uint8 *) &g_Config;
+    uint8  *pPreset = (uint8 *) &g_Preset;
+    int    count = 1 + RandomRange(RandomRange(4) == 0 ? 40 : 4);
+    int    run, offset;
+
+    while (count > 0)
+    {
+        run = 1 + RandomRange(6);  // changed bytes are often adjacent
+
+        if (RandomRange(3) != 0)
+        {
+            offset = 4 + RandomRange(sizeof(g_Config) - 8);
+            while (run-- > 0 && offset < (int) sizeof(g_Config) - 4)  pConfig[offset++] = Random();
+        }
+        else
+        {
+            offset = 4 + RandomRange(sizeof(g_Preset) - 8);
+            while (run-- > 0 && offset < (int) sizeof(g_Preset) - 4)  pPreset[offset++] = Random();
+        }
+        count--;
+    }
+
+    StoreConfigData();
+    StorePresetData();
+}
+
+
+/*
+ * Start with a blank EEPROM:  the check fails and "factory" defaults are loaded.
+ */
+PRIVATE  bool  StartBlank(void)
+{
+    HostEepromErase();
+    HostEepromPowerFail(-1);
+
+    if (CheckConfigData())  return FALSE;  // blank EEPROM must fail check
+    DefaultConfigData();
+    if (CheckPresetData())  return FALSE;
+    DefaultPresetData();
+
+    if (!FlushPersistentData())  return FALSE;
+    SaveExpected();
+
+    return  PowerCycle() && DataAsExpected();
+}
+
+
+PRIVATE  bool  PresetSwitchTest(void)
+{
+    uint32  bytesStart, compactStart, pageWrites, maxPageWrites = 0;
+    int     i, block, page;
+    bool    pass = StartBlank();
+
+    bytesStart = PersistentDataBytesWritten();
+    compactStart = PersistentDataCompactions();
+
+    for (i = 0;  pass && i < PRESET_CHANGES;  i++)
+    {
+        InstrumentPresetSelect((i * 3 + 1) % 8);
+        StoreConfigData();
+        RunService(300);  // longer than the write-behind delay
+        if (PersistentDataPending() != 0)  pass = FALSE;
+    }
+
+    if (pass)
+    {
+        SaveExpected();
+        pass = PowerCycle() && DataAsExpected();
+    }
+
+    for (block = 0;  block < 4;  block++)
+    {
+        for (page = 0;  page < 16;  page++)
+        {
+            pageWrites = HostEepromPageWrites(block, page);
+            if (pageWrites > maxPageWrites)  maxPageWrites = pageWrites;
+        }
+    }
+
+    printf("Preset switch test %s:  %d saves, %.1f bytes written per save "
+           "(whole block 0 image: %d), %u compactions\n",
+           pass ? "passed" : "FAILED", PRESET_CHANGES,
+           (double) (PersistentDataBytesWritten() - bytesStart) / PRESET_CHANGES,
+           (int) FULL_IMAGE_BYTES, PersistentDataCompactions() - compactStart);
+    printf("  Most writes to any EEPROM page: %u (%.0f%% of saves)\n",
+           maxPageWrites, 100.0 * maxPageWrites / PRESET_CHANGES);
+
+    return  pass;
+}
+
+
+PRIVATE  bool  RandomChangeTest(int iterations)
+{
+    uint32  bytesStart = PersistentDataBytesWritten();
+    uint32  compactStart = PersistentDataCompactions();
+    int     i, failures = 0;
+    bool    pass = StartBlank();
+
+    for (i = 0;  pass && i < iterations;  i++)
+    {
+        RandomChange();
+        RunService(RandomRange(SERVICE_TICKS_MAX));
+
+        if (RandomRange(8) == 0)
+        {
+            if (!FlushPersistentData())  { pass = FALSE;  break; }
+            SaveExpected();
+            if (!PowerCycle() || !DataAsExpected())  failures++;
+        }
+    }
+
+    if (pass && FlushPersistentData())
+    {
+        SaveExpected();
+        if (!PowerCycle() || !DataAsExpected())  failures++;
+    }
+    else  pass = FALSE;
+
+    if (failures != 0)  pass = FALSE;
+    if (PersistentDataWriteErrors() != 0)  pass = FALSE;
+
+    printf("Random change test %s:  %d changes, %u bytes written, %u compactions, "
+           "%d errors\n", pass ? "passed" : "FAILED", iterations,
+           PersistentDataBytesWritten() - bytesStart,
+           PersistentDataCompactions() - compactStart, failures);
+
+    return  pass;
+}
+
+
+/*
+ * Return TRUE if each byte of the data re-read from EEPROM equals the corresponding
+ * byte of one of the given number of snapshots of the data (states held in RAM).
+ */
+PRIVATE  bool  EachByteInHistory(uint8 *pData, uint8 *pHistory, int count, int size)
+{
+    int   i, n;
+
+    for (i = 0;  i < size;  i++)
+    {
+        for (n = 0;  n < count;  n++)
+        {
+            if (pData[i] == pHistory[n * size + i])  break;
+        }
+        if (n == count)  return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+PRIVATE  bool  PowerFailTest(int iterations)
+{
+    static  EepromBlock0_t  configHistory[CHANGES_MAX + 1];
+    static  EepromBlock1_t  presetHistory[CHANGES_MAX + 1];
+    int     i, n, changes, failures = 0;
+    bool    pass = StartBlank();
+
+    for (i = 0;  pass && i < iterations;  i++)
+    {
+        memcpy(&configHistory[0], &g_Config, sizeof(g_Config));   // as in EEPROM
+        memcpy(&presetHistory[0], &g_Preset, sizeof(g_Preset));
+        changes = 1 + RandomRange(CHANGES_MAX);
+
+        for (n = 1;  n <= changes;  n++)
+        {
+            RandomChange();
+            memcpy(&configHistory[n], &g_Config, sizeof(g_Config));
+            memcpy(&presetHistory[n], &g_Preset, sizeof(g_Preset));
+            RunService(RandomRange(SERVICE_TICKS_MAX));  // power OK -- some written
+        }
+
+        HostEepromPowerFail(RandomRange(16));
+        FlushPersistentData();
+
+        if (!PowerCycle()
+        ||  !EachByteInHistory((uint8 *) &g_Config, (uint8 *) configHistory,
+                               changes + 1, sizeof(g_Config))
+        ||  !EachByteInHistory((uint8 *) &g_Preset, (uint8 *) presetHistory,
+                               changes + 1, sizeof(g_Preset)))
+        {
+            failures++;
+            continue;
+        }
+
+        // Recovery:  the next change must be stored correctly
+        RandomChange();
+        if (!FlushPersistentData())  { pass = FALSE;  break; }
+        SaveExpected();
+        if (!PowerCycle() || !DataAsExpected())  failures++;
+    }
+
+    if (failures != 0)  pass = FALSE;
+
+    printf("Power failure test %s:  %d power failures, %d errors\n",
+           pass ? "passed" : "FAILED", iterations, failures);
+
+    return  pass;
+}
+
+
+int  main(int argc, char **argv)
+{
+    int   iterations = 2000;
+    int   opt;
+    bool  pass;
+
+    RandomSeed(0x2545F491);
+
+    while ((opt = getopt(argc, argv, "s:n:")) != -1)
+    {
+        if (opt == 's')  RandomSeed(strtoul(optarg, NULL, 0));
+        else if (opt == 'n')  iterations = atoi(optarg);
+        else
+        {
+            fprintf(stderr, "Usage: %s [-s <seed>] [-n <iterations>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    srand(m_RandomState);  // used by EEPROM emulation (incomplete write)
+
+    pass = PresetSwitchTest();
+    pass = RandomChangeTest(iterations) && pass;
+    pass = PowerFailTest(iterations / 4) && pass;
+
+    return  pass ? 0 : 1;
+}
@@ -0,0 +1,223 @@
+/*
+ * ================================================================================================
+ *
+ * Module:       host_stubs.c
+ *
+ * Overview:     Host PC stand-ins for the PIC32 hardware registers, peripheral drivers and
+ *               main-module functions referenced by the synth engine, patch data, config
+ *               and wave-table creator modules, so that those modules can be linked into
+ *               the host simulator without modification.
+ *
+ *               Console output (UART2) goes to stdout.  The EEPROM is emulated by a RAM
+ *               array, erased (0xFF) at start-up, so DefaultConfigData() etc. behave as on
+ *               a board with a blank EEPROM.  Writes are counted per page, and a power
+ *               failure can be simulated, for tests of the persistent data store.
+ *
+ * ================================================================================================
+ */
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "../mp_remi_synth_mk2.X/remi_synth_main.h"
+
+#define EEPROM_BLOCK_SIZE      256
+#define EEPROM_NUM_BLOCKS        8
+#define EEPROM_PAGE_SIZE        16
+
+volatile  HostLATDbits_t  LATDbits;
+volatile  HostIEC0bits_t  IEC0bits;
+volatile  unsigned int    TMR2;
+volatile  unsigned int    OC4RS;
+
+PRIVATE  uint8  m_EepromImage[EEPROM_NUM_BLOCKS][EEPROM_BLOCK_SIZE];
+PRIVATE  bool   m_EepromErased;
+PRIVATE  uint32 m_EepromPageWrites[EEPROM_NUM_BLOCKS][EEPROM_BLOCK_SIZE / EEPROM_PAGE_SIZE];
+PRIVATE  int    m_EepromWritesLeft = -1;   // Writes until power failure (-1: no failure)
+PRIVATE  bool   m_EepromPowerFailed;
+
+
+/*
+ * Function:     Emulate the CPU core COUNT register (40 counts per microsecond).
+ *               The value wraps modulo 2^32, as on the PIC32.
+ */
+unsigned int  HostCoreCountRead(void)
+{
+    struct timespec  ts;
+    uint64  nanosecs;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    nanosecs = (uint64) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+
+    return  (unsigned int) (nanosecs / 25);  // 25ns per count
+}
+
+
+/*
+ * Function:     Measure the host CPU time-stamp counter rate (cycles per nanosecond)
+ *               over a 50ms interval, for reporting benchmark results in CPU cycles.
+ *               Returns 0 where no cycle counter is available (non-x86 hosts).
+ */
+double  HostCpuCyclesPerNs(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    struct timespec  ts0, ts1;
+    uint64  tsc0, tsc1;
+    double  elapsedNs;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts0);
+    tsc0 = __rdtsc();
+    do
+    {
+        clock_gettime(CLOCK_MONOTONIC, &ts1);
+        elapsedNs = (ts1.tv_sec - ts0.tv_sec) * 1.0e9 + (ts1.tv_nsec - ts0.tv_nsec);
+    } while (elapsedNs < 50.0e6);
+    tsc1 = __rdtsc();
+
+    return  (double) (tsc1 - tsc0) / elapsedNs;
+#else
+    return  0;
+#endif
+}
+
+
+/*
+ * Function:     Stand-in for the audio DAC timer set-up -- the host renders off-line, so
+ *               the sample rate affects only the engine constants (see SampleRateSetup()).
+ */
+void  PWM_audioDAC_SetSampleRate(uint32 rate_Hz)
+{
+    (void) rate_Hz;
+}
+
+
+//=================================================================================================
+//                        Console (UART) output -- redirected to stdout
+//
+void  UART2_putstr(char *pstr)
+{
+    fputs(pstr, stdout);
+}
+
+uint8  UART2_putch(uint8 b)
+{
+    putchar(b);
+    return b;
+}
+
+void  UART1_init(uint16 br)
+{
+    (void) br;  // MIDI port not used in simulation
+}
+
+void  putDecimal(int32 lVal, uint8 bFieldSize)
+{
+    if (bFieldSize > 12)  bFieldSize = 12;
+    if (bFieldSize < 1)  bFieldSize = 1;
+
+    printf("%*d", (int) bFieldSize, (int) lVal);
+}
+
+
+//=================================================================================================
+//                        EEPROM emulation (RAM image, blank on start-up)
+//
+PRIVATE  void  EepromEraseAll(void)
+{
+    memset(m_EepromImage, 0xFF, sizeof(m_EepromImage));
+    memset(m_EepromPageWrites, 0, sizeof(m_EepromPageWrites));
+    m_EepromErased = TRUE;
+}
+
+int  EepromWriteData(uint8 *pData, uint8 promBlock, uint8 promAddr, int nbytes)
+{
+    if (!m_EepromErased)  EepromEraseAll();
+    if (promBlock >= EEPROM_NUM_BLOCKS)  return ERROR;
+    if ((int) promAddr + nbytes > EEPROM_BLOCK_SIZE)  return ERROR;
+    if ((promAddr % EEPROM_PAGE_SIZE) + nbytes > EEPROM_PAGE_SIZE)  return ERROR;
+
+    if (m_EepromPowerFailed)  return SUCCESS;   // write lost
+    if (m_EepromWritesLeft == 0)  // power fails during this write -- part written
+    {
+        nbytes = rand() % (nbytes + 1);
+        m_EepromPowerFailed = TRUE;
+    }
+    else if (m_EepromWritesLeft > 0)  m_EepromWritesLeft--;
+
+    memcpy(&m_EepromImage[promBlock][promAddr], pData, nbytes);
+    m_EepromPageWrites[promBlock][promAddr / EEPROM_PAGE_SIZE]++;
+    return SUCCESS;
+}
+
+int  EepromReadData(uint8 *pData, uint8 promBlock, uint8 promAddr, int nbytes)
+{
+    if (!m_EepromErased)  EepromEraseAll();
+    if (promBlock >= EEPROM_NUM_BLOCKS)  return ERROR;
+    if ((int) promAddr + nbytes > EEPROM_BLOCK_SIZE)  return ERROR;
+
+    memcpy(pData, &m_EepromImage[promBlock][promAddr], nbytes);
+    return SUCCESS;
+}
+
+int  EepromWriteStart(uint8 *pData, uint8 promBlock, uint8 promAddr, int nbytes)
+{
+    return  EepromWriteData(pData, promBlock, promAddr, nbytes);
+}
+
+uint8  EepromIsBusy(void)
+{
+    return 0;
+}
+
+/*
+ * Function:     Erase the emulated EEPROM (all 0xFF) and clear the page write counts.
+ */
+void  HostEepromErase(void)
+{
+    EepromEraseAll();
+}
+
+/*
+ * Function:     Simulate a power failure after the given number of EEPROM writes.
+ *               The next write is then left incomplete (a random number of bytes written)
+ *               and later writes are lost.  A negative value restores power (no failure).
+ */
+void  HostEepromPowerFail(int writesLeft)
+{
+    m_EepromWritesLeft = (writesLeft < 0) ? -1 : writesLeft;
+    m_EepromPowerFailed = FALSE;
+}
+
+/*
+ * Function:     Return the number of writes to a given EEPROM page since erased.
+ */
+uint32  HostEepromPageWrites(uint8 promBlock, uint8 page)
+{
+    return  m_EepromPageWrites[promBlock][page];
+}
+
+
+//=================================================================================================
+//                        Functions normally provided by remi_synth_main.c
+//
+void  InstrumentPresetSelect(uint8 preset)
+{
+    if (preset > 7) preset = 0;   // wrap 8 -> 0
+    g_Config.PresetLastSelected = preset;
+
+    SynthPatchTransition(g_Preset.Descr[preset].PatchNumber);
+}
+
+bool  isHandsetConnected()
+{
+    return FALSE;  // Envelope * Velocity amplitude control in AUTO mode
+}
+
+
+//=================================================================================================
+//                        Functions normally provided by MIDI_comms_lib.c
+//
+void  MIDI_EventQueueFlush(void)
+{
+    // no MIDI IN in the host simulator
+}
@@ -0,0 +1,35 @@
+/*
+ * File:       p32xxxx.h  (host PC simulation stub)
+ *
+ * Declares the few PIC32MX special function registers referenced by the modules
+ * linked into the host simulator.  The "registers" are ordinary variables defined
+ * in host_stubs.c;  writes to them have no effect.
+ *
+ * The CPU core COUNT register is emulated by HostCoreCountRead(), which returns a
+ * count derived from the host monotonic clock at the PIC32 rate of 40 counts/us,
+ * so that execution times measured by the synth engine keep the same units.
+ */
+#ifndef HOST_SIM_P32XXXX_H
+#define HOST_SIM_P32XXXX_H
+
+typedef struct
+{
+    unsigned  LATD0:1, LATD1:1, LATD2:1, LATD3:1, LATD4:1, LATD5:1, LATD6:1, LATD7:1;
+    unsigned  LATD8:1, LATD9:1, LATD10:1, LATD11:1;
+} HostLATDbits_t;
+
+typedef struct
+{
+    unsigned  CS0IE:1;    // Core S/W IRQ 0 (audio block render) enable
+} HostIEC0bits_t;
+
+extern  volatile  HostLATDbits_t  LATDbits;
+extern  volatile  HostIEC0bits_t  IEC0bits;
+extern  volatile  unsigned int    TMR2;
+extern  volatile  unsigned int    OC4RS;     // PWM audio DAC duty register
+
+unsigned int  HostCoreCountRead(void);
+
+#define READ_CPU_CORE_COUNT_REG(u32)  (u32 = HostCoreCountRead())
+
+#endif  // HOST_SIM_P32XXXX_H
@@ -0,0 +1,12 @@
+/*
+ * File:       sys/attribs.h  (host PC simulation stub)
+ *
+ * Interrupt handler attributes have no meaning on the host.
+ */
+#ifndef HOST_SIM_ATTRIBS_H
+#define HOST_SIM_ATTRIBS_H
+
+#define __ISR(vector, ipl)
+#define __ISR_AT_VECTOR(vector, ipl)
+
+#endif  // HOST_SIM_ATTRIBS_H
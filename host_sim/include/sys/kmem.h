@@ -0,0 +1,13 @@
+/*
+ * File:       sys/kmem.h  (host PC simulation stub)
+ *
+ * Host addresses are used as-is (no kseg translation).
+ */
+#ifndef HOST_SIM_KMEM_H
+#define HOST_SIM_KMEM_H
+
+#define KVA_TO_PA(v)   ((unsigned long)(v))
+#define PA_TO_KVA0(pa) ((void *)(pa))
+#define PA_TO_KVA1(pa) ((void *)(pa))
+
+#endif  // HOST_SIM_KMEM_H
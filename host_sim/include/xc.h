@@ -0,0 +1,12 @@
+/*
+ * File:       xc.h  (host PC simulation stub)
+ *
+ * Replaces the XC32 compiler header for the host build.  Device register
+ * declarations are in the companion stub "p32xxxx.h".
+ */
+#ifndef HOST_SIM_XC_H
+#define HOST_SIM_XC_H
+
+#include "p32xxxx.h"
+
+#endif  // HOST_SIM_XC_H
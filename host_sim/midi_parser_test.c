@@ -0,0 +1,719 @@
+/*
+ * ================================================================================================
+ *
+ * Module:       midi_parser_test.c
+ *
+ * Overview:     Host PC (Linux) test of the MIDI IN parser (MIDI_parser.c) and the
+ *               MIDI OUT scheduler (MIDI_comms_lib.c).
+ *
+ *               1. Stream test -- a random valid MIDI stream is generated, comprising all
+ *                  message classes:  channel messages, with and without running status,
+ *                  System Common messages, SysEx messages of up to 300 bytes, and Real-time
+ *                  bytes interleaved at random, even within other messages.  The stream is
+ *                  fed to the parser in blocks of random size, and the messages delivered
+ *                  are compared with those generated.
+ *
+ *               2. Fuzz test -- random bytes (biased towards status bytes) are fed to the
+ *                  parser.  Every message delivered must be well formed, SysEx chunks must
+ *                  be correctly framed, and the output must not depend on how the input is
+ *                  split into blocks.
+ *
+ *               3. Throughput -- a dense controller stream (CC, pitch bend and channel
+ *                  pressure, mostly running status) is parsed in 64-byte blocks, and the
+ *                  rate is reported in messages per second, for comparison with the MIDI
+ *                  wire rate (about 1000 3-byte messages per second at 31250 baud).
+ *
+ *               4. Resync -- after MIDI_ParserResync() (UART RX error), data bytes which
+ *                  follow the lost bytes must not be taken as running status messages.
+ *
+ *               5. MIDI OUT scheduler -- a 14-bit breath controller (CC 2/34, 1kHz), pitch
+ *                  bend, modulation and notes are sent at about twice the MIDI wire rate,
+ *                  into a simulated 31250 baud link.  The output is parsed and checked:
+ *                  all notes must arrive, in order;  every 14-bit breath value received
+ *                  must be one that was sent (MSB/LSB order kept);  the last value of each
+ *                  controller must arrive.  Coalescing, running status and queue depth
+ *                  statistics are reported;  a status byte must be sent at least every
+ *                  MIDI_OUT_STATUS_REFRESH messages, and after MIDI_OutputFlush().
+ *                  Then short sequences whose meaning depends on message order (Sustain
+ *                  around notes, RPN writes, Bank Select around Program Change) are
+ *                  queued at once, and must arrive unchanged.
+ *
+ * Usage:        midi_parser_test [-s <seed>] [-n <iterations>]
+ *
+ * Exit status is 0 if all tests pass, else 1.
+ *
+ * ================================================================================================
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../mp_remi_synth_mk2.X/MIDI_comms_lib.h"
+#include "test_random.h"
+
+#define SYSEX_MAX_LENGTH      320       // Longest SysEx message generated (incl. F0, F7)
+#define LOG_MAX_ENTRIES     20000       // Messages per stream test
+#define THROUGHPUT_MSGS   2000000       // Messages in throughput test stream
+#define WIRE_BYTE_TIME_US     320       // MIDI byte time on the wire (31250 baud)
+#define MIDI_OUT_TEST_MS     2000       // Duration of MIDI OUT scheduler test
+
+// Entry in the log of messages expected (generated) or received (delivered by parser)
+typedef struct Test_log_entry
+{
+    uint8   Status;           // Status byte, or 0xF0 for SysEx
+    uint8   Data1;
+    uint8   Data2;
+    uint8   Flags;            // SysEx: MIDI_SYSEX_END or MIDI_SYSEX_ABORT
+    uint16  Length;           // Message length (bytes) incl. status (SysEx: incl. F0, F7)
+    uint8   SysEx[SYSEX_MAX_LENGTH];
+
+} TestLogEntry_t;
+
+typedef struct Test_log
+{
+    TestLogEntry_t  *Entry;
+    int     Count;
+    int     Capacity;
+    int     Errors;           // Framing errors found by the SysEx handler
+    bool    SysExActive;      // SysEx handler: receiving SysEx message
+
+} TestLog_t;
+
+static  TestLog_t   m_Expected;
+static  TestLog_t   m_Received;
+static  TestLog_t  *m_pLog;                // Log written by the parser handlers
+static  uint32      m_MsgCount;            // Throughput test handler count
+
+// Simulated UART1 TX queue and link (MIDI OUT scheduler test)
+static  uint8       m_TxQueue[256];
+static  int         m_TxCount;
+static  MidiParser_t  m_WireParser;        // Parses bytes sent on the link
+static  uint32      m_WireTime_us;
+static  uint32      m_WireBytes;
+static  int         m_WireMsgsSinceStatus; // Messages received since a status byte
+static  int         m_WireMaxRunningMsgs;  // Most messages received per status byte
+static  uint32      m_NoteOnTime_us[128];  // Time each note-on was sent
+static  uint32      m_MaxNoteLatency_us;
+static  int         m_NotesRx;
+static  uint8       m_NextNoteRx;
+static  uint8       m_BreathMsbRx;
+static  bool        m_Breath14Sent[16384]; // 14-bit breath values sent
+static  int         m_Breath14Errors;
+static  uint8       m_LastCCRx[128];
+static  uint16      m_LastBendRx;
+
+// MIDI OUT sequences (status, data1, data2) for OutSequenceTest()...
+static  const  uint8  m_SustainSeq[][3] =   // note must be sustained
+    { { 0xB0, 64, 127 }, { 0x90, 60, 100 }, { 0x80, 60, 64 }, { 0xB0, 64, 0 } };
+static  const  uint8  m_RpnSeq[][3] =       // Pitch bend range = 2, then fine tuning = 64
+    { { 0xB0, 101, 0 }, { 0xB0, 100, 0 }, { 0xB0, 6, 2 },
+      { 0xB0, 101, 0 }, { 0xB0, 100, 1 }, { 0xB0, 6, 64 } };
+static  const  uint8  m_BankSeq[][3] =      // Bank 1, program 5, then bank 2, program 6
+    { { 0xB0, 0, 1 }, { 0xB0, 32, 0 }, { 0xC0, 5, 0 },
+      { 0xB0, 0, 2 }, { 0xB0, 32, 0 }, { 0xC0, 6, 0 } };
+static  const  uint8  m_NoteCCSeq[][3] =    // note must start with modulation = 10
+    { { 0xB0, 1, 10 }, { 0x90, 62, 100 }, { 0xB0, 1, 20 } };
+static  const  uint8  m_CoalesceSeq[][3] =
+    { { 0xB0, 1, 10 }, { 0xB0, 1, 20 }, { 0xE0, 0, 64 }, { 0xB1, 1, 5 }, { 0xB0, 1, 30 } };
+static  const  uint8  m_CoalesceExpect[][3] =
+    { { 0xB0, 1, 30 }, { 0xE0, 0, 64 }, { 0xB1, 1, 5 } };
+
+
+PRIVATE  void  LogInit(TestLog_t *pLog, int capacity)
+{
+    if (pLog->Entry == NULL)  pLog->Entry = calloc(capacity, sizeof(TestLogEntry_t));
+    pLog->Capacity = capacity;
+    pLog->Count = 0;
+    pLog->Errors = 0;
+    pLog->SysExActive = FALSE;
+}
+
+
+PRIVATE  TestLogEntry_t  *LogAppend(TestLog_t *pLog)
+{
+    TestLogEntry_t  *pEntry;
+
+    if (pLog->Count >= pLog->Capacity)
+    {
+        pLog->Capacity *= 2;
+        pLog->Entry = realloc(pLog->Entry, pLog->Capacity * sizeof(TestLogEntry_t));
+    }
+    pEntry = &pLog->Entry[pLog->Count++];
+    memset(pEntry, 0, sizeof(TestLogEntry_t));
+    return  pEntry;
+}
+
+
+/*
+ * Parser handlers -- write messages delivered into the log *m_pLog, and check message
+ * format and SysEx chunk framing.
+ */
+PRIVATE  void  TestMsgHandler(const MidiMessage_t *pMsg)
+{
+    TestLogEntry_t  *pEntry = LogAppend(m_pLog);
+
+    if (pMsg->Length != MIDI_MessageLength(pMsg->Status)
+    ||  (pMsg->Data1 | pMsg->Data2) & 0x80)  m_pLog->Errors++;
+
+    pEntry->Status = pMsg->Status;
+    pEntry->Data1 = pMsg->Data1;
+    pEntry->Data2 = pMsg->Data2;
+    pEntry->Length = pMsg->Length;
+}
+
+
+PRIVATE  void  TestSysExHandler(const uint8 *data, int length, uint8 flags, uint32 timestamp)
+{
+    static  TestLogEntry_t  sysExMsg;  // SysEx message being received
+    int  i;
+
+    (void) timestamp;
+    if (length > MIDI_SYSEX_CHUNK_SIZE)  m_pLog->Errors++;
+    if ((flags & MIDI_SYSEX_START) == 0 && !m_pLog->SysExActive)  m_pLog->Errors++;
+    if ((flags & MIDI_SYSEX_START) && m_pLog->SysExActive)  m_pLog->Errors++;
+    if ((flags & MIDI_SYSEX_START) && (length == 0 || data[0] != 0xF0))  m_pLog->Errors++;
+    if ((flags & MIDI_SYSEX_END) && (length == 0 || data[length - 1] != 0xF7))
+        m_pLog->Errors++;
+
+    if (flags & MIDI_SYSEX_START)
+    {
+        memset(&sysExMsg, 0, sizeof(sysExMsg));
+        sysExMsg.Status = 0xF0;
+        m_pLog->SysExActive = TRUE;
+    }
+
+    for (i = 0;  i < length;  i++)
+    {
+        if ((data[i] & 0x80) && !(i == 0 && (flags & MIDI_SYSEX_START))
+        &&  !(i == length - 1 && (flags & MIDI_SYSEX_END)))  m_pLog->Errors++;
+        if (sysExMsg.Length < SYSEX_MAX_LENGTH)  sysExMsg.SysEx[sysExMsg.Length] = data[i];
+        sysExMsg.Length++;
+    }
+
+    if (flags & (MIDI_SYSEX_END | MIDI_SYSEX_ABORT))  // message complete -- log it
+    {
+        sysExMsg.Flags = flags & (MIDI_SYSEX_END | MIDI_SYSEX_ABORT);
+        *LogAppend(m_pLog) = sysExMsg;
+        m_pLog->SysExActive = FALSE;
+    }
+}
+
+
+/*
+ * Feed a byte stream to the parser in blocks of random size (1..maxBlock bytes).
+ */
+PRIVATE  void  ParseInRandomBlocks(MidiParser_t *pParser, const uint8 *stream, int length,
+                                   int maxBlock)
+{
+    int  count;
+
+    while (length > 0)
+    {
+        count = 1 + RandomRange(maxBlock);
+        if (count > length)  count = length;
+        MIDI_ParseBuffer(pParser, stream, count, 0);
+        stream += count;
+        length -= count;
+    }
+}
+
+
+PRIVATE  bool  LogsEqual(TestLog_t *pLog1, TestLog_t *pLog2, int *pIndex)
+{
+    TestLogEntry_t  *p1, *p2;
+    int  i;
+
+    for (i = 0;  i < pLog1->Count && i < pLog2->Count;  i++)
+    {
+        p1 = &pLog1->Entry[i];
+        p2 = &pLog2->Entry[i];
+        if (p1->Status != p2->Status || p1->Data1 != p2->Data1 || p1->Data2 != p2->Data2
+        ||  p1->Flags != p2->Flags || p1->Length != p2->Length
+        ||  memcmp(p1->SysEx, p2->SysEx, sizeof(p1->SysEx)) != 0)  break;
+    }
+    *pIndex = i;
+    return  (i == pLog1->Count && i == pLog2->Count);
+}
+
+
+/*
+ * Generate a random valid MIDI stream of (about) the given number of messages.
+ * The messages are written into the expected-message log in order of completion.
+ * Return:  stream length (bytes)
+ */
+PRIVATE  int  GenerateStream(uint8 *stream, int numMsgs)
+{
+    static const uint8 commonStatus[] = { 0xF1, 0xF2, 0xF3, 0xF6 };
+    static const uint8 realTimeStatus[] = { 0xF8, 0xFA, 0xFB, 0xFC, 0xFE, 0xFF };
+    TestLogEntry_t  *pEntry;
+    uint8   runningStatus = 0;
+    uint8   status, msg[SYSEX_MAX_LENGTH];
+    int     length = 0;
+    int     msgLen, i, n, kind;
+
+    for (n = 0;  n < numMsgs;  n++)
+    {
+        kind = RandomRange(100);
+
+        if (kind < 70)  // channel message
+        {
+            if (runningStatus != 0 && RandomRange(3) != 0)  status = runningStatus;
+            else  status = 0x80 + (RandomRange(7) << 4) + RandomRange(16);
+            msgLen = MIDI_MessageLength(status);
+            msg[0] = status;
+            msg[1] = RandomRange(128);
+            msg[2] = RandomRange(128);
+            i = (status == runningStatus) ? 1 : 0;  // omit status byte (running status)
+            runningStatus = status;
+        }
+        else if (kind < 80)  // system common message
+        {
+            status = commonStatus[RandomRange(4)];
+            msgLen = MIDI_MessageLength(status);
+            msg[0] = status;
+            msg[1] = RandomRange(128);
+            msg[2] = RandomRange(128);
+            i = 0;
+            runningStatus = 0;
+        }
+        else  // SysEx -- mostly short, some long
+        {
+            msgLen = (RandomRange(4) == 0) ? 2 + RandomRange(SYSEX_MAX_LENGTH - 1)
+                                            : 2 + RandomRange(20);
+            msg[0] = 0xF0;
+            for (i = 1;  i < msgLen - 1;  i++)  msg[i] = RandomRange(128);
+            msg[msgLen - 1] = 0xF7;
+            i = 0;
+            runningStatus = 0;
+        }
+
+        for ( ;  i < msgLen;  i++)
+        {
+            // Real-time byte(s) may be inserted anywhere, even within a message...
+            while (RandomRange(10) == 0)
+            {
+                stream[length++] = realTimeStatus[RandomRange(6)];
+                pEntry = LogAppend(&m_Expected);
+                pEntry->Status = stream[length - 1];
+                pEntry->Length = 1;
+            }
+            stream[length++] = msg[i];
+        }
+
+        pEntry = LogAppend(&m_Expected);
+        pEntry->Status = msg[0];
+        pEntry->Length = msgLen;
+        if (msg[0] == 0xF0)
+        {
+            memcpy(pEntry->SysEx, msg, msgLen);
+            pEntry->Flags = MIDI_SYSEX_END;
+        }
+        else
+        {
+            if (msgLen > 1)  pEntry->Data1 = msg[1];
+            if (msgLen > 2)  pEntry->Data2 = msg[2];
+        }
+    }
+
+    return  length;
+}
+
+
+PRIVATE  bool  StreamTest(int iterations)
+{
+    MidiParser_t  parser;
+    uint8   *stream = malloc(LOG_MAX_ENTRIES * (SYSEX_MAX_LENGTH + 8));
+    int     length, index, iter;
+    bool    pass = TRUE;
+
+    for (iter = 0;  iter < iterations && pass;  iter++)
+    {
+        LogInit(&m_Expected, LOG_MAX_ENTRIES);
+        LogInit(&m_Received, LOG_MAX_ENTRIES);
+        length = GenerateStream(stream, 2000);
+
+        m_pLog = &m_Received;
+        MIDI_ParserInit(&parser, TestMsgHandler, TestSysExHandler);
+        ParseInRandomBlocks(&parser, stream, length, (iter & 1) ? 4 : 256);
+
+        if (!LogsEqual(&m_Expected, &m_Received, &index) || m_Received.Errors != 0
+        ||  parser.ErrorCount != 0)
+        {
+            printf("Stream test FAILED (iteration %d):  message %d of %d (%d rx'd), "
+                   "%d format errors, %d parser errors\n", iter, index, m_Expected.Count,
+                   m_Received.Count, m_Received.Errors, (int) parser.ErrorCount);
+            pass = FALSE;
+        }
+    }
+
+    if (pass)  printf("Stream test passed:  %d iterations, %d messages per stream\n",
+                      iterations, m_Expected.Count);
+    free(stream);
+    return  pass;
+}
+
+
+PRIVATE  bool  FuzzTest(int iterations)
+{
+    static  TestLog_t  wholeLog;
+    MidiParser_t  parser;
+    uint8   stream[4096];
+    uint32  parserErrors = 0, msgCount = 0;
+    int     iter, i, index;
+    bool    pass = TRUE;
+
+    for (iter = 0;  iter < iterations && pass;  iter++)
+    {
+        for (i = 0;  i < (int) sizeof(stream);  i++)
+        {
+            stream[i] = Random();
+            if (RandomRange(4) != 0)  stream[i] &= 0x7F;  // mostly data bytes
+        }
+
+        // Parse the stream in one block, then in random blocks -- results must agree
+        LogInit(&wholeLog, 1024);
+        m_pLog = &wholeLog;
+        MIDI_ParserInit(&parser, TestMsgHandler, TestSysExHandler);
+        MIDI_ParseBuffer(&parser, stream, sizeof(stream), 0);
+        parserErrors += parser.ErrorCount;
+        msgCount += parser.MessageCount;
+
+        LogInit(&m_Received, 1024);
+        m_pLog = &m_Received;
+        MIDI_ParserInit(&parser, TestMsgHandler, TestSysExHandler);
+        ParseInRandomBlocks(&parser, stream, sizeof(stream), 1 + (iter % 32));
+
+        if (!LogsEqual(&wholeLog, &m_Received, &index)
+        ||  wholeLog.Errors != 0 || m_Received.Errors != 0)
+        {
+            printf("Fuzz test FAILED (iteration %d):  message %d differs, "
+                   "%d format errors\n", iter, index, wholeLog.Errors + m_Received.Errors);
+            pass = FALSE;
+        }
+    }
+
+    if (pass)  printf("Fuzz test passed:  %d x %d random bytes, %u messages, "
+                      "%u parser errors (expected)\n", iterations, (int) sizeof(stream),
+                      msgCount, parserErrors);
+    return  pass;
+}
+
+
+PRIVATE  void  CountMsgHandler(const MidiMessage_t *pMsg)
+{
+    (void) pMsg;
+    m_MsgCount++;
+}
+
+
+PRIVATE  void  ThroughputTest(void)
+{
+    MidiParser_t  parser;
+    struct timespec  ts0, ts1;
+    uint8   *stream = malloc(THROUGHPUT_MSGS * 3);
+    uint8   status = 0;
+    int     length = 0, n, offset;
+    double  seconds;
+
+    // Breath/expression CC flood with occasional pitch bend and channel pressure
+    for (n = 0;  n < THROUGHPUT_MSGS;  n++)
+    {
+        uint8  next = (n % 16 == 15) ? 0xE0 : (n % 16 == 7) ? 0xD0 : 0xB0;
+
+        if (next != status)  stream[length++] = status = next;
+        stream[length++] = (next == 0xB0) ? 2 : n & 0x7F;
+        if (next != 0xD0)  stream[length++] = (n >> 3) & 0x7F;
+    }
+
+    m_MsgCount = 0;
+    MIDI_ParserInit(&parser, CountMsgHandler, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &ts0);
+    for (offset = 0;  offset < length;  offset += 64)
+        MIDI_ParseBuffer(&parser, &stream[offset], (length - offset < 64) ? length - offset : 64, 0);
+    clock_gettime(CLOCK_MONOTONIC, &ts1);
+
+    seconds = (ts1.tv_sec - ts0.tv_sec) + (ts1.tv_nsec - ts0.tv_nsec) * 1e-9;
+    printf("Throughput:  %u messages (%d bytes) in %.3f ms  =  %.1f M msgs/s,  "
+           "%.2f ns/byte\n", m_MsgCount, length, seconds * 1000, m_MsgCount / seconds / 1e6,
+           seconds * 1e9 / length);
+    free(stream);
+}
+
+
+/*
+ * Resync test -- a note-on is received, with a second note in running status;  then bytes
+ * are lost (UART RX error), so the parser is resynchronized.  The data bytes which follow
+ * must be ignored until the next status byte.  Events are read from the MIDI IN queue.
+ */
+PRIVATE  bool  ResyncTest(void)
+{
+    static const uint8  before[] = { 0x90, 60, 100, 62, 100, 64 };  // 3rd note incomplete
+    static const uint8  after[] = { 100, 65, 100, 0x90, 67, 100 };
+    static const uint8  expectNotes[] = { 60, 62, 67 };
+    MidiEvent_t  event;
+    int     count = 0;
+    bool    pass = TRUE;
+
+    MIDI_EventQueueFlush();
+    MIDI_ParserInput(before, sizeof(before), 0);
+    MIDI_ParserResync();
+    MIDI_ParserInput(after, sizeof(after), 1);
+
+    while (MIDI_GetEvent(&event))
+    {
+        if (count >= (int) sizeof(expectNotes) || event.Status != 0x90
+        ||  event.Data1 != expectNotes[count])  pass = FALSE;
+        count++;
+    }
+    if (count != (int) sizeof(expectNotes))  pass = FALSE;
+
+    printf("Resync test %s:  %d of %d notes received\n", pass ? "passed" : "FAILED",
+           count, (int) sizeof(expectNotes));
+    return  pass;
+}
+
+
+/*
+ * Stubs for the UART1 TX functions used by the MIDI OUT scheduler...
+ * The TX queue is drained at the wire rate by the test loop (MidiOutTest).
+ */
+uint8  UART1_putch(uint8 b)
+{
+    if (m_TxCount >= (int) sizeof(m_TxQueue))  return 0xFF;
+    m_TxQueue[m_TxCount++] = b;
+    return  b;
+}
+
+int   UART1_TxQueueCount(void)  { return  m_TxCount; }
+
+void  UART1_TxQueueHandler(void)  { }
+
+
+PRIVATE  void  WireMsgHandler(const MidiMessage_t *pMsg)
+{
+    uint8  command = pMsg->Status & 0xF0;
+    int    value14;
+
+    if (++m_WireMsgsSinceStatus > m_WireMaxRunningMsgs)
+        m_WireMaxRunningMsgs = m_WireMsgsSinceStatus;
+
+    if (command == NOTE_ON_CMD)
+    {
+        if (pMsg->Data1 != m_NextNoteRx)  m_NotesRx = -100000;  // out of order
+        if (m_WireTime_us - m_NoteOnTime_us[pMsg->Data1] > m_MaxNoteLatency_us)
+            m_MaxNoteLatency_us = m_WireTime_us - m_NoteOnTime_us[pMsg->Data1];
+        m_NextNoteRx = (pMsg->Data1 + 1) & 0x7F;
+        m_NotesRx++;
+    }
+    else if (command == CONTROL_CHANGE_CMD)
+    {
+        m_LastCCRx[pMsg->Data1] = pMsg->Data2;
+        if (pMsg->Data1 == CC_BREATH_PRESSURE)  m_BreathMsbRx = pMsg->Data2;
+        if (pMsg->Data1 == CC_BREATH_PRESSURE + 0x20)
+        {
+            value14 = ((int) m_BreathMsbRx << 7) + pMsg->Data2;
+            if (!m_Breath14Sent[value14])  m_Breath14Errors++;
+        }
+    }
+    else if (command == PITCH_BEND_CMD)
+        m_LastBendRx = ((uint16) pMsg->Data2 << 7) + pMsg->Data1;
+}
+
+
+/*
+ * Simulated UART -- if a byte time has passed since the last byte was sent, send the
+ * next byte from the TX queue to the wire parser.
+ */
+PRIVATE  void  WireStep(uint32 time_us, uint32 *pNextByte_us)
+{
+    if (time_us >= *pNextByte_us && m_TxCount != 0)
+    {
+        m_WireTime_us = time_us + WIRE_BYTE_TIME_US;
+        if (m_TxQueue[0] >= 0x80 && m_TxQueue[0] < 0xF8)  m_WireMsgsSinceStatus = 0;
+        MIDI_ParseBuffer(&m_WireParser, m_TxQueue, 1, 0);
+        memmove(m_TxQueue, &m_TxQueue[1], --m_TxCount);
+        m_WireBytes++;
+        *pNextByte_us = time_us + WIRE_BYTE_TIME_US;
+    }
+}
+
+
+/*
+ * Queue a sequence of channel messages (3 bytes each) all at once, as when the link is
+ * saturated, then send them.  The messages received must equal the expected sequence.
+ */
+PRIVATE  bool  OutSequenceTest(const char *name, const uint8 (*send)[3], int sendCount,
+                               const uint8 (*expect)[3], int expectCount)
+{
+    TestLogEntry_t  *pEntry;
+    uint32  time_us, nextByte_us = 0;
+    int     i, index;
+    uint8   chan;
+    bool    pass;
+
+    LogInit(&m_Expected, 64);
+    LogInit(&m_Received, 64);
+    m_pLog = &m_Received;
+
+    for (i = 0;  i < sendCount;  i++)
+    {
+        chan = (send[i][0] & 0x0F) + 1;
+        switch (send[i][0] & 0xF0)
+        {
+        case NOTE_ON_CMD:         MIDI_SendNoteOn(chan, send[i][1], send[i][2]);  break;
+        case NOTE_OFF_CMD:        MIDI_SendNoteOff(chan, send[i][1]);  break;
+        case CONTROL_CHANGE_CMD:  MIDI_SendControlChange(chan, send[i][1], send[i][2]);  break;
+        case PROGRAM_CHANGE_CMD:  MIDI_SendProgramChange(chan, send[i][1]);  break;
+        case PITCH_BEND_CMD:      MIDI_SendPitchBend(chan, send[i][1] | (send[i][2] << 7));  break;
+        }
+    }
+
+    for (i = 0;  i < expectCount;  i++)
+    {
+        pEntry = LogAppend(&m_Expected);
+        pEntry->Status = expect[i][0];
+        pEntry->Data1 = expect[i][1];
+        pEntry->Data2 = (MIDI_MessageLength(expect[i][0]) > 2) ? expect[i][2] : 0;
+        pEntry->Length = MIDI_MessageLength(expect[i][0]);
+    }
+
+    for (time_us = 0;  time_us < 100000;  time_us += 10)
+    {
+        MIDI_OutputService();
+        WireStep(time_us, &nextByte_us);
+    }
+
+    pass = LogsEqual(&m_Expected, &m_Received, &index) && m_Received.Errors == 0;
+    if (!pass)  printf("  %s sequence FAILED at message %d (%d rx'd)\n", name, index,
+                       m_Received.Count);
+    return  pass;
+}
+
+
+/*
+ * MIDI OUT scheduler test -- the main loop is simulated in 10us steps;  the UART sends
+ * one byte from the TX queue every WIRE_BYTE_TIME_US.
+ */
+PRIVATE  bool  MidiOutTest(void)
+{
+    uint32  time_us, nextByte_us = 0;
+    uint32  sent = 0;
+    int     notesSent = 0;
+    uint16  breath14 = 0, bend = 0;
+    uint8   modulation = 0, note = 0;
+    int     i;
+    bool    pass, refreshPass;
+
+    MIDI_ParserInit(&m_WireParser, WireMsgHandler, NULL);
+    memset(m_Breath14Sent, 0, sizeof(m_Breath14Sent));
+
+    for (time_us = 0;  time_us < (MIDI_OUT_TEST_MS + 200) * 1000;  time_us += 10)
+    {
+        if (time_us % 1000 == 0 && time_us < MIDI_OUT_TEST_MS * 1000)  // 1ms tick
+        {
+            uint32  t_ms = time_us / 1000;
+
+            breath14 = (t_ms * 37) & 0x3FFF;  // 14-bit breath controller
+            m_Breath14Sent[breath14] = TRUE;
+            MIDI_SendControlChange(1, CC_BREATH_PRESSURE, breath14 >> 7);
+            MIDI_SendControlChange(1, CC_BREATH_PRESSURE + 0x20, breath14 & 0x7F);
+            sent += 2;
+            if (t_ms % 2 == 0)  { bend = (t_ms * 101) & 0x3FFF;  MIDI_SendPitchBend(1, bend);  sent++; }
+            if (t_ms % 5 == 0)  { modulation = t_ms & 0x7F;  MIDI_SendControlChange(1, CC_MODULATION, modulation);  sent++; }
+            if (t_ms % 50 == 0)
+            {
+                if (notesSent != 0)  { MIDI_SendNoteOff(1, (note - 1) & 0x7F);  sent++; }
+                m_NoteOnTime_us[note] = time_us;
+                MIDI_SendNoteOn(1, note, 100);
+                note = (note + 1) & 0x7F;
+                notesSent++;
+                sent++;
+            }
+        }
+
+        MIDI_OutputService();
+        WireStep(time_us, &nextByte_us);
+    }
+
+    pass = (m_NotesRx == notesSent && m_Breath14Errors == 0 && MIDI_GetOutputDrops() == 0
+            && m_LastCCRx[CC_BREATH_PRESSURE] == (breath14 >> 7)
+            && m_LastCCRx[CC_BREATH_PRESSURE + 0x20] == (breath14 & 0x7F)
+            && m_LastCCRx[CC_MODULATION] == modulation && m_LastBendRx == bend
+            && MIDI_GetOutputQueueDepth() == 0
+            && m_WireMaxRunningMsgs <= MIDI_OUT_STATUS_REFRESH);
+
+    printf("MIDI OUT test %s:  %u msgs sent in %d ms (%.0f%% of wire rate), "
+           "%u coalesced, %u dropped\n", pass ? "passed" : "FAILED", sent, MIDI_OUT_TEST_MS,
+           sent * 3.0 * WIRE_BYTE_TIME_US / (MIDI_OUT_TEST_MS * 10.0),
+           MIDI_GetOutputCoalesced(), MIDI_GetOutputDrops());
+    printf("  %u bytes on wire, %u status bytes saved (running status), max queue depth %d,"
+           " max note-on latency %.2f ms\n", m_WireBytes, MIDI_GetOutputStatusBytesSaved(),
+           MIDI_GetOutputQueueMaxDepth(), m_MaxNoteLatency_us / 1000.0);
+    if (!pass)  printf("  notes %d/%d, breath value errors %d, max msgs per status byte %d\n",
+                       m_NotesRx, notesSent, m_Breath14Errors, m_WireMaxRunningMsgs);
+
+    // In a long run of messages with the same status, the status byte must be re-sent;
+    // after a flush (MIDI OUT enabled), the first message must be sent with its status,
+    // even though it is the same as the last status sent.
+    m_WireMaxRunningMsgs = 0;
+    for (i = 0;  i < MIDI_OUT_STATUS_REFRESH * 3;  i++)
+    {
+        MIDI_SendControlChange(1, 20 + i, i);
+        MIDI_OutputService();
+        for (time_us = 0, nextByte_us = 0;  m_TxCount != 0;  time_us += 10)
+            WireStep(time_us, &nextByte_us);
+    }
+    MIDI_SendControlChange(1, CC_MODULATION, 0);
+    MIDI_OutputFlush();
+    MIDI_SendControlChange(1, CC_MODULATION, 0);
+    MIDI_OutputService();
+    refreshPass = (m_TxCount == 3 && m_TxQueue[0] == CONTROL_CHANGE_CMD
+                   && m_WireMaxRunningMsgs <= MIDI_OUT_STATUS_REFRESH);
+    for (time_us = 0, nextByte_us = 0;  m_TxCount != 0;  time_us += 10)
+        WireStep(time_us, &nextByte_us);
+    printf("MIDI OUT status refresh test %s:  max %d msgs per status byte, status sent "
+           "after flush\n", refreshPass ? "passed" : "FAILED", m_WireMaxRunningMsgs);
+    pass = refreshPass && pass;
+
+    // Order-dependent sequences -- must not be coalesced or re-ordered
+    // (The wire parser keeps its running status from the test above.)
+    m_WireParser.MsgHandler = TestMsgHandler;
+    pass = OutSequenceTest("Sustain", m_SustainSeq, 4, m_SustainSeq, 4) && pass;
+    pass = OutSequenceTest("RPN", m_RpnSeq, 6, m_RpnSeq, 6) && pass;
+    pass = OutSequenceTest("Bank Select", m_BankSeq, 6, m_BankSeq, 6) && pass;
+    pass = OutSequenceTest("Note/CC", m_NoteCCSeq, 3, m_NoteCCSeq, 3) && pass;
+    // Continuous controllers are still coalesced across other controllers' values
+    pass = OutSequenceTest("Coalesced CC", m_CoalesceSeq, 5, m_CoalesceExpect, 3) && pass;
+
+    printf("MIDI OUT order test %s:  Sustain, RPN, Bank Select, coalesced CC sequences\n",
+           pass ? "passed" : "FAILED");
+    return  pass;
+}
+
+
+int  main(int argc, char **argv)
+{
+    int   iterations = 50;
+    int   opt;
+    bool  pass;
+
+    while ((opt = getopt(argc, argv, "s:n:")) != -1)
+    {
+        if (opt == 's')  RandomSeed(strtoul(optarg, NULL, 0));
+        else if (opt == 'n')  iterations = atoi(optarg);
+        else
+        {
+            fprintf(stderr, "Usage: %s [-s <seed>] [-n <iterations>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    pass = StreamTest(iterations);
+    pass = FuzzTest(iterations * 20) && pass;
+    ThroughputTest();
+    pass = ResyncTest() && pass;
+    pass = MidiOutTest() && pass;
+
+    return  pass ? 0 : 1;
+}
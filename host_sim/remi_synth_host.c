@@ -0,0 +1,736 @@
+/*
+ * ================================================================================================
+ *
+ * Module:       remi_synth_host.c
+ *
+ * Overview:     Off-line renderer and benchmark harness for the REMI synth engine, built
+ *               for a host PC (Linux).  The platform-independent firmware modules (synth
+ *               engine, patch data, config and wave-table creator) are linked against the
+ *               stubs in host_stubs.c.
+ *
+ *               For each patch defined in g_PatchProgram[], a fixed MIDI note sequence is
+ *               played and the audio output is written to a WAV file (16-bit mono PCM at
+ *               the configured sample rate, or as given by option -r).  Execution time is
+ *               measured using the same core-timer instrumentation as the firmware
+ *               ('diag -a'), giving samples per second, nanoseconds per sample and a cost
+ *               breakdown by processing stage:
+ *                 control  = SynthProcess() (1ms task: envelopes, modulation, etc)
+ *                 voices   = RenderVoice() for all active voices
+ *                 master   = mix limiter, level adjust and reverb
+ *               The reverb cost (per-stage profile, PROFILE_REVERB) is also shown separately,
+ *               in ns and host CPU cycles per sample, with the reverb delay-line RAM usage.
+ *
+ *               With option -c, the output of each patch is compared against a reference WAV
+ *               file of the same name in the given directory, e.g. rendered by a build with
+ *               32-bit reverb delay lines (make test-reverb16), using the same options -p, -m
+ *               and -i.  The maximum difference is reported in 12-bit DAC steps;  the exit
+ *               status is 1 if it is one step or more.
+ *
+ *               With option -k, the exit status is 1 if any block was clipped, e.g. where the
+ *               voices of the 4-note chord in the sequence overload the mixer (make test-chord).
+ *
+ *               With option -i a, the patches are rendered once for each wave-table
+ *               interpolation mode (truncate, linear, Hermite) and the cost of each mode
+ *               is compared, so that quality can be traded against voice count.
+ *
+ *               With option -s, the patch switch time (SynthPatchSelect) is measured instead,
+ *               for a first pass through all patches (wave-table analysis cache cold), a
+ *               second pass, and switching back and forth between adjacent patches.
+ *
+ *               With option -t, a preset change is made while a note is held, for each
+ *               pair of adjacent patches, both abruptly (SynthPatchSelect) and with a
+ *               crossfade (SynthPatchTransition).  Output discontinuities ("clicks") caused
+ *               by the change are detected and reported.
+ *
+ * Usage:        remi_synth_host [-o <dir>] [-p <patch>] [-m <mode>] [-i <interp>] [-n]
+ *                               [-c <dir>] [-s] [-t] [-r <kHz>] [-k]
+ *                 -o <dir>     WAV file output directory (default: current dir)
+ *                 -p <patch>   render only the given patch ID number
+ *                 -m <mode>    MIDI IN mode 1..4 (default 1: Omni-On-Poly)
+ *                 -i <interp>  oscillator interpolation 0:Truncate, 1:Linear, 2:Hermite,
+ *                              or 'a' to benchmark all modes (default: config setting)
+ *                 -n           no WAV output (benchmark only)
+ *                 -c <dir>     compare output with reference WAV files in <dir>
+ *                 -s           benchmark patch switching only
+ *                 -t           test preset change transitions only
+ *                 -r <kHz>     audio sample rate 32, 40 or 48 kHz (default: config setting)
+ *                 -k           exit status 1 if clipping is detected
+ *
+ * ================================================================================================
+ */
+#include <unistd.h>
+#include "../mp_remi_synth_mk2.X/remi_synth_main.h"
+
+#define SEQUENCE_LENGTH_MS    3000    // Duration of note sequence, incl. release tail
+#define WAV_PATH_MAX_LEN       256
+#define WAV_HEADER_SIZE         44    // bytes, as written by WavFileClose()
+#define DAC_STEP_PCM            16    // 12-bit DAC step in 16-bit PCM units
+
+typedef struct Host_note_event
+{
+    uint16  Time_ms;          // Event time from start of sequence (ms)
+    uint8   NoteNum;          // MIDI note number
+    uint8   Velocity;         // Note-On velocity; 0 => Note-Off
+
+} HostNoteEvent_t;
+
+typedef struct Host_render_stats
+{
+    uint64  Samples;          // Number of samples rendered
+    uint64  VoiceSamples;     // Sum over blocks of (voices rendered * block size)
+    uint64  ControlCount;     // SynthProcess() time (core timer counts)
+    uint64  VoiceCount;       // Voice render time (core timer counts)
+    uint64  MasterCount;      // Master stage time (core timer counts)
+    uint64  ReverbCount;      // Reverb time, profiled blocks (core timer counts)
+    uint64  ReverbSamples;    // Number of samples in profiled blocks
+    uint64  VoiceDspCount;    // Voice DSP time, excl. oscillators (core timer counts)
+    int     MaxVoices;        // Max. number of voices rendered in one block
+    int     ClippedBlocks;    // Number of blocks with clipping detected
+    uint64  RefSamples;       // Number of samples compared with reference file
+    int     MaxRefError;      // Max. difference from reference (16-bit PCM units)
+
+} HostRenderStats_t;
+
+// Single note, then a legato pair, then a 4-note chord (uses the voice pool in poly mode)
+PRIVATE  const  HostNoteEvent_t  m_NoteSequence[] =
+{
+    {    0, 60, 100 },  {  400, 60,   0 },
+    {  500, 64,  80 },  {  700, 67,  80 },  {  900, 64,   0 },  {  900, 67,   0 },
+    { 1000, 60, 100 },  { 1000, 64, 100 },  { 1000, 67, 100 },  { 1000, 72, 100 },
+    { 2200, 60,   0 },  { 2200, 64,   0 },  { 2200, 67,   0 },  { 2200, 72,   0 },
+};
+
+extern  volatile  bool    v_SynthEnable;
+extern  volatile  bool    v_Clipping;
+extern  volatile  uint32  v_ISRexecTime;
+extern  volatile  uint32  v_VoiceRenderTime;
+extern  volatile  uint8   v_VoicesRendered;
+extern  volatile  uint32  v_SampleClock;
+
+extern  double  HostCpuCyclesPerNs(void);
+
+PRIVATE  int    RenderAllPatches(int patchID, char *outDir, bool writeWav,
+                                 HostRenderStats_t *pTotals);
+PRIVATE  void   CompareInterpModes(int patchID);
+PRIVATE  void   PatchSwitchBenchmark(void);
+PRIVATE  void   ReportSwitchTime(char *label);
+PRIVATE  void   PresetChangeTest(void);
+PRIVATE  void   RenderSteps(int numMs, int32 *maxStep);
+PRIVATE  void   RenderPatch(int patchIdx, FILE *wavFile, FILE *refFile,
+                            HostRenderStats_t *pStats);
+PRIVATE  void   ReportStats(char *label, HostRenderStats_t *pStats);
+PRIVATE  void   AccumulateStats(HostRenderStats_t *pTotal, HostRenderStats_t *pStats);
+PRIVATE  FILE  *WavFileOpen(char *path);
+PRIVATE  void   WavFileClose(FILE *wavFile, uint32 numSamples);
+PRIVATE  void   PutLE(FILE *fp, uint32 value, int nbytes);
+
+PRIVATE  double  m_CyclesPerNs;       // Host CPU cycles per ns (0 if unknown)
+PRIVATE  char   *m_RefDir;            // Reference WAV file directory (NULL => no compare)
+
+
+int  main(int argc, char *argv[])
+{
+    char   *outDir = ".";
+    int     patchID = -1;             // -1 => all patches
+    int     midiMode = OMNI_ON_POLY;
+    int     interpMode = -1;          // -1 => config default; 3 => compare all modes
+    bool    writeWav = TRUE;
+    bool    switchBench = FALSE;
+    bool    changeTest = FALSE;
+    bool    clipCheck = FALSE;
+    int     rate_kHz = 0;             // 0 => config default
+    int     opt;
+    HostRenderStats_t  totals;
+
+    while ((opt = getopt(argc, argv, "o:p:m:i:nc:str:k")) != -1)
+    {
+        if (opt == 'o')  outDir = optarg;
+        else if (opt == 'p')  patchID = atoi(optarg);
+        else if (opt == 'm')  midiMode = atoi(optarg);
+        else if (opt == 'i')  interpMode = (optarg[0] == 'a') ? 3 : atoi(optarg);
+        else if (opt == 'n')  writeWav = FALSE;
+        else if (opt == 'c')  m_RefDir = optarg;
+        else if (opt == 's')  switchBench = TRUE;
+        else if (opt == 't')  changeTest = TRUE;
+        else if (opt == 'r')  rate_kHz = atoi(optarg);
+        else if (opt == 'k')  clipCheck = TRUE;
+        else
+        {
+            fprintf(stderr, "Usage: %s [-o <dir>] [-p <patch>] [-m <mode>] [-i <interp>] [-n]"
+                    " [-c <dir>] [-s] [-t] [-r <kHz>] [-k]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (midiMode < OMNI_ON_POLY || midiMode > OMNI_OFF_MONO)
+    {
+        fprintf(stderr, "! MIDI IN mode must be 1..4\n");
+        return 1;
+    }
+
+    DefaultPresetData();              // EEPROM is blank -- load "factory" defaults
+    DefaultConfigData();
+    g_Config.MidiInMode = midiMode;
+    g_Config.AudioAmpldControlMode = AMPLD_CTRL_ENV_VELO;  // no expression input
+
+    if (rate_kHz == 32 || rate_kHz == 40 || rate_kHz == 48)
+        g_Config.SampleRate_kHz = rate_kHz;   // instated by SynthPrepare()
+    else if (rate_kHz != 0)
+    {
+        fprintf(stderr, "! Sample rate must be 32, 40 or 48 (kHz)\n");
+        return 1;
+    }
+
+    g_ExpressionCalibr = g_Config.ExpressionCalibr;  // Init settable parameters
+    g_FilterInputAtten = g_Config.FilterInputAtten;
+    g_FilterOutputGain = g_Config.FilterOutputGain;
+    g_NoiseFilterGain = g_Config.NoiseFilterGain;
+    m_CyclesPerNs = HostCpuCyclesPerNs();
+
+    if (switchBench)
+    {
+        PatchSwitchBenchmark();
+        return 0;
+    }
+    if (changeTest)
+    {
+        PresetChangeTest();
+        return 0;
+    }
+    if (interpMode == 3)
+    {
+        CompareInterpModes(patchID);
+        return 0;
+    }
+    if (interpMode >= OSC_INTERP_TRUNCATE && interpMode <= OSC_INTERP_HERMITE)
+    {
+        g_Config.Osc1InterpMode = interpMode;
+        g_Config.Osc2InterpMode = interpMode;
+    }
+    else if (interpMode != -1)
+    {
+        fprintf(stderr, "! Interpolation mode must be 0..2 or 'a'\n");
+        return 1;
+    }
+
+    printf("REMI synth host renderer -- %d Hz, block size %d, %d voices max, MIDI mode %d\n\n",
+           g_Config.SampleRate_kHz * 1000, AUDIO_BLOCK_SIZE, SYNTH_VOICES_MAX, midiMode);
+
+    if (RenderAllPatches(patchID, outDir, writeWav, &totals) != SUCCESS)  return 1;
+
+    ReportStats("All patches", &totals);
+
+    if (m_RefDir != NULL && totals.MaxRefError >= DAC_STEP_PCM)  return 1;
+    if (clipCheck && totals.ClippedBlocks != 0)
+    {
+        fprintf(stderr, "! Clipping detected in %d blocks\n", totals.ClippedBlocks);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/*
+ * Function:     Render the note sequence with each patch (or the given patch ID only),
+ *               listing the cost of each patch and accumulating statistics in pTotals.
+ *               If writeWav is TRUE, a WAV file is written for each patch in outDir.
+ *
+ * Return val:   ERROR if a WAV file could not be created (or a reference file opened),
+ *               or the patch ID was not found, otherwise SUCCESS.
+ */
+PRIVATE  int  RenderAllPatches(int patchID, char *outDir, bool writeWav,
+                               HostRenderStats_t *pTotals)
+{
+    char    wavPath[WAV_PATH_MAX_LEN];
+    char    refPath[WAV_PATH_MAX_LEN];
+    char    patchName[24];
+    int     i, c;
+    FILE   *wavFile;
+    FILE   *refFile;
+    HostRenderStats_t  stats;
+
+    printf("Patch  Name                   ns/sample  voices  clip  file\n");
+
+    memset(pTotals, 0, sizeof(HostRenderStats_t));
+
+    for (i = 0;  i < GetNumberOfPatchesDefined();  i++)
+    {
+        if (patchID >= 0 && g_PatchProgram[i].PatchNumber != patchID)  continue;
+
+        // Make a file-name-safe copy of the patch name
+        for (c = 0;  c < 20 && g_PatchProgram[i].PatchName[c] != 0;  c++)
+        {
+            patchName[c] = g_PatchProgram[i].PatchName[c];
+            if (!isalnum((int) patchName[c]))  patchName[c] = '_';
+        }
+        patchName[c] = 0;
+
+        wavFile = NULL;
+        if (writeWav)
+        {
+            snprintf(wavPath, sizeof(wavPath), "%s/patch_%03d_%s.wav",
+                     outDir, g_PatchProgram[i].PatchNumber, patchName);
+            wavFile = WavFileOpen(wavPath);
+            if (wavFile == NULL)
+            {
+                fprintf(stderr, "! Cannot create file: %s\n", wavPath);
+                return ERROR;
+            }
+        }
+
+        refFile = NULL;
+        if (m_RefDir != NULL)
+        {
+            snprintf(refPath, sizeof(refPath), "%s/patch_%03d_%s.wav",
+                     m_RefDir, g_PatchProgram[i].PatchNumber, patchName);
+            refFile = fopen(refPath, "rb");
+            if (refFile == NULL || fseek(refFile, WAV_HEADER_SIZE, SEEK_SET) != 0)
+            {
+                fprintf(stderr, "! Cannot read reference file: %s\n", refPath);
+                return ERROR;
+            }
+        }
+
+        RenderPatch(i, wavFile, refFile, &stats);
+
+        if (wavFile != NULL)  WavFileClose(wavFile, (uint32) stats.Samples);
+        if (refFile != NULL)  fclose(refFile);
+
+        printf("%5d  %-20s  %9.1f  %6d  %4d  %s\n", g_PatchProgram[i].PatchNumber,
+               g_PatchProgram[i].PatchName,
+               ((stats.ControlCount + stats.VoiceCount + stats.MasterCount) * 25.0) / stats.Samples,
+               stats.MaxVoices, stats.ClippedBlocks, writeWav ? wavPath : "-");
+
+        AccumulateStats(pTotals, &stats);
+    }
+
+    if (pTotals->Samples == 0)
+    {
+        fprintf(stderr, "! Patch ID %d not found\n", patchID);
+        return ERROR;
+    }
+
+    return SUCCESS;
+}
+
+
+/*
+ * Function:     Benchmark the wave-table oscillator interpolation modes.
+ *
+ * The patches are rendered (without WAV output) once for each mode, with both oscillators
+ * set to the same mode.  Voice render cost is reported per voice-sample, in ns and in host
+ * CPU cycles (time-stamp counter, x86 hosts only), and relative to truncation.
+ * The relative cost applies approximately to the target, where the absolute per-voice
+ * render time is shown by the 'diag -a' command.
+ */
+PRIVATE  void  CompareInterpModes(int patchID)
+{
+    static char *modeName[] = { "Truncate", "Linear", "Hermite" };
+    HostRenderStats_t  totals[3];
+    double  voiceNs[3];
+    double  cyclesPerNs = m_CyclesPerNs;
+    int     mode;
+
+    for (mode = OSC_INTERP_TRUNCATE;  mode <= OSC_INTERP_HERMITE;  mode++)
+    {
+        g_Config.Osc1InterpMode = mode;
+        g_Config.Osc2InterpMode = mode;
+        printf("\nInterpolation mode %d (%s)\n", mode, modeName[mode]);
+        if (RenderAllPatches(patchID, NULL, FALSE, &totals[mode]) != SUCCESS)  return;
+        voiceNs[mode] = (totals[mode].VoiceCount * 25.0) / totals[mode].VoiceSamples;
+    }
+
+    printf("\nInterpolation   ns/voice-sample   cycles/voice-sample   relative\n");
+    for (mode = OSC_INTERP_TRUNCATE;  mode <= OSC_INTERP_HERMITE;  mode++)
+    {
+        if (cyclesPerNs != 0)
+            printf("%d  %-10s  %15.1f  %20.1f  %9.2f\n", mode, modeName[mode], voiceNs[mode],
+                   voiceNs[mode] * cyclesPerNs, voiceNs[mode] / voiceNs[OSC_INTERP_TRUNCATE]);
+        else  printf("%d  %-10s  %15.1f  %20s  %9.2f\n", mode, modeName[mode], voiceNs[mode],
+                     "-", voiceNs[mode] / voiceNs[OSC_INTERP_TRUNCATE]);
+    }
+}
+
+
+/*
+ * Function:     Benchmark patch switching, i.e. SynthPatchSelect() incl. SynthPrepare().
+ *
+ * The switch time is taken from the engine profile (stage PROFILE_PATCH_SWITCH).
+ * The first pass selects each patch in turn, starting with the wave-table analysis cache
+ * empty;  the second pass repeats the sequence (the cache holds only the most recently
+ * used tables).  Then each pair of adjacent patches is selected alternately, as when
+ * switching between two presets in performance, where the analyses are cached.
+ */
+PRIVATE  void  PatchSwitchBenchmark(void)
+{
+    int   numPatches = GetNumberOfPatchesDefined();
+    int   i, n;
+
+    printf("REMI synth host -- patch switch time (%d patches)\n\n", numPatches);
+    printf("Sequence                Count    Min(us)   Mean(us)    Max(us)\n");
+
+    ProfileReset();
+    for (i = 0;  i < numPatches;  i++)  SynthPatchSelect(g_PatchProgram[i].PatchNumber);
+    ReportSwitchTime("First pass (cold)");
+
+    ProfileReset();
+    for (i = 0;  i < numPatches;  i++)  SynthPatchSelect(g_PatchProgram[i].PatchNumber);
+    ReportSwitchTime("Second pass");
+
+    ProfileReset();
+    for (i = 0;  i + 1 < numPatches;  i++)
+    {
+        for (n = 0;  n < 4;  n++)
+        {
+            SynthPatchSelect(g_PatchProgram[i].PatchNumber);
+            SynthPatchSelect(g_PatchProgram[i + 1].PatchNumber);
+        }
+    }
+    ReportSwitchTime("Adjacent pairs A/B");
+}
+
+
+PRIVATE  void  ReportSwitchTime(char *label)
+{
+    ProfileStage_t  stats;
+
+    ProfileGetStage(PROFILE_PATCH_SWITCH, &stats);
+    if (stats.Count == 0)  return;
+
+    printf("%-20s %8u %10.1f %10.1f %10.1f\n", label, (unsigned) stats.Count,
+           stats.Min / 40.0, ((double) stats.Total / stats.Count) / 40.0, stats.Max / 40.0);
+}
+
+
+/*
+ * Function:     Test preset change transitions, with a note held.
+ *
+ * For each pair of adjacent patches (A, B), a note is started on patch A and, after
+ * CHANGE_TIME_MS, the patch is changed to B, either abruptly by SynthPatchSelect(), or
+ * by SynthPatchTransition() with the configured crossfade time.  A click is a step between
+ * consecutive output samples larger than occurs in the normal sound of either patch, i.e.
+ * the largest step in the CHANGE_WINDOW_MS following the change is compared with the
+ * largest step in the 50ms before the change (patch A) and in the first CHANGE_WINDOW_MS
+ * of the same note started on patch B (incl. its attack).  A ratio of 1.5 or more is
+ * counted as a click.
+ */
+#define CHANGE_TIME_MS      300    // Time of patch change after note-on
+#define CHANGE_WINDOW_MS     80    // Duration of click detection window after change
+
+PRIVATE  void  PresetChangeTest(void)
+{
+    static char *modeName[] = { "Abrupt (SynthPatchSelect)", "Crossfade (SynthPatchTransition)" };
+    int32   maxStep[CHANGE_TIME_MS + CHANGE_WINDOW_MS];  // per ms
+    int     numPatches = GetNumberOfPatchesDefined();
+    int     mode, i, t, pairs, clicks;
+    int32   normal, change;
+    double  ratio, sumRatio, worst;
+
+    printf("REMI synth host -- preset change with note held (crossfade time %d ms)\n\n",
+           g_Config.PatchFadeTime_ms);
+    printf("Change mode                        Pairs  Clicks  Mean ratio  Max ratio\n");
+
+    for (mode = 0;  mode < 2;  mode++)
+    {
+        pairs = 0;  clicks = 0;  sumRatio = 0;  worst = 0;
+
+        for (i = 0;  i + 1 < numPatches;  i++)
+        {
+            // Reference:  note started on patch B
+            memset(ReverbDelayLine, 0, REVERB_DELAY_MAX_SIZE * sizeof(reverb_t));
+            SynthPatchSelect(g_PatchProgram[i + 1].PatchNumber);
+            SynthPostEvent(SYNTH_EVENT_NOTE_ON, 60, 100, v_SampleClock);
+            RenderSteps(CHANGE_WINDOW_MS, maxStep);
+            SynthNoteOff(0);
+            normal = 0;
+            for (t = 0;  t < CHANGE_WINDOW_MS;  t++)
+            {
+                if (maxStep[t] > normal)  normal = maxStep[t];
+            }
+
+            // Note started on patch A, then changed to patch B
+            memset(ReverbDelayLine, 0, REVERB_DELAY_MAX_SIZE * sizeof(reverb_t));
+            SynthPatchSelect(g_PatchProgram[i].PatchNumber);
+            SynthPostEvent(SYNTH_EVENT_NOTE_ON, 60, 100, v_SampleClock);
+            RenderSteps(CHANGE_TIME_MS, maxStep);
+
+            if (mode == 0)  SynthPatchSelect(g_PatchProgram[i + 1].PatchNumber);
+            else  SynthPatchTransition(g_PatchProgram[i + 1].PatchNumber);
+            RenderSteps(CHANGE_WINDOW_MS, &maxStep[CHANGE_TIME_MS]);
+            SynthNoteOff(0);
+
+            change = 0;
+            for (t = CHANGE_TIME_MS - 50;  t < CHANGE_TIME_MS;  t++)
+            {
+                if (maxStep[t] > normal)  normal = maxStep[t];
+            }
+            for (t = CHANGE_TIME_MS;  t < CHANGE_TIME_MS + CHANGE_WINDOW_MS;  t++)
+            {
+                if (maxStep[t] > change)  change = maxStep[t];
+            }
+            if (normal == 0)  continue;  // both patches silent
+
+            ratio = (double) change / normal;
+            if (ratio >= 1.5)  clicks++;
+            if (ratio > worst)  worst = ratio;
+            sumRatio += ratio;
+            pairs++;
+        }
+
+        if (pairs != 0)
+            printf("%-32s %7d %7d %11.2f %10.2f\n", modeName[mode], pairs, clicks,
+                   sumRatio / pairs, worst);
+    }
+}
+
+
+/*
+ * Function:     Render numMs milliseconds of audio, running the 1ms control task ahead of
+ *               each millisecond, and store the largest step between consecutive output
+ *               samples (16-bit PCM units) in each ms in maxStep[].
+ */
+PRIVATE  void  RenderSteps(int numMs, int32 *maxStep)
+{
+    static  int32  lastPcm;
+    fixed_t  outBuf[SAMPLE_RATE_MAX_HZ / 1000];
+    int      samplesPerMs = SynthSampleRate() / 1000;
+    int32    pcm;
+    int      ms, isam;
+
+    for (ms = 0;  ms < numMs;  ms++)
+    {
+        SynthProcess();
+        SynthRenderBlock(outBuf, samplesPerMs);
+
+        maxStep[ms] = 0;
+        for (isam = 0;  isam < samplesPerMs;  isam++)
+        {
+            pcm = outBuf[isam] >> 5;  // 12:20 fixed-pt -> 16-bit PCM
+            if (abs(pcm - lastPcm) > maxStep[ms])  maxStep[ms] = abs(pcm - lastPcm);
+            lastPcm = pcm;
+        }
+    }
+}
+
+
+/*
+ * Function:     Render the note sequence using the patch at index patchIdx in g_PatchProgram[].
+ *
+ * The control process, SynthProcess(), is called once per millisecond of simulated time,
+ * ahead of the audio block which spans the millisecond boundary, as would occur on the
+ * target where the 1ms task and the block render ISR run asynchronously.
+ * Note events are posted ahead of the block in which they are due, scheduled at the exact
+ * sample of the event time, so the renderer applies them with sample accuracy.
+ * Output samples are written to wavFile, unless wavFile is NULL, and compared with the
+ * samples read from refFile, unless refFile is NULL.
+ */
+PRIVATE  void  RenderPatch(int patchIdx, FILE *wavFile, FILE *refFile,
+                           HostRenderStats_t *pStats)
+{
+    fixed_t  outBuf[AUDIO_BLOCK_SIZE];
+    uint32   samplesPerMs;
+    uint32   totalSamples;
+    uint32   sampleCount = 0;
+    uint32   msCount = 0;
+    uint32   seqStartClock;
+    uint32   eventSample;
+    uint32   startTime, CC_Reg;
+    ProfileStage_t  reverbStats;
+    ProfileStage_t  voiceDspStats;
+    int      evIdx = 0;
+    int      isam;
+    int32    pcm;
+    int32    refPcm;
+    int      lo, hi;
+
+    memset(pStats, 0, sizeof(HostRenderStats_t));
+    memset(ReverbDelayLine, 0, REVERB_DELAY_MAX_SIZE * sizeof(reverb_t));
+
+    SynthPatchSelect(g_PatchProgram[patchIdx].PatchNumber);
+    samplesPerMs = SynthSampleRate() / 1000;
+    totalSamples = SEQUENCE_LENGTH_MS * samplesPerMs;
+    seqStartClock = v_SampleClock;
+    ProfileReset();
+
+    while (sampleCount < totalSamples)
+    {
+        // Post the note events which are due in this block
+        while (evIdx < (int) ARRAY_SIZE(m_NoteSequence))
+        {
+            eventSample = m_NoteSequence[evIdx].Time_ms * samplesPerMs;
+            if (eventSample >= sampleCount + AUDIO_BLOCK_SIZE)  break;
+
+            if (m_NoteSequence[evIdx].Velocity != 0)
+                SynthPostEvent(SYNTH_EVENT_NOTE_ON, m_NoteSequence[evIdx].NoteNum,
+                               m_NoteSequence[evIdx].Velocity, seqStartClock + eventSample);
+            else  SynthPostEvent(SYNTH_EVENT_NOTE_OFF, m_NoteSequence[evIdx].NoteNum,
+                                 0, seqStartClock + eventSample);
+            evIdx++;
+        }
+
+        // Run the 1ms control task for each ms boundary up to the start of this block
+        while (msCount * samplesPerMs <= sampleCount)
+        {
+            READ_CPU_CORE_COUNT_REG(startTime);
+            SynthProcess();
+            READ_CPU_CORE_COUNT_REG(CC_Reg);
+            pStats->ControlCount += CC_Reg - startTime;
+            msCount++;
+        }
+
+        v_Clipping = FALSE;
+        SynthRenderBlock(outBuf, AUDIO_BLOCK_SIZE);
+
+        pStats->VoiceCount += v_VoiceRenderTime;
+        pStats->MasterCount += v_ISRexecTime - v_VoiceRenderTime;
+        pStats->VoiceSamples += v_VoicesRendered * AUDIO_BLOCK_SIZE;
+        if (v_VoicesRendered > pStats->MaxVoices)  pStats->MaxVoices = v_VoicesRendered;
+        if (v_Clipping)  pStats->ClippedBlocks++;
+
+        for (isam = 0;  isam < AUDIO_BLOCK_SIZE;  isam++)
+        {
+            pcm = outBuf[isam] >> 5;  // 12:20 fixed-pt -> 16-bit PCM
+            if (pcm > 32767)  pcm = 32767;
+            if (pcm < -32768)  pcm = -32768;
+            if (wavFile != NULL)  PutLE(wavFile, (uint32) pcm, 2);
+
+            if (refFile != NULL && (lo = fgetc(refFile)) != EOF && (hi = fgetc(refFile)) != EOF)
+            {
+                refPcm = (int16) (lo | (hi << 8));
+                if (abs(pcm - refPcm) > pStats->MaxRefError)
+                    pStats->MaxRefError = abs(pcm - refPcm);
+                pStats->RefSamples++;
+            }
+        }
+
+        sampleCount += AUDIO_BLOCK_SIZE;
+    }
+
+    SynthNoteOff(0);  // Release all voices
+    pStats->Samples = sampleCount;
+
+    ProfileGetStage(PROFILE_REVERB, &reverbStats);
+    pStats->ReverbCount = reverbStats.Total;
+    pStats->ReverbSamples = (uint64) reverbStats.Count * AUDIO_BLOCK_SIZE;
+    ProfileGetStage(PROFILE_VOICE_DSP, &voiceDspStats);
+    pStats->VoiceDspCount = voiceDspStats.Total;
+}
+
+
+PRIVATE  void  AccumulateStats(HostRenderStats_t *pTotal, HostRenderStats_t *pStats)
+{
+    pTotal->Samples += pStats->Samples;
+    pTotal->VoiceSamples += pStats->VoiceSamples;
+    pTotal->ControlCount += pStats->ControlCount;
+    pTotal->VoiceCount += pStats->VoiceCount;
+    pTotal->MasterCount += pStats->MasterCount;
+    pTotal->ReverbCount += pStats->ReverbCount;
+    pTotal->ReverbSamples += pStats->ReverbSamples;
+    pTotal->VoiceDspCount += pStats->VoiceDspCount;
+    pTotal->ClippedBlocks += pStats->ClippedBlocks;
+    pTotal->RefSamples += pStats->RefSamples;
+    if (pStats->MaxRefError > pTotal->MaxRefError)  pTotal->MaxRefError = pStats->MaxRefError;
+    if (pStats->MaxVoices > pTotal->MaxVoices)  pTotal->MaxVoices = pStats->MaxVoices;
+}
+
+
+/*
+ * Function:     Print throughput and per-stage cost summary.
+ *               Core timer counts are converted to ns (25ns per count).
+ *               The reverb cost (included in master) is per sample of the profiled blocks,
+ *               i.e. those in which voices were rendered.
+ *               The voice DSP cost (mixer, noise, filter and output gain, i.e. the per-voice
+ *               cost excluding the oscillators) is per voice-sample.
+ */
+PRIVATE  void  ReportStats(char *label, HostRenderStats_t *pStats)
+{
+    double  totalNs = (pStats->ControlCount + pStats->VoiceCount + pStats->MasterCount) * 25.0;
+    double  samples = (double) pStats->Samples;
+    double  periodNs = 1.0e9 / SynthSampleRate();   // sample period (ns)
+    double  reverbNs;
+    double  voiceDspNs;
+
+    printf("\n%s: %llu samples in %.3f ms\n", label,
+           (unsigned long long) pStats->Samples, totalNs / 1.0e6);
+    printf("  Throughput:   %.0f samples/s  (%.1f x real-time)\n",
+           samples * 1.0e9 / totalNs, (samples * periodNs) / totalNs);
+    printf("  Cost:         %.1f ns/sample\n", totalNs / samples);
+    printf("  Stage          ns/sample   share\n");
+    printf("  control       %10.1f  %5.1f %%\n", pStats->ControlCount * 25.0 / samples,
+           pStats->ControlCount * 2500.0 / totalNs);
+    printf("  voices        %10.1f  %5.1f %%\n", pStats->VoiceCount * 25.0 / samples,
+           pStats->VoiceCount * 2500.0 / totalNs);
+    printf("  master        %10.1f  %5.1f %%\n", pStats->MasterCount * 25.0 / samples,
+           pStats->MasterCount * 2500.0 / totalNs);
+    if (pStats->VoiceSamples != 0)
+        printf("  Per voice:    %.1f ns/sample  (max. %d voices rendered)\n",
+               pStats->VoiceCount * 25.0 / pStats->VoiceSamples, pStats->MaxVoices);
+    if (pStats->VoiceSamples != 0)
+    {
+        voiceDspNs = pStats->VoiceDspCount * 25.0 / pStats->VoiceSamples;
+        printf("  Voice DSP:    %.1f ns/sample", voiceDspNs);
+        if (m_CyclesPerNs != 0)  printf(", %.1f cycles/sample", voiceDspNs * m_CyclesPerNs);
+        printf("  (mixer, noise, filter, output gain)\n");
+    }
+    if (pStats->ReverbSamples != 0)
+    {
+        reverbNs = pStats->ReverbCount * 25.0 / pStats->ReverbSamples;
+        printf("  Reverb:       %.1f ns/sample", reverbNs);
+        if (m_CyclesPerNs != 0)  printf(", %.1f cycles/sample", reverbNs * m_CyclesPerNs);
+        printf("  (%d-line FDN, %d bytes delay RAM)\n", REVERB_FDN_LINES,
+               (int) (REVERB_DELAY_MAX_SIZE * sizeof(ReverbDelayLine[0])));
+    }
+    printf("  Clipped blocks: %d\n", pStats->ClippedBlocks);
+    if (m_RefDir != NULL)
+        printf("  Reference:    max. error %.2f DAC steps (12-bit) over %llu samples -- %s\n",
+               (double) pStats->MaxRefError / DAC_STEP_PCM, (unsigned long long) pStats->RefSamples,
+               (pStats->MaxRefError < DAC_STEP_PCM) ? "PASS" : "FAIL");
+}
+
+
+//=================================================================================================
+//                        WAV file output (16-bit mono PCM, little-endian)
+//
+PRIVATE  FILE  *WavFileOpen(char *path)
+{
+    FILE  *fp = fopen(path, "wb");
+
+    if (fp != NULL)  WavFileClose(fp, 0);  // write header with placeholder sizes
+
+    return  fp;
+}
+
+/*
+ * Function:     Write (or re-write) the WAV file header with the given data size.
+ *               If numSamples is non-zero, the file is closed.
+ */
+PRIVATE  void  WavFileClose(FILE *wavFile, uint32 numSamples)
+{
+    uint32  dataBytes = numSamples * 2;
+
+    fseek(wavFile, 0, SEEK_SET);
+    fwrite("RIFF", 1, 4, wavFile);
+    PutLE(wavFile, 36 + dataBytes, 4);
+    fwrite("WAVEfmt ", 1, 8, wavFile);
+    PutLE(wavFile, 16, 4);                    // fmt chunk size
+    PutLE(wavFile, 1, 2);                     // PCM
+    PutLE(wavFile, 1, 2);                     // mono
+    PutLE(wavFile, SynthSampleRate(), 4);
+    PutLE(wavFile, SynthSampleRate() * 2, 4);  // byte rate
+    PutLE(wavFile, 2, 2);                     // block align
+    PutLE(wavFile, 16, 2);                    // bits per sample
+    fwrite("data", 1, 4, wavFile);
+    PutLE(wavFile, dataBytes, 4);
+
+    if (numSamples != 0)  fclose(wavFile);
+}
+
+PRIVATE  void  PutLE(FILE *fp, uint32 value, int nbytes)
+{
+    while (nbytes-- > 0)
+    {
+        fputc(value & 0xFF, fp);
+        value >>= 8;
+    }
+}
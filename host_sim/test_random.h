@@ -0,0 +1,34 @@
+/*
+ * ================================================================================================
+ *
+ * Module:       test_random.h
+ *
+ * Overview:     Pseudo-random number generator (xorshift32) shared by the host simulator
+ *               tests.  The sequence depends only on the seed (test option -s), so a test
+ *               failure can be reproduced on any host.
+ *
+ * ================================================================================================
+ */
+#ifndef TEST_RANDOM_H
+#define TEST_RANDOM_H
+
+static  uint32  m_RandomState = 1;         // Generator state (never 0)
+
+
+static inline  void  RandomSeed(uint32 seed)
+{
+    m_RandomState = seed | 1;
+}
+
+static inline  uint32  Random(void)        // xorshift32
+{
+    m_RandomState ^= m_RandomState << 13;
+    m_RandomState ^= m_RandomState >> 17;
+    m_RandomState ^= m_RandomState << 5;
+    return  m_RandomState;
+}
+
+static inline  uint32  RandomRange(uint32 n)  { return  Random() % n; }
+
+
+#endif // TEST_RANDOM_H
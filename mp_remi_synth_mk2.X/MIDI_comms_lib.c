@@ -6,11 +6,72 @@
  * 
  * It is highly recommended to enable interrupt-driven input and queued output to
  * prevent blocking of time-critical application functions.
+ *
+ * MIDI OUT messages are not written directly to the UART;  they are held in the MIDI OUT
+ * queue and released one at a time by MIDI_OutputService(), when the UART TX queue is
+ * empty.  While a message is waiting, a newer value for the same controller replaces it
+ * (see OutQueuePut), unless that would move the value ahead of a note, program change or
+ * other order-dependent message, so the output tracks the latest controller values with
+ * bounded latency, even when the link is saturated.
  * 
  * ================================================================================================
  */
+#include "../Drivers/HardwareProfile.h"   // UART driver build options
 #include "MIDI_comms_lib.h"
 
+PRIVATE  void  ParserMessageHandler(const MidiMessage_t *pMsg);
+PRIVATE  void  ParserSysExHandler(const uint8 *data, int length, uint8 flags, uint32 timestamp);
+
+// MIDI IN parser state -- accessed only by MIDI_ParserInput() (UART RX IRQ context)
+static  MidiParser_t  m_InputParser = { .MsgHandler = ParserMessageHandler,
+                                        .SysExHandler = ParserSysExHandler };
+static  uint8   m_SysExBuffer[MIDI_MSG_MAX_LENGTH];  // Sys.Ex. msg being received
+static  uint8   m_SysExLength;
+static  bool    m_SysExTooLong;              // Flag: Sys.Ex. msg being received is too long
+
+// Single-producer, single-consumer event queue (lock-free)...
+// The producer (parser) writes only m_EventQueueTail;  the consumer writes only
+// m_EventQueueHead.  An event is written into the queue before the tail index is advanced,
+// so the consumer never sees a partly written event.
+static  MidiEvent_t      m_EventQueue[MIDI_EVENT_QUEUE_SIZE];
+static  volatile  uint8  m_EventQueueHead;   // Index of next event to be read
+static  volatile  uint8  m_EventQueueTail;   // Index of next free place for writing
+static  volatile  int    m_EventQueueOverflows;  // Events lost -- queue full
+
+// Completed System Exclusive message, handed over from producer to consumer.
+// The producer writes it only when m_SysExReady is FALSE; the consumer clears the flag
+// when it has copied the message.
+static  uint8            m_SysExMessage[MIDI_MSG_MAX_LENGTH];
+static  uint8            m_SysExMessageLength;
+static  volatile  bool   m_SysExReady;
+
+// MIDI OUT message queue (FIFO) -- accessed only in the background (main loop) context.
+// The latest pending (unsent) value of a continuous controller (or pitch bend / channel
+// pressure) may be replaced by a newer value -- see OutQueuePut().
+typedef struct MIDI_output_message
+{
+    uint8   Status;           // Status byte (command + channel)
+    uint8   Data1;            // 1st data byte
+    uint8   Data2;            // 2nd data byte (if any)
+    uint8   Length;           // Message length (bytes), incl. status byte
+
+} MidiOutMsg_t;
+
+static  MidiOutMsg_t  m_OutQueue[MIDI_OUT_QUEUE_SIZE];
+static  uint8   m_OutQueueHead;              // Index of next message to be sent
+static  uint8   m_OutQueueTail;              // Index of next free place for writing
+static  uint8   m_OutQueueMaxDepth;          // Highest queue depth seen (diagnostic)
+static  uint8   m_OutRunningStatus;          // Last status byte sent (0: none)
+static  uint8   m_OutStatusAge;              // Messages sent since the last status byte
+static  uint32  m_OutDropCount;              // Messages lost -- queue full
+static  uint32  m_OutCoalesceCount;          // Unsent messages replaced by newer values
+static  uint32  m_OutStatusBytesSaved;       // Status bytes omitted (running status)
+
+PRIVATE  void  EventQueuePut(const MidiEvent_t *pEvent);
+PRIVATE  void  OutQueuePut(uint8 status, uint8 data1, uint8 data2);
+PRIVATE  bool  OutQueueCanMerge(uint8 status, uint8 data1);
+PRIVATE  void  OutQueueSendNext(void);
+
 
 /*
  * Function:     Transmit MIDI Note-On/Velocity message.
@@ -31,9 +92,7 @@ void  MIDI_SendNoteOn(uint8 chan, uint8 noteNum, uint8 velocity)
 {
     uint8   statusByte = 0x90 | ((chan - 1) & 0xF);
 
-    UART1_putch(statusByte);
-    UART1_putch(noteNum & 0x7F);
-    UART1_putch(velocity & 0x7F);
+    OutQueuePut(statusByte, noteNum & 0x7F, velocity & 0x7F);
 }
 
 
@@ -50,9 +109,7 @@ void  MIDI_SendNoteOff(uint8 chan, uint8 noteNum)
 {
     uint8   statusByte = 0x80 | ((chan - 1) & 0xF);
 
-    UART1_putch(statusByte);
-    UART1_putch(noteNum & 0x7F);
-    UART1_putch(64);
+    OutQueuePut(statusByte, noteNum & 0x7F, 64);
 }
 
 
@@ -66,8 +123,7 @@ void  MIDI_SendAfterTouch(uint8 chan, uint8 level)
 {
     uint8   statusByte = 0xD0 | ((chan - 1) & 0xF);
 
-    UART1_putch(statusByte);
-    UART1_putch(level & 0x7F);
+    OutQueuePut(statusByte, level & 0x7F, 0);
 }
 
 
@@ -81,9 +137,7 @@ void  MIDI_SendPitchBend(uint8 chan, uint16 value)
 {
     uint8   statusByte = 0xE0 | ((chan - 1) & 0xF);
 
-    UART1_putch(statusByte);
-    UART1_putch(value & 0x7F);           // 7 LS bits
-    UART1_putch((value >> 7) & 0x7F);    // 7 MS bits
+    OutQueuePut(statusByte, value & 0x7F, (value >> 7) & 0x7F);  // 7 LS bits, 7 MS bits
 }
 
 
@@ -112,9 +166,7 @@ void  MIDI_SendControlChange(uint8 chan, uint8 ctrlNum, uint8 value)
 {
     uint8   statusByte = 0xB0 | ((chan - 1) & 0xF);
 
-    UART1_putch(statusByte);
-    UART1_putch(ctrlNum & 0x7F);
-    UART1_putch(value & 0x7F);
+    OutQueuePut(statusByte, ctrlNum & 0x7F, value & 0x7F);
 }
 
 
@@ -128,8 +180,7 @@ void  MIDI_SendProgramChange(uint8 chan, uint8 progNum)
 {
     uint8   statusByte = 0xC0 | ((chan - 1) & 0xF);
 
-    UART1_putch(statusByte);
-    UART1_putch(progNum & 0x7F);
+    OutQueuePut(statusByte, progNum & 0x7F, 0);
 }
 
 
@@ -146,31 +197,15 @@ void  MIDI_SendReceiverMode(uint8 chan, uint8 mode)
 {
     uint8   statusByte = 0xB0 | ((chan - 1) & 0xF);
 
-    UART1_putch(statusByte);
-
     if (mode == OMNI_ON_POLY || mode == OMNI_ON_MONO)
-    {
-        UART1_putch(125);   // Omni On
-        UART1_putch(0);
-    }
-    else  // Omni Off
-    {
-        UART1_putch(124);   // Omni Off
-        UART1_putch(0);
-    }
-
-    UART1_putch(statusByte);
+        OutQueuePut(statusByte, 125, 0);   // Omni On
+    else  
+        OutQueuePut(statusByte, 124, 0);   // Omni Off
 
     if (mode == OMNI_ON_POLY || mode == OMNI_OFF_POLY)
-    {
-        UART1_putch(127);   // Poly mode
-        UART1_putch(0);
-    }
+        OutQueuePut(statusByte, 127, 0);   // Poly mode
     else
-    {
-        UART1_putch(126);   // Mono mode (with M = 1)
-        UART1_putch(1);
-    }
+        OutQueuePut(statusByte, 126, 1);   // Mono mode (with M = 1)
 }
 
 
@@ -184,9 +219,7 @@ void  MIDI_SendAllSoundOff(uint8 chan)
 {
     uint8   statusByte = 0xB0 | ((chan - 1) & 0xF);
 
-    UART1_putch(statusByte);
-    UART1_putch(120);
-    UART1_putch(0);
+    OutQueuePut(statusByte, 120, 0);
 }
 
 
@@ -199,42 +232,362 @@ void  MIDI_SendResetAllControllers(uint8 chan)
 {
     uint8   statusByte = 0xB0 | ((chan - 1) & 0xF);
 
-    UART1_putch(statusByte);
-    UART1_putch(121);
-    UART1_putch(0);
+    OutQueuePut(statusByte, 121, 0);
 }
 
 
 /*
- * Function:     Find length of a given MIDI command/status message.
+ * Function:     Put a channel message into the MIDI OUT queue.
  *
- * Entry args:   MIDI command/status byte
- * 
- * Return:       (int) message length (bytes), usually 2 or 3, but...
- *               if status byte is SYS_EXCLUSIVE_CMD, return maximum length, or...
- *               if status byte is not supported (unrecognised), return 0.
- * 
- * todo:         support All Sound off, System reset, etc
+ * Entry args:   status = status byte (command + channel)
+ *               data1, data2 = data bytes (data2 is ignored if the message has only one)
+ *
+ * If the message is a continuous controller value (see OutQueueCanMerge), and a message
+ * for the same channel and controller is waiting to be sent, the waiting message takes
+ * the new value (in its place in the queue) -- the older value is never sent.  This is
+ * done only if every message for the same channel queued after the waiting message is
+ * also a continuous controller value, so the new value is never moved ahead of a note,
+ * program change, switch or RPN/NRPN message, etc. sent before it;  otherwise the new
+ * message is appended to the queue.
+ *
+ * The MSB and LSB of a 14-bit controller (CC 0..31 and CC 32..63) need care, because an
+ * MSB resets the LSB to 0 in the receiver.  When a waiting MSB is updated, a waiting LSB
+ * queued after it is set to 0 (it will be updated by the LSB which normally follows).
+ * A waiting LSB is not updated if its MSB is queued after it.
+ *
+ * If the queue is full, the message is dropped (counted).
+ */
+PRIVATE  void  OutQueuePut(uint8 status, uint8 data1, uint8 data2)
+{
+    uint8  tail = m_OutQueueTail;
+    uint8  depth, i;
+    MidiOutMsg_t  *pMsg, *pLsbMsg = NULL;
+
+    if (OutQueueCanMerge(status, data1))
+    {
+        // Search back from the newest waiting message for the same channel...
+        for (i = tail;  i != m_OutQueueHead;  )
+        {
+            i = (i - 1) & (MIDI_OUT_QUEUE_SIZE - 1);
+            pMsg = &m_OutQueue[i];
+            if ((pMsg->Status & 0x0F) != (status & 0x0F))  continue;  // other channel
+            if (!OutQueueCanMerge(pMsg->Status, pMsg->Data1))  break;  // order-dependent
+
+            if (pMsg->Status != status)  continue;  // other continuous controller
+
+            if ((status & 0xF0) == CONTROL_CHANGE_CMD)
+            {
+                if (data1 < 64 && pMsg->Data1 == (data1 ^ 32))  // 14-bit partner (MSB/LSB)
+                {
+                    if (data1 >= 32)  break;  // LSB with its MSB queued after it
+                    pLsbMsg = pMsg;
+                }
+                if (pMsg->Data1 != data1)  continue;  // different controller
+                if (pLsbMsg != NULL)  pLsbMsg->Data2 = 0;
+            }
+
+            pMsg->Data1 = data1;  // replace the unsent value
+            pMsg->Data2 = data2;
+            m_OutCoalesceCount++;
+            return;
+        }
+    }
+
+    if (((tail + 1) & (MIDI_OUT_QUEUE_SIZE - 1)) == m_OutQueueHead)  // queue full
+    {
+        m_OutDropCount++;
+        return;
+    }
+
+    pMsg = &m_OutQueue[tail];
+    pMsg->Status = status;
+    pMsg->Data1 = data1;
+    pMsg->Data2 = data2;
+    pMsg->Length = MIDI_MessageLength(status);
+    m_OutQueueTail = (tail + 1) & (MIDI_OUT_QUEUE_SIZE - 1);
+
+    depth = (m_OutQueueTail - m_OutQueueHead) & (MIDI_OUT_QUEUE_SIZE - 1);
+    if (depth > m_OutQueueMaxDepth)  m_OutQueueMaxDepth = depth;
+}
+
+
+/*
+ * Return TRUE if a message is a continuous controller value, which may be replaced by a
+ * newer value while waiting to be sent:  Pitch Bend, Channel Pressure or Control Change,
+ * except Channel Mode messages (CC 120..127), the switch controllers (CC 64..69, e.g.
+ * Sustain) and the RPN/NRPN controllers (CC 6, 38 and 96..101), whose effect depends on
+ * their order relative to other messages.
+ */
+PRIVATE  bool  OutQueueCanMerge(uint8 status, uint8 data1)
+{
+    uint8  command = status & 0xF0;
+
+    if (command == PITCH_BEND_CMD || command == CHAN_PRESSURE_CMD)  return TRUE;
+    if (command != CONTROL_CHANGE_CMD)  return FALSE;
+
+    if (data1 >= 120)  return FALSE;  // Channel Mode message
+    if (data1 >= 64 && data1 <= 69)  return FALSE;  // switch (Sustain, Portamento, ...)
+    if (data1 == 6 || data1 == 38 || (data1 >= 96 && data1 <= 101))  return FALSE;  // RPN
+
+    return TRUE;
+}
+
+
+/*
+ * Write the next message in the MIDI OUT queue (if any) to the UART.
+ * The status byte is omitted if it is the same as that of the previous message
+ * (running status), but it is re-sent at least every MIDI_OUT_STATUS_REFRESH messages,
+ * so that a receiver connected (or which has lost sync) in a long run of messages with
+ * the same status will resynchronize.
+ */
+PRIVATE  void  OutQueueSendNext(void)
+{
+    MidiOutMsg_t  *pMsg;
+
+    if (m_OutQueueHead == m_OutQueueTail)  return;  // queue empty
+
+    pMsg = &m_OutQueue[m_OutQueueHead];
+
+    if (pMsg->Status != m_OutRunningStatus || m_OutStatusAge >= MIDI_OUT_STATUS_REFRESH)
+    {
+        UART1_putch(pMsg->Status);
+        m_OutRunningStatus = pMsg->Status;
+        m_OutStatusAge = 0;
+    }
+    else  m_OutStatusBytesSaved++;
+
+    m_OutStatusAge++;
+
+    UART1_putch(pMsg->Data1);
+    if (pMsg->Length == 3)  UART1_putch(pMsg->Data2);
+
+    m_OutQueueHead = (m_OutQueueHead + 1) & (MIDI_OUT_QUEUE_SIZE - 1);
+}
+
+
+/*
+ * Function:     MIDI OUT service routine -- called frequently from the main loop.
+ *
+ * The next message in the MIDI OUT queue is released to the UART TX queue only when the
+ * latter is empty, so that messages wait in the MIDI OUT queue, where controller values
+ * can be updated, rather than in the UART TX queue, where they cannot.
+ */
+void  MIDI_OutputService(void)
+{
+#if UART1_TX_USING_QUEUE
+    if (UART1_TxQueueCount() == 0)  OutQueueSendNext();
+    UART1_TxQueueHandler();
+#else
+    OutQueueSendNext();  // UART1_putch() waits for the TX register to be empty
+#endif
+}
+
+
+/*
+ * Function:     Discard all messages waiting in the MIDI OUT queue and cancel running
+ *               status, so that the next message is sent with its status byte.
+ *
+ * To be called when MIDI OUT is enabled, because the state of the receiver is unknown.
+ */
+void  MIDI_OutputFlush(void)
+{
+    m_OutQueueHead = m_OutQueueTail;
+    m_OutRunningStatus = 0;
+}
+
+
+int  MIDI_GetOutputQueueDepth(void)
+{
+    return  (m_OutQueueTail - m_OutQueueHead) & (MIDI_OUT_QUEUE_SIZE - 1);
+}
+
+
+int  MIDI_GetOutputQueueMaxDepth(void)
+{
+    return  m_OutQueueMaxDepth;
+}
+
+
+uint32  MIDI_GetOutputDrops(void)
+{
+    return  m_OutDropCount;
+}
+
+
+uint32  MIDI_GetOutputCoalesced(void)
+{
+    return  m_OutCoalesceCount;
+}
+
+
+uint32  MIDI_GetOutputStatusBytesSaved(void)
+{
+    return  m_OutStatusBytesSaved;
+}
+
+
+/*
+ * Function:     MIDI IN message parser input -- the producer side of the MIDI IN event queue.
+ *
+ * Called with each block of bytes received from the MIDI IN port, normally from the UART
+ * RX data-ready handler (see UART1_RX_READY_HANDLER in UART_drv.h).  Bytes are passed to
+ * the MIDI parser (MIDI_parser.c);  each complete message is put into the queue, to be
+ * read by MIDI_GetEvent().
+ *
+ * Entry args:   data = bytes received from the MIDI IN port
+ *               count = number of bytes in data[]
+ *               timestamp = time of arrival of the bytes (units are defined by the caller)
+ *
+ * Channel messages (incl. running status) and System Exclusive messages are queued.
+ * System Common and Real-time messages are not used by the application, so they are
+ * not queued.  A System Exclusive message longer than MIDI_MSG_MAX_LENGTH bytes is
+ * discarded (the REMI handset messages are short).
+ */
+void  MIDI_ParserInput(const uint8 *data, int count, uint32 timestamp)
+{
+    MIDI_ParseBuffer(&m_InputParser, data, count, timestamp);
+}
+
+
+/*
+ * Function:     Resynchronize the MIDI IN parser after a loss of received data, e.g. a
+ *               UART overrun or framing error.  Any partly received message and the
+ *               running status are discarded, so that data bytes following the lost
+ *               bytes are not taken as part of a stale message.
+ *
+ * Called in the same context as MIDI_ParserInput() (UART RX data-ready handler).
  */
-int  MIDI_GetMessageLength(uint8 statusByte)
+void  MIDI_ParserResync(void)
 {
-    uint8  command = statusByte & 0xF0;
-    uint8  length = 0;
-    
-    if (command == PROGRAM_CHANGE_CMD || command == CHAN_PRESSURE_CMD)  
+    MIDI_ParserReset(&m_InputParser);
+}
+
+
+PRIVATE  void  ParserMessageHandler(const MidiMessage_t *pMsg)
+{
+    if (pMsg->Status < 0xF0)  EventQueuePut(pMsg);  // Channel message
+}
+
+
+/*
+ * SysEx chunks are accumulated in m_SysExBuffer[].  When the message is complete,
+ * it is handed over to the consumer, provided the previous one has been fetched.
+ */
+PRIVATE  void  ParserSysExHandler(const uint8 *data, int length, uint8 flags, uint32 timestamp)
+{
+    MidiEvent_t  event;
+
+    if (flags & MIDI_SYSEX_START)
     {
-        length = 2;
+        m_SysExLength = 0;
+        m_SysExTooLong = FALSE;
     }
-    else if (command == NOTE_ON_CMD || command == NOTE_OFF_CMD
-    ||  command == CONTROL_CHANGE_CMD || command == PITCH_BEND_CMD)  
+
+    if (m_SysExLength + length > MIDI_MSG_MAX_LENGTH)  m_SysExTooLong = TRUE;
+    else
+    {
+        memcpy(&m_SysExBuffer[m_SysExLength], data, length);
+        m_SysExLength += length;
+    }
+
+    if ((flags & MIDI_SYSEX_END) && !m_SysExTooLong && !m_SysExReady)
+    {
+        memcpy(m_SysExMessage, m_SysExBuffer, m_SysExLength);
+        m_SysExMessageLength = m_SysExLength;
+        m_SysExReady = TRUE;
+
+        event.Timestamp = timestamp;
+        event.Status = SYS_EXCLUSIVE_MSG;
+        event.Data1 = 0;
+        event.Data2 = 0;
+        event.Length = m_SysExLength;
+        EventQueuePut(&event);
+    }
+}
+
+
+PRIVATE  void  EventQueuePut(const MidiEvent_t *pEvent)
+{
+    uint8  tail = m_EventQueueTail;
+
+    if (((tail + 1) & (MIDI_EVENT_QUEUE_SIZE - 1)) == m_EventQueueHead)  // queue full
     {
-        length = 3;
+        m_EventQueueOverflows++;
+        return;
     }
-    else if (statusByte == SYS_EXCLUSIVE_MSG)
+
+    m_EventQueue[tail] = *pEvent;
+    m_EventQueueTail = (tail + 1) & (MIDI_EVENT_QUEUE_SIZE - 1);  // publish the event
+}
+
+
+/*
+ * Function:     Get the next event from the MIDI IN event queue -- the consumer side.
+ *
+ * Entry args:   pEvent = pointer to caller's event structure, to receive the event
+ *
+ * Return:       TRUE if an event was copied to *pEvent;  FALSE if the queue is empty.
+ *
+ * If the event is a System Exclusive message, the caller should then fetch the message
+ * using MIDI_GetSysExMessage(), otherwise no further Sys.Ex. messages will be received.
+ */
+bool  MIDI_GetEvent(MidiEvent_t *pEvent)
+{
+    uint8  head = m_EventQueueHead;
+
+    if (head == m_EventQueueTail)  return FALSE;  // queue empty
+
+    *pEvent = m_EventQueue[head];
+    m_EventQueueHead = (head + 1) & (MIDI_EVENT_QUEUE_SIZE - 1);  // release the slot
+
+    return TRUE;
+}
+
+
+/*
+ * Function:     Fetch the System Exclusive message most recently received, and release
+ *               the buffer for the next Sys.Ex. message.
+ *
+ * Entry args:   msgBuf = pointer to caller's buffer (MIDI_MSG_MAX_LENGTH bytes)
+ *
+ * Return:       Message length (bytes) incl. status and EOX bytes, or 0 if none pending.
+ */
+int  MIDI_GetSysExMessage(uint8 *msgBuf)
+{
+    int  length = 0;
+
+    if (m_SysExReady)
     {
-        length = MIDI_MSG_MAX_LENGTH;
+        length = m_SysExMessageLength;
+        memcpy(msgBuf, m_SysExMessage, length);
+        m_SysExReady = FALSE;
     }
-    else  length = 0;  // unsupported message type
-    
+
     return  length;
 }
+
+
+/*
+ * Function:     Discard all events in the MIDI IN event queue (consumer side only).
+ */
+void  MIDI_EventQueueFlush(void)
+{
+    m_EventQueueHead = m_EventQueueTail;
+    m_SysExReady = FALSE;
+}
+
+
+int  MIDI_GetEventQueueOverflows(void)
+{
+    return  m_EventQueueOverflows;
+}
+
+
+/*
+ * Function:     Get the number of MIDI IN errors found by the parser (stray data bytes,
+ *               incomplete messages, aborted SysEx messages) since power-on/reset.
+ */
+uint32  MIDI_GetParserErrors(void)
+{
+    return  m_InputParser.ErrorCount;
+}
@@ -10,6 +10,7 @@
 
 #include "../Common/system_def.h"
 #include "../Drivers/UART_drv.h"
+#include "MIDI_parser.h"
 
 #define OMNI_ON_POLY      1   // MIDI device responds in Poly mode on all channels
 #define OMNI_ON_MONO      2   // MIDI device responds in Mono mode on all channels
@@ -31,6 +32,14 @@
 #define CC_CHANNEL_VOLUME    7       //    ..     ..     ..
 #define CC_EXPRESSION        11      //    ..     ..     ..
 #define MIDI_MSG_MAX_LENGTH  16      // not in MIDI specification!
+#define MIDI_EVENT_QUEUE_SIZE  32    // MIDI IN event queue size (must be a power of 2)
+#define MIDI_OUT_QUEUE_SIZE    32    // MIDI OUT message queue size (must be a power of 2)
+#define MIDI_OUT_STATUS_REFRESH  16  // MIDI OUT status byte is re-sent every N msgs (max)
+
+// Decoded MIDI IN message (event), as delivered by MIDI_GetEvent()...
+// For a System Exclusive message, only Status and Length are valid; the message content
+// is fetched by MIDI_GetSysExMessage().
+typedef  MidiMessage_t  MidiEvent_t;
 
 
 // MIDI Channel Voice Messages ------------------------------------------------
@@ -46,8 +55,23 @@ void   MIDI_SendReceiverMode(uint8 chan, uint8 mode);
 void   MIDI_SendAllSoundOff(uint8 chan);
 void   MIDI_SendResetAllControllers(uint8 chan);
 
-// MIDI utility functions -----------------------------------------------------
-int    MIDI_GetMessageLength(uint8 statusByte);
+// MIDI OUT scheduler ---------------------------------------------------------
+void   MIDI_OutputService(void);
+void   MIDI_OutputFlush(void);
+int    MIDI_GetOutputQueueDepth(void);
+int    MIDI_GetOutputQueueMaxDepth(void);
+uint32 MIDI_GetOutputDrops(void);
+uint32 MIDI_GetOutputCoalesced(void);
+uint32 MIDI_GetOutputStatusBytesSaved(void);
+
+// MIDI IN parser and event queue ---------------------------------------------
+void   MIDI_ParserInput(const uint8 *data, int count, uint32 timestamp);  // Producer
+void   MIDI_ParserResync(void);
+bool   MIDI_GetEvent(MidiEvent_t *pEvent);                   // Consumer (synth task)
+int    MIDI_GetSysExMessage(uint8 *msgBuf);
+void   MIDI_EventQueueFlush(void);
+int    MIDI_GetEventQueueOverflows(void);
+uint32 MIDI_GetParserErrors(void);
 
 
 #endif // _MIDI_COMMS_LIB_H
@@ -0,0 +1,252 @@
+/* ================================================================================================
+ *
+ * FileName:    MIDI_parser.c
+ *
+ * Overview:    Table-driven MIDI 1.0 receive parser.
+ *
+ * Bytes received from a MIDI IN port are passed to MIDI_ParseBuffer() in blocks of any
+ * size (one byte or more).  Complete messages are passed to the message handler;  System
+ * Exclusive messages, which may be of any length, are passed to the SysEx handler in chunks
+ * of up to MIDI_SYSEX_CHUNK_SIZE bytes, as they arrive.
+ *
+ * MIDI 1.0 receiver rules implemented:
+ *   o  Running status -- data bytes following a complete channel message, without a new
+ *      status byte, form another message with the same status.
+ *   o  System Real-time bytes (0xF8..0xFF) may appear anywhere, even between the data bytes
+ *      of another message or within a SysEx message.  They are delivered at once and do not
+ *      affect the parser state.  Undefined real-time bytes (0xF9, 0xFD) are ignored.
+ *   o  System Common messages (0xF1..0xF7) cancel running status.  Undefined System Common
+ *      bytes (0xF4, 0xF5) are ignored, apart from cancelling running status.
+ *   o  A SysEx message is terminated by EOX (0xF7) or by any other non-real-time status
+ *      byte, in which case the message is delivered as aborted.
+ *   o  Data bytes received without a valid status are discarded (counted as errors).
+ *
+ * ================================================================================================
+ */
+#include "MIDI_parser.h"
+
+// Status byte attributes:  bits 1:0 = number of data bytes;  bits 7:4 = message class
+#define MSG_DATA_BYTES_MASK   0x03
+#define MSG_CLASS_CHANNEL     0x10
+#define MSG_CLASS_COMMON      0x20
+#define MSG_CLASS_REALTIME    0x40
+#define MSG_CLASS_SYSEX       0x80
+#define MSG_UNDEFINED         0x00
+
+// Channel message attributes, indexed by status bits 6:4 (0x80..0xE0)...
+PRIVATE  const  uint8  m_ChannelMsgInfo[8] =
+{
+    MSG_CLASS_CHANNEL | 2,      // 0x80  Note Off
+    MSG_CLASS_CHANNEL | 2,      // 0x90  Note On
+    MSG_CLASS_CHANNEL | 2,      // 0xA0  Poly Key Pressure
+    MSG_CLASS_CHANNEL | 2,      // 0xB0  Control Change (incl. Channel Mode)
+    MSG_CLASS_CHANNEL | 1,      // 0xC0  Program Change
+    MSG_CLASS_CHANNEL | 1,      // 0xD0  Channel Pressure
+    MSG_CLASS_CHANNEL | 2,      // 0xE0  Pitch Bend
+    MSG_UNDEFINED               // 0xF0  (System message -- see m_SystemMsgInfo[])
+};
+
+// System message attributes, indexed by status bits 3:0 (0xF0..0xFF)...
+PRIVATE  const  uint8  m_SystemMsgInfo[16] =
+{
+    MSG_CLASS_SYSEX,            // 0xF0  System Exclusive
+    MSG_CLASS_COMMON | 1,       // 0xF1  MTC Quarter Frame
+    MSG_CLASS_COMMON | 2,       // 0xF2  Song Position Pointer
+    MSG_CLASS_COMMON | 1,       // 0xF3  Song Select
+    MSG_CLASS_COMMON,           // 0xF4  (undefined) -- no message delivered
+    MSG_CLASS_COMMON,           // 0xF5  (undefined) -- no message delivered
+    MSG_CLASS_COMMON,           // 0xF6  Tune Request
+    MSG_CLASS_SYSEX,            // 0xF7  EOX (end of SysEx)
+    MSG_CLASS_REALTIME,         // 0xF8  Timing Clock
+    MSG_UNDEFINED,              // 0xF9  (undefined)
+    MSG_CLASS_REALTIME,         // 0xFA  Start
+    MSG_CLASS_REALTIME,         // 0xFB  Continue
+    MSG_CLASS_REALTIME,         // 0xFC  Stop
+    MSG_UNDEFINED,              // 0xFD  (undefined)
+    MSG_CLASS_REALTIME,         // 0xFE  Active Sensing
+    MSG_CLASS_REALTIME          // 0xFF  System Reset
+};
+
+#define STATUS_INFO(sb)  (((sb) < 0xF0) ? m_ChannelMsgInfo[((sb) >> 4) & 7] \
+                                        : m_SystemMsgInfo[(sb) & 0x0F])
+
+PRIVATE  void  DeliverMessage(MidiParser_t *pParser, uint8 status, uint8 length,
+                              uint32 timestamp);
+PRIVATE  void  DeliverSysExChunk(MidiParser_t *pParser, uint32 timestamp);
+
+
+/*
+ * Function:     Initialize a MIDI parser instance.
+ *
+ * Entry args:   pParser = pointer to parser state structure (caller's storage)
+ *               msgHandler = function to receive complete messages (NULL: none)
+ *               sysExHandler = function to receive SysEx message chunks (NULL: none)
+ */
+void  MIDI_ParserInit(MidiParser_t *pParser, MidiMsgHandler_t msgHandler,
+                      MidiSysExHandler_t sysExHandler)
+{
+    pParser->MsgHandler = msgHandler;
+    pParser->SysExHandler = sysExHandler;
+    pParser->MessageCount = 0;
+    pParser->ErrorCount = 0;
+    MIDI_ParserReset(pParser);
+}
+
+
+/*
+ * Function:     Reset parser state, e.g. after a receive error (UART overrun).
+ *               Any partly received message is discarded.  Counters are not reset.
+ */
+void  MIDI_ParserReset(MidiParser_t *pParser)
+{
+    pParser->Status = 0;
+    pParser->DataExpected = 0;
+    pParser->DataCount = 0;
+    pParser->SysExActive = FALSE;
+    pParser->SysExCount = 0;
+}
+
+
+/*
+ * Function:     Parse a block of bytes received from a MIDI IN port.
+ *
+ * Entry args:   pParser = pointer to parser state structure
+ *               data = pointer to bytes received
+ *               count = number of bytes in data[]
+ *               timestamp = time of arrival of the block (units are defined by the caller)
+ *
+ * Handlers are called from within this function, in the order messages are completed.
+ * A message may span any number of calls.
+ */
+void  MIDI_ParseBuffer(MidiParser_t *pParser, const uint8 *data, int count, uint32 timestamp)
+{
+    uint8  rxByte, info;
+
+    while (count-- > 0)
+    {
+        rxByte = *data++;
+
+        if ((rxByte & 0x80) == 0)  // data byte
+        {
+            if (pParser->SysExActive)
+            {
+                pParser->SysExChunk[pParser->SysExCount++] = rxByte;
+                if (pParser->SysExCount == MIDI_SYSEX_CHUNK_SIZE)
+                    DeliverSysExChunk(pParser, timestamp);
+            }
+            else if (pParser->Status != 0)
+            {
+                pParser->Data[pParser->DataCount++] = rxByte;
+
+                if (pParser->DataCount == pParser->DataExpected)  // message complete
+                {
+                    DeliverMessage(pParser, pParser->Status, pParser->DataCount + 1, timestamp);
+                    pParser->DataCount = 0;  // expect more data with same status (running)
+                    if (pParser->Status >= 0xF0)  pParser->Status = 0;  // not for Sys Common
+                }
+            }
+            else  pParser->ErrorCount++;  // no status -- discard data byte
+
+            continue;
+        }
+
+        info = STATUS_INFO(rxByte);
+
+        if (info & MSG_CLASS_REALTIME)  // deliver now;  parser state is unchanged
+        {
+            DeliverMessage(pParser, rxByte, 1, timestamp);
+            continue;
+        }
+        if (info == MSG_UNDEFINED)  continue;  // undefined real-time byte (0xF9, 0xFD)
+
+        // Any other status byte terminates a SysEx message or incomplete message...
+        if (pParser->SysExActive)
+        {
+            pParser->SysExActive = FALSE;
+
+            if (rxByte == 0xF7)  // EOX
+            {
+                pParser->SysExChunk[pParser->SysExCount++] = rxByte;
+                pParser->SysExFlags |= MIDI_SYSEX_END;
+                pParser->MessageCount++;
+                DeliverSysExChunk(pParser, timestamp);
+                pParser->Status = 0;
+                continue;
+            }
+
+            pParser->SysExFlags |= MIDI_SYSEX_ABORT;
+            pParser->ErrorCount++;
+            DeliverSysExChunk(pParser, timestamp);
+        }
+        else if (pParser->DataCount != 0)  pParser->ErrorCount++;  // incomplete message
+
+        pParser->Status = 0;
+        pParser->DataCount = 0;
+
+        if (info & MSG_CLASS_SYSEX)
+        {
+            if (rxByte == 0xF7)  { pParser->ErrorCount++;  continue; }  // EOX without SysEx
+
+            pParser->SysExActive = TRUE;
+            pParser->SysExFlags = MIDI_SYSEX_START;
+            pParser->SysExChunk[0] = rxByte;
+            pParser->SysExCount = 1;
+        }
+        else if ((info & MSG_DATA_BYTES_MASK) != 0)  // channel or system common message
+        {
+            pParser->Status = rxByte;
+            pParser->DataExpected = info & MSG_DATA_BYTES_MASK;
+        }
+        else if (rxByte == 0xF6)  DeliverMessage(pParser, rxByte, 1, timestamp);  // Tune Req.
+        // else undefined System Common byte (0xF4, 0xF5) -- ignore
+    }
+}
+
+
+PRIVATE  void  DeliverMessage(MidiParser_t *pParser, uint8 status, uint8 length,
+                              uint32 timestamp)
+{
+    MidiMessage_t  msg;
+
+    pParser->MessageCount++;
+    if (pParser->MsgHandler == NULL)  return;
+
+    msg.Timestamp = timestamp;
+    msg.Status = status;
+    msg.Data1 = (length > 1) ? pParser->Data[0] : 0;
+    msg.Data2 = (length > 2) ? pParser->Data[1] : 0;
+    msg.Length = length;
+
+    pParser->MsgHandler(&msg);
+}
+
+
+PRIVATE  void  DeliverSysExChunk(MidiParser_t *pParser, uint32 timestamp)
+{
+    if (pParser->SysExHandler != NULL)
+        pParser->SysExHandler(pParser->SysExChunk, pParser->SysExCount,
+                              pParser->SysExFlags, timestamp);
+
+    pParser->SysExFlags = 0;
+    pParser->SysExCount = 0;
+}
+
+
+/*
+ * Function:     Find length of a given MIDI message from its status byte.
+ *
+ * Return:       (int) message length (bytes), including status byte, or...
+ *               0 if the status byte is invalid, undefined or SysEx (variable length).
+ */
+int  MIDI_MessageLength(uint8 statusByte)
+{
+    uint8  info;
+
+    if ((statusByte & 0x80) == 0)  return 0;  // not a status byte
+
+    info = STATUS_INFO(statusByte);
+    if (info == MSG_UNDEFINED || (info & MSG_CLASS_SYSEX))  return 0;
+    if (statusByte == 0xF4 || statusByte == 0xF5)  return 0;
+
+    return  (info & MSG_DATA_BYTES_MASK) + 1;
+}
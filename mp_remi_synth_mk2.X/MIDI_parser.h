@@ -0,0 +1,71 @@
+/****************************************************************************************
+ *
+ * FileName:   MIDI_parser.h
+ *
+ * Overview:   Table-driven MIDI 1.0 receive parser (byte stream to messages).
+ *
+ * The parser has no static data;  all state is held in a MidiParser_t structure owned
+ * by the caller, so that a parser may be instanced for each MIDI IN stream (or test).
+ *
+ * =======================================================================================
+ */
+#ifndef _MIDI_PARSER_H
+#define _MIDI_PARSER_H
+
+#include "../Common/system_def.h"
+
+#define MIDI_SYSEX_CHUNK_SIZE   16      // Max. bytes passed to the SysEx handler per call
+
+// Flags passed to the SysEx chunk handler (may be combined)...
+#define MIDI_SYSEX_START     0x01     // First chunk of message (begins with 0xF0)
+#define MIDI_SYSEX_END       0x02     // Last chunk of message (ends with EOX, 0xF7)
+#define MIDI_SYSEX_ABORT     0x04     // Message terminated by a status byte other than EOX
+
+// Decoded MIDI message, as passed to the message handler...
+// Channel Voice/Mode, System Common (except SysEx) and System Real-time messages.
+typedef struct MIDI_message
+{
+    uint32  Timestamp;        // Time of arrival of buffer (units defined by caller)
+    uint8   Status;           // Status byte (command + channel, or system msg type)
+    uint8   Data1;            // 1st data byte (0 if none)
+    uint8   Data2;            // 2nd data byte (0 if none)
+    uint8   Length;           // Message length (bytes), incl. status byte
+
+} MidiMessage_t;
+
+// Handler called for each complete message (not SysEx)...
+typedef void (* MidiMsgHandler_t)(const MidiMessage_t *pMsg);
+
+// Handler called for each chunk of a System Exclusive message...
+// The first chunk begins with the SysEx status byte (0xF0);  the last chunk ends with
+// EOX (0xF7), unless the message was aborted, in which case the last chunk may be empty.
+typedef void (* MidiSysExHandler_t)(const uint8 *data, int length, uint8 flags,
+                                    uint32 timestamp);
+
+typedef struct MIDI_parser
+{
+    MidiMsgHandler_t    MsgHandler;       // Message handler (NULL: messages ignored)
+    MidiSysExHandler_t  SysExHandler;     // SysEx chunk handler (NULL: SysEx ignored)
+    uint8   Status;           // Status of msg being received, or running status (0: none)
+    uint8   DataExpected;     // Number of data bytes in current message
+    uint8   DataCount;        // Number of data bytes received so far
+    uint8   Data[2];          // Data bytes received
+    bool    SysExActive;      // Flag: receiving System Exclusive msg
+    uint8   SysExFlags;       // Flags for next SysEx chunk
+    uint8   SysExCount;       // Bytes held in SysExChunk[]
+    uint8   SysExChunk[MIDI_SYSEX_CHUNK_SIZE];
+    uint32  MessageCount;     // Messages delivered, incl. complete SysEx messages
+    uint32  ErrorCount;       // Stray data bytes, incomplete messages, aborted SysEx
+
+} MidiParser_t;
+
+
+void   MIDI_ParserInit(MidiParser_t *pParser, MidiMsgHandler_t msgHandler,
+                       MidiSysExHandler_t sysExHandler);
+void   MIDI_ParserReset(MidiParser_t *pParser);
+void   MIDI_ParseBuffer(MidiParser_t *pParser, const uint8 *data, int count,
+                        uint32 timestamp);
+int    MIDI_MessageLength(uint8 statusByte);
+
+
+#endif // _MIDI_PARSER_H
@@ -16,6 +16,8 @@
 
 #include "../Common/system_def.h"
 #include "../Drivers/HardwareProfile.h"
+#include "../Drivers/UART_drv.h"
+#include "remi_synth_config.h"
 
 #ifdef INCLUDE_KERNEL_RTC_SUPPORT
 #include "RTC_support.h"
@@ -218,6 +220,10 @@ void  __ISR(_TIMER_1_VECTOR, IPL5AUTO)  Timer_1_RTI_Handler(void)
     v_RTI_tick_counter++;
     v_RTI_flag_1ms_task = 1;
 
+#if UART1_RX_USING_DMA
+    UART1_RxTickService();  // Pass UART1 RX data (DMA buffer) to the application
+#endif
+
     if (++count_to_5  >= 5) { v_RTI_flag_5ms_task = 1;  count_to_5 = 0; }
     if (++count_to_50 >= 50) { v_RTI_flag_50ms_task = 1;  count_to_50 = 0; }
     if (++count_to_500 >= 500) { v_RTI_flag_500ms_task = 1;  count_to_500 = 0; }
@@ -299,6 +305,8 @@ void  BootReset()
 {
     unsigned int status = 0;
 
+    FlushPersistentData();   // Complete deferred EEPROM writes before reset
+
     asm volatile("di    %0" : "=r"(status));     // Disable Interrupts
 
     SYSKEY = 0x00000000;   // Execute register unlock sequence
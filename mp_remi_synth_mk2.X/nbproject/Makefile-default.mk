@@ -57,17 +57,17 @@ OBJECTDIR=build/${CND_CONF}/${IMAGE_TYPE}
 DISTDIR=dist/${CND_CONF}/${IMAGE_TYPE}
 
 # Source Files Quoted if spaced
-SOURCEFILES_QUOTED_IF_SPACED=../Common/TimeDelay.c ../Drivers/EEPROM_drv.c ../Drivers/I2C_drv.c ../Drivers/SPI_drv.c ../Drivers/LCD_KS0108_drv.c ../Drivers/UART_drv.c ./kernel.c ./LCD_graphics_lib.c ./wave_table_creator.c ./MIDI_comms_lib.c ./console_cli.c ./pic32_low_level.c remi_synth_CLI.c remi_synth_GUI.c remi_synth_config.c remi_synth_data.c remi_synth_engine.c remi_synth_main.c
+SOURCEFILES_QUOTED_IF_SPACED=../Common/TimeDelay.c ../Drivers/EEPROM_drv.c ../Drivers/I2C_drv.c ../Drivers/SPI_drv.c ../Drivers/LCD_KS0108_drv.c ../Drivers/UART_drv.c ./kernel.c ./LCD_graphics_lib.c ./wave_table_creator.c ./MIDI_comms_lib.c ./MIDI_parser.c ./console_cli.c ./pic32_low_level.c remi_synth_CLI.c remi_synth_GUI.c remi_synth_config.c remi_synth_data.c remi_synth_engine.c remi_synth_main.c
 
 # Object Files Quoted if spaced
-OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/_ext/2108356922/TimeDelay.o ${OBJECTDIR}/_ext/1904510940/EEPROM_drv.o ${OBJECTDIR}/_ext/1904510940/I2C_drv.o ${OBJECTDIR}/_ext/1904510940/SPI_drv.o ${OBJECTDIR}/_ext/1904510940/LCD_KS0108_drv.o ${OBJECTDIR}/_ext/1904510940/UART_drv.o ${OBJECTDIR}/kernel.o ${OBJECTDIR}/LCD_graphics_lib.o ${OBJECTDIR}/wave_table_creator.o ${OBJECTDIR}/MIDI_comms_lib.o ${OBJECTDIR}/console_cli.o ${OBJECTDIR}/pic32_low_level.o ${OBJECTDIR}/remi_synth_CLI.o ${OBJECTDIR}/remi_synth_GUI.o ${OBJECTDIR}/remi_synth_config.o ${OBJECTDIR}/remi_synth_data.o ${OBJECTDIR}/remi_synth_engine.o ${OBJECTDIR}/remi_synth_main.o
-POSSIBLE_DEPFILES=${OBJECTDIR}/_ext/2108356922/TimeDelay.o.d ${OBJECTDIR}/_ext/1904510940/EEPROM_drv.o.d ${OBJECTDIR}/_ext/1904510940/I2C_drv.o.d ${OBJECTDIR}/_ext/1904510940/SPI_drv.o.d ${OBJECTDIR}/_ext/1904510940/LCD_KS0108_drv.o.d ${OBJECTDIR}/_ext/1904510940/UART_drv.o.d ${OBJECTDIR}/kernel.o.d ${OBJECTDIR}/LCD_graphics_lib.o.d ${OBJECTDIR}/wave_table_creator.o.d ${OBJECTDIR}/MIDI_comms_lib.o.d ${OBJECTDIR}/console_cli.o.d ${OBJECTDIR}/pic32_low_level.o.d ${OBJECTDIR}/remi_synth_CLI.o.d ${OBJECTDIR}/remi_synth_GUI.o.d ${OBJECTDIR}/remi_synth_config.o.d ${OBJECTDIR}/remi_synth_data.o.d ${OBJECTDIR}/remi_synth_engine.o.d ${OBJECTDIR}/remi_synth_main.o.d
+OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/_ext/2108356922/TimeDelay.o ${OBJECTDIR}/_ext/1904510940/EEPROM_drv.o ${OBJECTDIR}/_ext/1904510940/I2C_drv.o ${OBJECTDIR}/_ext/1904510940/SPI_drv.o ${OBJECTDIR}/_ext/1904510940/LCD_KS0108_drv.o ${OBJECTDIR}/_ext/1904510940/UART_drv.o ${OBJECTDIR}/kernel.o ${OBJECTDIR}/LCD_graphics_lib.o ${OBJECTDIR}/wave_table_creator.o ${OBJECTDIR}/MIDI_comms_lib.o ${OBJECTDIR}/MIDI_parser.o ${OBJECTDIR}/console_cli.o ${OBJECTDIR}/pic32_low_level.o ${OBJECTDIR}/remi_synth_CLI.o ${OBJECTDIR}/remi_synth_GUI.o ${OBJECTDIR}/remi_synth_config.o ${OBJECTDIR}/remi_synth_data.o ${OBJECTDIR}/remi_synth_engine.o ${OBJECTDIR}/remi_synth_main.o
+POSSIBLE_DEPFILES=${OBJECTDIR}/_ext/2108356922/TimeDelay.o.d ${OBJECTDIR}/_ext/1904510940/EEPROM_drv.o.d ${OBJECTDIR}/_ext/1904510940/I2C_drv.o.d ${OBJECTDIR}/_ext/1904510940/SPI_drv.o.d ${OBJECTDIR}/_ext/1904510940/LCD_KS0108_drv.o.d ${OBJECTDIR}/_ext/1904510940/UART_drv.o.d ${OBJECTDIR}/kernel.o.d ${OBJECTDIR}/LCD_graphics_lib.o.d ${OBJECTDIR}/wave_table_creator.o.d ${OBJECTDIR}/MIDI_comms_lib.o.d ${OBJECTDIR}/MIDI_parser.o.d ${OBJECTDIR}/console_cli.o.d ${OBJECTDIR}/pic32_low_level.o.d ${OBJECTDIR}/remi_synth_CLI.o.d ${OBJECTDIR}/remi_synth_GUI.o.d ${OBJECTDIR}/remi_synth_config.o.d ${OBJECTDIR}/remi_synth_data.o.d ${OBJECTDIR}/remi_synth_engine.o.d ${OBJECTDIR}/remi_synth_main.o.d
 
 # Object Files
-OBJECTFILES=${OBJECTDIR}/_ext/2108356922/TimeDelay.o ${OBJECTDIR}/_ext/1904510940/EEPROM_drv.o ${OBJECTDIR}/_ext/1904510940/I2C_drv.o ${OBJECTDIR}/_ext/1904510940/SPI_drv.o ${OBJECTDIR}/_ext/1904510940/LCD_KS0108_drv.o ${OBJECTDIR}/_ext/1904510940/UART_drv.o ${OBJECTDIR}/kernel.o ${OBJECTDIR}/LCD_graphics_lib.o ${OBJECTDIR}/wave_table_creator.o ${OBJECTDIR}/MIDI_comms_lib.o ${OBJECTDIR}/console_cli.o ${OBJECTDIR}/pic32_low_level.o ${OBJECTDIR}/remi_synth_CLI.o ${OBJECTDIR}/remi_synth_GUI.o ${OBJECTDIR}/remi_synth_config.o ${OBJECTDIR}/remi_synth_data.o ${OBJECTDIR}/remi_synth_engine.o ${OBJECTDIR}/remi_synth_main.o
+OBJECTFILES=${OBJECTDIR}/_ext/2108356922/TimeDelay.o ${OBJECTDIR}/_ext/1904510940/EEPROM_drv.o ${OBJECTDIR}/_ext/1904510940/I2C_drv.o ${OBJECTDIR}/_ext/1904510940/SPI_drv.o ${OBJECTDIR}/_ext/1904510940/LCD_KS0108_drv.o ${OBJECTDIR}/_ext/1904510940/UART_drv.o ${OBJECTDIR}/kernel.o ${OBJECTDIR}/LCD_graphics_lib.o ${OBJECTDIR}/wave_table_creator.o ${OBJECTDIR}/MIDI_comms_lib.o ${OBJECTDIR}/MIDI_parser.o ${OBJECTDIR}/console_cli.o ${OBJECTDIR}/pic32_low_level.o ${OBJECTDIR}/remi_synth_CLI.o ${OBJECTDIR}/remi_synth_GUI.o ${OBJECTDIR}/remi_synth_config.o ${OBJECTDIR}/remi_synth_data.o ${OBJECTDIR}/remi_synth_engine.o ${OBJECTDIR}/remi_synth_main.o
 
 # Source Files
-SOURCEFILES=../Common/TimeDelay.c ../Drivers/EEPROM_drv.c ../Drivers/I2C_drv.c ../Drivers/SPI_drv.c ../Drivers/LCD_KS0108_drv.c ../Drivers/UART_drv.c ./kernel.c ./LCD_graphics_lib.c ./wave_table_creator.c ./MIDI_comms_lib.c ./console_cli.c ./pic32_low_level.c remi_synth_CLI.c remi_synth_GUI.c remi_synth_config.c remi_synth_data.c remi_synth_engine.c remi_synth_main.c
+SOURCEFILES=../Common/TimeDelay.c ../Drivers/EEPROM_drv.c ../Drivers/I2C_drv.c ../Drivers/SPI_drv.c ../Drivers/LCD_KS0108_drv.c ../Drivers/UART_drv.c ./kernel.c ./LCD_graphics_lib.c ./wave_table_creator.c ./MIDI_comms_lib.c ./MIDI_parser.c ./console_cli.c ./pic32_low_level.c remi_synth_CLI.c remi_synth_GUI.c remi_synth_config.c remi_synth_data.c remi_synth_engine.c remi_synth_main.c
 
 
 
@@ -167,6 +167,12 @@ ${OBJECTDIR}/MIDI_comms_lib.o: ./MIDI_comms_lib.c  .generated_files/flags/defaul
 	@${RM} ${OBJECTDIR}/MIDI_comms_lib.o 
 	${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG   -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/MIDI_comms_lib.o.d" -o ${OBJECTDIR}/MIDI_comms_lib.o ./MIDI_comms_lib.c    -DXPRJ_default=$(CND_CONF)  -no-legacy-libc  $(COMPARISON_BUILD)  -mdfp="${DFP_DIR}"  
 	
+${OBJECTDIR}/MIDI_parser.o: ./MIDI_parser.c  .generated_files/flags/default/aff450f54c4bcb817211c0e54d591ea48143211b .generated_files/flags/default/87483c345429186c5999dcd95309ab66555f8ca8
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/MIDI_parser.o.d 
+	@${RM} ${OBJECTDIR}/MIDI_parser.o 
+	${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG   -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/MIDI_parser.o.d" -o ${OBJECTDIR}/MIDI_parser.o ./MIDI_parser.c    -DXPRJ_default=$(CND_CONF)  -no-legacy-libc  $(COMPARISON_BUILD)  -mdfp="${DFP_DIR}"  
+	
 ${OBJECTDIR}/console_cli.o: ./console_cli.c  .generated_files/flags/default/b8c9e5d85206dfd5a67f221fd2ac7c2ea6daef08 .generated_files/flags/default/87483c345429186c5999dcd95309ab66555f8ca8
 	@${MKDIR} "${OBJECTDIR}" 
 	@${RM} ${OBJECTDIR}/console_cli.o.d 
@@ -276,6 +282,12 @@ ${OBJECTDIR}/MIDI_comms_lib.o: ./MIDI_comms_lib.c  .generated_files/flags/defaul
 	@${RM} ${OBJECTDIR}/MIDI_comms_lib.o 
 	${MP_CC}  $(MP_EXTRA_CC_PRE)  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/MIDI_comms_lib.o.d" -o ${OBJECTDIR}/MIDI_comms_lib.o ./MIDI_comms_lib.c    -DXPRJ_default=$(CND_CONF)  -no-legacy-libc  $(COMPARISON_BUILD)  -mdfp="${DFP_DIR}"  
 	
+${OBJECTDIR}/MIDI_parser.o: ./MIDI_parser.c  .generated_files/flags/default/2cd1a0ea5e164490685a19ebac7074d5a45139a4 .generated_files/flags/default/87483c345429186c5999dcd95309ab66555f8ca8
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/MIDI_parser.o.d 
+	@${RM} ${OBJECTDIR}/MIDI_parser.o 
+	${MP_CC}  $(MP_EXTRA_CC_PRE)  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/MIDI_parser.o.d" -o ${OBJECTDIR}/MIDI_parser.o ./MIDI_parser.c    -DXPRJ_default=$(CND_CONF)  -no-legacy-libc  $(COMPARISON_BUILD)  -mdfp="${DFP_DIR}"  
+	
 ${OBJECTDIR}/console_cli.o: ./console_cli.c  .generated_files/flags/default/6b5b86bd375b2f3618ac4a96711d214172af5e12 .generated_files/flags/default/87483c345429186c5999dcd95309ab66555f8ca8
 	@${MKDIR} "${OBJECTDIR}" 
 	@${RM} ${OBJECTDIR}/console_cli.o.d 
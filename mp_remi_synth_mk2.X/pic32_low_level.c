@@ -8,13 +8,26 @@
  *             application build variants. May contain traces of nut products.
  *
  */
+#include <sys/attribs.h>    // For interrupt handlers
+#include <sys/kmem.h>       // For KVA_TO_PA() -- DMA addresses
+
 #include "pic32_low_level.h"
+#include "remi_synth_def.h"
+#include "../Drivers/SPI_drv.h"
 
 #include <stdlib.h>
 #include <string.h>
 
 static  uint16  m_AnalogReading[16];     // ADC inputs -- raw readings
 
+static  uint16  m_PwmDutyBuffer[2 * AUDIO_BLOCK_SIZE];  // DMA "ping-pong" buffer (OC4 duty)
+static  volatile int  m_RenderBlockIndex;  // Index of buffer half to be re-filled
+static  uint16  m_PwmDutyMidScale = 1000;   // PWM duty for zero signal (half the period)
+static  int32   m_PwmDutyGain = 65536;      // PWM duty scale [16:16] = (PR2 + 1) / 2000
+#ifdef SYNTH_MK3_MX440_MAM
+static  uint16  m_SpiDacBuffer[2 * AUDIO_BLOCK_SIZE];   // SPI DAC words (in step with PWM)
+#endif
+
 
 void  Init_MCU_IO_ports(void)
 {
@@ -52,16 +65,35 @@ void  Init_MCU_IO_ports(void)
 
 
 /*`````````````````````````````````````````````````````````````````````````````````````````````````
- * Function:  Initialize Timer #2 and OC4 pin for PWM audio DAC operation.
+ * Function:  Initialize Timer #2, OC4 and DMA channel 0 for PWM audio DAC operation.
  *
  * Timer_2 is set up to generate the PWM audio output signal using a sampling
  * rate of 40ks/s.  Prescaler = 1:1;  Fclk = FCY = 80MHz;  Tclk = 12.5ns.
- * Timer_2 period := 50.00us (4000 x 12.5ns);  PR2 = 1999;  PWM freq = 40kHz.
- * Maximum duty register value is 1999.
+ * Timer_2 period := 25.00us (2000 x 12.5ns);  PR2 = 1999;  PWM freq = 40kHz.
+ * Maximum duty register value is 1999.  The sample rate is changed subsequently by
+ * PWM_audioDAC_SetSampleRate(), called by the synth engine (see SynthPrepare()).
  * Output Compare module OC4 is set up for PWM (fault-detect disabled).
+ *
+ * The OC4 duty register is not written by the CPU.  DMA channel 0 is triggered by the
+ * Timer_2 IRQ event (T2IF) to copy one sample per period from the PWM duty "ping-pong"
+ * buffer, m_PwmDutyBuffer[], into OC4RS.  The Timer_2 CPU interrupt is not enabled.
+ * The buffer holds 2 blocks of AUDIO_BLOCK_SIZE samples.  The DMA channel raises an IRQ
+ * when the source pointer passes the half-way point and again at the end of the buffer;
+ * the DMA ISR then requests the block renderer to re-fill the half just emptied.
+ *
+ * On the mk3/mx440 platform, the optional SPI DAC (MCP4921) is fed in the same way.
+ * DMA channels 1..3, also triggered by T2IF, frame the DAC chip-select (SS2#/EXT-CS#)
+ * and copy one DAC word per period from m_SpiDacBuffer[] into SPI2BUF (see SPI_drv.c).
+ * The two buffers are filled together by the render ISR, so the SPI DAC and PWM outputs
+ * run in step (the DAC is one sample behind), with no CPU involvement.
+ *
+ * Note: The PIC32MX DMA source size register is 8 bits (256 bytes max.), hence
+ *       AUDIO_BLOCK_SIZE must not exceed 64 samples.
  */
 void  PWM_audioDAC_init(void)
 {
+    int  i;
+
     TRISDbits.TRISD3 = 0;    // RD3/OC4 is an output pin
     TRISDbits.TRISD4 = 0;    // RD4/OC5 ..   ..   ..
 
@@ -72,13 +104,146 @@ void  PWM_audioDAC_init(void)
     PR2 = 1999;              // Period = 2000 x 12.5ns (-> freq = 40kHz)
     IFS0bits.T2IF = 0;       // Clear IRQ flag
     IPC2bits.T2IP = 6;       // Set IRQ priority (highest!)
-    T2CONbits.TON = 1;       // Start Timer
+
+    for (i = 0;  i < (2 * AUDIO_BLOCK_SIZE);  i++)
+    {
+        m_PwmDutyBuffer[i] = 1000;   // mid-scale (silence)
+#ifdef SYNTH_MK3_MX440_MAM
+        m_SpiDacBuffer[i] = 0x3000 | 2000;   // DAC command bits + mid-scale data
+#endif
+    }
+
+    // DMA channel 0 setup -- Source: m_PwmDutyBuffer[];  Destination: OC4RS
+    DMACONbits.ON = 1;                        // Enable the DMA controller
+    DCH0CON = 0;
+    DCH0CONbits.CHPRI = 3;                    // Highest channel priority
+    DCH0CONbits.CHAEN = 1;                    // Auto-enable (repeat continuously)
+    DCH0ECON = 0;
+    DCH0ECONbits.CHSIRQ = _TIMER_2_IRQ;       // Cell transfer start on T2 event
+    DCH0ECONbits.SIRQEN = 1;
+    DCH0SSA = KVA_TO_PA(m_PwmDutyBuffer);
+    DCH0DSA = KVA_TO_PA(&OC4RS);
+    DCH0SSIZ = sizeof(m_PwmDutyBuffer) & 0xFF;  // bytes (0 => 256)
+    DCH0DSIZ = 2;                             // OC4RS (16 bits)
+    DCH0CSIZ = 2;                             // 1 sample per cell transfer
+    DCH0INTCLR = 0x00FF00FF;                  // Clear all flags and enables
+    DCH0INTbits.CHSHIE = 1;                   // IRQ on source half empty
+    DCH0INTbits.CHBCIE = 1;                   // IRQ on block transfer complete
+
+    IFS1bits.DMA0IF = 0;
+    IPC9bits.DMA0IP = 6;                      // Buffer swap IRQ priority (highest!)
+    AUDIO_DMA_IRQ_ENABLE();
+
+    IFS0bits.CS0IF = 0;                       // Core S/W IRQ 0 runs the renderer
+    IPC0bits.CS0IP = 5;                       // Render IRQ priority
+    AUDIO_RENDER_IRQ_ENABLE();
 
     OC4R = 1000;             // PWM Set initial duty (50%)
     OC4RS = 1000;
     OC4CON = 0x8006;         // Enable OC4 for PWM
 
-    TIMER2_IRQ_ENABLE();
+    DCH0CONbits.CHEN = 1;    // Enable DMA channel
+
+#ifdef SYNTH_MK3_MX440_MAM   // SPI DAC words are sent by DMA (in step with PWM)
+    SPI_DMA_TxInit(2, 0, 3);  // SPI2: mode 0, 10MHz, 16-bit, CS framed by DMA
+    SPI_DMA_TxStart(2, m_SpiDacBuffer, sizeof(m_SpiDacBuffer), _TIMER_2_IRQ);
+#endif
+
+    T2CONbits.TON = 1;       // Start Timer (all DMA channels start in step)
+}
+
+
+/*`````````````````````````````````````````````````````````````````````````````````````````````````
+ * Function:  Set the audio sample rate, i.e. the Timer_2 period, which paces the PWM and
+ *            SPI DAC outputs (via DMA) and hence the block render ISR.
+ *
+ * Entry arg: rate_Hz = sample rate, e.g. 32000, 40000 or 48000 Hz
+ *
+ * PR2 = (80MHz / rate) - 1, e.g. 2499 at 32kHz, 1999 at 40kHz, 1665 at 48kHz (48.019kHz).
+ * The PWM duty range is the timer period, so the duty scale factor and mid-scale value
+ * are adjusted to keep the same output level at any rate.  The timer is stopped while the
+ * period is changed, so that TMR2 does not overrun the new period.
+ * The caller should silence the synth beforehand;  the audio output may glitch briefly.
+ */
+void  PWM_audioDAC_SetSampleRate(uint32 rate_Hz)
+{
+    uint32  period = PERIPH_CLOCK_HZ / rate_Hz;   // timer counts per sample
+
+    AUDIO_RENDER_IRQ_DISABLE();
+    m_PwmDutyMidScale = (uint16) (period / 2);
+    m_PwmDutyGain = (int32) ((period << 16) / 2000);
+    AUDIO_RENDER_IRQ_ENABLE();
+
+    T2CONbits.TON = 0;
+    TMR2 = 0;
+    PR2 = period - 1;
+    T2CONbits.TON = 1;
+}
+
+
+/*`````````````````````````````````````````````````````````````````````````````````````````````````
+ * Function:  DMA channel 0 interrupt service routine -- audio buffer swap.
+ *
+ * The ISR determines which half of the PWM duty buffer has just been emptied by the
+ * DMA channel, then requests the (lower priority) render ISR to re-fill that half.
+ * The render ISR has a full block period to complete before the DMA channel wraps
+ * around to the half being re-filled.
+ */
+void  __ISR(_DMA_0_VECTOR, IPL6AUTO)  DMA0_IRQService(void)
+{
+    if (DCH0INTbits.CHSHIF)  m_RenderBlockIndex = 0;  // 1st half emptied
+    if (DCH0INTbits.CHBCIF)  m_RenderBlockIndex = AUDIO_BLOCK_SIZE;  // 2nd half emptied
+
+    DCH0INTCLR = 0x000000FF;      // Clear DMA channel event flags
+    IFS1bits.DMA0IF = 0;          // Clear the IRQ
+    AUDIO_RENDER_IRQ_REQUEST();   // Trigger core software IRQ 0
+}
+
+
+/*`````````````````````````````````````````````````````````````````````````````````````````````````
+ * Function:  Audio block render ISR (core software interrupt 0).
+ *
+ * Calls the synth block renderer to compute AUDIO_BLOCK_SIZE samples, then converts
+ * the samples to PWM duty values (range 1..PR2) in the free half of the DMA buffer.
+ * The DAC write time and total ISR time are recorded for the engine profile ('diag -r').
+ */
+void  __ISR(_CORE_SOFTWARE_0_VECTOR, IPL5AUTO)  AudioRender_IRQService(void)
+{
+    fixed_t  sampleBuf[AUDIO_BLOCK_SIZE];
+    uint16  *pDuty;
+    uint32   entryTime, dacStartTime, CC_Reg;
+    int      i;
+
+    READ_CPU_CORE_COUNT_REG(entryTime);
+    IFS0bits.CS0IF = 0;    // Clear the IRQ
+    SynthRenderBlock(sampleBuf, AUDIO_BLOCK_SIZE);
+    READ_CPU_CORE_COUNT_REG(dacStartTime);
+
+    pDuty = &m_PwmDutyBuffer[m_RenderBlockIndex];
+    for (i = 0;  i < AUDIO_BLOCK_SIZE;  i++)
+    {
+        pDuty[i] = (uint16)(m_PwmDutyMidScale + (((sampleBuf[i] >> 10) * m_PwmDutyGain) >> 16));
+#ifdef SYNTH_MK3_MX440_MAM  // SPI DAC output (12 bits)
+        m_SpiDacBuffer[m_RenderBlockIndex + i] = 
+                0x3000 | (uint16)(2000 + (int)(sampleBuf[i] >> 9));  // cmd + data
+#endif
+    }
+
+    READ_CPU_CORE_COUNT_REG(CC_Reg);
+    ProfileRecord(PROFILE_DAC_WRITE, CC_Reg - dacStartTime);
+    ProfileRecord(PROFILE_RENDER_ISR, CC_Reg - entryTime);
+}
+
+
+/*
+ * Function:  Timer_3 interrupt service routine (ISR)
+ *
+ * Overview:  The ISR handles any task(s) which must be executed
+ *            synchronously with the Timer_3 rollover (period).
+ */
+void __ISR(_TIMER_3_VECTOR, IPL5AUTO)  Timer_3_IRQService(void)
+{
+    IFS0bits.T3IF = 0;
 }
 
 
@@ -38,12 +38,19 @@
 #define POT_CHANNEL_LIST    { 0, 1, 2, 3, 4, 5 }  // Pot inputs (sub-set of ADC chan list)
 
 // Arg u32 is a variable of type uint32
+// (Macro may be pre-defined for host PC simulation -- see host_sim/include/p32xxxx.h)
+#ifndef READ_CPU_CORE_COUNT_REG
 #define READ_CPU_CORE_COUNT_REG(u32)  asm volatile("mfc0   %0, $9" : "=r"(u32));
+#endif
 
-// Macros to enable/disable audio wave sampling routine (Timer 2 ISR)...
+// Macros to enable/disable the audio output DMA (buffer swap) and block render IRQs...
+// Refer to function PWM_audioDAC_init() defined in file "pic32_low_level.c"
 //
-#define TIMER2_IRQ_DISABLE()   IEC0bits.T2IE = 0
-#define TIMER2_IRQ_ENABLE()    IEC0bits.T2IE = 1
+#define AUDIO_DMA_IRQ_DISABLE()     IEC1bits.DMA0IE = 0
+#define AUDIO_DMA_IRQ_ENABLE()      IEC1bits.DMA0IE = 1
+#define AUDIO_RENDER_IRQ_DISABLE()  IEC0bits.CS0IE = 0
+#define AUDIO_RENDER_IRQ_ENABLE()   IEC0bits.CS0IE = 1
+#define AUDIO_RENDER_IRQ_REQUEST()  IFS0bits.CS0IF = 1
 //
 #define TIMER3_IRQ_DISABLE()   IEC0bits.T3IE = 0
 #define TIMER3_IRQ_ENABLE()    IEC0bits.T3IE = 1
@@ -54,7 +61,10 @@
 
 // Macros to set EXT-CS# pin high or low  (RG9/SS2# on UEXT connector)
 #define EXT_CS_HIGH()     LATGbits.LATG9 = 1
-#define EXT_CS_LOW()      LATFbits.LATG9 = 0
+#define EXT_CS_LOW()      LATGbits.LATG9 = 0
+
+// SPI DAC chip-select (mk3/mx440 platform) uses EXT-CS#, which is driven by DMA --
+// refer to function SPI_DMA_TxStart() in SPI_drv.c.
 
 // Macro to read 6 button input pins (RB15..RB10) into 16-bit word (bits 5:0)
 #define READ_BUTTON_INPUTS()   ((PORTB >> 10) & 0x003F)  // active LOW
@@ -95,6 +105,8 @@
 
 
 void   Init_MCU_IO_ports(void);
+void   PWM_audioDAC_init(void);
+void   PWM_audioDAC_SetSampleRate(uint32 rate_Hz);
 void   ADC_Init(void);
 void   DebugLEDControl(uint8 state);
 void   ToggleBacklight(void);
@@ -21,6 +21,7 @@ PRIVATE  void   DumpActivePatchParams();
 PRIVATE  void   SetPatchParameter(char *paramAbbr, int paramVal);
 PRIVATE  void   WaveOscSoundTest(int freq, int duration); 
 PRIVATE  void   CoreCycleTimerTest();
+PRIVATE  void   EngineProfileReport();
 PRIVATE  void   DisplayControllerTest();
 PRIVATE  void   TestFixedPtBase2Exp();
 
@@ -29,7 +30,9 @@ extern  int32  g_TraceBuffer[][5];       // Debug usage only
 extern  uint32 g_TaskCallFrequency;      // Debug usage only
 
 extern  volatile  bool v_SynthEnable;    // Signal to enable synth engine
-extern  volatile  uint32 v_ISRexecTime;  // ISR execution time (core cycle count)
+extern  volatile  uint32 v_ISRexecTime;  // Block render time (core cycle count)
+extern  volatile  uint32 v_VoiceRenderTime;  // Voice render time, last block
+extern  volatile  uint8  v_VoicesRendered;   // Voices rendered, last block
 
 // Variables used for MIDI IN monitor ...
 extern  BOOL   g_MidiInputMonitorActive;
@@ -60,6 +63,7 @@ const  CmndTableEntry_t  AppCommands[] =
     {    "preset",     APP_CMD,       Cmnd_preset     },
     {    "patch",      APP_CMD,       Cmnd_patch      },
     {    "sound",      APP_CMD,       Cmnd_sound      },
+    {    "mod",        APP_CMD,       Cmnd_mod        },
     {    "wav",        APP_CMD,       Cmnd_wav        },
     //---------------------------------------------------
     {    "$",          0,             NULL            }   // Dummy last entry
@@ -92,9 +96,10 @@ const  UserSettableParameter_t  UserParam[] =
 void  Cmnd_config(int argCount, char * argValue[])
 {
     static char *pitchBendModeName[] = 
-            { "Disabled", "MIDI Pitch-Bend", "MIDI Exprn CC", "Analog CV (TBD!)" };
+            { "Disabled", "MIDI Pitch-Bend", "MIDI Exprn CC" };
     static char *audioCtrlModeName[] = 
             { "Fixed Level", "ENV & Velocity", "Expression", "Auto-detect" };
+    static char *interpModeName[] = { "Truncate", "Linear", "Hermite" };
     char   textBuf[100];
     bool   updateConfig = 0;
     bool   isCmdError = 0;
@@ -117,7 +122,9 @@ void  Cmnd_config(int argCount, char * argValue[])
         
         sprintf(textBuf, "mim | MIDI IN Mode: %d ", g_Config.MidiInMode);
         putstr("\t");  putstr(textBuf);
-        if (g_Config.MidiInMode == 2) putstr("= Omni-On-Mono \n");
+        if (g_Config.MidiInMode == 1) putstr("= Omni-On-Poly \n");
+        else if (g_Config.MidiInMode == 2) putstr("= Omni-On-Mono \n");
+        else if (g_Config.MidiInMode == 3) putstr("= Omni-Off-Poly \n");
         else if (g_Config.MidiInMode == 4) putstr("= Omni-Off-Mono \n");  
         else  putstr("(invalid) \n");
         
@@ -153,6 +160,21 @@ void  Cmnd_config(int argCount, char * argValue[])
         putstr("\t");  putstr(textBuf);
         sprintf(textBuf, "rvm | Reverb Mix (wet/dry ratio): %d %%\n", g_Config.ReverbMix_pc);
         putstr("\t");  putstr(textBuf);
+        
+        sprintf(textBuf, "oi1 | OSC1 Interpolation: %d = %s\n", g_Config.Osc1InterpMode,
+                interpModeName[g_Config.Osc1InterpMode]);
+        putstr("\t");  putstr(textBuf);
+        sprintf(textBuf, "oi2 | OSC2 Interpolation: %d = %s\n", g_Config.Osc2InterpMode,
+                interpModeName[g_Config.Osc2InterpMode]);
+        putstr("\t");  putstr(textBuf);
+        
+        sprintf(textBuf, "pft | Preset change Fade Time: %d ms", g_Config.PatchFadeTime_ms);
+        putstr("\t");  putstr(textBuf);
+        if (g_Config.PatchFadeTime_ms == 0)  putstr(" (Off) \n");
+        else  putstr(" \n");
+        
+        sprintf(textBuf, "asr | Audio Sample Rate: %d kHz \n", g_Config.SampleRate_kHz);
+        putstr("\t");  putstr(textBuf);
 
         return;
     }
@@ -173,7 +195,7 @@ void  Cmnd_config(int argCount, char * argValue[])
     }    
     else if (strmatch(argValue[1], "mim"))  // MIDI IN Mode
     {
-        if (argCount >= 3 && (arg == 2 || arg == 4))
+        if (argCount >= 3 && (arg >= 1 && arg <= 4))
         {
             g_Config.MidiInMode = arg;
             updateConfig = 1;
@@ -236,7 +258,7 @@ void  Cmnd_config(int argCount, char * argValue[])
     }
     else if (strmatch(argValue[1], "pbc"))  // Pitch-Bend Control Mode
     {
-        if (argCount >= 3 && (arg >= 0 && arg <= 3))  // todo: arg == 3 (analog CV)
+        if (argCount >= 3 && (arg >= 0 && arg <= PITCH_BEND_BY_EXPRN_CC))
         {
             g_Config.PitchBendCtrlMode = arg;
             updateConfig = 1;
@@ -279,6 +301,42 @@ void  Cmnd_config(int argCount, char * argValue[])
         }
         else  isCmdError = 1;
     }
+    else if (strmatch(argValue[1], "oi1"))  // OSC1 wave-table interpolation mode
+    {
+        if (argCount >= 3 && (arg >= OSC_INTERP_TRUNCATE && arg <= OSC_INTERP_HERMITE))
+        {
+            g_Config.Osc1InterpMode = arg;
+            updateConfig = 1;
+        }
+        else  isCmdError = 1;
+    }
+    else if (strmatch(argValue[1], "oi2"))  // OSC2 wave-table interpolation mode
+    {
+        if (argCount >= 3 && (arg >= OSC_INTERP_TRUNCATE && arg <= OSC_INTERP_HERMITE))
+        {
+            g_Config.Osc2InterpMode = arg;
+            updateConfig = 1;
+        }
+        else  isCmdError = 1;
+    }
+    else if (strmatch(argValue[1], "pft"))  // Preset change crossfade time (0: Off)
+    {
+        if (argCount >= 3 && (arg == 0 || (arg >= PATCH_FADE_TIME_MIN && arg <= PATCH_FADE_TIME_MAX)))
+        {
+            g_Config.PatchFadeTime_ms = arg;
+            updateConfig = 1;
+        }
+        else  isCmdError = 1;
+    }
+    else if (strmatch(argValue[1], "asr"))  // Audio sample rate (kHz)
+    {
+        if (argCount >= 3 && (arg == 32 || arg == 40 || arg == 48))
+        {
+            g_Config.SampleRate_kHz = arg;
+            updateConfig = 1;
+        }
+        else  isCmdError = 1;
+    }
 
     if (isCmdError)  putstr("! Invalid <arg> value \n");
     
@@ -367,8 +425,10 @@ void  Cmnd_preset(int argCount, char * argValue[])
                 g_Preset.Descr[activePreset].PatchNumber = arg;
                 StorePresetData();
                 InstrumentPresetSelect(activePreset);  // activate the new setting
-                putstr("Patch #");  putDecimal(g_Patch.PatchNumber, 1);
-                putstr(" '");  putstr(g_Patch.PatchName);
+                putstr("Patch #");  putDecimal(arg, 1);
+                putstr(" '");  
+                if (arg == 0)  putstr(g_Config.UserPatch.PatchName);
+                else  putstr((char *) g_PatchProgram[i].PatchName);
                 putstr("' loaded and assigned to Preset ");
                 if (activePreset == 0)  putch('8');
                 else  putDecimal(activePreset, 1);  
@@ -556,7 +616,7 @@ void  Cmnd_patch(int argCount, char *argValue[])
 
             memcpy(&g_Config.UserPatch, &g_Patch, sizeof(PatchParamTable_t));
 
-            if (StoreConfigData())  putstr("* Saved OK.\n");
+            if (StoreConfigData() && FlushPersistentData())  putstr("* Saved OK.\n");
             else  putstr("! Error writing to EEPROM.\n");
             break;
         }
@@ -613,8 +673,10 @@ void  Cmnd_patch(int argCount, char *argValue[])
             if (status == ERROR)  putstr("! Missing or invalid patch ID.\n");
             else  
             {
-                putstr("Patch #");  putDecimal(g_Patch.PatchNumber, 1);
-                putstr(" '");  putstr(g_Patch.PatchName);
+                putstr("Patch #");  putDecimal(arg, 1);
+                putstr(" '");  
+                if (arg == 0)  putstr(g_Config.UserPatch.PatchName);
+                else  putstr((char *) g_PatchProgram[i].PatchName);
                 putstr("' loaded and assigned to Preset ");
                 if (activePreset == 0)  putch('8');
                 else  putDecimal(activePreset, 1);  
@@ -793,7 +855,7 @@ PRIVATE  void   DumpActivePatchParams()
     putstr(textBuf);
     putstr("\n");
 
-    //-------------  Noise Mixer & Bi-quad resonant Filter ------------------------------
+    //-------------  Noise Mixer & State-Variable Filter --------------------------------
 
     sprintf(textBuf,
             "\t%d,\t// NM: Noise Mode (0:Off, 1:Noise, 2:Add wave, 3:Mix wave; +4:R.Mod)\n",
@@ -816,11 +878,14 @@ PRIVATE  void   DumpActivePatchParams()
     sprintf(textBuf, "\t%d,\t// FT: Filter Note Tracking (0:Off, 1:On) \n",
             (int) g_Patch.FilterNoteTrack);
     putstr(textBuf);
+    sprintf(textBuf, "\t%d,\t// FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)\n",
+            (int) g_Patch.FilterMode);
+    putstr(textBuf);
     putstr("\n");
 
     //-------------  Amplidude Envelope Generator and Audio Level Adjust  ----------------
 
-    sprintf(textBuf, "\t%d,\t// EA: Envelope Attack time (5..5000+ ms)\n",
+    sprintf(textBuf, "\t%d,\t// EA: Envelope Attack time (1..5000+ ms)\n",
             (int) g_Patch.AmpldEnvAttack_ms);
     putstr(textBuf);
     sprintf(textBuf, "\t%d,\t// EP: Envelope Peak time (0..5000+ ms)\n",
@@ -944,7 +1009,7 @@ PRIVATE  void   SetPatchParameter(char *paramAbbr, int paramVal)
             else  isBadValue = 1;
             break;
         }
-        //-------------  Noise Generator & Bi-Quad Variable Filter --------------------------------
+        //-------------  Noise Generator & State-Variable Filter ----------------------------------
         case PARAM_HASH_VALUE('N', 'M'):
         {
             if (paramVal <= 7)  g_Patch.NoiseMode = paramVal;
@@ -982,10 +1047,16 @@ PRIVATE  void   SetPatchParameter(char *paramAbbr, int paramVal)
             else  isBadValue = 1;
             break;
         }
+        case PARAM_HASH_VALUE('F', 'M'):
+        {
+            if (paramVal <= FILTER_MODE_HIGHPASS)  g_Patch.FilterMode = paramVal;
+            else  isBadValue = 1;
+            break;
+        }
         //-------------  Amplitude Envelope and Output Amplitude Control  -------------------
         case PARAM_HASH_VALUE('E', 'A'):
         {
-            if (paramVal >= 5 && paramVal <= 10000)  
+            if (paramVal >= 1 && paramVal <= 10000)  
                 g_Patch.AmpldEnvAttack_ms = paramVal;
             else  isBadValue = 1;
             break;
@@ -1238,6 +1309,8 @@ void  Cmnd_eeprom(int argCount, char * argValue[])
         return;
     }
 
+    FlushPersistentData();  // Complete any deferred writes before direct access
+
     if (EepromReadData(buffer, 0, 0, 16) != 16)
     {
         putstr("! Error: EEPROM read access failed. \n");
@@ -1376,6 +1449,133 @@ void  Cmnd_sound(int argCount, char * argValue[])
 }
 
 
+/*
+ *   CLI command function:  Cmnd_mod
+ *
+ *   The "mod" command views or modifies the LFO settings and the modulation matrix.
+ *   Routes set by this command are not saved;  they are replaced by the default
+ *   routes (derived from the active patch) on patch change or "mod -d".
+ */
+void  Cmnd_mod(int argCount, char * argValue[])
+{
+    static  char  *srcName[] = { "none", "LFO1", "LFO2", "VibRamp", "Contour", "AmpEnv",
+                                 "Veloc", "Moduln", "Pressure", "Exprn", "PitchBend" };
+    static  char  *dstName[] = { "Pitch", "MixLevel", "FilterFc", "Noise", "Ampld" };
+    static  char  *dstUnits[] = { "cents", "%", "semi", "%", "%" };
+    static  char  *waveName[] = { "sine", "triangle", "square", "S/H" };
+    static  float  dstScale[] = { 1200, 100, 1, 100, 100 };  // units per fixed-pt 1.0
+    
+    char    textBuf[80];
+    char    option;
+    int     i, dest, source, scaler;
+    float   depth;
+    ModRoute_t  *pRoute;
+    SynthLFO_t  *pLFO;
+
+    if (argCount == 2 && *argValue[1] == '?')   // help wanted
+    {
+        putstr( "View or modify LFO settings and the modulation matrix \n" );
+        putstr( "```````````````````````````````````````````````````````````\n" );
+        putstr( "Usage:  mod  [opt]  [arg's] \n" );
+        putstr( "  where <opt> = \n" );
+        putstr( " (none) : List LFOs, base values and routes \n");
+        putstr( " -l  <lfo> <wave> <freq>  : Set LFO (1|2) wave, freq (Hz x10) \n");
+        putstr( "        wave: 0:sine, 1:triangle, 2:square, 3:sample-hold \n");
+        putstr( " -r  <slot> <src> <dest> <depth> [scaler] : Set route \n");
+        putstr( " -b  <dest> <value> : Set destination base value \n");
+        putstr( " -x  <slot> : Delete route \n");
+        putstr( " -d  : Restore default routes (from active patch) \n");
+        putstr( "  Sources: 1:LFO1, 2:LFO2, 3:VibRamp, 4:Contour, 5:AmpEnv, \n");
+        putstr( "           6:Veloc, 7:Moduln, 8:Pressure, 9:Exprn, 10:PitchBend \n");
+        putstr( "  Dest's:  0:Pitch (cents), 1:MixLevel (%), 2:FilterFc (semi), \n");
+        putstr( "           3:Noise (%), 4:Ampld (%) \n");
+        putstr( "```````````````````````````````````````````````````````````\n" );
+        return;
+    }
+
+    if (argCount >= 2)  option = tolower(argValue[1][1]);
+    else  option = 0;  // list
+
+    if (argCount >= 2 && *argValue[1] != '-')  option = '?';
+
+    switch (option)
+    {
+    case 0:  // List LFOs, base values and routes
+    {
+        for (i = 1;  i <= MOD_LFO_COUNT;  i++)
+        {
+            pLFO = GetSynthLfo(i);
+            sprintf(textBuf, "LFO%d: %-8s %5.1f Hz \n", i, waveName[pLFO->Waveform], 
+                    (float) pLFO->Freq_x10 / 10);
+            putstr(textBuf);
+        }
+        putstr("Base: ");
+        for (dest = 0;  dest < MOD_NUM_DESTS;  dest++)
+        {
+            depth = FixedToFloat(ModMatrixGetBase(dest)) * dstScale[dest];
+            sprintf(textBuf, " %s %.1f %s%s", dstName[dest], depth, dstUnits[dest],
+                    (dest < MOD_NUM_DESTS - 1) ? "," : "\n");
+            putstr(textBuf);
+        }
+        putstr("Slot  Source     Scaler     Dest        Depth \n");
+        for (i = 0;  i < MOD_ROUTES_MAX;  i++)
+        {
+            pRoute = ModMatrixGetRoute(i);
+            if (pRoute == NULL)  break;
+            depth = FixedToFloat(pRoute->Depth) * dstScale[pRoute->Dest];
+            sprintf(textBuf, "%3d   %-10s %-10s %-10s %7.2f %s \n", i, 
+                    srcName[pRoute->Source], srcName[pRoute->Scaler], 
+                    dstName[pRoute->Dest], depth, dstUnits[pRoute->Dest]);
+            putstr(textBuf);
+        }
+        break;
+    }
+    case 'l':  // Set LFO waveform and frequency
+    {
+        if (argCount < 5 || SynthLfoSetup(atoi(argValue[2]), atoi(argValue[3]), 
+                                          atoi(argValue[4])) != SUCCESS)
+            putstr("! Bad or missing arg(s).\n");
+        break;
+    }
+    case 'r':  // Set route
+    {
+        if (argCount < 6)  { putstr("! Missing arg(s).\n");  break; }
+        source = atoi(argValue[3]);
+        dest = atoi(argValue[4]);
+        scaler = (argCount >= 7) ? atoi(argValue[6]) : MOD_SRC_NONE;
+        if (dest < 0 || dest >= MOD_NUM_DESTS)  { putstr("! Bad dest.\n");  break; }
+        depth = atof(argValue[5]) / dstScale[dest];
+        if (ModMatrixSetRoute(atoi(argValue[2]), source, scaler, dest, FloatToFixed(depth))
+            != SUCCESS)  putstr("! Bad arg(s).\n");
+        break;
+    }
+    case 'b':  // Set destination base value
+    {
+        if (argCount < 4)  { putstr("! Missing arg(s).\n");  break; }
+        dest = atoi(argValue[2]);
+        if (dest < 0 || dest >= MOD_NUM_DESTS)  { putstr("! Bad dest.\n");  break; }
+        depth = atof(argValue[3]) / dstScale[dest];
+        ModMatrixSetBase(dest, FloatToFixed(depth));
+        break;
+    }
+    case 'x':  // Delete route
+    {
+        if (argCount < 3 || ModMatrixDeleteRoute(atoi(argValue[2])) != SUCCESS)
+            putstr("! Bad or missing arg.\n");
+        break;
+    }
+    case 'd':  // Restore default routes
+    {
+        ModMatrixRestore();
+        break;
+    }
+    default:
+        putstr("! Invalid option. Enter 'mod ?' for usage.\n");
+        break;
+    }
+}
+
+
 /*```````````````````````````````````````````````````````````````````````````````````````
  *   Function called by "diag" command.
  * 
@@ -1399,15 +1599,16 @@ void  DiagnosticCommandExec(int argCount, char * argValue[])
         putstr( "`````````````````````````````````````````````` \n" );
         putstr( "Usage:  diag  <option>  [arg's] ... \n" );
         putstr( "Options:  \n" );
-        putstr( " -a  :  Audio ISR execution time \n");
+        putstr( " -a  :  Audio block render time \n");
         putstr( " -b  :  Background task frequency \n");
         putstr( " -c  :  Control pot readings \n");
         putstr( " -d  :  LCD backlight toggle \n");
         putstr( " -e  :  Expression peak value \n");
         putstr( " -i  :  Test I2C bus signals \n");
-        putstr( " -o  :  Audio Output level \n");
+        putstr( " -o  :  Audio Output level (per voice) \n");
         putstr( " -p  :  Pitch Bend (arg: +/-8000) \n");
-        putstr( " -s  :  Disable/enable Synth ISR (arg: 0|1) \n");
+        putstr( " -r  :  Render profile, by stage (arg: 0 => reset) \n");
+        putstr( " -s  :  Suspend/resume synth engine (arg: 0|1) \n");
         putstr( " -u  :  UART errors.\n");
         putstr( " -y  :  CPU core cYcle timer \n");
 #ifdef SUPPORT_DIAG_MODE        
@@ -1429,17 +1630,51 @@ void  DiagnosticCommandExec(int argCount, char * argValue[])
     
     switch (option)
     {
-    case 'a':  // Show Audio ISR execution time (us)
+    case 'a':  // Show Audio block render time (us)
     {
         int  execTime_us = (int) v_ISRexecTime / 40 + 1;  // 40 counts per microsecond
-        int  duty_pc = (execTime_us * 100) / 25;  // duty = % of ISR period
+        int  period_us = (AUDIO_BLOCK_SIZE * 1000000) / SynthSampleRate();  // block period
+        int  duty_pc = (execTime_us * 100) / period_us;  // duty = % of block period
+        int  sample_ns = (int) ((v_ISRexecTime * 25) / AUDIO_BLOCK_SIZE);  // 25ns per count
+        int  voices = v_VoicesRendered;
+        int  voiceTime = v_VoiceRenderTime;  // core timer counts
+        int  budget = ((AUDIO_BLOCK_SIZE * 40000) / (SynthSampleRate() / 1000)) 
+                      * AUDIO_RENDER_BUDGET_PC / 100;  // counts per block
+        int  perVoice, overhead, maxVoices;
         
-        putstr("Audio ISR execution time: ");
+        putstr("Audio block render time: ");
         putDecimal(execTime_us, 1);
-        putstr(" us;  Portion of CPU time: ");
+        putstr(" us per ");
+        putDecimal(AUDIO_BLOCK_SIZE, 1);
+        putstr(" samples (");
+        putDecimal(sample_ns, 1);
+        putstr(" ns/sample) \n");
+        putstr("Portion of CPU time: ");
         putDecimal(duty_pc, 1);
-        putstr(" % \n");
-        putstr("excluding context-switching overhead (negligible).\n");
+        putstr(" %  (block period = ");
+        putDecimal(period_us, 1);
+        putstr(" us) \n");
+        
+        if (voices != 0)  // estimate voice capacity within render budget
+        {
+            perVoice = voiceTime / voices;
+            if (perVoice < 1)  perVoice = 1;  // (voice render time not yet measured)
+            overhead = (int) v_ISRexecTime - voiceTime;
+            maxVoices = (budget > overhead) ? (budget - overhead) / perVoice : 0;
+            putstr("Voices rendered: ");
+            putDecimal(voices, 1);
+            putstr(",  ");
+            putDecimal((perVoice * 25) / AUDIO_BLOCK_SIZE, 1);
+            putstr(" ns/sample per voice \n");
+            putstr("Max. voices (");
+            putDecimal(AUDIO_RENDER_BUDGET_PC, 1);
+            putstr("% budget): ");
+            putDecimal(maxVoices, 1);
+            putstr("  (pool size = ");
+            putDecimal(SYNTH_VOICES_MAX, 1);
+            putstr(") \n");
+        }
+        else  putstr("Play a note to measure voice render time. \n");
         break;
     }
     case 'b':  // Background task frequency check
@@ -1519,10 +1754,17 @@ void  DiagnosticCommandExec(int argCount, char * argValue[])
     }
     case 'o':  // Show audio Output level (control variable)
     {
-        float  outputLevel = FixedToFloat(v_OutputLevel);
+        int    voice;
+        float  outputLevel;
         
-        sprintf(textBuf, "v_OutputLevel = %9.6f \n", outputLevel);
+        sprintf(textBuf, "Active voices: %d \n", GetActiveVoiceCount());
         putstr(textBuf);
+        for (voice = 0;  voice < SYNTH_VOICES_MAX;  voice++)
+        {
+            outputLevel = FixedToFloat(GetVoiceOutputLevel(voice));
+            sprintf(textBuf, "Voice %d output level = %9.6f \n", voice, outputLevel);
+            putstr(textBuf);
+        }
         break;
     }
     case 'p':  // Pitch bend test
@@ -1539,17 +1781,29 @@ void  DiagnosticCommandExec(int argCount, char * argValue[])
         }
         break;
     }
-    case 's':  // Suspend or activate synth audio ISR
+    case 'r':  // Show (or reset) audio engine profile
+    {
+        if (argCount == 3 && *argValue[2] == '0') 
+        {
+            AUDIO_RENDER_IRQ_DISABLE();
+            ProfileReset();
+            AUDIO_RENDER_IRQ_ENABLE();
+            putstr("* Render profile reset.\n"); 
+        }
+        else  EngineProfileReport();
+        break;
+    }
+    case 's':  // Suspend or activate synth engine (render ISR outputs silence)
     {
         if (argCount == 3 && *argValue[2] == '0') 
         {
             v_SynthEnable = FALSE;
-            putstr("* Synth audio ISR suspended.\n "); 
+            putstr("* Synth engine suspended (render ISR outputs silence).\n "); 
         }
         else  
         {
             v_SynthEnable = TRUE;
-            putstr("* Synth audio ISR active.\n "); 
+            putstr("* Synth engine active.\n "); 
         }
         break;
     }
@@ -1561,6 +1815,37 @@ void  DiagnosticCommandExec(int argCount, char * argValue[])
         putstr("UART #2 error count: ");  
         putDecimal(UART2_getErrorCount(), 5);
         putNewLine();
+        putstr("MIDI IN event queue overflows: ");  
+        putDecimal(MIDI_GetEventQueueOverflows(), 5);
+        putNewLine();
+        putstr("MIDI IN parser errors: ");  
+        putDecimal(MIDI_GetParserErrors(), 5);
+        putNewLine();
+        putstr("MIDI OUT queue depth (max): ");  
+        putDecimal(MIDI_GetOutputQueueDepth(), 1);
+        putstr(" (");  
+        putDecimal(MIDI_GetOutputQueueMaxDepth(), 1);
+        putstr(")\n");
+        putstr("MIDI OUT msgs coalesced: ");  
+        putDecimal(MIDI_GetOutputCoalesced(), 5);
+        putNewLine();
+        putstr("MIDI OUT msgs dropped: ");  
+        putDecimal(MIDI_GetOutputDrops(), 5);
+        putNewLine();
+        putstr("EEPROM bytes written (pending pages): ");  
+        putDecimal(PersistentDataBytesWritten(), 1);
+        putstr(" (");  
+        putDecimal(PersistentDataPending(), 1);
+        putstr(")\n");
+        putstr("EEPROM journal compactions: ");  
+        putDecimal(PersistentDataCompactions(), 5);
+        putNewLine();
+        putstr("EEPROM write errors: ");  
+        putDecimal(PersistentDataWriteErrors(), 5);
+        putNewLine();
+        putstr("Synth event queue overflows: ");  
+        putDecimal(GetSynthEventOverflows(), 5);
+        putNewLine();
         break;
     }
     case 'y':  // Core cycle timer test
@@ -1603,6 +1888,76 @@ void  DiagnosticCommandExec(int argCount, char * argValue[])
 }
 
 
+/*`````````````
+ * Function:  Command option "diag -r"
+ *
+ * Audio engine profile report.  For each profiling stage, shows the minimum, mean and
+ * maximum execution times (us) since the profile was reset, followed by the log2 histogram
+ * of execution times (core timer counts), one row per non-empty bin.
+ * Stages within the renderer are profiled only in blocks where voices were rendered.
+ */
+PRIVATE  void   EngineProfileReport()
+{
+    static  const  char  *stageName[] = 
+        { "ISR", "Events", "Osc", "VoiceDSP", "Master", "Reverb", "DAC", "Process", "Patch" };
+    ProfileStage_t  stats[PROFILE_NUM_STAGES];
+    char    textBuf[100];
+    float   mean;
+    bool    binEmpty;
+    unsigned  lowerLimit;           // histogram bin lower limit (counts)
+    int     stage, bin;
+    int     period = (AUDIO_BLOCK_SIZE * 40000) / (SynthSampleRate() / 1000);  // counts
+
+    AUDIO_RENDER_IRQ_DISABLE();  // Take a consistent snapshot
+    for (stage = 0;  stage < PROFILE_NUM_STAGES;  stage++)  
+        ProfileGetStage(stage, &stats[stage]);
+    AUDIO_RENDER_IRQ_ENABLE();
+
+    putstr("Stage         Count      Min(us)   Mean(us)    Max(us) \n");
+    for (stage = 0;  stage < PROFILE_NUM_STAGES;  stage++)
+    {
+        if (stats[stage].Count != 0)  mean = (float) stats[stage].Total / stats[stage].Count;
+        else  mean = 0;
+        sprintf(textBuf, "%-9s %9u %12.1f %10.1f %10.1f \n", stageName[stage],
+                (unsigned) stats[stage].Count, (float) stats[stage].Min / 40, 
+                mean / 40, (float) stats[stage].Max / 40);
+        putstr(textBuf);
+    }
+
+    putstr("\nCounts>=     us  ");
+    for (stage = 0;  stage < PROFILE_NUM_STAGES;  stage++)
+    {
+        sprintf(textBuf, "%9s", stageName[stage]);
+        putstr(textBuf);
+    }
+    putNewLine();
+
+    for (bin = 0;  bin < PROFILE_HIST_BINS;  bin++)
+    {
+        binEmpty = TRUE;
+        for (stage = 0;  stage < PROFILE_NUM_STAGES;  stage++)
+        {
+            if (stats[stage].Hist[bin] != 0)  binEmpty = FALSE;
+        }
+        if (binEmpty)  continue;
+
+        lowerLimit = (bin == 0) ? 0 : (1U << bin);
+        sprintf(textBuf, "%8u %6.1f  ", lowerLimit, (float) lowerLimit / 40);
+        putstr(textBuf);
+        for (stage = 0;  stage < PROFILE_NUM_STAGES;  stage++)
+        {
+            sprintf(textBuf, "%9u", (unsigned) stats[stage].Hist[bin]);
+            putstr(textBuf);
+        }
+        putNewLine();
+    }
+
+    sprintf(textBuf, "Block period: %d counts;  render ISR overruns (max > period): %s \n",
+            period, (stats[PROFILE_RENDER_ISR].Max > (uint32) period) ? "YES" : "none");
+    putstr(textBuf);
+}
+
+
 /*`````````````
  * Function:  Command option "diag -c"
  *
@@ -1612,7 +1967,8 @@ PRIVATE  void   CoreCycleTimerTest()
 {
     uint32  count;
 
-    TIMER2_IRQ_DISABLE();  // Stop IRQ's from audio ISR during test
+    AUDIO_DMA_IRQ_DISABLE();  // Stop IRQ's from audio ISRs during test
+    AUDIO_RENDER_IRQ_DISABLE();
 
     while ((milliseconds() & 0xF) != 15)  {/* Wait for ms timer pending... */}
     while ((milliseconds() & 0xF) != 0)   {/* ... rollover */}
@@ -1632,7 +1988,8 @@ PRIVATE  void   CoreCycleTimerTest()
         Delay_Nx25ns(40);
     }
 */    
-    TIMER2_IRQ_ENABLE();
+    AUDIO_RENDER_IRQ_ENABLE();
+    AUDIO_DMA_IRQ_ENABLE();
 }
 
 
@@ -26,6 +26,7 @@ void    Cmnd_eeprom( int argCount, char * argValue[] );
 void    Cmnd_info( int argCount, char * argValue[] );
 void    Cmnd_mimon( int argCount, char * argValue[] );
 void    Cmnd_sound( int argCount, char * argValue[] );
+void    Cmnd_mod( int argCount, char * argValue[] );
 void    Cmnd_util(int argCount, char *argValue[]);
 void    Cmnd_trace( int argCount, char * argValue[] );
 
@@ -1266,7 +1266,7 @@ PRIVATE  void  ScreenFunc_MainSettingsMenu(bool isNewScreen)
 PRIVATE  void  ScreenFunc_SetMidiInMode(bool isNewScreen)
 {
     bool   doRefresh = 0;
-    uint8  mode = g_Config.MidiInMode;   // can be 2 or 4
+    uint8  mode = g_Config.MidiInMode;   // 1..4
 
     if (isNewScreen)  // new screen
     {
@@ -1285,7 +1285,7 @@ PRIVATE  void  ScreenFunc_SetMidiInMode(bool isNewScreen)
         {
             if (ButtonCode() == 'C')  // change mode
             {
-                if (mode == 2)  mode = 4;  else  mode = 2;
+                if (++mode > OMNI_OFF_MONO)  mode = OMNI_ON_POLY;
                 g_Config.MidiInMode = mode;
                 StoreConfigData();
             }
@@ -1306,12 +1306,24 @@ PRIVATE  void  ScreenFunc_SetMidiInMode(bool isNewScreen)
         LCD_PosXY(4, 22);
         LCD_PutText("Current setting: ");
         
-        if (mode == 2)  
+        if (mode == 1)  
+        {
+            LCD_PutText("1");
+            LCD_PosXY(16, 32);
+            LCD_PutText("Omni-On, Poly");
+        }
+        else if (mode == 2)  
         {
             LCD_PutText("2");
             LCD_PosXY(16, 32);
             LCD_PutText("Omni-On, Mono");
         }
+        else if (mode == 3)  
+        {
+            LCD_PutText("3");
+            LCD_PosXY(16, 32);
+            LCD_PutText("Omni-Off, Poly");
+        }
         else if (mode == 4)  
         {
             LCD_PutText("4");
@@ -1532,7 +1544,7 @@ PRIVATE  void  ScreenFunc_SetPitchBendMode(bool isNewScreen)
 {
     static uint8  ctrlMode;   // may be: 0, 1, or 2
     static char  *pitchBendModeName[] = 
-            { "Disabled", "MIDI PB msg", "MIDI Exprn", "Analog CV.IN1" };
+            { "Disabled", "MIDI PB msg", "MIDI Exprn" };
     char   textBuf[40];
     bool   doRefresh = 0;
 
@@ -1565,7 +1577,7 @@ PRIVATE  void  ScreenFunc_SetPitchBendMode(bool isNewScreen)
             }
             if (ButtonCode() == 'C')  // change mode -- scroll thru options
             {
-                if (++ctrlMode >= 3)  ctrlMode = 0;    // *** change to 4 if Analog CV option ***
+                if (++ctrlMode > PITCH_BEND_BY_EXPRN_CC)  ctrlMode = 0;
                 g_Config.PitchBendCtrlMode = ctrlMode;
                 StoreConfigData();
                 SynthPrepare();  // instate new setting
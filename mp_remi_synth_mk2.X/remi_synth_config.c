@@ -3,13 +3,112 @@
  *
  *   Module handles persistent data storage in non-volatile memory.
  *   Customized for the REMI mk3 (mx440) sound synth using 24LCXX EEPROM.
+ *
+ *   Writes to EEPROM are deferred ("write-behind").  StoreConfigData() and StorePresetData()
+ *   only compare the working copy of the data (g_Config, g_Preset) with a RAM shadow of
+ *   the EEPROM contents and mark the 16-byte pages which differ.  The marked pages are
+ *   written by PersistentDataService(), one page per 1ms tick, after the data has been
+ *   unchanged for EEPROM_WRITE_DELAY_MS, so that a caller never waits for an EEPROM
+ *   programming cycle (5ms per page).  FlushPersistentData() writes all marked pages at
+ *   once, where the data must be in EEPROM before the function returns (e.g. MCU reset).
+ *
+ *   Changes are written to a journal in EEPROM blocks 2 and 3, rather than to the data
+ *   blocks (0 and 1) themselves.  A journal record (8 bytes) holds up to 4 changed bytes,
+ *   so a typical change, e.g. Preset selection, costs one 8-byte record, and the writes
+ *   are spread over the 32 pages of the journal, instead of the same data block page.
+ *   A page with more changes than fit in two records is written to the data block, if
+ *   the page has no changes in the journal.  When the journal is full, it is compacted:
+ *   each data block page with changes in the journal is written, then a journal header
+ *   with the next epoch number is written, which invalidates all records in the journal.
+ *   (The epoch number is included in the CRC of each record, but is not stored.)
+ *   FetchConfigData() and FetchPresetData() apply ("replay") the journal records to the
+ *   data read from the data blocks.
+ *
+ *   Each record has a CRC, so a record left incomplete by a power failure is not
+ *   replayed, nor are any records after it.  If power fails during a compaction, before
+ *   the header is written, the records are replayed over the data block pages already
+ *   written, which restores the values last written to the journal.
  */
 #include "remi_synth_main.h"
 #include "remi_synth_config.h"
 
+#define EEPROM_PAGE_SIZE          16    // 24LC04B/08B write page size (bytes)
+#define EEPROM_WRITE_DELAY_MS    200    // Write-behind delay after last change to data
+#define EEPROM_RETRY_DELAY_MS   1000    // Delay before re-trying a failed page write
+#define EEPROM_WRITE_TIMEOUT_MS   20    // Max. time allowed for programming cycle (5ms)
+
+#define JOURNAL_FIRST_BLOCK        2    // Journal occupies EEPROM blocks 2 and 3
+#define JOURNAL_SLOTS             64    // Journal size (records), incl. header (slot 0)
+#define RECORDS_PER_BLOCK         32    // Journal records per EEPROM block (256 bytes)
+#define RECORDS_PER_PAGE           2    // Journal records per EEPROM page
+#define JOURNAL_PAGE_RECORDS_MAX   2    // Max. records for changes in one data block page
+
+#define PAGES_IN(nbytes)   (((nbytes) + EEPROM_PAGE_SIZE - 1) / EEPROM_PAGE_SIZE)
+
+enum  EEPROM_Write_States
+{
+    WRITE_IDLE = 0,         // No page write in progress
+    WRITE_CYCLE_BUSY        // Waiting for EEPROM programming cycle to complete
+};
+
+enum  EEPROM_Write_Types
+{
+    WRITE_DATA_PAGE = 0,    // Data block page (g_Config or g_Preset)
+    WRITE_JOURNAL_RECORDS,  // Journal record(s), 1 or 2 in the same journal page
+    WRITE_JOURNAL_HEADER    // Journal header (end of compaction)
+};
+
+typedef struct Persistent_data_block
+{
+    uint8   *pData;         // Working copy of data (application access)
+    uint8   *pShadow;       // Copy of data as held in EEPROM (page multiple)
+    uint16  size;           // Size of data (bytes), max. 256
+    uint8   promBlock;      // EEPROM block number (0..3)
+    uint16  dirtyPages;     // Bit N set => page N differs from EEPROM, to be written
+    uint16  retryPages;     // Bit N set => page N write failed, to be re-written
+    uint16  journalPages;   // Bit N set => page N has changes held in journal
+
+} PersistBlock_t;
+
 EepromBlock0_t  g_Config;     // structure holding configuration data
 EepromBlock1_t  g_Preset;     // structure holding Preset parameters
 
+PRIVATE  uint8  m_ConfigShadow[PAGES_IN(sizeof(EepromBlock0_t)) * EEPROM_PAGE_SIZE];
+PRIVATE  uint8  m_PresetShadow[PAGES_IN(sizeof(EepromBlock1_t)) * EEPROM_PAGE_SIZE];
+
+PRIVATE  PersistBlock_t  m_PersistBlock[2] =
+{
+    { (uint8 *) &g_Config, m_ConfigShadow, MIN(sizeof(EepromBlock0_t), 256), 0, 0, 0, 0 },
+    { (uint8 *) &g_Preset, m_PresetShadow, MIN(sizeof(EepromBlock1_t), 256), 1, 0, 0, 0 }
+};
+
+PRIVATE  uint8   m_WriteState;        // EEPROM write state (enum EEPROM_Write_States)
+PRIVATE  uint16  m_WriteDelay_ms;     // Time remaining until next page write
+PRIVATE  uint8   m_WriteTimer_ms;     // Time elapsed in programming cycle
+PRIVATE  uint8   m_ActiveWrite;       // Type of write in progress (enum EEPROM_Write_Types)
+PRIVATE  uint8   m_ActiveBlock;       // Block index of data page being written
+PRIVATE  uint8   m_ActivePage;        // Page number of data page being written
+PRIVATE  uint16  m_JournalEpoch;      // Journal epoch number (in header record)
+PRIVATE  uint8   m_JournalSlot;       // Journal slot for next record (JOURNAL_SLOTS: full)
+PRIVATE  bool    m_Compacting;        // Journal compaction in progress
+PRIVATE  uint32  m_BytesWritten;      // Diagnostic counters...
+PRIVATE  uint32  m_Compactions;
+PRIVATE  uint32  m_WriteErrors;
+
+PRIVATE  void  LoadShadow(PersistBlock_t *pBlock, int fetchResult);
+PRIVATE  void  ReplayJournal(PersistBlock_t *pBlock);
+PRIVATE  int   ReadJournalPage(JournalRecord_t *pRecord, int slot);
+PRIVATE  uint16 RecordCheck(JournalRecord_t *pRecord, uint16 epoch);
+PRIVATE  bool  MarkDirtyPages(PersistBlock_t *pBlock);
+PRIVATE  int   CountJournalRecords(PersistBlock_t *pBlock, int page);
+PRIVATE  bool  WriteNextPage(void);
+PRIVATE  bool  WriteDataPage(int b, int page);
+PRIVATE  bool  WriteJournalRecords(int b, int page);
+PRIVATE  bool  WriteJournalHeader(void);
+PRIVATE  void  StartCompaction(void);
+PRIVATE  void  WriteCompleted(void);
+PRIVATE  void  WriteFailed(void);
+
 
 /*`````````````````````````````````````````````````````````````````````````````````````````````````
  *
@@ -43,6 +142,10 @@ void  DefaultConfigData(void)
     g_Config.AudioAmpldControlMode = 3;     // 0:Const, 1:ENV*Vel, 2:Exprn, 3:Auto
     g_Config.PresetLastSelected = 1;
 	g_Config.BatteryChargeFlag = 0;         // 1:charging ('Lite' variant only)
+    g_Config.Osc1InterpMode = OSC_INTERP_LINEAR;  // 0:Truncate, 1:Linear, 2:Hermite
+    g_Config.Osc2InterpMode = OSC_INTERP_LINEAR;
+    g_Config.PatchFadeTime_ms = 10;         // 0:Off (abrupt change), 5..20 ms
+    g_Config.SampleRate_kHz = SAMPLE_RATE_DEFAULT_HZ / 1000;  // 32, 40 or 48 kHz
     
     // Calibration constants (default settings)
     g_Config.ExpressionCalibr = 1.0;       // range 0.25 ~ 2.5
@@ -118,6 +221,23 @@ bool  CheckConfigData(void)
 }
 
 
+/*
+ *  Function replaces any configuration setting which is out of range, e.g. an option not
+ *  supported by this firmware version, by its default value.  To be called after the
+ *  config data have been read from EEPROM, so that every setting used as an index (e.g.
+ *  into a table of mode names) is valid.  The RAM copy only is changed.
+ */
+void  ValidateConfigData(void)
+{
+    if (g_Config.PitchBendCtrlMode > PITCH_BEND_BY_EXPRN_CC)  // e.g. 3 = Analog CV
+        g_Config.PitchBendCtrlMode = PITCH_BEND_DISABLED;
+    if (g_Config.Osc1InterpMode > OSC_INTERP_HERMITE)
+        g_Config.Osc1InterpMode = OSC_INTERP_LINEAR;
+    if (g_Config.Osc2InterpMode > OSC_INTERP_HERMITE)
+        g_Config.Osc2InterpMode = OSC_INTERP_LINEAR;
+}
+
+
 /*
  *  Function checks the integrity of persistent data stored in EEPROM block 1.
  *
@@ -141,7 +261,8 @@ bool  CheckPresetData(void)
 
 /*
  *  Function copies data from EEPROM block #0 to a RAM buffer where persistent data
- *  can be accessed by the application. If the operation is successful, the return
+ *  can be accessed by the application, and applies the changes held in the journal
+ *  (EEPROM blocks 2 and 3).  If the operation is successful, the return
  *  value will be equal to the size of the structure g_Config (bytes).
  *
  *  Return val:  (int) number of bytes successfully copied to the buffer, or,
@@ -153,6 +274,8 @@ int  FetchConfigData()
     int  result = EepromReadData((uint8 *) &g_Config, 0, 0, sizeof(g_Config));
 
     if (sizeof(g_Config) > 256)  result = ERROR;
+    LoadShadow(&m_PersistBlock[0], result);
+    ReplayJournal(&m_PersistBlock[0]);
 
     return  result;
 }
@@ -160,7 +283,8 @@ int  FetchConfigData()
 
 /*
  *  Function copies data from EEPROM block #1 to a RAM buffer where persistent data
- *  can be accessed by the application. If the operation is successful, the return
+ *  can be accessed by the application, and applies the changes held in the journal
+ *  (EEPROM blocks 2 and 3).  If the operation is successful, the return
  *  value will be equal to the size of the structure g_Preset (bytes).
  *
  *  Return val:  (int) number of bytes successfully copied to the buffer, or,
@@ -172,78 +296,547 @@ int  FetchPresetData()
     int  result = EepromReadData((uint8 *) &g_Preset, 1, 0, sizeof(g_Preset));
 
     if (sizeof(g_Preset) > 256)  result = ERROR;
+    LoadShadow(&m_PersistBlock[1], result);
+    ReplayJournal(&m_PersistBlock[1]);
 
     return  result;
 }
 
 
 /*
- *  Function copies data from a RAM buffer (holding current working
- *  values of persistent parameters) to the EEPROM block #0.
+ *  Function schedules data in the RAM buffer (holding current working values of
+ *  persistent parameters) to be copied to EEPROM block #0.  Only the bytes which
+ *  differ from the EEPROM contents are written (as journal records, or pages of the
+ *  data block), by PersistentDataService().
  *  <!> The size of the structure g_Config must not exceed 256 bytes.
  *
  *  Return val:  TRUE if the operation was successful, else FALSE.
  */
 bool  StoreConfigData()
 {
-    int    promAddr = 0;
-    int    bytesToCopy = sizeof(g_Config);
-    uint8  *pData = (uint8 *) &g_Config;
-    BOOL   result = TRUE;
+    BOOL   result = MarkDirtyPages(&m_PersistBlock[0]);
+
+    if (sizeof(g_Config) > 256)  result = FALSE;
+
+    return result;
+}
+
+
+/*
+ *  Function schedules data in the RAM buffer (holding current working values of
+ *  persistent parameters) to be copied to EEPROM block #1.  Only the bytes which
+ *  differ from the EEPROM contents are written (as journal records, or pages of the
+ *  data block), by PersistentDataService().
+ *  <!> The size of the structure g_Preset must not exceed 256 bytes.
+ *
+ *  Return val:  TRUE if the operation was successful, else FALSE.
+ */
+bool  StorePresetData()
+{
+    BOOL   result = MarkDirtyPages(&m_PersistBlock[1]);
+
+    if (sizeof(g_Preset) > 256)  result = FALSE;
 
-    if (sizeof(g_Config) > 256)
+    return result;
+}
+
+
+/*
+ *  EEPROM write-behind service routine, called once per 1ms tick from the background
+ *  task executive, after the synth control process.  The function never waits for the
+ *  EEPROM;  it either starts a write (journal records or a data block page), or checks
+ *  if a programming cycle is complete.
+ *
+ *  A page write (16 data bytes on the I2C bus at 400kHz) takes about 0.5ms.
+ */
+void  PersistentDataService()
+{
+    if (m_WriteState == WRITE_CYCLE_BUSY)
     {
-        bytesToCopy = 256;
-        result = FALSE;
+        if (!EepromIsBusy())
+        {
+            WriteCompleted();
+            m_WriteState = WRITE_IDLE;
+        }
+        else if (++m_WriteTimer_ms >= EEPROM_WRITE_TIMEOUT_MS)  // device not responding
+        {
+            WriteFailed();
+            m_WriteState = WRITE_IDLE;
+        }
+        return;
     }
 
-    while (bytesToCopy > 0)
+    if (m_WriteDelay_ms != 0)  { m_WriteDelay_ms--;  return; }
+
+    if (WriteNextPage())
     {
-        if (EepromWriteData(pData, 0, promAddr, 16) == ERROR)
+        m_WriteTimer_ms = 0;
+        m_WriteState = WRITE_CYCLE_BUSY;
+    }
+}
+
+
+/*
+ *  Function writes all pending (changed) data to the EEPROM, waiting for each page
+ *  programming cycle to complete, i.e. the data is in EEPROM when the function returns.
+ *
+ *  Return val:  TRUE if the operation was successful, else FALSE.
+ */
+bool  FlushPersistentData()
+{
+    uint32  errorCount = m_WriteErrors;
+    uint16  npolls;
+
+    m_WriteDelay_ms = 0;
+
+    do
+    {
+        if (m_WriteState == WRITE_CYCLE_BUSY)  // wait for write in progress to complete
         {
-            result = FALSE;
-            break;
+            for (npolls = 1000;  EepromIsBusy() && npolls != 0;  npolls--)  { ; }
+            if (npolls == 0)  WriteFailed();
+            else  WriteCompleted();
+            m_WriteState = WRITE_IDLE;
+        }
+
+        if (m_WriteErrors != errorCount)  break;
+
+        if (WriteNextPage())  m_WriteState = WRITE_CYCLE_BUSY;
+
+    } while (m_WriteState == WRITE_CYCLE_BUSY);
+
+    return  (m_WriteErrors == errorCount);
+}
+
+
+/*
+ *  Function returns the number of EEPROM writes pending, i.e. the number of data block
+ *  pages with changes not yet written, plus one if a journal compaction is in progress.
+ */
+int  PersistentDataPending()
+{
+    int  count = m_Compacting ? 1 : 0;
+    int  b, page;
+
+    for (b = 0;  b < 2;  b++)
+    {
+        for (page = 0;  page < 16;  page++)
+        {
+            if (m_PersistBlock[b].dirtyPages & (1 << page))  count++;
         }
-        promAddr += 16;
-        pData += 16;
-        bytesToCopy -= 16;
     }
 
-    return result;
+    return count;
 }
 
 
 /*
- *  Function copies data from a RAM buffer (holding current working
- *  values of persistent parameters) to the EEPROM block #1.
- *  <!> The size of the structure g_Preset must not exceed 256 bytes.
+ *  Diagnostic counters:  EEPROM bytes written since reset (journal records and data
+ *  block pages), journal compactions and failed writes.
+ */
+uint32  PersistentDataBytesWritten()
+{
+    return m_BytesWritten;
+}
+
+uint32  PersistentDataCompactions()
+{
+    return m_Compactions;
+}
+
+uint32  PersistentDataWriteErrors()
+{
+    return m_WriteErrors;
+}
+
+
+/*
+ *  Function initializes the RAM shadow of an EEPROM block with the data just fetched.
+ *  If the fetch failed, the shadow is set to the erased state (0xFF), so that every
+ *  page of the block will be written on the next call to the Store function.
+ */
+PRIVATE  void  LoadShadow(PersistBlock_t *pBlock, int fetchResult)
+{
+    memset(pBlock->pShadow, 0xFF, PAGES_IN(pBlock->size) * EEPROM_PAGE_SIZE);
+    if (fetchResult != ERROR)  memcpy(pBlock->pShadow, pBlock->pData, pBlock->size);
+    pBlock->dirtyPages = 0;
+    pBlock->retryPages = 0;
+    pBlock->journalPages = 0;
+}
+
+
+/*
+ *  Function applies the journal records for a data block to the data (and its shadow)
+ *  just fetched from the block, in the order written.  Replay stops at the first record
+ *  which is not valid (erased, incomplete or from an earlier epoch);  new records will be
+ *  appended there.  If the journal header is not valid, the journal is marked full, so
+ *  that it is initialized (by compaction) when a record is next to be written.
+ */
+PRIVATE  void  ReplayJournal(PersistBlock_t *pBlock)
+{
+    JournalRecord_t  record[RECORDS_PER_PAGE];
+    JournalRecord_t  *pRecord;
+    int   slot, offset, length;
+
+    m_Compacting = FALSE;
+    m_JournalSlot = JOURNAL_SLOTS;
+
+    if (ReadJournalPage(record, 0) == ERROR)  return;
+
+    m_JournalEpoch = record[0].Data[0] | ((uint16) record[0].Data[1] << 8);
+
+    if (record[0].Target != JOURNAL_HEADER || RecordCheck(&record[0], 0) != record[0].Check)
+    {
+        // Header not valid (e.g. header write incomplete, so the epoch number may be part
+        // old, part new) -- skip ahead, so that the next epoch is not one already used.
+        m_JournalEpoch += 0x100;
+        return;
+    }
+
+    for (slot = 1;  slot < JOURNAL_SLOTS;  slot++)
+    {
+        if ((slot % RECORDS_PER_PAGE) == 0 && ReadJournalPage(record, slot) == ERROR)
+            return;  // journal state unknown -- leave marked full
+
+        pRecord = &record[slot % RECORDS_PER_PAGE];
+        if (RecordCheck(pRecord, m_JournalEpoch) != pRecord->Check)  break;
+        if ((pRecord->Target & 0xEF) == 0 || (pRecord->Target & 0xE8) != 0)  break;
+        if ((pRecord->Target & 7) > JOURNAL_DATA_MAX)  break;
+        if ((pRecord->Target >> 4) != pBlock->promBlock)  continue;  // other block
+
+        offset = pRecord->Offset;
+        length = pRecord->Target & 7;
+        if ((offset + length) > pBlock->size)  break;  // block format has changed
+
+        memcpy(&pBlock->pData[offset], pRecord->Data, length);
+        memcpy(&pBlock->pShadow[offset], pRecord->Data, length);
+        pBlock->journalPages |= 1 << (offset / EEPROM_PAGE_SIZE);
+        pBlock->journalPages |= 1 << ((offset + length - 1) / EEPROM_PAGE_SIZE);
+    }
+
+    m_JournalSlot = slot;
+}
+
+
+/*
+ *  Function reads the EEPROM page holding the given journal record (slot) and the
+ *  other record(s) in the same page.
  *
- *  Return val:  TRUE if the operation was successful, else FALSE.
+ *  Return val:  ERROR (-1) if the EEPROM could not be accessed, else 0.
  */
-bool  StorePresetData()
+PRIVATE  int  ReadJournalPage(JournalRecord_t *pRecord, int slot)
 {
-    int    promAddr = 0;
-    int    bytesToCopy = sizeof(g_Preset);
-    uint8  *pData = (uint8 *) &g_Preset;
-    BOOL   result = TRUE;
+    slot -= slot % RECORDS_PER_PAGE;
 
-    if (sizeof(g_Preset) > 256)
+    if (EepromReadData((uint8 *) pRecord, JOURNAL_FIRST_BLOCK + slot / RECORDS_PER_BLOCK,
+                       (slot % RECORDS_PER_BLOCK) * sizeof(JournalRecord_t),
+                       EEPROM_PAGE_SIZE) == ERROR)  return ERROR;
+
+    return 0;
+}
+
+
+/*
+ *  Function computes the CRC-16 (CCITT polynomial) of a journal record, excluding
+ *  the check word, followed by the given epoch number (0 for the header record).
+ *  The epoch follows the record data, rather than being the CRC initial value, so that
+ *  a change in epoch cannot be cancelled by a change in the first bytes of a record
+ *  (e.g. an incomplete write over a record of an earlier epoch).
+ */
+PRIVATE  uint16  RecordCheck(JournalRecord_t *pRecord, uint16 epoch)
+{
+    uint8   bytes[sizeof(JournalRecord_t)];
+    uint16  crc = 0xFFFF;
+    int     i, bit;
+
+    memcpy(bytes, pRecord, sizeof(JournalRecord_t) - 2);
+    bytes[sizeof(JournalRecord_t) - 2] = epoch & 0xFF;
+    bytes[sizeof(JournalRecord_t) - 1] = epoch >> 8;
+
+    for (i = 0;  i < (int) sizeof(JournalRecord_t);  i++)
     {
-        bytesToCopy = 256;
-        result = FALSE;
+        crc ^= (uint16) bytes[i] << 8;
+
+        for (bit = 0;  bit < 8;  bit++)
+        {
+            if (crc & 0x8000)  crc = (crc << 1) ^ 0x1021;
+            else  crc = crc << 1;
+        }
     }
 
-    while (bytesToCopy > 0)
+    return crc;
+}
+
+
+/*
+ *  Function compares the working copy of a block of persistent data with the shadow
+ *  (EEPROM contents) and marks each page which differs, to be written.
+ *  If any page is marked, the write-behind delay is restarted.
+ *
+ *  Return val:  TRUE (no error is possible)
+ */
+PRIVATE  bool  MarkDirtyPages(PersistBlock_t *pBlock)
+{
+    int   page, offset, nbytes;
+
+    for (page = 0;  page < PAGES_IN(pBlock->size);  page++)
     {
-        if (EepromWriteData(pData, 1, promAddr, 16) == ERROR)
+        offset = page * EEPROM_PAGE_SIZE;
+        nbytes = MIN(EEPROM_PAGE_SIZE, pBlock->size - offset);
+
+        if (memcmp(&pBlock->pData[offset], &pBlock->pShadow[offset], nbytes) != 0)
         {
-            result = FALSE;
-            break;
+            pBlock->dirtyPages |= (1 << page);
+            m_WriteDelay_ms = EEPROM_WRITE_DELAY_MS;
         }
-        promAddr += 16;
-        pData += 16;
-        bytesToCopy -= 16;
     }
 
-    return result;
+    return TRUE;
+}
+
+
+/*
+ *  Function returns the number of journal records needed to hold the changes in a page,
+ *  i.e. the bytes which differ from the shadow, in runs of up to JOURNAL_DATA_MAX bytes.
+ */
+PRIVATE  int  CountJournalRecords(PersistBlock_t *pBlock, int page)
+{
+    int   offset = page * EEPROM_PAGE_SIZE;
+    int   end = offset + MIN(EEPROM_PAGE_SIZE, pBlock->size - offset);
+    int   count = 0;
+
+    while (offset < end)
+    {
+        if (pBlock->pData[offset] != pBlock->pShadow[offset])
+        {
+            count++;
+            offset += JOURNAL_DATA_MAX;
+        }
+        else  offset++;
+    }
+
+    return count;
+}
+
+
+/*
+ *  Function finds the next page with changes to be written and starts the write,
+ *  without waiting for the programming cycle to complete.  Changes are written to
+ *  the journal, unless the journal is being compacted, or the page has too many
+ *  changes and none already in the journal, in which case the page is written to the
+ *  data block.  When no data block pages remain to be written during a compaction,
+ *  the new journal header is written.
+ *
+ *  Return val:  TRUE if a write was started;  FALSE if none (or I2C bus error).
+ */
+PRIVATE  bool  WriteNextPage()
+{
+    PersistBlock_t  *pBlock;
+    uint16  pageMask;
+    int     b, page, records;
+    bool    writePage;
+
+    for (b = 0;  b < 2;  b++)
+    {
+        pBlock = &m_PersistBlock[b];
+
+        for (page = 0;  pBlock->dirtyPages != 0;  page++)
+        {
+            pageMask = 1 << page;
+            if ((pBlock->dirtyPages & pageMask) == 0)  continue;
+
+            records = CountJournalRecords(pBlock, page);
+            if (records == 0 && (pBlock->retryPages & pageMask) == 0)  // page unchanged
+            {
+                pBlock->dirtyPages &= ~pageMask;
+                continue;
+            }
+
+            writePage = m_Compacting || ((pBlock->journalPages & pageMask) == 0
+                        && (records > JOURNAL_PAGE_RECORDS_MAX
+                            || (pBlock->retryPages & pageMask) != 0));
+
+            if (!writePage && m_JournalSlot >= JOURNAL_SLOTS)  // journal full
+            {
+                StartCompaction();
+                writePage = TRUE;
+            }
+
+            if (writePage)  return  WriteDataPage(b, page);
+            else  return  WriteJournalRecords(b, page);
+        }
+    }
+
+    if (m_Compacting)  return  WriteJournalHeader();
+
+    return FALSE;
+}
+
+
+/*
+ *  Function starts the write of a data block page, from the shadow.
+ *  The page is written even if unchanged, if a previous write of the page failed.
+ */
+PRIVATE  bool  WriteDataPage(int b, int page)
+{
+    PersistBlock_t  *pBlock = &m_PersistBlock[b];
+    int   offset = page * EEPROM_PAGE_SIZE;
+
+    pBlock->dirtyPages &= ~(1 << page);
+    pBlock->retryPages &= ~(1 << page);
+    memcpy(&pBlock->pShadow[offset], &pBlock->pData[offset],
+           MIN(EEPROM_PAGE_SIZE, pBlock->size - offset));
+
+    m_ActiveWrite = WRITE_DATA_PAGE;
+    m_ActiveBlock = b;
+    m_ActivePage = page;
+
+    if (EepromWriteStart(&pBlock->pShadow[offset], pBlock->promBlock, offset,
+                         EEPROM_PAGE_SIZE) == ERROR)
+    {
+        WriteFailed();
+        return FALSE;
+    }
+
+    m_BytesWritten += EEPROM_PAGE_SIZE;
+    return TRUE;
+}
+
+
+/*
+ *  Function starts the write of journal records holding the changes in a data block
+ *  page, as many as fit in the current journal page (1 or 2 records).  If there are
+ *  more changes in the data block page, it remains marked to be written.
+ */
+PRIVATE  bool  WriteJournalRecords(int b, int page)
+{
+    PersistBlock_t   *pBlock = &m_PersistBlock[b];
+    JournalRecord_t  record[RECORDS_PER_PAGE];
+    JournalRecord_t  *pRecord;
+    int   offset = page * EEPROM_PAGE_SIZE;
+    int   end = offset + MIN(EEPROM_PAGE_SIZE, pBlock->size - offset);
+    int   maxRecords = RECORDS_PER_PAGE - (m_JournalSlot % RECORDS_PER_PAGE);
+    int   records = 0;
+    int   length;
+
+    while (offset < end && records < maxRecords)
+    {
+        if (pBlock->pData[offset] == pBlock->pShadow[offset])  { offset++;  continue; }
+
+        length = MIN(JOURNAL_DATA_MAX, end - offset);
+        pRecord = &record[records++];
+        pRecord->Target = (pBlock->promBlock << 4) | length;
+        pRecord->Offset = offset;
+        memset(pRecord->Data, 0xFF, JOURNAL_DATA_MAX);
+        memcpy(pRecord->Data, &pBlock->pData[offset], length);
+        pRecord->Check = RecordCheck(pRecord, m_JournalEpoch);
+
+        memcpy(&pBlock->pShadow[offset], &pBlock->pData[offset], length);
+        offset += length;
+    }
+
+    if (CountJournalRecords(pBlock, page) == 0)  pBlock->dirtyPages &= ~(1 << page);
+    pBlock->journalPages |= (1 << page);
+
+    m_ActiveWrite = WRITE_JOURNAL_RECORDS;
+
+    if (EepromWriteStart((uint8 *) record, JOURNAL_FIRST_BLOCK + m_JournalSlot / RECORDS_PER_BLOCK,
+                         (m_JournalSlot % RECORDS_PER_BLOCK) * sizeof(JournalRecord_t),
+                         records * sizeof(JournalRecord_t)) == ERROR)
+    {
+        WriteFailed();
+        return FALSE;
+    }
+
+    m_JournalSlot += records;
+    m_BytesWritten += records * sizeof(JournalRecord_t);
+    return TRUE;
+}
+
+
+/*
+ *  Function starts the write of the journal header for the next epoch, which completes
+ *  a compaction.  All records in the journal then become invalid (earlier epoch).
+ */
+PRIVATE  bool  WriteJournalHeader()
+{
+    JournalRecord_t  header = { JOURNAL_HEADER, 0, { 0, 0, 'J', 'R' }, 0 };
+    uint16  epoch = m_JournalEpoch + 1;
+
+    header.Data[0] = epoch & 0xFF;
+    header.Data[1] = epoch >> 8;
+    header.Check = RecordCheck(&header, 0);
+
+    m_ActiveWrite = WRITE_JOURNAL_HEADER;
+
+    if (EepromWriteStart((uint8 *) &header, JOURNAL_FIRST_BLOCK, 0,
+                         sizeof(JournalRecord_t)) == ERROR)
+    {
+        WriteFailed();
+        return FALSE;
+    }
+
+    m_BytesWritten += sizeof(JournalRecord_t);
+    return TRUE;
+}
+
+
+/*
+ *  Function starts a journal compaction:  every data block page with changes in the
+ *  journal is marked to be written (from the shadow, which holds the changes), after
+ *  which a new journal header is written.
+ */
+PRIVATE  void  StartCompaction()
+{
+    PersistBlock_t  *pBlock;
+    int   b;
+
+    for (b = 0;  b < 2;  b++)
+    {
+        pBlock = &m_PersistBlock[b];
+        pBlock->dirtyPages |= pBlock->journalPages;
+        pBlock->retryPages |= pBlock->journalPages;
+        pBlock->journalPages = 0;
+    }
+
+    m_Compacting = TRUE;
+    m_Compactions++;
+}
+
+
+/*
+ *  Function is called when the EEPROM programming cycle of a write is complete.
+ *  A compaction is complete when its journal header has been written.
+ */
+PRIVATE  void  WriteCompleted()
+{
+    if (m_ActiveWrite == WRITE_JOURNAL_HEADER)
+    {
+        m_JournalEpoch++;
+        m_JournalSlot = 1;
+        m_Compacting = FALSE;
+    }
+}
+
+
+/*
+ *  Function is called when a write fails (I2C bus error or programming cycle timeout).
+ *  A data block page is marked to be re-written (even if unchanged).  If journal
+ *  records were being written, the journal may now hold a corrupt record, beyond which
+ *  no records would be replayed, so a compaction is started.  A failed journal header
+ *  write is simply repeated (compaction still in progress).
+ */
+PRIVATE  void  WriteFailed()
+{
+    PersistBlock_t  *pBlock = &m_PersistBlock[m_ActiveBlock];
+
+    if (m_ActiveWrite == WRITE_DATA_PAGE)
+    {
+        pBlock->dirtyPages |= (1 << m_ActivePage);
+        pBlock->retryPages |= (1 << m_ActivePage);
+    }
+    else if (m_ActiveWrite == WRITE_JOURNAL_RECORDS)  StartCompaction();
+
+    m_WriteDelay_ms = EEPROM_RETRY_DELAY_MS;
+    m_WriteErrors++;
 }
@@ -19,7 +19,6 @@
 #define PITCH_BEND_DISABLED         0    // Pitch Bend disabled
 #define PITCH_BEND_BY_MIDI_PB       1    // Pitch Bend uses MIDI pitch-bend data
 #define PITCH_BEND_BY_EXPRN_CC      2    // Pitch Bend uses MIDI expression CC data
-#define PITCH_BEND_BY_ANALOG_CV     3    // Pitch Bend uses analog CV input (todo)
 
 // Possible values for configuration parameter: g_Config.AudioAmpldControlMode
 #define AMPLD_CTRL_FIXED_FS         0    // Output ampld is fixed (full-scale)
@@ -60,6 +59,10 @@ typedef struct Eeprom_block0_structure
     uint8   AudioAmpldControlMode;    // Ampld ctrl = 0:Fixed, 1:Env*Vel, 2:Exprn, 3:Auto
     uint8   PresetLastSelected;       // Preset last selected (0..7)
     uint8   BatteryChargeFlag;        // Flag set TRUE in battery charge state
+    uint8   Osc1InterpMode;           // OSC1 wave-table interpolation (0:Trunc, 1:Lin, 2:Herm)
+    uint8   Osc2InterpMode;           // OSC2 wave-table interpolation (0:Trunc, 1:Lin, 2:Herm)
+    uint8   PatchFadeTime_ms;         // Preset change crossfade time (0:Off, 5..20 ms)
+    uint8   SampleRate_kHz;           // Audio sample rate (32, 40 or 48 kHz)
     
     // Calibration param's (not settable via "config" cmd; use "set" cmd) 
     float   ExpressionCalibr;         // Expression calibration factor (gain)
@@ -87,24 +90,34 @@ typedef struct Eeprom_block1_structure
 } EepromBlock1_t;
 
 
+// EEPROM blocks 2 and 3 hold a journal of changes to blocks 0 and 1 (see remi_synth_config.c)
+//
+#define JOURNAL_HEADER            0x80   // Value of JournalRecord_t.Target in header record
+#define JOURNAL_DATA_MAX             4   // Max. data bytes per journal record
+
+// The check word is a CRC-16 of bytes 0..5 followed by the journal epoch number, so that
+// records written in an earlier epoch are not valid.
+// In the header record, Data[0..1] holds the epoch number;  the CRC is of bytes 0..5 and 0.
+typedef struct Eeprom_journal_record
+{
+    uint8   Target;                   // EEPROM block (b4) and data length (b2:0, 1..4)
+    uint8   Offset;                   // Offset of data in EEPROM block (bytes)
+    uint8   Data[JOURNAL_DATA_MAX];   // New value of data
+    uint16  Check;                    // CRC-16 of bytes 0..5 and epoch number
+
+} JournalRecord_t;
+
+
 typedef struct Eeprom_block2_structure
 {
-    uint32 checkDword;
-    ////
-    //     (block not used yet)
-    ////
-    uint32 EndOfDataBlockCode;
+    JournalRecord_t  Record[32];      // Journal header (record 0) and records 1..31
 
 } EepromBlock2_t;
 
 
 typedef struct Eeprom_block3_structure
 {
-    uint32 checkDword;
-    ////
-    //     (block not used yet)
-    ////
-    uint32 EndOfDataBlockCode;
+    JournalRecord_t  Record[32];      // Journal records 32..63
 
 } EepromBlock3_t;
 
@@ -120,11 +133,18 @@ extern  EepromBlock1_t  g_Preset;     // structure holding Preset parameters
 void  DefaultConfigData(void);
 void  DefaultPresetData(void);
 bool  CheckConfigData(void);
+void  ValidateConfigData(void);
 bool  CheckPresetData(void);
 int   FetchConfigData(void);
 int   FetchPresetData(void);
 bool  StoreConfigData(void);
 bool  StorePresetData(void);
+void  PersistentDataService(void);
+bool  FlushPersistentData(void);
+int   PersistentDataPending(void);
+uint32  PersistentDataBytesWritten(void);
+uint32  PersistentDataCompactions(void);
+uint32  PersistentDataWriteErrors(void);
 
 
 #endif // REMI_SYNTH_CONFIG_H
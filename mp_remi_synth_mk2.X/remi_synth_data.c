@@ -38,8 +38,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         0,      // FR: Filter Resonance x10000 (0..9990, 0:Bypass)
         0,      // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        10,     // EA: Envelope Attack time (5..5000+ ms)
+        10,     // EA: Envelope Attack time (1..5000+ ms)
         0,      // EP: Envelope Peak time (0..5000+ ms)
         10,     // ED: Envelope Decay time (5..5000+ ms)
         100,    // ER: Envelope Release time (5..5000+ ms)
@@ -70,8 +71,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         0,      // FR: Filter Resonance x10000 (0..9990, 0:Bypass)
         0,      // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        10,     // EA: Envelope Attack time (5..5000+ ms)
+        10,     // EA: Envelope Attack time (1..5000+ ms)
         0,      // EP: Envelope Peak time (0..5000+ ms)
         10,     // ED: Envelope Decay time (5..5000+ ms)
         100,    // ER: Envelope Release time (5..5000+ ms)
@@ -102,8 +104,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         0,      // FR: Filter Resonance x10000 (0..9990, 0:Bypass)
         0,      // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        10,     // EA: Envelope Attack time (5..5000+ ms)
+        10,     // EA: Envelope Attack time (1..5000+ ms)
         0,      // EP: Envelope Peak time (0..5000+ ms)
         10,     // ED: Envelope Decay time (5..5000+ ms)
         100,    // ER: Envelope Release time (5..5000+ ms)
@@ -134,8 +137,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         0,      // FR: Filter Resonance x10000 (0..9990, 0:Bypass)
         0,      // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        10,     // EA: Envelope Attack time (5..5000+ ms)
+        10,     // EA: Envelope Attack time (1..5000+ ms)
         0,      // EP: Envelope Peak time (0..5000+ ms)
         10,     // ED: Envelope Decay time (5..5000+ ms)
         100,    // ER: Envelope Release time (5..5000+ ms)
@@ -167,8 +171,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         9700,   // FR: Filter Resonance x10000  (0..9990, 0:Bypass)
         15,     // FF: Filter Freq/Offset (semitone#, 0..108)
         1,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
 
-        20,     // EA: Envelope Attack time (5..5000+ ms)
+        20,     // EA: Envelope Attack time (1..5000+ ms)
         0,      // EP: Envelope Peak time (0..5000+ ms)
         10,     // ED: Envelope Decay time (5..5000+ ms)
         100,    // ER: Envelope Release time (5..5000+ ms)
@@ -199,8 +204,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         0,      // FR: Filter Resonance x10000 (0..9990, 0:Bypass)
         0,      // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        20,     // EA: Envelope Attack time (5..5000+ ms)
+        20,     // EA: Envelope Attack time (1..5000+ ms)
         0,      // EP: Envelope Peak time (0..5000+ ms)
         10,     // ED: Envelope Decay time (5..5000+ ms)
         100,    // ER: Envelope Release time (5..5000+ ms)
@@ -231,8 +237,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         0,      // FR: Filter Resonance x10000 (0..9990, 0:Bypass)
         0,      // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        10,     // EA: Envelope Attack time (5..5000+ ms)
+        10,     // EA: Envelope Attack time (1..5000+ ms)
         0,      // EP: Envelope Peak time (0..5000+ ms)
         10,     // ED: Envelope Decay time (5..5000+ ms)
         100,    // ER: Envelope Release time (5..5000+ ms)
@@ -263,8 +270,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         0,      // FR: Filter Resonance x10000 (0..9990, 0:Bypass)
         0,      // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        20,     // EA: Envelope Attack time (5..5000+ ms)
+        20,     // EA: Envelope Attack time (1..5000+ ms)
         0,      // EP: Envelope Peak time (0..5000+ ms)
         10,     // ED: Envelope Decay time (5..5000+ ms)
         100,    // ER: Envelope Release time (5..5000+ ms)
@@ -295,8 +303,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         9700,   // FR: Filter Resonance x10000 (0..9990, 0:Bypass)
         9,      // FF: Filter Freq/Offset (semitone#, 0..108)
         1,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        20,     // EA: Envelope Attack time (5..5000+ ms)
+        20,     // EA: Envelope Attack time (1..5000+ ms)
         0,      // EP: Envelope Peak time (0..5000+ ms)
         10,     // ED: Envelope Decay time (5..5000+ ms)
         100,    // ER: Envelope Release time (5..5000+ ms)
@@ -328,8 +337,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         9500,   // FR: Filter Resonance x10000  (0..9990, 0:Bypass)
         60,     // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        30,     // EA: Envelope Attack time (5..5000+ ms)
+        30,     // EA: Envelope Attack time (1..5000+ ms)
         0,      // EP: Envelope Peak time (0..5000+ ms)
         10,     // ED: Envelope Decay time (5..5000+ ms)
         10,     // ER: Envelope Release time (5..5000+ ms)
@@ -361,8 +371,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         0,      // FR: Filter Resonance x10000 (0..9990, 0:Bypass)
         0,      // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        5,      // EA: Envelope Attack time (5..5000+ ms)
+        5,      // EA: Envelope Attack time (1..5000+ ms)
         0,      // EP: Envelope Peak time (0..5000+ ms)
         5,      // ED: Envelope Decay time (5..5000+ ms)
         10,     // ER: Envelope Release time (5..5000+ ms)
@@ -393,8 +404,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         0,      // FR: Filter Resonance x10000 (0..9990, 0:Bypass)
         0,      // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        5,      // EA: Envelope Attack time (5..5000+ ms)
+        5,      // EA: Envelope Attack time (1..5000+ ms)
         50,     // EP: Envelope Peak time (0..5000+ ms)
         100,    // ED: Envelope Decay time (5..5000+ ms)
         50,     // ER: Envelope Release time (5..5000+ ms)
@@ -425,8 +437,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         0,      // FR: Filter Resonance x10000 (0..9990, 0:Bypass)
         0,      // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        5,      // EA: Envelope Attack time (5..5000+ ms)
+        5,      // EA: Envelope Attack time (1..5000+ ms)
         50,     // EP: Envelope Peak time (0..5000+ ms)
         100,    // ED: Envelope Decay time (5..5000+ ms)
         50,     // ER: Envelope Release time (5..5000+ ms)
@@ -457,8 +470,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         0,      // FR: Filter Resonance x10000 (0..9990, 0:Bypass)
         0,      // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        5,      // EA: Envelope Attack time (5..5000+ ms)
+        5,      // EA: Envelope Attack time (1..5000+ ms)
         50,     // EP: Envelope Peak time (0..5000+ ms)
         100,    // ED: Envelope Decay time (5..5000+ ms)
         50,     // ER: Envelope Release time (5..5000+ ms)
@@ -489,8 +503,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         0,      // FR: Filter Resonance x10000 (0..9990, 0:Bypass)
         0,      // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        5,      // EA: Envelope Attack time (5..5000+ ms)
+        5,      // EA: Envelope Attack time (1..5000+ ms)
         0,      // EP: Envelope Peak time (0..5000+ ms)
         5,      // ED: Envelope Decay time (5..5000+ ms)
         10,     // ER: Envelope Release time (5..5000+ ms)
@@ -521,8 +536,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         0,      // FR: Filter Resonance x10000 (0..9990, 0:Bypass)
         0,      // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        10,     // EA: Envelope Attack time (5..5000+ ms)
+        10,     // EA: Envelope Attack time (1..5000+ ms)
         50,     // EP: Envelope Peak time (0..5000+ ms)
         100,    // ED: Envelope Decay time (5..5000+ ms)
         10,     // ER: Envelope Release time (5..5000+ ms)
@@ -553,8 +569,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         0,      // FR: Filter Resonance x10000 (0..9990, 0:Bypass)
         0,      // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        10,     // EA: Envelope Attack time (5..5000+ ms)
+        10,     // EA: Envelope Attack time (1..5000+ ms)
         50,     // EP: Envelope Peak time (0..5000+ ms)
         100,    // ED: Envelope Decay time (5..5000+ ms)
         10,     // ER: Envelope Release time (5..5000+ ms)
@@ -585,8 +602,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         0,      // FR: Filter Resonance x10000 (0..9990, 0:Bypass)
         0,      // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        5,      // EA: Envelope Attack time (5..5000+ ms)
+        5,      // EA: Envelope Attack time (1..5000+ ms)
         50,     // EP: Envelope Peak time (0..5000+ ms)
         100,    // ED: Envelope Decay time (5..5000+ ms)
         50,     // ER: Envelope Release time (5..5000+ ms)
@@ -617,8 +635,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         0,      // FR: Filter Resonance x10000 (0..9990, 0:Bypass)
         0,      // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        5,      // EA: Envelope Attack time (5..5000+ ms)
+        5,      // EA: Envelope Attack time (1..5000+ ms)
         50,     // EP: Envelope Peak time (0..5000+ ms)
         100,    // ED: Envelope Decay time (5..5000+ ms)
         50,     // ER: Envelope Release time (5..5000+ ms)
@@ -650,8 +669,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         9500,   // FR: Filter Resonance x10000  (0..9990, 0:Bypass)
         60,     // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        10,     // EA: Envelope Attack time (5..5000+ ms)
+        10,     // EA: Envelope Attack time (1..5000+ ms)
         50,     // EP: Envelope Peak time (0..5000+ ms)
         500,    // ED: Envelope Decay time (5..5000+ ms)
         50,     // ER: Envelope Release time (5..5000+ ms)
@@ -682,8 +702,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         9500,   // FR: Filter Resonance x10000  (0..9990, 0:Bypass)
         60,     // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        10,     // EA: Envelope Attack time (5..5000+ ms)
+        10,     // EA: Envelope Attack time (1..5000+ ms)
         50,     // EP: Envelope Peak time (0..5000+ ms)
         1000,   // ED: Envelope Decay time (5..5000+ ms)
         50,     // ER: Envelope Release time (5..5000+ ms)
@@ -714,8 +735,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         9500,   // FR: Filter Resonance x10000  (0..9990, 0:Bypass)
         60,     // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        5,      // EA: Envelope Attack time (5..5000+ ms)
+        5,      // EA: Envelope Attack time (1..5000+ ms)
         50,     // EP: Envelope Peak time (0..5000+ ms)
         1000,   // ED: Envelope Decay time (5..5000+ ms)
         1000,   // ER: Envelope Release time (5..5000+ ms)
@@ -747,8 +769,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         9800,   // FR: Filter Resonance x10000 (0..9999, 0:Off/Bypass)
         24,     // FF: Filter Freq/Offset (semitone#, 0..108)
         1,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
 
-        10,     // EA: Envelope Attack time (5..5000+ ms)
+        10,     // EA: Envelope Attack time (1..5000+ ms)
         0,      // EP: Envelope Peak time (0..5000+ ms)
         5,      // ED: Envelope Decay time (5..5000+ ms)
         50,     // ER: Envelope Release time (5..5000+ ms)
@@ -779,8 +802,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         9500,   // FR: Filter Resonance x10000  (0..9990, 0:Bypass)
         60,     // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        20,     // EA: Envelope Attack time (5..5000+ ms)
+        20,     // EA: Envelope Attack time (1..5000+ ms)
         50,     // EP: Envelope Peak time (0..5000+ ms)
         1000,   // ED: Envelope Decay time (5..5000+ ms)
         1000,   // ER: Envelope Release time (5..5000+ ms)
@@ -811,8 +835,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         9500,   // FR: Filter Resonance x10000  (0..9990, 0:Bypass)
         60,     // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        20,     // EA: Envelope Attack time (5..5000+ ms)
+        20,     // EA: Envelope Attack time (1..5000+ ms)
         50,     // EP: Envelope Peak time (0..5000+ ms)
         1000,   // ED: Envelope Decay time (5..5000+ ms)
         1000,   // ER: Envelope Release time (5..5000+ ms)
@@ -844,8 +869,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         0,      // FR: Filter Resonance x10000 (0..9999, 0:Off/bypass)
         0,      // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        50,     // EA: Envelope Attack time (5..5000+ ms)
+        50,     // EA: Envelope Attack time (1..5000+ ms)
         0,      // EP: Envelope Peak time (0..5000+ ms)
         1000,   // ED: Envelope Decay time (5..5000+ ms)
         100,    // ER: Envelope Release time (5..5000+ ms)
@@ -876,8 +902,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         0,      // FR: Filter Resonance x10000 (0..9990, 0:Bypass)
         0,      // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
                 
-        50,     // EA: Envelope Attack time (5..5000+ ms)
+        50,     // EA: Envelope Attack time (1..5000+ ms)
         0,      // EP: Envelope Peak time (0..5000+ ms)
         10,     // ED: Envelope Decay time (5..5000+ ms)
         500,    // ER: Envelope Release time (5..5000+ ms)
@@ -908,8 +935,9 @@ const  PatchParamTable_t  g_PatchProgram[] =
         0,      // FR: Filter Resonance x10000 (0..9990, 0:Off/Bypass)
         0,      // FF: Filter Freq/Offset (semitone#, 0..108)
         0,      // FT: Filter Note Tracking (0:Off, 1:On)
+        0,      // FM: Filter Mode (0:Band-pass, 1:Low-pass, 2:High-pass)
 
-        30,     // EA: Envelope Attack time (5..5000+ ms)
+        30,     // EA: Envelope Attack time (1..5000+ ms)
         0,      // EP: Envelope Peak time (0..5000+ ms)
         10,     // ED: Envelope Decay time (5..5000+ ms)
         200,    // ER: Envelope Release time (5..5000+ ms)
@@ -9,19 +9,33 @@
 #include "../Common/system_def.h"
 #include "pic32_low_level.h"
 
-#define SAMPLE_RATE_HZ        (40000)    // For wave-table Oscillators
+#define SAMPLE_RATE_DEFAULT_HZ  (40000)  // Audio sample rate, unless configured otherwise
+#define SAMPLE_RATE_MAX_HZ      (48000)  // Highest selectable audio sample rate
+#define AUDIO_BLOCK_SIZE           32    // Samples rendered per audio block (max. 64)
+#define SYNTH_VOICES_MAX            4    // Number of voices in pool (polyphony)
+#define VOICE_MIX_GAIN_RISE_MS     20    // Voice mix gain rise time, 0 to 1.0 (ms)
+#define AUDIO_RENDER_BUDGET_PC     75    // Max. portion of block period for render (%)
 #define PARTIAL_ORDER_MAX          16    // Highest partial order for waveform generator
+#define SYNTH_EVENT_QUEUE_SIZE     32    // Scheduled synth events pending (power of 2)
+#define SYNTH_EVENT_LATENCY_US   1500    // Event scheduling latency (microseconds)
 
-#define REVERB_DELAY_MAX_SIZE    2000    // samples 
-#define REVERB_LOOP_TIME_SEC     0.04    // seconds (max. 0.05 sec.)
-#define REVERB_DECAY_TIME_SEC     1.5    // seconds
+#define REVERB_FDN_LINES            4    // Reverb feedback delay network lines (fixed)
+#define REVERB_DELAY_MAX_SIZE    1980    // samples, sum of FDN delay line lengths
+#define REVERB_DECAY_TIME_SEC     1.5    // seconds (60dB decay)
+#ifndef REVERB_DELAY_16BIT  // may be overridden by compiler option
+#define REVERB_DELAY_16BIT          1    // Reverb delay lines hold packed int16 samples
+#endif
+#define REVERB_SAMPLE_SHIFT         7    // Scale fixed_t to int16 delay sample (+/-4.0)
 
 #define USER_WAVE_TABLE_ID          0   
 #define WAVE_TABLE_MAXIMUM_SIZE  2600    // samples
-#define REVERB_DELAY_MAX_SIZE    2000    // samples (max. 0.05 sec.)
 #define SINE_WAVE_TABLE_SIZE     1260    // samples (for g_sinewave[] LUT)
 #define SQUARE_WAVE_ID             44    // waveform ID for square-wave
 #define SAWTOOTH_WAVE_ID           77    // waveform ID for sawtooth-wave
+#define WAVE_MIPMAP_LEVELS          7    // Band-limited table levels per osc. (incl. level 0)
+#define WAVE_MIPMAP_HARMONICS_MAX  64    // Highest harmonic assumed in level 0 (source) table
+#define WAVE_MIPMAP_BUFFER_SIZE  1280    // samples, levels 1..6 (512+256+128*4)
+#define WAVE_ANALYSIS_CACHE_SIZE    4    // Flash wave-table analyses cached (see WaveMipmapBuild)
 
 #define FIXED_MIN_LEVEL    (1)                   // Minimum non-zerosignal level (0.000001)
 #define FIXED_MAX_LEVEL  (IntToFixedPt(1) - 1)   // Full-scale normalized signal level
@@ -57,6 +71,55 @@
 #define FILTER_CTRL_EXPRESS         3    // Filter Fc control by Expression (CC2/CC11)
 #define FILTER_CTRL_MODULN          4    // Filter Fc control by Modulation (CC1)
 
+// Possible values for patch parameter: m_Patch.FilterMode
+#define FILTER_MODE_BANDPASS        0    // Band-pass (resonator), constant bandwidth
+#define FILTER_MODE_LOWPASS         1    // Low-pass, resonant (constant Q)
+#define FILTER_MODE_HIGHPASS        2    // High-pass, resonant (constant Q)
+
+// Patch transition (crossfade) states -- see SynthPatchTransition()
+#define PATCH_FADE_IDLE             0    // No transition in progress
+#define PATCH_FADE_OUT              1    // Old patch fading out
+#define PATCH_FADE_SWITCH           2    // Voice mix silent -- new patch to be instated
+#define PATCH_FADE_IN               3    // New patch fading in
+#define PATCH_FADE_TIME_MIN         5    // Fade time range (ms), each of fade out/in
+#define PATCH_FADE_TIME_MAX        20
+
+// Modulation matrix sources -- bipolar (+/-1.0) or unipolar (0..1.0), normalized
+#define MOD_SRC_NONE                0    // No source (as a scaler: x1.0)
+#define MOD_SRC_LFO1                1    // LFO 1 (bipolar)
+#define MOD_SRC_LFO2                2    // LFO 2 (bipolar)
+#define MOD_SRC_VIB_RAMP            3    // Vibrato delay + ramp generator
+#define MOD_SRC_CONTOUR             4    // Contour envelope (per voice)
+#define MOD_SRC_AMPLD_ENV           5    // Ampld envelope, excl. velocity (per voice)
+#define MOD_SRC_VELOCITY            6    // Attack velocity (per voice)
+#define MOD_SRC_MODULN              7    // Modulation lever (CC1)
+#define MOD_SRC_PRESSURE            8    // Expression/pressure, linear (CC2/CC7/CC11)
+#define MOD_SRC_EXPRESS             9    // Expression/pressure, square-law
+#define MOD_SRC_PITCH_BEND         10    // Pitch-bend lever (bipolar)
+#define MOD_NUM_SOURCES            11
+
+// Modulation matrix destinations (units of base value and route depth)
+#define MOD_DST_PITCH               0    // Osc. pitch, OSC1 and OSC2 (octaves)
+#define MOD_DST_MIX_LEVEL           1    // Wave mixer OSC2 level (0..1.0)
+#define MOD_DST_FILTER_FREQ         2    // Filter Fc offset from patch/note (semitones)
+#define MOD_DST_NOISE_LEVEL         3    // Noise level (0..1.0)
+#define MOD_DST_AMPLD               4    // Voice output gain (0..1.0)
+#define MOD_NUM_DESTS               5
+
+#define MOD_ROUTES_MAX              8    // Modulation matrix routing table size
+#define MOD_LFO_COUNT               2    // Number of LFOs
+
+// LFO waveforms -- refer to function SynthLfoSetup()
+#define LFO_WAVE_SINE               0
+#define LFO_WAVE_TRIANGLE           1
+#define LFO_WAVE_SQUARE             2
+#define LFO_WAVE_SAMPLE_HOLD        3    // Random level, new value each cycle
+
+// Wave-table oscillator interpolation modes (config param's Osc1InterpMode, Osc2InterpMode)
+#define OSC_INTERP_TRUNCATE         0    // Table index truncated (no interpolation)
+#define OSC_INTERP_LINEAR           1    // Linear interpolation between adjacent samples
+#define OSC_INTERP_HERMITE          2    // 4-point, 3rd-order Hermite interpolation
+
 #define PARAM_HASH_VALUE(a, b)   ((a) * 100 + b)   // Hash code for 2-char abbreviation
 #define IS_FLASH_WAVETABLE(id)   (id != 0 && id <= GetHighestWaveTableID())
 
@@ -101,13 +164,14 @@ typedef  struct  synth_patch_param_table
     uint16  ContourDelay_ms;        // 1..10k ms
     uint16  ContourRamp_ms;         // 1..10k ms
     uint8   ContourHoldLevel;       // 0..100 %
-    // Noise Modulator & Bi-quad Variable Filter
+    // Noise Modulator & State-Variable Filter
     uint8   NoiseMode;              // 0:Off, 1:Noise only, 2:Add wave, 3:Mix wave (+4:Pitch)
     uint8   NoiseLevelCtrl;         // 0:Fixed, 1:Amp.Env, 2:LFO, 3:Exprn, 4:Modn
     uint8   FilterControl;          // 0:Fixed, 1:Contour, 2:LFO, 3:Exprn, 4:Modn
     uint16  FilterResonance;        // 0..9999  (0: bypass filter)
     uint8   FilterFrequency;        // 0..120 (MIDI note number)
     uint8   FilterNoteTrack;        // 0:Off, 1:On
+    uint8   FilterMode;             // 0:Band-pass, 1:Low-pass, 2:High-pass
     // Amplitude Envelope 
     uint16  AmpldEnvAttack_ms;      // 1..10k ms
     uint16  AmpldEnvPeak_ms;        // 0..10k ms
@@ -122,6 +186,235 @@ typedef  struct  synth_patch_param_table
 // ``````  if the LFO is used for filter freq. mod'n, Vibrato Depth is % FS.
 
 
+// Modulation matrix route:  adds (Source x Scaler x Depth) to the destination control.
+//
+typedef  struct  mod_route
+{
+    uint8    Source;                 // Modulation source (MOD_SRC_xxx)
+    uint8    Scaler;                 // Source controlling the depth, or MOD_SRC_NONE
+    uint8    Dest;                   // Destination (MOD_DST_xxx)
+    fixed_t  Depth;                  // Output per unit of source (destination units)
+
+} ModRoute_t;
+
+
+// Low-frequency oscillator state -- updated by the synth process at 5ms intervals
+//
+typedef  struct  synth_lfo
+{
+    int32    Angle;                  // Phase, index into g_sinewave[] [24:8 fixed-pt]
+    int32    Step;                   // Phase increment per update [24:8 fixed-pt]
+    fixed_t  Output;                 // LFO output, normalized (+/-1.0)
+    fixed_t  HoldLevel;              // Random level, updated each cycle (sample-hold)
+    uint8    Waveform;               // LFO_WAVE_xxx
+    uint8    Freq_x10;               // LFO freq * 10 Hz (1..250)
+
+} SynthLFO_t;
+
+
+// Descriptor for one level of a band-limited wave-table "mipmap".
+// Level 0 is the source table (flash or user RAM buffer);  level N (N > 0) is built from
+// the source table by SynthPrepare(), containing only harmonics 1..(64 >> N).
+//
+typedef  struct  wave_table_level
+{
+    int16   *Address;                // Address of wave-table samples
+    int32    Period;                 // Table size << 16 (phase wrap limit [16:16])
+    uint16   Harmonics;              // Highest harmonic order contained in the table
+
+} WaveTableLevel_t;
+
+// Harmonic analysis (DFT) of a wave-table, used to build the mipmap levels.
+// Analyses of flash wave-tables are cached, so that the mipmap of a recently used table
+// can be rebuilt (e.g. when a patch is re-selected) without repeating the DFT.
+//
+typedef  struct  wave_analysis
+{
+    int16   *Source;                 // Wave-table analysed (NULL if entry not valid)
+    int      Size;                   // Number of samples in wave-table
+    int32    AmpldRe[WAVE_MIPMAP_HARMONICS_MAX / 2];  // Harmonic ampld, cos component
+    int32    AmpldIm[WAVE_MIPMAP_HARMONICS_MAX / 2];  // Harmonic ampld, sin component
+    uint16   Harmonics;              // Harmonic limit of source table (level 0)
+    uint16   Highest;                // Highest significant harmonic (1..32)
+    uint16   Scale_pK;               // Level scale factor x1000 (0 if not yet found)
+    uint32   LastUsed;               // Cache access sequence number (LRU replacement)
+
+} WaveAnalysis_t;
+
+
+// Control parameter ramp -- used by the block renderer to interpolate linearly from one
+// value of a control-rate variable to the next, to avoid "zipper" noise.  The ramp runs
+// for one control update period (Length), so the interpolated value follows the control
+// variable with a lag of about one period.
+//
+typedef  struct  ramp_param
+{
+    int32    Value;                  // Current value (advanced by Step every sample)
+    int32    Step;                   // Increment per sample
+    int32    Target;                 // Control value at which the ramp ends
+    uint16   Length;                 // Ramp duration (samples) = control update period
+    uint16   Count;                  // Samples remaining in the ramp
+
+} RampParam_t;
+
+
+// Audio render parameters -- a flattened, pre-scaled copy of the patch and config params
+// read by the audio render ISR.  The control path builds a new set in a spare buffer, then
+// publishes it by a single pointer write, so the ISR never sees a partly updated set.
+//
+typedef  struct  render_params
+{
+    fixed_t  LevelAdjust;            // Output level adjust gain (AudioLevelAdjust / 100)
+    fixed_t  FilterInGain;           // Filter input gain x filter atten (x q in BP mode)
+    fixed_t  FilterOutGain;          // Filter output gain (g_FilterOutputGain / 10)
+    fixed_t  NoiseOutGain;           // Noise filter output gain (g_NoiseFilterGain)
+    uint8    Osc1IsWave;             // TRUE if OSC1 uses a wave-table (else sawtooth)
+    uint8    Osc2IsWave;             // TRUE if OSC2 uses a wave-table (else sawtooth)
+    uint8    Osc1InterpMode;         // OSC1 wave-table interpolation mode
+    uint8    Osc2InterpMode;         // OSC2 wave-table interpolation mode
+    uint8    NoiseMode;              // Noise mode (patch param)
+    uint8    FilterMode;             // Filter mode (patch param)
+    uint8    FilterEnabled;          // TRUE if filter enabled (resonance != 0)
+    uint8    Spare;                  // (pad to word boundary)
+
+} RenderParams_t;
+
+
+// Reverb delay line sample type.  In 16-bit mode, the delay history is stored as int16,
+// scaled by 2^-REVERB_SAMPLE_SHIFT, giving a range of +/-4.0 and a resolution of 1/4 of
+// a 12-bit DAC step.  ReverbPack(x) rounds and saturates;  x must be a simple variable.
+//
+#if REVERB_DELAY_16BIT
+typedef  int16    reverb_t;
+
+#define REVERB_PACK_LIMIT   ((32767 << REVERB_SAMPLE_SHIFT) - (1 << (REVERB_SAMPLE_SHIFT - 1)))
+#define ReverbPack(x)   (reverb_t) ((x > REVERB_PACK_LIMIT) ? 32767 : \
+                        (x < -REVERB_PACK_LIMIT) ? -32767 : \
+                        ((x + (1 << (REVERB_SAMPLE_SHIFT - 1))) >> REVERB_SAMPLE_SHIFT))
+#define ReverbUnpack(r)  ((fixed_t) r << REVERB_SAMPLE_SHIFT)
+#else
+typedef  fixed_t  reverb_t;
+
+#define ReverbPack(x)    (x)
+#define ReverbUnpack(r)  (r)
+#endif
+
+
+// Data structure for each voice in the synth voice pool.
+// The audio-rate state is placed first, so that the block renderer accesses each
+// voice as one contiguous record;  the pool is a simple array of these records.
+//
+typedef  struct  synth_voice
+{
+    // Audio-rate state -- accessed by the block renderer
+    int32    Osc1Angle;              // sample pos'n in wave-table, OSC1 [16:16]
+    int32    Osc2Angle;              // sample pos'n in wave-table, OSC2 [16:16]
+    int32    Osc1Step;               // sample pos'n increment, OSC1 [16:16 fixed-pt]
+    int32    Osc2Step;               // sample pos'n increment, OSC2 [16:16 fixed-pt]
+    fixed_t  Osc1SawAmpld;           // sawtooth sample amplitude, OSC1
+    fixed_t  Osc2SawAmpld;           // sawtooth sample amplitude, OSC2
+    fixed_t  Osc1SawIncr;            // sawtooth wave ampld increment, OSC1
+    fixed_t  Osc2SawIncr;            // sawtooth wave ampld increment, OSC2
+    fixed_t  FilterLow;              // state-variable filter low-pass state
+    fixed_t  FilterBand;             // state-variable filter band-pass state
+    uint32   RandLast;               // noise generator state (NB: must be odd!)
+    WaveTableLevel_t  *Osc1LevelInUse;  // OSC1 wave-table level in use by renderer
+    WaveTableLevel_t  *Osc2LevelInUse;  // OSC2 wave-table level in use by renderer
+    RampParam_t  Mix2Ramp;           // Osc2 mixer input level ramp (x1000 << 16)
+    RampParam_t  NoiseRamp;          // Noise level ramp (normalized)
+    RampParam_t  OutputRamp;         // Voice output level ramp (normalized)
+    RampParam_t  FilterFreqRamp;     // Filter freq. coeff (f) ramp
+    RampParam_t  FilterDampRamp;     // Filter damping coeff (q) ramp
+    int32    AmpldEnvLevel;          // Ampld envelope level, incl. velocity [2:30 fixed-pt]
+    int32    AmpldEnvStep;           // Ampld envelope attack increment per sample [2:30]
+    int32    AmpldEnvPeak;           // Ampld envelope attack peak level [2:30]
+    int32    AmpldEnvSustain;        // Ampld envelope sustain level [2:30]
+    uint32   AmpldEnvCount;          // Samples remaining in ampld envelope segment
+    // Real-time control variables -- written by the synth process (control rate)
+    uint16   Mix2Level;              // Osc2 Mixer input level x1000 (0..1000)
+    fixed_t  NoiseLevel;             // Noise level control (normalized)
+    fixed_t  OutputLevel;            // Voice output level control (normalized)
+    fixed_t  FilterCoeff_f;          // Filter freq. coeff f = 2 * sin(pi * Fc / Fs)
+    fixed_t  FilterCoeff_q;          // Filter damping coeff q = 1 / Q
+    fixed_t  AmpldModGain;           // Output gain from modulation matrix (0..1.0)
+    WaveTableLevel_t  *Osc1Level;    // OSC1 wave-table level selected for the note
+    WaveTableLevel_t  *Osc2Level;    // OSC2 wave-table level selected for the note
+    // Note and envelope state -- accessed by the synth process only
+    fixed_t  Osc1StepMedian;         // Median value of Osc1Step (as at Note-On)
+    fixed_t  Osc2StepMedian;         // Median value of Osc2Step (as at Note-On)
+    fixed_t  FreqModMult;            // Osc. freq. multiplier, smoothed (0: new note)
+    fixed_t  AttackVelocity;         // Attack Velocity, normalized (0 ~ 0.999)
+    fixed_t  AmpldEnvOutput;         // Ampld envelope output x velocity (from renderer)
+    fixed_t  ContourEnvOutput;       // Contour env. output, normalized (0 ~ 1.0)
+    fixed_t  ContourDelta;           // Step change in contour output per 5ms
+    fixed_t  ContourHoldLevel;       // Contour output level held at finish of ramp
+    uint32   ContourTimer;           // Time elapsed in contour phase (ms)
+    fixed_t  SmoothExprnLevel;       // Expression level, normalized, smoothed
+    uint32   StartCount;             // Note-On sequence number (for voice stealing)
+    uint8    AmpldEnvSegment;        // Ampld envelope segment (aka "phase")
+    uint8    ContourSegment;         // Contour envelope segment (aka "phase")
+    uint8    NoteKey;                // MIDI note number received (before transpose)
+    uint8    NotePlaying;            // MIDI note number playing (after transpose)
+    uint8    NoteVelocity;           // MIDI note-on velocity received
+    bool     Gate;                   // TRUE if Note ON, ie. "gated", else FALSE
+    bool     Active;                 // TRUE while the voice is sounding
+    bool     TriggerAttack;          // Signal to put ampld envelope into attack
+    bool     TriggerRelease;         // Signal to put ampld envelope into release
+    bool     TriggerContour;         // Signal to start contour envelope gen
+    bool     RampReset;              // Signal to renderer to reset ramps (new voice)
+    bool     AmpldEnvControl;        // Output level is controlled by the ampld envelope
+
+} SynthVoice_t;
+
+
+// Synth event types -- refer to function SynthPostEvent()
+#define SYNTH_EVENT_NOTE_ON         1    // Data1 = note number, Value = velocity
+#define SYNTH_EVENT_NOTE_OFF        2    // Data1 = note number
+#define SYNTH_EVENT_EXPRESSION      3    // Value = expression/pressure (14 bits)
+#define SYNTH_EVENT_MODULATION      4    // Value = modulation lever position (14 bits)
+#define SYNTH_EVENT_PITCH_BEND      5    // Value = PB lever position (14 bits, centre 0x2000)
+
+// A note or controller event, scheduled to be applied by the block renderer at a given
+// sample clock value.  Events are held in a FIFO queue, in time order.
+//
+typedef  struct  synth_event
+{
+    uint32   SampleTime;             // Sample clock value at which the event is due
+    uint16   Value;                  // Velocity, or 14-bit controller value
+    uint8    Type;                   // Event type (SYNTH_EVENT_xxx)
+    uint8    Data1;                  // Note number (note events)
+
+} SynthEvent_t;
+
+
+// Audio engine profiling stages -- refer to function ProfileRecord()
+#define PROFILE_RENDER_ISR          0    // Audio render ISR, total (incl. DAC write)
+#define PROFILE_EVENTS              1    // Scheduled events applied by the renderer
+#define PROFILE_OSCILLATORS         2    // Oscillator block kernels, all voices
+#define PROFILE_VOICE_DSP           3    // Mixer, noise, filter, voice limiter, output atten.
+#define PROFILE_MASTER              4    // Master limiter and level adjust
+#define PROFILE_REVERB              5    // Reverb effect
+#define PROFILE_DAC_WRITE           6    // DAC (PWM/SPI) buffer write
+#define PROFILE_SYNTH_PROCESS       7    // SynthProcess() -- 1ms task
+#define PROFILE_PATCH_SWITCH        8    // SynthPatchSelect() -- patch change
+#define PROFILE_NUM_STAGES          9
+#define PROFILE_HIST_BINS          16    // Log2 histogram bins (core timer counts)
+
+// Execution time statistics for one profiling stage (core timer counts, 40 per us).
+// Histogram bin N counts the measurements in the range 2^N to 2^(N+1) - 1;  bin 0 also
+// counts zero and the top bin counts everything above its lower limit.
+//
+typedef  struct  profile_stage
+{
+    uint32   Min;                    // Minimum execution time
+    uint32   Max;                    // Maximum execution time
+    uint32   Count;                  // Number of measurements
+    uint64   Total;                  // Sum of measurements (for mean)
+    uint32   Hist[PROFILE_HIST_BINS];  // Log2 histogram
+
+} ProfileStage_t;
+
+
 // This descriptor is used for wave-tables which are regenerated in the RAM buffer
 //
 typedef struct Waveform_Descriptor 
@@ -160,6 +453,7 @@ extern  const  int16   g_sawtooth_wave[];
 extern  const  uint16  g_base2exp[];
 
 extern  int16  WaveTableBuffer[];        // Wave-table buffer in data RAM
+extern  reverb_t  ReverbDelayLine[];     // Reverb FDN delay lines (contiguous)
 extern  PatchParamTable_t  g_Patch;      // active (working) patch parameters
 
 extern  int      g_Osc1WaveTableSize;    // Number of samples in OSC1 wave-table
@@ -167,15 +461,13 @@ extern  int      g_Osc2WaveTableSize;    // Number of samples in OSC2 wave-table
 extern  float    g_Osc1FreqDiv;          // OSC1 frequency divider
 extern  float    g_Osc2FreqDiv;          // OSC2 frequency divider
 
-extern  volatile uint16   v_Mix2Level; 
-extern  volatile fixed_t  v_OutputLevel;
-
 
 // Functions defined in "remi_synth2_engine.c" available to external modules:
 //
 void   SynthAudioInit();
 void   SynthPrepare();
 short  SynthPatchSelect(int patchID);
+short  SynthPatchTransition(int patchID);
 void   SynthNoteOn(uint8 note, uint8 vel);
 void   SynthNoteChange(uint8 note);
 void   SynthNoteOff(uint8 note);
@@ -184,6 +476,11 @@ void   SynthExpression(unsigned data14);
 void   SynthModulation(unsigned data14);
 void   SynthEffectSwitch(uint8 ctrlnum, uint8 enab);
 void   SynthProcess();
+void   SynthRenderBlock(fixed_t *outBuf, int nSamples);
+uint32 SynthSampleClock(void);
+uint32 SynthSampleRate(void);
+uint32 SynthEventLatency(void);
+bool   SynthPostEvent(uint8 type, uint8 data1, uint16 value, uint32 sampleTime);
 
 PatchParamTable_t  *GetActivePatchTable();
 
@@ -193,14 +490,27 @@ int    GetActivePatchID();
 int    GetTableIndexOfPatchID(uint16 patchID);
 int    GetActiveWaveTable(void);
 void   WaveTableSizeSet(uint16 size);
+void   UserWaveTableInvalidate(void);
 void   OscFreqDividerSet(short oscnum, float freqDiv);
 float  OscFreqDividerGet(short oscnum);
 bool   isSynthActive();
+int    GetActiveVoiceCount(void);
+fixed_t  GetVoiceOutputLevel(int voice);
 void   SetVibratoMode(unsigned mode);
 uint8  GetVibratoMode(void);
-void   SetFilterFreqIndex(uint8 freqIndex);
-uint8  GetFilterFreqIndex();
+int    SynthLfoSetup(int lfo, uint8 waveform, uint8 freq_x10);
+SynthLFO_t  *GetSynthLfo(int lfo);
+int    ModMatrixSetRoute(int slot, uint8 source, uint8 scaler, uint8 dest, fixed_t depth);
+int    ModMatrixDeleteRoute(int slot);
+ModRoute_t  *ModMatrixGetRoute(int slot);
+void   ModMatrixSetBase(uint8 dest, fixed_t value);
+fixed_t  ModMatrixGetBase(uint8 dest);
+void   ModMatrixRestore(void);
 int    GetReverbMixSetting(void);
+int    GetSynthEventOverflows(void);
+void   ProfileRecord(uint8 stage, uint32 counts);
+void   ProfileReset(void);
+void   ProfileGetStage(uint8 stage, ProfileStage_t *pStats);
 
 fixed_t  GetExpressionLevel(void);
 fixed_t  GetModulationLevel(void);
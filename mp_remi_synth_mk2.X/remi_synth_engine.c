@@ -11,24 +11,58 @@
  *
  * ================================================================================================
  */
-#include <sys/attribs.h>    // For interrupt handlers
-
 #include "remi_synth_main.h"
 #include "remi_synth_def.h"
 
 PRIVATE  void   WaveTableSelect(uint8 osc_num, uint8 wave_id);
-PRIVATE  void   AmpldEnvelopeShaper();
-PRIVATE  void   AudioLevelController();
-PRIVATE  void   ContourEnvelopeShaper();
-PRIVATE  void   OscFreqModulation();
-PRIVATE  void   OscMixRatioModulation();
-PRIVATE  void   NoiseLevelControl();
-PRIVATE  void   FilterFrequencyControl();
+PRIVATE  void   WaveMipmapPrepare();
+PRIVATE  void   WaveMipmapBuild(WaveTableLevel_t *mipmap, int16 *buffer, int16 *source, int size);
+PRIVATE  WaveAnalysis_t  *WaveAnalysisGet(int16 *source, int size);
+PRIVATE  void   WaveAnalyse(WaveAnalysis_t *pWave, int16 *source, int size);
+PRIVATE  WaveTableLevel_t  *WaveMipmapLevelSelect(WaveTableLevel_t *mipmap, float tableFreq);
+PRIVATE  void   SynthParamsPrepare(void);
+PRIVATE  void   VoicePoolReset(void);
+PRIVATE  int    PatchIndexFind(int patchNum);
+PRIVATE  short  PatchParamsLoad(PatchParamTable_t *pPatch, int patchNum);
+PRIVATE  void   UserWaveTableRestore(void);
+PRIVATE  void   PatchTransitionSwitch(void);
+PRIVATE  void   PatchFadeRender(fixed_t *buf, int nSamples);
+PRIVATE  SynthVoice_t  *VoiceAllocate(uint8 noteNum);
+PRIVATE  void   VoiceNoteChange(SynthVoice_t *pVoice, uint8 noteNum);
+PRIVATE  int    TransposeNote(uint8 noteNum);
+PRIVATE  void   AmpldEnvelopePrepare(void);
+PRIVATE  void   AmpldEnvelopeAdvance(SynthVoice_t *pVoice, int nSamples);
+PRIVATE  void   AudioLevelController(SynthVoice_t *pVoice);
+PRIVATE  void   ClippingIndicator();
+PRIVATE  void   ContourEnvelopeShaper(SynthVoice_t *pVoice);
+PRIVATE  void   ModMatrixPrepare();
+PRIVATE  void   ModMatrixBuild();
+PRIVATE  void   ModRouteAdd(uint8 source, uint8 scaler, uint8 dest, fixed_t depth);
+PRIVATE  void   ModMatrixEvaluate(SynthVoice_t *pVoice, fixed_t *modOut);
+PRIVATE  void   OscStepModulation(SynthVoice_t *pVoice, fixed_t pitchMod);
+PRIVATE  void   OscMixRatioModulation(SynthVoice_t *pVoice, fixed_t mixMod);
+PRIVATE  void   NoiseLevelControl(SynthVoice_t *pVoice, fixed_t noiseMod);
+PRIVATE  void   FilterFrequencyControl(SynthVoice_t *pVoice, fixed_t freqMod);
+PRIVATE  fixed_t  FilterFreqCoeff(fixed_t pitch);
 PRIVATE  void   LowFrequencyOscillator();
 PRIVATE  void   VibratoRampGenerator();
+PRIVATE  void   VoiceControlUpdate(SynthVoice_t *pVoice);
+PRIVATE  void   ApplySynthEvent(SynthEvent_t *pEvent);
+PRIVATE  void   RenderParamsPublish(void);
+PRIVATE  void   SampleRateSetup(void);
+PRIVATE  void   RenderVoice(SynthVoice_t *pVoice, RenderParams_t *pParams, fixed_t *mixBuf,
+                            int nSamples);
+PRIVATE  void   ReverbRenderBlock(fixed_t *inBuf, fixed_t *outBuf, int nSamples);
+PRIVATE  void   RampParamInit(RampParam_t *pRamp, int32 value, uint16 length);
+PRIVATE  void   RampParamBegin(RampParam_t *pRamp, int32 target, int nSamples);
+PRIVATE  void   RampParamEnd(RampParam_t *pRamp, int32 value);
+PRIVATE  void   OscWaveRenderBlock(fixed_t *oscBuf, int nSamples, int16 *table, int32 period,
+                                   int32 *pAngle, int32 step, uint8 interpMode);
+PRIVATE  void   OscSawRenderBlock(fixed_t *oscBuf, int nSamples, fixed_t *pAmpld, fixed_t incr,
+                                  int32 *pAngle, int32 step, int32 period);
 
 int16    WaveTableBuffer[WAVE_TABLE_MAXIMUM_SIZE];  // signed 16-bit samples
-fixed_t  ReverbDelayLine[REVERB_DELAY_MAX_SIZE];    // fixed-point samples
+reverb_t ReverbDelayLine[REVERB_DELAY_MAX_SIZE];    // delay samples, all FDN lines
 
 PatchParamTable_t  g_Patch;        // active (working) patch parameters
 
@@ -47,59 +81,104 @@ float  g_FilterInputAtten;         // Filter input atten/gain (.01 ~ 2.5)
 float  g_FilterOutputGain;         // Filter output atten/gain (0.1 ~ 25)
 float  g_NoiseFilterGain;          // Noise gen. gain adjustment (0.1 ~ 25)
 
+static SynthVoice_t  m_Voice[SYNTH_VOICES_MAX];  // Voice pool (contiguous array)
+static SynthVoice_t *m_LastVoice;         // Voice most recently allocated (Note-On)
+static uint32   m_NoteOnCount;            // Note-On sequence counter (voice age)
+
 static int16   *m_WaveTable1;             // Pointer to OSC1 wave-table
 static int16   *m_WaveTable2;             // Pointer to OSC2 wave-table
-static fixed_t  m_Osc1StepMedian;         // Median value of v_Osc1Step (as at Note-On)
-static fixed_t  m_Osc2StepMedian;         // Median value of v_Osc2Step (as at Note-On)
+static WaveTableLevel_t  m_Osc1Mipmap[WAVE_MIPMAP_LEVELS];  // OSC1 band-limited table levels
+static WaveTableLevel_t  m_Osc2Mipmap[WAVE_MIPMAP_LEVELS];  // OSC2 band-limited table levels
+static int16    m_Osc1MipmapBuffer[WAVE_MIPMAP_BUFFER_SIZE];  // OSC1 table levels 1..N
+static int16    m_Osc2MipmapBuffer[WAVE_MIPMAP_BUFFER_SIZE];  // OSC2 table levels 1..N
+static int16   *m_Osc1MipmapSource;       // Source table of OSC1 mipmap (NULL => rebuild)
+static int16   *m_Osc2MipmapSource;       // Source table of OSC2 mipmap (NULL => rebuild)
+static int      m_Osc1MipmapSize;         // Source table size of OSC1 mipmap
+static int      m_Osc2MipmapSize;         // Source table size of OSC2 mipmap
+static WaveAnalysis_t  m_WaveAnalysis[WAVE_ANALYSIS_CACHE_SIZE];  // Flash wave-table DFT cache
+static uint32   m_WaveAnalysisSeq;        // Wave analysis cache access sequence counter
+static WaveformDesc_t  m_UserWaveDesc;    // User waveform last generated in WaveTableBuffer
+static bool     m_UserWaveValid;          // TRUE if WaveTableBuffer matches m_UserWaveDesc
+static PatchParamTable_t  m_PatchPending; // Patch to be activated by patch transition
+static volatile uint8  m_PatchFadeState;  // Patch transition state (PATCH_FADE_xxx)
+static fixed_t  m_PatchFadeLevel;         // Voice mix gain in patch transition (0..1.0)
+static fixed_t  m_PatchFadeStep;          // Voice mix gain increment per sample
+static fixed_t  m_VoiceMixGain = IntToFixedPt(1);  // Voice mix gain, 1 / active voices
+static fixed_t  m_VoiceMixRiseStep;       // Max. voice mix gain increment per sample
 static fixed_t  m_SawtoothPeakAmpld;      // Sawtooth waveform peak amplitude
 static fixed_t  m_FundamentalPeriod;      // Waveform period, equiv. 2*pi radians
-static int32    m_LFO_Step;               // LFO "phase step" (fixed-point 24:8 bit format)
-static fixed_t  m_LFO_output;             // LFO output signal, normalized, bipolar (+/-1.0)
+static SynthLFO_t  m_LFO[MOD_LFO_COUNT];  // Low-frequency oscillators (common to all voices)
+static uint32   m_LfoRandom;              // Sample-and-hold LFO random number state
+static ModRoute_t  m_ModRoute[MOD_ROUTES_MAX];  // Modulation matrix routing table
+static fixed_t  m_ModBase[MOD_NUM_DESTS]; // Modulation matrix destination base values
+static int      m_ModRouteCount;          // Number of routes in use
+static bool     m_ModMatrixValid;         // FALSE if routing is to be rebuilt from the patch
+static bool     m_PitchModEnabled;        // TRUE if any route modulates the osc. pitch
 static fixed_t  m_PressureLevel;          // Breath pressure, linear response (0..+1.0)
 static fixed_t  m_ExpressionLevel;        // Expression (pressure) square-law (0..+1.0)
 static fixed_t  m_ModulationLevel;        // Modulation level, normalized
-static fixed_t  m_PitchBendFactor;        // Pitch-Bend factor, normalized
+static fixed_t  m_PitchBendLevel;         // Pitch-Bend lever position, normalized (+/-1.0)
 static uint8    m_PitchBendControl;       // Pitch-Bend control mode (Off, PBmsg, Exprn, CV)
 static uint8    m_VibratoControl;         // 0:None, 1:FX.Sw, 2:CC(Mod.Lvr), 3:Auto
 static fixed_t  m_RampOutput;             // Vibrato Ramp output level, normalized (0..1)
-static fixed_t  m_AmpldEnvOutput;         // Amplitude envelope output (0 ~ 0.9995)
 
 static short    m_NumberOfWavetables;     // Number of Wavetables defined in flash PM
-static fixed_t  m_ContourEnvOutput;       // Mixer contour output, normalized (0 ~ 1.0)
-static fixed_t  m_AttackVelocity;         // Attack Velocity, normalized (0 ~ 0.999)
-static bool     m_TriggerAttack;          // Signal to put ampld envelope into attack
-static bool     m_TriggerRelease;         // Signal to put ampld envelope into release
-static bool     m_TriggerContour;         // Signal to start contour envelope gen
 static bool     m_LegatoNoteChange;       // Signal Legato note change to Vibrato func.
-static uint8    m_Note_ON;                // TRUE if Note ON, ie. "gated", else FALSE
-static uint8    m_NotePlaying;            // MIDI note number of note playing
+static uint8    m_Note_ON;                // TRUE if any voice is gated, else FALSE
 static uint8    m_ExprnCalibr_pc;         // Expression calibration factor (25..250)
-static uint8    m_AliasFilterTcn;         // Anti-alias filter time-constant N = log2(1/K)
-static uint8    m_FilterAtten_pc;         // Filter input atten/gain (%)
-static uint8    m_FilterGain_x10;         // Filter output gain x10 (1..250)
-static uint8    m_NoiseGain_x10;          // Noise filter gain x10 (1..250)
-static fixed_t  m_FiltCoeff_c[110];       // Bi-quad filter coeff. c  (a1 = -c)
-static int      m_RvbDelayLen;            // Reverb. delay line length (samples)
-static fixed_t  m_RvbDecay;               // Reverb. decay factor
+static int32    m_FilterOmegaC0;          // Filter omega (pi * Fc / Fs) at C0 [2:30 fixed-pt]
+static fixed_t  m_FilterDamping;          // Filter damping, f * q (band-pass) or q
+static fixed_t  m_FilterInGain;           // Filter input gain (x q in band-pass mode)
+static RenderParams_t  m_RenderParams[2];  // Audio render params (double-buffered)
+static RenderParams_t * volatile  m_pRenderParams = &m_RenderParams[0];  // Set in use by ISR
+static reverb_t *m_RvbLine[REVERB_FDN_LINES];      // Reverb. FDN delay lines (in ReverbDelayLine)
+static int      m_RvbIndex[REVERB_FDN_LINES];      // Reverb. delay line read/write index
+static fixed_t  m_RvbLoopGain[REVERB_FDN_LINES];   // Reverb. delay line loop gain (decay)
+static fixed_t  m_RvbDamping[REVERB_FDN_LINES];    // Reverb. loop low-pass filter output
 static uint16   m_RvbAtten;               // Reverb. attenuation factor (0..127)
 static uint16   m_RvbMix;                 // Reverb. wet/dry mix ratio (0..127)
+static int32    m_AmpldAttackStep;        // Ampld env. attack increment, full scale [2:30]
+static int32    m_AmpldPeakLevel;         // Ampld env. attack peak level [2:30]
+static int32    m_AmpldSustainLevel;      // Ampld env. sustain level [2:30]
+static int32    m_AmpldDecayCoeff;        // Ampld env. decay coeff. per sample [1:31]
+static int32    m_AmpldReleaseCoeff;      // Ampld env. release coeff. per sample [1:31]
+static int32    m_AmpldDecayBlkCoeff;     // Ampld env. decay coeff. per block [1:31]
+static int32    m_AmpldReleaseBlkCoeff;   // Ampld env. release coeff. per block [1:31]
+static uint32   m_AmpldAttackSamples;     // Ampld env. attack duration (samples)
+static uint32   m_AmpldPeakSamples;       // Ampld env. peak-hold duration (samples)
+static uint32   m_AmpldDecaySamples;      // Ampld env. decay duration (samples)
+static uint32   m_AmpldReleaseSamples;    // Ampld env. release duration (samples)
+
+static uint32   m_SampleRate = SAMPLE_RATE_DEFAULT_HZ;  // Audio sample rate (Hz)
+static uint16   m_SamplesPerMs = SAMPLE_RATE_DEFAULT_HZ / 1000;  // = 1ms control ramp length
+static uint16   m_CoreCountsPerSample = 40000000 / SAMPLE_RATE_DEFAULT_HZ;  // CPU core counts
+static uint16   m_EventLatency = SAMPLE_RATE_DEFAULT_HZ / 1000 * SYNTH_EVENT_LATENCY_US / 1000;
+
+// Reverb. FDN delay line lengths -- mutually prime, total = REVERB_DELAY_MAX_SIZE...
+static const uint16  m_RvbDelayLen[REVERB_FDN_LINES] = { 389, 457, 521, 613 };  // samples
+
+// Single-producer, single-consumer queue of scheduled events (lock-free)...
+// The producer (SynthPostEvent) writes only m_EventQueueTail;  the consumer (block renderer)
+// writes only m_EventQueueHead.  To flush the queue, the producer sets m_EventDiscardIndex
+// and raises m_EventDiscardReq;  the renderer then discards events up to the index.
+static SynthEvent_t  m_EventQueue[SYNTH_EVENT_QUEUE_SIZE];
+static volatile uint8  m_EventQueueHead;  // Index of next event to be applied
+static volatile uint8  m_EventQueueTail;  // Index of next free place for posting
+static volatile uint8  m_EventDiscardIndex;  // Queue tail index when flush requested
+static volatile bool   m_EventDiscardReq; // Request to flush the event queue
+static int      m_EventQueueOverflows;    // Events lost -- queue full
+
+static ProfileStage_t  m_Profile[PROFILE_NUM_STAGES];  // Execution time stats by stage
+static uint32   m_OscRenderTime;          // Oscillator render time, block (core counts)
+static uint32   m_VoiceDspTime;           // Voice DSP time, block (core counts)
 
 volatile bool     v_SynthEnable;          // Signal to enable synth engine
-volatile int32    v_Osc1Angle;            // sample pos'n in wave-table, OSC1 [16:16]
-volatile int32    v_Osc2Angle;            // sample pos'n in wave-table, OSC2 [16:16]
-volatile int32    v_Osc1Step;             // sample pos'n increment, OSC1 [16:16 fixed-pt]
-volatile int32    v_Osc2Step;             // sample pos'n increment, OSC2 [16:16 fixed-pt]
-volatile fixed_t  v_Osc1SawtoothIncr;     // sawtooth wave ampld increment, OSC1
-volatile fixed_t  v_Osc2SawtoothIncr;     // sawtooth wave ampld increment, OSC2
-volatile uint16   v_Mix2Level;            // Osc2 Mixer input level x1000 (0..1000)
-volatile fixed_t  v_NoiseLevel;           // Noise level control (normalized)
-volatile fixed_t  v_OutputLevel;          // Audio output level control (normalized)
-volatile fixed_t  v_coeff_a1;             // Bi-quad filter coeff a1 (active)
-volatile fixed_t  v_coeff_a2;             // Bi-quad filter coeff a2 (active)
-volatile fixed_t  v_coeff_b0;             // Bi-quad filter coeff b0 (active)
-volatile fixed_t  v_coeff_b2;             // Bi-quad filter coeff b2 (active)
 volatile bool     v_Clipping;             // Mixer output clipping (flag)
-volatile uint32   v_ISRexecTime;          // ISR execution time (core cycle count)
+volatile uint32   v_ISRexecTime;          // Block render time (core cycle count)
+volatile uint32   v_VoiceRenderTime;      // Voice render time, all voices (core cycles)
+volatile uint8    v_VoicesRendered;       // Number of voices in last block rendered
+volatile uint32   v_SampleClock;          // Sample clock at start of next block to render
+volatile uint32   v_BlockStartTime;       // Render entry time, last block (core cycle count)
 
 
 // Look-up table giving frequencies of notes on the chromatic scale.
@@ -145,25 +224,122 @@ const  float  m_NoteFrequency[] =
  *
  * Overview:     This function must be called following any change in the synth patch
  *               or synth configuration parameter, before playing a note.
+ *               It is also called on receipt of MIDI All Sound Off (CC 120) or Reset All
+ *               Controllers (CC 121).  MIDI IN events waiting to be serviced (received
+ *               while the synth was being set up, or with the All Sound Off) are discarded,
+ *               as well as synth events scheduled but not yet applied.
  */
 void  SynthPrepare()
 {
-    static  bool prepDone = FALSE;
-    float   res, res_sq, freq_rat;
+    v_SynthEnable = 0;    // Disable the synth tone-generator
+    m_Note_ON = FALSE;    // no note playing
+
+    MIDI_EventQueueFlush();                  // Discard stale MIDI IN events
+    m_EventDiscardIndex = m_EventQueueTail;  // Discard scheduled events...
+    m_EventDiscardReq = TRUE;                // ... when the next block is rendered
+
+    m_PatchFadeState = PATCH_FADE_IDLE;      // Cancel any patch transition in progress
+    m_PatchFadeLevel = IntToFixedPt(1);
+
+    VoicePoolReset();     // Silence all voices
+    SampleRateSetup();    // Instate the configured sample rate, if changed
+    SynthParamsPrepare();
+}
+
+
+/*
+ * Function:     Instate the audio sample rate set by config param SampleRate_kHz, if it has
+ *               changed, and compute the engine constants which depend on the sample rate.
+ *
+ * Called by SynthPrepare() only, with the synth disabled and all voices silenced.
+ * The audio DAC timer (Timer_2) is re-programmed to suit the new rate.  Variables derived
+ * from the rate elsewhere (oscillator steps, envelope segments, mipmap level selection,
+ * ramp lengths) use m_SampleRate or m_SamplesPerMs when next computed.  The event
+ * scheduling latency is kept the same in time (SYNTH_EVENT_LATENCY_US), not in samples.
+ *
+ * The reverb delay lines keep the same lengths (in samples) at any rate, so the echo
+ * spacing varies with the rate, but the loop gains are recalculated for the same decay time.
+ */
+PRIVATE  void  SampleRateSetup(void)
+{
+    static  bool  setupDone = FALSE;
+    uint32  rate = (uint32) g_Config.SampleRate_kHz * 1000;
     float   rvbDecayFactor;
-    float   pi_2 = 2.0f * 3.14159265f;
+    int     idx;
+
+    if (rate != 32000 && rate != 40000 && rate != 48000)  rate = SAMPLE_RATE_DEFAULT_HZ;
+    if (setupDone && rate == m_SampleRate)  return;   // no change
+
+    AUDIO_RENDER_IRQ_DISABLE();
+    m_SampleRate = rate;
+    m_SamplesPerMs = (uint16) (rate / 1000);
+    m_CoreCountsPerSample = (uint16) (40000000 / rate);
+    m_EventLatency = (uint16) (m_SamplesPerMs * SYNTH_EVENT_LATENCY_US / 1000);
+    m_VoiceMixRiseStep = IntToFixedPt(1) / (VOICE_MIX_GAIN_RISE_MS * m_SamplesPerMs);
+    AUDIO_RENDER_IRQ_ENABLE();
+
+    // Reverb FDN loop gain of each line is set for 60dB decay in REVERB_DECAY_TIME_SEC,
+    // whatever the line length...
+    for (idx = 0;  idx < REVERB_FDN_LINES;  idx++)
+    {
+        rvbDecayFactor = (float) m_RvbDelayLen[idx] / (rate * REVERB_DECAY_TIME_SEC);
+        m_RvbLoopGain[idx] = FloatToFixed( powf(0.001f, rvbDecayFactor) );
+    }
+    // Filter omega at C0 (lowest Fc) -- higher frequencies are derived by FilterFreqCoeff()
+    m_FilterOmegaC0 = (int32) ((3.14159265f * m_NoteFrequency[0] / rate) * 1073741824.0f);
+
+    PWM_audioDAC_SetSampleRate(rate);
+    setupDone = TRUE;
+}
+
+
+/*
+ * Function:     Silence all voices, i.e. reset the voice pool to the initial (free) state.
+ *
+ * The caller must ensure that the audio render ISR does not access the voices meanwhile,
+ * i.e. the synth is disabled or the render IRQ is held off.
+ */
+PRIVATE  void  VoicePoolReset(void)
+{
+    int   idx;
+
+    for (idx = 0;  idx < SYNTH_VOICES_MAX;  idx++)
+    {
+        memset(&m_Voice[idx], 0, sizeof(SynthVoice_t));
+        m_Voice[idx].RandLast = (idx << 16) | 1;  // Seed must be odd!
+    }
+    m_LastVoice = &m_Voice[0];
+}
+
+
+/*
+ * Function:     Compute the synth operational variables which depend on the active patch
+ *               and configuration parameters, incl. band-limited wave-tables, envelope
+ *               constants, modulation routing and filter damping.
+ *
+ * Called by SynthPrepare(), and by PatchTransitionSwitch() while the voice mix is silent.
+ */
+PRIVATE  void  SynthParamsPrepare(void)
+{
+    static  bool prepDone = FALSE;
+    float   res, res_sq;
+    reverb_t *pRvbLine;
     int     idx;
     int     preset = g_Config.PresetLastSelected;
 
-    v_SynthEnable = 0;    // Disable the synth tone-generator
-    m_Note_ON = FALSE;    // no note playing
-    
     if (!prepDone)  // One-time initialisation at power-on/reset
     {
-        // Calculate reverb delay-line constants...
-        m_RvbDelayLen = (int) (REVERB_LOOP_TIME_SEC * SAMPLE_RATE_HZ);  // samples
-        rvbDecayFactor = (float) REVERB_LOOP_TIME_SEC / REVERB_DECAY_TIME_SEC;
-        m_RvbDecay = FloatToFixed( powf(0.001f, rvbDecayFactor) );
+        // Locate the reverb FDN delay lines in ReverbDelayLine[]...
+        // (The loop gains depend on the sample rate -- see SampleRateSetup())
+        pRvbLine = ReverbDelayLine;
+        for (idx = 0;  idx < REVERB_FDN_LINES;  idx++)
+        {
+            m_RvbLine[idx] = pRvbLine;
+            pRvbLine += m_RvbDelayLen[idx];
+        }
+        SynthLfoSetup(1, LFO_WAVE_SINE, 50);       // LFO1 freq. is set by the patch
+        SynthLfoSetup(2, LFO_WAVE_TRIANGLE, 10);   // 1 Hz
+        m_LfoRandom = 1;
         prepDone = TRUE;
     }
     
@@ -171,25 +347,77 @@ void  SynthPrepare()
     WaveTableSelect(2, g_Patch.Osc2WaveTable);
 
     m_NumberOfWavetables = GetHighestWaveTableID() + 1;
+    WaveMipmapPrepare();   // Build band-limited versions of the active wave-tables
     m_SawtoothPeakAmpld = (IntToFixedPt(1) * 95) / 100;  // = 0.95
     m_FundamentalPeriod = 1260 << 16;  // 1 cycle of fundamental (2*pi radians)
     m_VibratoControl = g_Preset.Descr[preset].VibratoMode;
     m_PitchBendControl = g_Config.PitchBendCtrlMode; 
     m_RvbAtten = ((uint16)g_Config.ReverbAtten_pc << 7) / 100;  // = 0..127
     m_RvbMix = ((uint16)g_Config.ReverbMix_pc << 7) / 100;  // = 0..127
-
-    // Find coefficients for bi-quad filter according to patch Filter Resonance
-    res = (float) g_Patch.FilterResonance / 10000;   // range 0 ~ 0.9999
+    AmpldEnvelopePrepare();
+    ModMatrixPrepare();
+
+    // Find state-variable filter damping according to patch Filter Resonance (res).
+    // In band-pass mode, the product f * q is held constant, giving the same (constant)
+    // bandwidth as a 2-pole resonator with pole radius res, and the gain at the resonant
+    // peak is res^2 / (1 - res^2).  In low-pass and high-pass modes, Q is constant and the
+    // pass-band gain is 1.0, so the gain at the resonant peak is 1 / q (approx. the same).
+    res = (float) g_Patch.FilterResonance / 10000;   // range 0 ~ 0.999
     res_sq = res * res;
-    v_coeff_a2 = FloatToFixed(res_sq);
-    v_coeff_b0 = FloatToFixed(0.5f - (res_sq / 2.0f));
-    v_coeff_b2 = 0 - v_coeff_b0;  // b2 = -b0
-    // Coeff a1 = -c is both resonance and frequency dependent...  
-    for (idx = 0 ; idx <= 108 ; idx++)    // populate LUT
+    if (g_Patch.FilterMode == FILTER_MODE_BANDPASS)
+    {
+        m_FilterDamping = FloatToFixed((1.0f - res_sq));
+        m_FilterInGain = FloatToFixed((res_sq / (1.0f - res_sq)));
+    }
+    else
     {
-        freq_rat = m_NoteFrequency[idx] / SAMPLE_RATE_HZ;   // Fr = Fc / Fs
-        m_FiltCoeff_c[idx] = FloatToFixed(2.0 * res * cosf(pi_2 * freq_rat));
+        m_FilterDamping = FloatToFixed((2.0f - 2.0f * res));
+        m_FilterInGain = IntToFixedPt(1);
     }
+
+    RenderParamsPublish();
+}
+
+
+/*
+ * Function:     Build the audio render parameter set from the active patch and config
+ *               params and, if it differs from the set in use, publish it to the ISR.
+ *
+ * Called by SynthParamsPrepare() and by the Synth Process at 5ms intervals, so that any
+ * change in a patch or config param affecting the render ISR is picked up.
+ *
+ * The new set is written into the buffer not in use by the ISR, then the ISR's pointer
+ * is switched to it.  The pointer write is atomic and the ISR reads the pointer once per
+ * block, so no block is rendered with a mix of old and new params.  The ISR completes a
+ * block before the control path resumes, so the old buffer is free to re-use next time.
+ */
+PRIVATE  void  RenderParamsPublish(void)
+{
+    RenderParams_t  params;
+    RenderParams_t  *pNext;
+    int   filterAtten_pc = (int) (g_FilterInputAtten * 100);
+    int   filterGain_x10 = (uint8) (g_FilterOutputGain * 10);  // 1..250
+    int   noiseGain_x10 = (uint8) (g_NoiseFilterGain * 10);    // 1..250
+    int   levelAdjust = g_Patch.AudioLevelAdjust;
+
+    memset(&params, 0, sizeof(RenderParams_t));
+    params.LevelAdjust = IntToFixedPt(levelAdjust) / 100;
+    params.FilterInGain = (fixed_t) (((int64) m_FilterInGain * filterAtten_pc) / 100);
+    params.FilterOutGain = IntToFixedPt(filterGain_x10) / 100;
+    params.NoiseOutGain = IntToFixedPt(noiseGain_x10) / 10;
+    params.Osc1IsWave = (g_Patch.Osc1WaveTable < m_NumberOfWavetables);
+    params.Osc2IsWave = (g_Patch.Osc2WaveTable < m_NumberOfWavetables);
+    params.Osc1InterpMode = g_Config.Osc1InterpMode;
+    params.Osc2InterpMode = g_Config.Osc2InterpMode;
+    params.NoiseMode = g_Patch.NoiseMode;
+    params.FilterMode = g_Patch.FilterMode;
+    params.FilterEnabled = (g_Patch.FilterResonance != 0);
+
+    if (memcmp(&params, m_pRenderParams, sizeof(RenderParams_t)) == 0)  return;  // no change
+
+    pNext = (m_pRenderParams == &m_RenderParams[0]) ? &m_RenderParams[1] : &m_RenderParams[0];
+    memcpy(pNext, &params, sizeof(RenderParams_t));
+    m_pRenderParams = pNext;
 }
 
 
@@ -236,294 +464,913 @@ PRIVATE  void  WaveTableSelect(uint8 osc_num, uint8 wave_id)
 
 
 /*`````````````````````````````````````````````````````````````````````````````````````````````````
- * Function:     Copies patch parameters from a given pre-defined patch table in flash
- *               program memory to the "active" patch parameter table in data memory, except
- *               if patchNum is 0, load last saved 'User Patch' from EEPROM image.
- *               If the given patch ID number cannot be found, the function will copy
- *               parameters from a "default" patch (idx == 0) and return ERROR (-1).
+ * Function:     Build band-limited wave-table "mipmaps" for the active oscillator wave-tables.
  *
- * Entry args:   patchNum = ID number of patch parameter table to be accessed.
- *               <!> This is *not* an index into the patch definitions array, g_PatchProgram[].
+ * Overview:     Called by SynthPrepare() after the wave-tables for OSC1 and OSC2 have been
+ *               selected, and by WaveTableSizeSet() after the user wave-table is modified.
+ *               If both oscillators use the same wave-table, the mipmap is built once
+ *               and shared.  Oscillators configured as "pure sawtooth" have no mipmap.
  *
- * Return val:   ERROR (-1) if the given patch ID cannot be found, else OK (0).
+ *               An oscillator's mipmap is not rebuilt if it was last built (in the
+ *               oscillator's own buffer) from the same flash wave-table, so a patch change
+ *               which keeps the wave-tables costs nothing here.  The user wave-table (RAM)
+ *               may have been modified, so a mipmap built from it is always rebuilt.
  */
-short  SynthPatchSelect(int patchNum)
+PRIVATE  void  WaveMipmapPrepare()
 {
-    short  status = SUCCESS;
-    int    i;
-    int    patchCount = GetNumberOfPatchesDefined();
-
-    if (patchNum >= 10)  // e.g. NUMBER_OF_USER_PATCHES = 10  *** todo ***
-    {
-        for (i = 0;  i < patchCount;  i++)
-        {
-            if (g_PatchProgram[i].PatchNumber == patchNum)  break;
-        }
-
-        if (i >= patchCount)   // patchNum not found -- load default patch
-        {
-            i = 0;
-            status = ERROR;
-        }
+    bool  osc1IsWave = (g_Patch.Osc1WaveTable < m_NumberOfWavetables);
+    bool  osc2IsWave = (g_Patch.Osc2WaveTable < m_NumberOfWavetables);
 
-        memcpy(&g_Patch, &g_PatchProgram[i], sizeof(PatchParamTable_t));
-    }
-    else  // if (patchNum < NUMBER_OF_USER_PATCHES)   *** todo: add user patches ***
+    if (osc1IsWave && (m_WaveTable1 != m_Osc1MipmapSource || m_WaveTable1 == WaveTableBuffer
+    ||  g_Osc1WaveTableSize != m_Osc1MipmapSize))
     {
-        // Copy User Patch (persistent data in EEPROM) to active patch
-        memcpy(&g_Patch, &g_Config.UserPatch, sizeof(PatchParamTable_t));
+        WaveMipmapBuild(m_Osc1Mipmap, m_Osc1MipmapBuffer, m_WaveTable1, g_Osc1WaveTableSize);
+        m_Osc1MipmapSource = m_WaveTable1;
+        m_Osc1MipmapSize = g_Osc1WaveTableSize;
     }
-    
-    if (g_Patch.Osc1WaveTable == 0)  // Restore User Wavetable for OSC1
+
+    if (osc2IsWave && osc1IsWave && m_WaveTable2 == m_WaveTable1 
+    &&  g_Osc2WaveTableSize == g_Osc1WaveTableSize)
     {
-        GenerateWaveTable( (WaveformDesc_t *) &g_Config.UserWaveform );
-        g_Osc1WaveTableSize = g_Config.UserWaveform.Size;
-        g_Osc1FreqDiv = g_Config.UserWaveform.FreqDiv;
+        memcpy(m_Osc2Mipmap, m_Osc1Mipmap, sizeof(m_Osc2Mipmap));  // share OSC1 mipmap
+        m_Osc2MipmapSource = NULL;   // OSC2 buffer not used
     }
-    if (g_Patch.Osc2WaveTable == 0)  // Restore User Wavetable for OSC2
+    else if (osc2IsWave && (m_WaveTable2 != m_Osc2MipmapSource || m_WaveTable2 == WaveTableBuffer
+    ||  g_Osc2WaveTableSize != m_Osc2MipmapSize))
     {
-        GenerateWaveTable( (WaveformDesc_t *) &g_Config.UserWaveform );
-        g_Osc2WaveTableSize = g_Config.UserWaveform.Size;
-        g_Osc2FreqDiv = g_Config.UserWaveform.FreqDiv;
+        WaveMipmapBuild(m_Osc2Mipmap, m_Osc2MipmapBuffer, m_WaveTable2, g_Osc2WaveTableSize);
+        m_Osc2MipmapSource = m_WaveTable2;
+        m_Osc2MipmapSize = g_Osc2WaveTableSize;
     }
-    
-    // Ensure minimum values are assigned to envelope transition times...
-    // (except for peak-hold time, which may be zero)
-    if (g_Patch.AmpldEnvAttack_ms < 5) g_Patch.AmpldEnvAttack_ms = 5;
-    if (g_Patch.AmpldEnvDecay_ms < 5) g_Patch.AmpldEnvDecay_ms = 5;
-    if (g_Patch.AmpldEnvRelease_ms < 5) g_Patch.AmpldEnvRelease_ms = 5;
-    if (g_Patch.ContourDelay_ms < 5) g_Patch.ContourDelay_ms = 5;
-    if (g_Patch.ContourRamp_ms < 5) g_Patch.ContourRamp_ms = 5;
-    if (g_Patch.LFO_RampTime < 5) g_Patch.LFO_RampTime = 5;
-
-    SynthPrepare();
-
-    return  status;
 }
 
 
 /*
- * Function:     If a note is already playing, perform a Legato note change;
- *               otherwise initiate a new note.
+ * Function:     Build a band-limited wave-table mipmap from a given source wave-table.
  *
- * Entry args:   noteNum  = MIDI standard note number, range: 12 ~ 120 (C0..C9),
- *                          e.g. note #60 = C4 = middle-C.
- *               velocity = attack velocity (usage dependent on synth settings)
+ * Entry args:   mipmap = array of WAVE_MIPMAP_LEVELS level descriptors to be set up
+ *               buffer = RAM buffer for levels 1..N (WAVE_MIPMAP_BUFFER_SIZE samples)
+ *               source = source wave-table (flash or user RAM buffer), becomes level 0
+ *               size   = number of samples in source wave-table
  *
- * When a new note is initiated, the function prepares the synth wave-table oscillators
- * to play the given note, sets filter characteristics according to patch parameters,
- * then triggers the envelope shapers to enter the 'Attack' phase.
+ * The source table is analysed (DFT) to find the amplitude and phase of harmonics 1..32.
+ * If these account for 99.9% of the signal energy, the highest significant (> -60dB)
+ * harmonic found is the harmonic limit of level 0, otherwise WAVE_MIPMAP_HARMONICS_MAX
+ * is assumed.  Level N (N = 1..6) is re-synthesized from harmonics 1..(64 >> N) only,
+ * in a table of 16 samples per cycle of the highest harmonic (minimum 128 samples).
+ * Levels which would contain all the harmonics of the source table are not built;
+ * they reference level 0 instead.  All levels built are scaled by the same factor, if
+ * necessary, so that the peak sample value (incl. Gibbs overshoot) does not clip.
+ * The computation uses the sine LUT, g_sinewave[], in place of sin() and cos().
+ *
+ * The analysis (DFT) of a flash wave-table is cached -- see WaveAnalysisGet() -- along
+ * with the scale factor found by the first build, so that the mipmap of a recently used
+ * table is rebuilt by a single re-synthesis pass.  The level sizes are powers of 2, so the
+ * re-synthesis sine LUT index is found by a mask and shift, rather than by division.
  */
-void  SynthNoteOn(uint8 noteNum, uint8 velocity)
+PRIVATE  void  WaveMipmapBuild(WaveTableLevel_t *mipmap, int16 *buffer, int16 *source, int size)
 {
-    int32  oscFreqLFO;  // 24:8 bit fixed-point
-    
-    if (!m_Note_ON)  // Note OFF -- Initiate a new note...
+    WaveAnalysis_t  *pWave;
+    int32   sinePeak = g_sinewave[SINE_WAVE_TABLE_SIZE / 4];
+    int32   sample, peak = 0;
+    int32   scale_pK = 1000;   // level scale factor x1000
+    int     level, harmonics, levelSize, levelShift;
+    int     i, k, pass;
+    int     idx;               // index into g_sinewave[]
+    int16  *pLevelData;
+
+    mipmap[0].Address = source;
+    mipmap[0].Period = size << 16;
+    if (size == 0)  size = 1;  // avoid divide by zero (user table not yet created)
+
+    pWave = WaveAnalysisGet(source, size);
+    mipmap[0].Harmonics = pWave->Harmonics;
+
+    // Pass 0 finds the peak sample value over all levels;  pass 1 stores the samples.
+    // Pass 0 is skipped if the scale factor is known from a previous build.
+    if (pWave->Scale_pK != 0)  scale_pK = pWave->Scale_pK;
+
+    for (pass = (pWave->Scale_pK != 0) ? 1 : 0;  pass < 2;  pass++)
     {
-        SynthNoteChange(noteNum);  // Set OSC1 and OSC2 frequencies, etc
+        pLevelData = buffer;
 
-        oscFreqLFO = (((int) g_Patch.LFO_Freq_x10) << 8) / 10;  // set LFO freq.
-        m_LFO_Step = (oscFreqLFO * SINE_WAVE_TABLE_SIZE) / 1000;  // LFO Fs = 1000Hz
-        m_AmpldEnvOutput = 0;
-        m_ContourEnvOutput = IntToFixedPt(g_Patch.ContourStartLevel) / 100;
+        for (level = 1;  level < WAVE_MIPMAP_LEVELS;  level++)
+        {
+            harmonics = WAVE_MIPMAP_HARMONICS_MAX >> level;
+            levelSize = (harmonics >= 8) ? (harmonics * 16) : 128;
+            for (levelShift = 0;  (1 << levelShift) < levelSize;  levelShift++)  {;}
 
-        // A square-law curve is applied to velocity
-        m_AttackVelocity = IntToFixedPt((int) velocity) / 128;  // normalized
-        m_AttackVelocity = MultiplyFixed(m_AttackVelocity, m_AttackVelocity);  // squared
-        
-        // Refresh synth operational variables from global (non-patch) settable params.
-        m_ExprnCalibr_pc = (uint8) (g_ExpressionCalibr * 100);
-        m_NoiseGain_x10 = (uint8) (g_NoiseFilterGain * 10);
-        m_FilterAtten_pc = (uint8) (g_FilterInputAtten * 100); 
-        m_FilterGain_x10 = (uint8) (g_FilterOutputGain * 10); 
-        
-//      v_Osc1Angle = 0;           // redundant code ??? 
-//      v_Osc2Angle = 0;
-//      v_Mix2Level = (1000 * (int) g_Patch.MixerOsc2Level) / 100;
-//      v_NoiseLevel = 0;   
-//      v_OutputLevel = 0;
-
-        m_LegatoNoteChange = 0;    // Not a Legato event
-        m_TriggerAttack = 1;       // Let 'er rip, Boris
-        m_TriggerContour = 1;
-        v_SynthEnable = 1;
-    }
-    else  // Note already playing -- do legato note change
-    {
-        SynthNoteChange(noteNum);  // Adjust OSC1 and OSC2 frequencies
-        m_LegatoNoteChange = 1;    // Signal Note-Change event (for vibrato fn)
+            if (harmonics >= mipmap[0].Harmonics)   // Level not needed
+            {
+                mipmap[level] = mipmap[0];
+                pLevelData += levelSize;
+                continue;
+            }
+
+            for (i = 0;  i < levelSize;  i++)
+            {
+                sample = 0;
+                for (k = 1;  k <= harmonics;  k++)
+                {
+                    // idx = ((k * i) % levelSize) * SINE_WAVE_TABLE_SIZE / levelSize
+                    idx = (((k * i) & (levelSize - 1)) * SINE_WAVE_TABLE_SIZE) >> levelShift;
+                    sample += pWave->AmpldIm[k-1] * g_sinewave[idx];
+                    idx += SINE_WAVE_TABLE_SIZE / 4;
+                    if (idx >= SINE_WAVE_TABLE_SIZE)  idx -= SINE_WAVE_TABLE_SIZE;
+                    sample += pWave->AmpldRe[k-1] * g_sinewave[idx];
+                }
+                sample = sample / sinePeak;
+
+                if (pass == 0)
+                {
+                    if (sample > peak)  peak = sample;
+                    if (-sample > peak)  peak = -sample;
+                }
+                else  pLevelData[i] = (int16) ((sample * scale_pK) / 1000);
+            }
+
+            mipmap[level].Address = pLevelData;
+            mipmap[level].Period = levelSize << 16;
+            mipmap[level].Harmonics = (pWave->Highest < harmonics) ? pWave->Highest : harmonics;
+            pLevelData += levelSize;
+        }
+
+        if (pass == 0 && peak > 32000)  scale_pK = (32000 * 1000) / peak;
     }
+
+    pWave->Scale_pK = (uint16) scale_pK;
 }
 
 
 /*
- * Function:     Set the pitch of a note to be initiated, or change pitch of the note
- *               in progress, without affecting the amplitude envelope (i.e. no re-attack).
- *               This function may be used where a "legato" effect is required.
- *               (See also: SynthNoteOn() function.)
+ * Function:     Find the harmonic analysis of a given wave-table in the cache, or analyse
+ *               the table (DFT), replacing the least recently used cache entry.
  *
- * Entry args:   noteNum = MIDI standard note number. (Note #60 = C4 = middle-C.)
- *               The REMI synth supports note numbers in the range: 12 (C0) to 120 (C9).
+ * Entry args:   source = source wave-table (flash or user RAM buffer)
+ *               size   = number of samples in source wave-table (> 0)
  *
- * The actual perceived pitch depends on the Frequency Divider values and the dominant
- * partial(s) in the waveform(s). Normally, the Osc.Freq.Div parameter value is chosen to
- * match the wave-table, so that the perceived pitch corresponds to the MIDI note number.
+ * Return val:   Pointer to the cache entry holding the analysis.
+ *
+ * The user wave-table (RAM buffer) may be modified at any time, so it is always analysed,
+ * and the entry is marked as invalid and least recently used, to be replaced next.
  */
-void  SynthNoteChange(uint8 noteNum)
+PRIVATE  WaveAnalysis_t  *WaveAnalysisGet(int16 *source, int size)
 {
-    float   osc1Freq, osc2Freq;
-    fixed_t osc1Step, osc2Step;
-    float   osc2detune;      // ratio:  osc2Freq / osc1Freq;
-    fixed_t detuneNorm;
-    int     cents, noteTransposed;
-    int     preset = g_Config.PresetLastSelected;
-
-    // Apply PRESET Pitch Transpose parameter
-    noteTransposed = (int) noteNum + g_Preset.Descr[preset].PitchTranspose;
-
-    // Ensure note number is within synth range (12 ~ 120)
-    noteTransposed &= 0x7F;
-    if (noteTransposed > 120)  noteTransposed -= 12;   // too high
-    if (noteTransposed < 12)   noteTransposed += 12;   // too low
+    WaveAnalysis_t  *pEntry = &m_WaveAnalysis[0];   // least recently used entry
+    int   i;
 
-    noteNum = noteTransposed;
-    m_NotePlaying = noteNum;
-    m_Note_ON = TRUE;
+    for (i = 0;  i < WAVE_ANALYSIS_CACHE_SIZE;  i++)
+    {
+        if (source != WaveTableBuffer && m_WaveAnalysis[i].Source == source 
+        &&  m_WaveAnalysis[i].Size == size)
+        {
+            m_WaveAnalysis[i].LastUsed = ++m_WaveAnalysisSeq;
+            return  &m_WaveAnalysis[i];   // cache hit
+        }
+        if (m_WaveAnalysis[i].LastUsed < pEntry->LastUsed)  pEntry = &m_WaveAnalysis[i];
+    }
 
-    // Convert MIDI note number to frequency (Hz);  apply OSC1 freq.divider param.
-    osc1Freq = m_NoteFrequency[noteNum - 12] / g_Osc1FreqDiv;
+    WaveAnalyse(pEntry, source, size);
 
-    // Calculate detune factor as a fraction of an octave
-    cents = g_Patch.Osc2Detune % 1200;     // Limit +/- 1 octave
-    detuneNorm = (IntToFixedPt(1) * cents) / 1200;  // range +/-1.000
-    osc2detune = FixedToFloat(Base2Exp(detuneNorm));
-    osc2Freq = osc1Freq * osc2detune;      // Apply OSC2 detune factor
-    osc2Freq = osc2Freq / g_Osc2FreqDiv;   // Apply OSC2 Freq.Divider parameter
+    if (source == WaveTableBuffer)
+    {
+        pEntry->Source = NULL;
+        pEntry->LastUsed = 0;
+    }
+    else  pEntry->LastUsed = ++m_WaveAnalysisSeq;
 
-    // Initialize oscillator variables for use in audio ISR
-    osc1Step = (int32) ((osc1Freq * (g_Osc1WaveTableSize << 16)) / SAMPLE_RATE_HZ);
-    osc2Step = (int32) ((osc2Freq * (g_Osc2WaveTableSize << 16)) / SAMPLE_RATE_HZ);
-    
-    if (g_Patch.Osc1WaveTable >= m_NumberOfWavetables)  // Pure sawtooth or square
-        osc1Step = (int32) ((m_FundamentalPeriod * osc1Freq) / SAMPLE_RATE_HZ);
-    
-    m_Osc1StepMedian = osc1Step;  // for Osc FM (vibrato, pitch-bend, etc)
-    m_Osc2StepMedian = osc2Step;
-    
-//  TIMER2_IRQ_DISABLE();  
-    v_Osc1Step = osc1Step;
-    v_Osc2Step = osc2Step;
-//  TIMER2_IRQ_ENABLE();
+    return  pEntry;
 }
 
 
 /*
- * Function:     End the note playing, if it matches the given note number.
+ * Function:     Analyse a wave-table (DFT) to find the amplitude and phase of harmonics
+ *               1..32 and the harmonic limit of the table -- see WaveMipmapBuild().
  *
- * Entry args:   noteNum = MIDI standard note number of note to be ended.
- * 
- * If noteNum == 0, the note will be terminated regardless of m_NotePlaying.  
- * This deviation from the MIDI standard is provided to support the REMI 2 handset.
+ * Entry args:   pWave  = analysis result (entry in wave analysis cache)
+ *               source = source wave-table (flash or user RAM buffer)
+ *               size   = number of samples in source wave-table (> 0)
  *
- * The function puts the amplitude envelope into the 'Release' phase. The note will be
- * terminated by the synth process (B/G task) when the release time expires, or if
- * a new note is initiated prior.
+ * The sine LUT index of sample i for harmonic k is ((k * i) % size) * SINE / size, where
+ * SINE = SINE_WAVE_TABLE_SIZE.  It is advanced exactly, without division, by tracking the
+ * quotient (idx) and remainder (rem) of (k * i % size) * SINE, divided by size.
  */
-void  SynthNoteOff(uint8 noteNum)
+PRIVATE  void  WaveAnalyse(WaveAnalysis_t *pWave, int16 *source, int size)
 {
-    int   noteTransposed;
-    int   preset = g_Config.PresetLastSelected;
+    int32   sinePeak = g_sinewave[SINE_WAVE_TABLE_SIZE / 4];
+    int64   sumRe, sumIm;
+    int64   totalEnergy = 0;   // sum of squared samples / N
+    int64   harmEnergy = 0;    // sum of harmonic energies (ampld^2 / 2)
+    int     highest = 0;       // highest significant harmonic (1..32)
+    int     i, k;
+    int     idx, rem;          // index into g_sinewave[], remainder (see above)
+    int     idxStep, remStep;  // increments of idx, rem per sample
+    int     phase;             // (k * i) % size
+    int     cosIdx;
+
+    for (i = 0;  i < size;  i++)  totalEnergy += (int32) source[i] * source[i];
+    totalEnergy = totalEnergy / size;
+
+    for (k = 1;  k <= WAVE_MIPMAP_HARMONICS_MAX / 2;  k++)  // DFT analysis
+    {
+        sumRe = 0;  sumIm = 0;
+        idxStep = (k * SINE_WAVE_TABLE_SIZE) / size;
+        remStep = (k * SINE_WAVE_TABLE_SIZE) % size;
+        idx = 0;  rem = 0;  phase = 0;
 
-    // Apply PRESET Pitch Transpose parameter
-    noteTransposed = (int) noteNum + g_Preset.Descr[preset].PitchTranspose;
+        for (i = 0;  i < size;  i++)
+        {
+            sumIm += (int32) source[i] * g_sinewave[idx];
+            cosIdx = idx + SINE_WAVE_TABLE_SIZE / 4;   // cos(x) = sin(x + pi/2)
+            if (cosIdx >= SINE_WAVE_TABLE_SIZE)  cosIdx -= SINE_WAVE_TABLE_SIZE;
+            sumRe += (int32) source[i] * g_sinewave[cosIdx];
+
+            idx += idxStep;
+            rem += remStep;
+            if (rem >= size)  { rem -= size;  idx++; }
+            phase += k;
+            if (phase >= size)  { phase -= size;  idx -= SINE_WAVE_TABLE_SIZE; }
+        }
+        // Scale sums to sample units:  ampld = 2 * sum / (N * sine_peak)
+        pWave->AmpldRe[k-1] = (int32) ((sumRe * 2) / ((int64) size * sinePeak));
+        pWave->AmpldIm[k-1] = (int32) ((sumIm * 2) / ((int64) size * sinePeak));
+        sumRe = (int64) pWave->AmpldRe[k-1] * pWave->AmpldRe[k-1] 
+              + (int64) pWave->AmpldIm[k-1] * pWave->AmpldIm[k-1];
+        harmEnergy += sumRe / 2;
+        if (sumRe > (32 * 32))  highest = k;   // ampld > -60dB FS (approx.)
+    }
 
-    // Ensure note number is within synth range (12 ~ 108)
-    noteTransposed &= 0x7F;
-    if (noteTransposed > 120)  noteTransposed -= 12;   // too high
-    if (noteTransposed < 12)   noteTransposed += 12;   // too low
+    pWave->Source = source;
+    pWave->Size = size;
+    pWave->Highest = highest;
+    pWave->Scale_pK = 0;   // found by the first mipmap build
 
-    if (noteNum == 0 || noteTransposed == m_NotePlaying)
-    {
-        m_TriggerRelease = 1;
-        m_Note_ON = FALSE;
-    }
+    // If harmonics above 32 carry less than 0.1% of the energy, the table is limited
+    if ((totalEnergy - harmEnergy) < (totalEnergy / 1000))  pWave->Harmonics = highest;
+    else  pWave->Harmonics = WAVE_MIPMAP_HARMONICS_MAX;
 }
 
 
 /*
- * Function:     Set the "Pressure Level" according to a given data value.
- *               Equivalent to MIDI Control Change message (CC# = 02, 07 or 11).
+ * Function:     Select the wave-table mipmap level for a given oscillator frequency.
  *
- * Entry args:   data14 = MIDI expression/pressure value (14 bits, unsigned).
+ * Entry args:   mipmap    = array of level descriptors (see WaveMipmapBuild())
+ *               tableFreq = frequency of one cycle of the wave-table (Hz), 
+ *                           i.e. note frequency divided by osc. freq. divider
  *
- * Outputs:      (fixed_t) m_PressureLevel = normalized pressure level (0..+1.0)
- *                             capped at 0.99 FS, linear response
- *                                                ```````````````
- *               (fixed_t) m_ExpressionLevel = normalized pressure level (0..+1.0)
- *                             capped at 0.99 FS, square-law response
- *                                                ```````````````````
- * Note:         A square-law is applied to the data value to approximate an exponential
- *               response curve. The output pressure level is fixed point, normalized.
+ * Return val:   Pointer to the lowest level (most harmonics) in which the highest harmonic
+ *               is below the Nyquist frequency (m_SampleRate / 2), if any, else the
+ *               highest level (fundamental only).
  */
-void   SynthExpression(unsigned data14)
+PRIVATE  WaveTableLevel_t  *WaveMipmapLevelSelect(WaveTableLevel_t *mipmap, float tableFreq)
 {
-    uint32  ulval;
-    fixed_t level;
-    fixed_t levelMax = (IntToFixedPt(1) * 99) / 100;
-    
-    ulval = data14 << 6;  // scale to 20 bits (fractional part)
-    level = (fixed_t) ulval;  
-    level = (level * m_ExprnCalibr_pc) / 100;  // adjust level
-    if (level > levelMax) level = levelMax;  // cap at 0.99
-    m_PressureLevel = level;
+    int  level = 0;
 
-    ulval = ((uint32) data14 * data14) / 16384;  // apply square law
-    ulval = ulval << 6;   // scale to 20 bits (fractional part)
-    level = (fixed_t) ulval; 
-    level = (level * m_ExprnCalibr_pc) / 100;  // adjust level
-    if (level > levelMax) level = levelMax;  // cap at 0.99
-    if (level > g_ExpressionPeak)  g_ExpressionPeak = level;  // diagnostic
-    m_ExpressionLevel = level;  
+    while (level < (WAVE_MIPMAP_LEVELS - 1)
+    &&    (tableFreq * mipmap[level].Harmonics) > (m_SampleRate / 2))
+    {
+        level++;
+    }
+
+    return  &mipmap[level];
 }
 
 
-/*
- * Function:     Modify pitch of note in progress according to Pitch-Bend data value.
+/*`````````````````````````````````````````````````````````````````````````````````````````````````
+ * Function:     Copies patch parameters from a given pre-defined patch table in flash
+ *               program memory to the "active" patch parameter table in data memory, except
+ *               if patchNum is 0, load last saved 'User Patch' from EEPROM image.
+ *               If the given patch ID number cannot be found, the function will copy
+ *               parameters from a "default" patch (idx == 0) and return ERROR (-1).
  *
- * Entry args:   bipolarPosn = signed integer representing Pitch Bend lever position,
- *                        in the range +/-8000 (14 LS bits).  Centre pos'n is 0.
+ * Entry args:   patchNum = ID number of patch parameter table to be accessed.
+ *               <!> This is *not* an index into the patch definitions array, g_PatchProgram[].
+ *
+ * Return val:   ERROR (-1) if the given patch ID cannot be found, else OK (0).
  *
- * Affected:     m_PitchBendFactor, which is processed by the real-time synth function
- *               OscFreqModulation() while a note is in progress.
+ * The User Wave-table is regenerated only if the user waveform descriptor has changed, or
+ * the buffer has been modified (see UserWaveTableInvalidate), since it was last generated.
+ * Band-limited wave-tables are rebuilt only for oscillators whose wave-table has changed.
+ * The execution time is recorded in the engine profile (stage PROFILE_PATCH_SWITCH).
  */
-void   SynthPitchBend(int bipolarPosn)
+short  SynthPatchSelect(int patchNum)
 {
-    // Scale lever position (arg) according to patch 'PitchBendRange' param.
-    // PitchBendRange may be up to 1200 cents (ie. 1 octave maximum).
-    int  posnScaled = (bipolarPosn * g_Config.PitchBendRange) / 1200;
-    
-    // Convert to 20-bit *signed* fixed-point fraction  (13 + 7 = 20 bits)
-    m_PitchBendFactor = (fixed_t) (posnScaled << 7);
+    short  status;
+    uint32 entryTime, CC_Reg;
+
+    READ_CPU_CORE_COUNT_REG(entryTime);
+
+    status = PatchParamsLoad(&g_Patch, patchNum);
+    UserWaveTableRestore();
+
+    m_ModMatrixValid = FALSE;  // Set up default modulation routing for the patch
+    SynthPrepare();
+
+    READ_CPU_CORE_COUNT_REG(CC_Reg);
+    ProfileRecord(PROFILE_PATCH_SWITCH, CC_Reg - entryTime);
+
+    return  status;
 }
 
 
 /*
- * Function:     Control synth effect(s) according to MIDI Modulation data (CC#1);
- *               e.g. vibrato depth, noise level, filter freq., etc.
- *               The effect(s) to be controlled is a function of the synth patch^.
- *
- * Entry args:   data14 = unsigned integer representing Modulation Lever position;
- *                        range 0..16383 (= 2^14 - 1).
- *
- * Output:       m_ModulationLevel, normalized fixed-pt number in the range 0..+1.0.
+ * Function:     Copy the parameters of a given patch (see SynthPatchSelect) into a given
+ *               patch table, ensuring that minimum values are assigned to envelope times.
  *
+ * Return val:   ERROR (-1) if the given patch ID cannot be found, else OK (0).
  */
-void   SynthModulation(unsigned data14)
+PRIVATE  short  PatchParamsLoad(PatchParamTable_t *pPatch, int patchNum)
 {
-    if (data14 < (16 * 1024))  
-        m_ModulationLevel = (fixed_t) ((uint32) data14 << 6);  
-    else   m_ModulationLevel = FIXED_MAX_LEVEL;
-}
+    short  status = SUCCESS;
+    int    i;
+
+    if (patchNum >= 10)  // e.g. NUMBER_OF_USER_PATCHES = 10  *** todo ***
+    {
+        i = PatchIndexFind(patchNum);
+
+        if (i < 0)   // patchNum not found -- load default patch
+        {
+            i = 0;
+            status = ERROR;
+        }
+
+        memcpy(pPatch, &g_PatchProgram[i], sizeof(PatchParamTable_t));
+    }
+    else  // if (patchNum < NUMBER_OF_USER_PATCHES)   *** todo: add user patches ***
+    {
+        // Copy User Patch (persistent data in EEPROM) to active patch
+        memcpy(pPatch, &g_Config.UserPatch, sizeof(PatchParamTable_t));
+    }
+    
+    // Ensure minimum values are assigned to envelope transition times...
+    // (except for peak-hold time, which may be zero;  attack may be as short as 1ms)
+    if (pPatch->AmpldEnvAttack_ms < 1) pPatch->AmpldEnvAttack_ms = 1;
+    if (pPatch->AmpldEnvDecay_ms < 5) pPatch->AmpldEnvDecay_ms = 5;
+    if (pPatch->AmpldEnvRelease_ms < 5) pPatch->AmpldEnvRelease_ms = 5;
+    if (pPatch->ContourDelay_ms < 5) pPatch->ContourDelay_ms = 5;
+    if (pPatch->ContourRamp_ms < 5) pPatch->ContourRamp_ms = 5;
+    if (pPatch->LFO_RampTime < 5) pPatch->LFO_RampTime = 5;
+
+    return  status;
+}
+
+
+/*
+ * Function:     If either oscillator of the active patch is driven from the User Wave-table,
+ *               restore the table (RAM buffer) from the user waveform descriptor in EEPROM
+ *               and set the oscillator's table size and freq. divider.
+ */
+PRIVATE  void  UserWaveTableRestore(void)
+{
+    if ((g_Patch.Osc1WaveTable == 0 || g_Patch.Osc2WaveTable == 0)
+    &&  (!m_UserWaveValid 
+    ||  memcmp(&m_UserWaveDesc, &g_Config.UserWaveform, sizeof(WaveformDesc_t)) != 0))
+    {
+        GenerateWaveTable( (WaveformDesc_t *) &g_Config.UserWaveform );
+        memcpy(&m_UserWaveDesc, &g_Config.UserWaveform, sizeof(WaveformDesc_t));
+        m_UserWaveValid = TRUE;
+    }
+    if (g_Patch.Osc1WaveTable == 0)  // User Wavetable for OSC1
+    {
+        g_Osc1WaveTableSize = g_Config.UserWaveform.Size;
+        g_Osc1FreqDiv = g_Config.UserWaveform.FreqDiv;
+    }
+    if (g_Patch.Osc2WaveTable == 0)  // User Wavetable for OSC2
+    {
+        g_Osc2WaveTableSize = g_Config.UserWaveform.Size;
+        g_Osc2FreqDiv = g_Config.UserWaveform.FreqDiv;
+    }
+}
+
+
+/*`````````````````````````````````````````````````````````````````````````````````````````````````
+ * Function:     Change the active patch without a break in the audio output, i.e. with a
+ *               "patch transition" (crossfade) lasting 2 x g_Config.PatchFadeTime_ms.
+ *
+ * Entry args:   patchNum = ID number of patch to be activated (see SynthPatchSelect).
+ *
+ * Return val:   ERROR (-1) if the given patch ID cannot be found, else OK (0).
+ *
+ * The new patch parameters are loaded into a second (pending) patch table;  the active
+ * patch, g_Patch, is not modified while any voice is being rendered.  The transition has
+ * three phases, each advanced by the block renderer or the synth process:
+ *
+ *   PATCH_FADE_OUT :  The renderer fades the voice mix out, over the fade time, while the
+ *                     voices continue to play the old patch.  The reverb continues.
+ *   PATCH_FADE_SWITCH: The renderer holds off events and outputs the reverb tail only,
+ *                     until the synth process calls PatchTransitionSwitch() to instate
+ *                     the pending patch.  Notes held are carried over to the new patch.
+ *   PATCH_FADE_IN :   The renderer fades the voice mix in, over the fade time.
+ *
+ * The old patch and the new patch cannot sound together, since the band-limited tables
+ * are rebuilt in place.  A further patch change during a transition replaces the pending
+ * patch;  the fade-out continues from the present level.  If the synth is not running,
+ * or the fade time is zero, the patch is changed at once by SynthPatchSelect().
+ *
+ * Note:         The new patch is not active (in g_Patch) when the function returns.
+ */
+short  SynthPatchTransition(int patchNum)
+{
+    short  status;
+    int    fadeTime = g_Config.PatchFadeTime_ms;
+
+    if (!v_SynthEnable || fadeTime == 0)  return  SynthPatchSelect(patchNum);
+
+    if (fadeTime < PATCH_FADE_TIME_MIN)  fadeTime = PATCH_FADE_TIME_MIN;
+    if (fadeTime > PATCH_FADE_TIME_MAX)  fadeTime = PATCH_FADE_TIME_MAX;
+
+    status = PatchParamsLoad(&m_PatchPending, patchNum);
+
+    AUDIO_RENDER_IRQ_DISABLE();
+    m_PatchFadeStep = IntToFixedPt(1) / (fadeTime * m_SamplesPerMs);
+    if (m_PatchFadeState == PATCH_FADE_IDLE)  m_PatchFadeLevel = IntToFixedPt(1);
+    if (m_PatchFadeState != PATCH_FADE_SWITCH)  m_PatchFadeState = PATCH_FADE_OUT;
+    AUDIO_RENDER_IRQ_ENABLE();
+
+    return  status;
+}
+
+
+/*
+ * Function:     Instate the pending patch at the mid-point of a patch transition, when
+ *               the voice mix has been faded out -- see SynthPatchTransition().
+ *
+ * Called by the synth process (not the render ISR).  Released voices are freed and the
+ * active patch table is replaced with the render IRQ held off;  the operational variables
+ * are then computed while the renderer holds off events and voices.  Voices which are
+ * gated (note held) are not re-triggered:  the envelope states are carried over, while the
+ * oscillators and filter are set up afresh for the new patch.  The amplitude envelope of
+ * a held note in the sustain phase glides from its present level to the new sustain level.
+ */
+PRIVATE  void  PatchTransitionSwitch(void)
+{
+    SynthVoice_t  *pVoice;
+    uint16  ramp5ms = m_SamplesPerMs * 5;
+    int     v;
+    uint32  entryTime, CC_Reg;
+
+    READ_CPU_CORE_COUNT_REG(entryTime);
+
+    AUDIO_RENDER_IRQ_DISABLE();
+    for (v = 0, pVoice = m_Voice;  v < SYNTH_VOICES_MAX;  v++, pVoice++)
+    {
+        if (!pVoice->Gate)  pVoice->Active = FALSE;  // Released voice -- free it
+    }
+    memcpy(&g_Patch, &m_PatchPending, sizeof(PatchParamTable_t));
+    AUDIO_RENDER_IRQ_ENABLE();
+
+    UserWaveTableRestore();
+    m_ModMatrixValid = FALSE;  // Set up default modulation routing for the patch
+    SynthParamsPrepare();
+
+    for (v = 0, pVoice = m_Voice;  v < SYNTH_VOICES_MAX;  v++, pVoice++)
+    {
+        AUDIO_RENDER_IRQ_DISABLE();
+        if (pVoice->Active)  // Held note -- set up oscillators and filter on the new patch
+        {
+            VoiceNoteChange(pVoice, pVoice->NoteKey);
+            pVoice->Osc1LevelInUse = NULL;   // Tables rebuilt -- no phase re-scaling
+            pVoice->Osc2LevelInUse = NULL;
+            pVoice->FreqModMult = 0;
+            pVoice->FilterLow = 0;
+            pVoice->FilterBand = 0;
+
+            pVoice->AmpldEnvPeak = (int32) (((int64) m_AmpldPeakLevel
+                                   * pVoice->AttackVelocity) >> 20);
+            pVoice->AmpldEnvSustain = (int32) (((int64) m_AmpldSustainLevel
+                                      * pVoice->AttackVelocity) >> 20);
+            if (pVoice->AmpldEnvSegment == ENV_SUSTAIN)
+            {
+                pVoice->AmpldEnvCount = m_AmpldDecaySamples;
+                pVoice->AmpldEnvSegment = ENV_DECAY;
+            }
+
+            VoiceControlUpdate(pVoice);
+            RampParamInit(&pVoice->Mix2Ramp, (int32) pVoice->Mix2Level << 16, ramp5ms);
+            RampParamInit(&pVoice->NoiseRamp, pVoice->NoiseLevel, ramp5ms);
+            RampParamInit(&pVoice->FilterFreqRamp, pVoice->FilterCoeff_f, ramp5ms);
+            RampParamInit(&pVoice->FilterDampRamp, pVoice->FilterCoeff_q, ramp5ms);
+        }
+        AUDIO_RENDER_IRQ_ENABLE();
+    }
+
+    READ_CPU_CORE_COUNT_REG(CC_Reg);
+    ProfileRecord(PROFILE_PATCH_SWITCH, CC_Reg - entryTime);
+
+    m_PatchFadeState = PATCH_FADE_IN;
+}
+
+
+/*
+ * Function:     Apply the patch transition gain to a block (or segment) of the voice mix,
+ *               advancing the fade level by one step per sample -- see SynthPatchTransition().
+ *               Called by the block renderer while a transition is in progress.
+ */
+PRIVATE  void  PatchFadeRender(fixed_t *buf, int nSamples)
+{
+    fixed_t  level = m_PatchFadeLevel;
+    fixed_t  step = m_PatchFadeStep;
+    fixed_t  sample;
+    int      isam;
+
+    if (m_PatchFadeState == PATCH_FADE_OUT)
+    {
+        for (isam = 0;  isam < nSamples;  isam++)
+        {
+            level -= step;
+            if (level < 0)  level = 0;
+            sample = buf[isam];
+            buf[isam] = MultiplyFixed(sample, level);
+        }
+        if (level == 0)  m_PatchFadeState = PATCH_FADE_SWITCH;
+    }
+    else if (m_PatchFadeState == PATCH_FADE_IN)
+    {
+        for (isam = 0;  isam < nSamples;  isam++)
+        {
+            level += step;
+            if (level > IntToFixedPt(1))  level = IntToFixedPt(1);
+            sample = buf[isam];
+            buf[isam] = MultiplyFixed(sample, level);
+        }
+        if (level == IntToFixedPt(1))  m_PatchFadeState = PATCH_FADE_IDLE;
+    }
+    else  // PATCH_FADE_SWITCH -- voice mix is silent
+    {
+        for (isam = 0;  isam < nSamples;  isam++)  buf[isam] = 0;
+    }
+
+    m_PatchFadeLevel = level;
+}
+
+
+/*
+ * Function:     Find the index of a patch definition in g_PatchProgram[], given its ID.
+ *
+ * Return val:   Index of the patch in g_PatchProgram[], or -1 if the ID is not found.
+ *
+ * Patches are defined in ascending order of ID number, so a binary search is used.
+ * The order is verified on the first call;  if it is not ascending (e.g. a patch was
+ * added out of order), a linear search is used instead.
+ */
+PRIVATE  int  PatchIndexFind(int patchNum)
+{
+    static  int8  isSorted = -1;   // -1: not yet checked
+    int   patchCount = GetNumberOfPatchesDefined();
+    int   lo = 0, hi = patchCount - 1, mid;
+    int   i;
+
+    if (isSorted < 0)
+    {
+        isSorted = TRUE;
+        for (i = 1;  i < patchCount;  i++)
+        {
+            if (g_PatchProgram[i].PatchNumber <= g_PatchProgram[i-1].PatchNumber)  
+                isSorted = FALSE;
+        }
+    }
+
+    if (!isSorted)
+    {
+        for (i = 0;  i < patchCount;  i++)
+        {
+            if (g_PatchProgram[i].PatchNumber == patchNum)  return i;
+        }
+        return  -1;
+    }
+
+    while (lo <= hi)
+    {
+        mid = (lo + hi) / 2;
+        if (g_PatchProgram[mid].PatchNumber == patchNum)  return mid;
+        if (g_PatchProgram[mid].PatchNumber < patchNum)  lo = mid + 1;
+        else  hi = mid - 1;
+    }
+
+    return  -1;
+}
+
+
+/*
+ * Function:     Initiate a new note, or perform a Legato note change.
+ *
+ * Entry args:   noteNum  = MIDI standard note number, range: 12 ~ 120 (C0..C9),
+ *                          e.g. note #60 = C4 = middle-C.
+ *               velocity = attack velocity (usage dependent on synth settings)
+ *
+ * In a MONO MIDI IN mode (2 or 4), only voice 0 is used.  If a note is already playing,
+ * a Legato note change is performed; otherwise a new note is initiated.
+ *
+ * In a POLY MIDI IN mode (1 or 3), a voice is allocated from the pool for each new note.
+ * If all voices are busy, a voice is "stolen" -- see function VoiceAllocate().
+ *
+ * When a new note is initiated, the function prepares the voice's wave-table oscillators
+ * to play the given note, sets filter characteristics according to patch parameters,
+ * then triggers the voice envelope shapers to enter the 'Attack' phase.
+ *
+ * The amplitude envelope is generated by the block renderer, which starts the attack at
+ * the first sample rendered after the trigger.  The first step of the contour envelope
+ * and the voice control variables (osc. steps, mix ratio, noise level, filter coeff.) are
+ * computed here, rather than waiting for the next synth process tick, so that a note-on
+ * applied by the block renderer at a scheduled sample (see SynthPostEvent) starts
+ * sounding at that exact sample.
+ */
+void  SynthNoteOn(uint8 noteNum, uint8 velocity)
+{
+    SynthVoice_t  *pVoice;
+    bool   isPolyMode = (g_Config.MidiInMode == OMNI_ON_POLY 
+                      || g_Config.MidiInMode == OMNI_OFF_POLY);
+
+    if (isPolyMode)  pVoice = VoiceAllocate(noteNum);
+    else  pVoice = &m_Voice[0];
+
+    if (!pVoice->Gate)  // Voice not gated -- Initiate a new note...
+    {
+        VoiceNoteChange(pVoice, noteNum);  // Set OSC1 and OSC2 frequencies, etc
+
+        pVoice->AmpldEnvOutput = 0;
+        pVoice->ContourEnvOutput = IntToFixedPt(g_Patch.ContourStartLevel) / 100;
+
+        // A square-law curve is applied to velocity
+        pVoice->AttackVelocity = IntToFixedPt((int) velocity) / 128;  // normalized
+        pVoice->AttackVelocity = MultiplyFixed(pVoice->AttackVelocity, pVoice->AttackVelocity);
+        pVoice->NoteVelocity = velocity;
+        
+        // Refresh synth operational variables from global (non-patch) settable params.
+        m_ExprnCalibr_pc = (uint8) (g_ExpressionCalibr * 100);
+
+        pVoice->StartCount = ++m_NoteOnCount;  // for voice stealing
+        if (!pVoice->Active)  pVoice->RampReset = TRUE;  // Free voice -- no ramp from old values
+        if (!pVoice->Active)  pVoice->FreqModMult = 0;   // ... nor smoothing of pitch mod'n
+        pVoice->TriggerAttack = 1;     // Let 'er rip, Boris
+        pVoice->TriggerContour = 1;
+        pVoice->Active = TRUE;
+        m_LegatoNoteChange = 0;        // Not a Legato event
+        v_SynthEnable = 1;
+    }
+    else  // Note already playing -- do legato note change
+    {
+        VoiceNoteChange(pVoice, noteNum);  // Adjust OSC1 and OSC2 frequencies
+        m_LegatoNoteChange = 1;    // Signal Note-Change event (for vibrato fn)
+    }
+
+    pVoice->NoteKey = noteNum;
+    pVoice->Gate = TRUE;
+    m_LastVoice = pVoice;
+    m_Note_ON = TRUE;
+
+    if (pVoice->TriggerAttack)  ContourEnvelopeShaper(pVoice);  // New note -- start now
+    VoiceControlUpdate(pVoice);
+    if (pVoice->TriggerAttack)  AudioLevelController(pVoice);
+}
+
+
+/*
+ * Function:     Allocate a voice from the pool to play a given note (poly modes only).
+ *
+ * Entry args:   noteNum = MIDI note number (as received, before transpose)
+ *
+ * Return val:   Pointer to the voice allocated.
+ *
+ * If a gated voice is already playing the same note, that voice is returned, so the note
+ * will be re-attacked.  Otherwise, a free (inactive) voice is used if one is available.
+ * If all voices are active, a voice is "stolen" as follows:
+ *   1. the quietest of the voices which have been released (not gated), if any;
+ *   2. otherwise, the oldest gated voice, i.e. the voice with the lowest StartCount.
+ * A stolen voice is cut off;  the attack of the new note starts from the voice's present
+ * envelope level (or, if the envelope does not control the output level, the output
+ * level is ramped to that of the new note over 1ms).
+ * The oscillator and filter states of a stolen voice are retained.
+ */
+PRIVATE  SynthVoice_t  *VoiceAllocate(uint8 noteNum)
+{
+    SynthVoice_t  *pVoice;
+    SynthVoice_t  *pQuietest = NULL;
+    SynthVoice_t  *pOldest = NULL;
+    int  v;
+
+    for (v = 0, pVoice = m_Voice;  v < SYNTH_VOICES_MAX;  v++, pVoice++)
+    {
+        if (pVoice->Gate && pVoice->NoteKey == noteNum)  
+        {
+            pVoice->Gate = FALSE;  // Re-attack same note
+            return  pVoice;
+        }
+    }
+
+    for (v = 0, pVoice = m_Voice;  v < SYNTH_VOICES_MAX;  v++, pVoice++)
+    {
+        if (!pVoice->Active)  return  pVoice;   // Free voice found
+
+        if (!pVoice->Gate)  // Released voice -- candidate for stealing
+        {
+            if (pQuietest == NULL || pVoice->OutputLevel < pQuietest->OutputLevel)
+                pQuietest = pVoice;
+        }
+        else if (pOldest == NULL || pVoice->StartCount < pOldest->StartCount)
+            pOldest = pVoice;
+    }
+
+    pVoice = (pQuietest != NULL) ? pQuietest : pOldest;
+    pVoice->Gate = FALSE;  // Steal it
+    pVoice->OutputLevel = 0;
+
+    return  pVoice;
+}
+
+
+/*
+ * Function:     Set the pitch of a note to be initiated, or change pitch of the note
+ *               in progress, without affecting the amplitude envelope (i.e. no re-attack).
+ *               This function may be used where a "legato" effect is required.
+ *               (See also: SynthNoteOn() function.)
+ *
+ * Entry args:   noteNum = MIDI standard note number. (Note #60 = C4 = middle-C.)
+ *               The REMI synth supports note numbers in the range: 12 (C0) to 120 (C9).
+ *
+ * The pitch change is applied to the voice most recently allocated by SynthNoteOn().
+ *
+ * The actual perceived pitch depends on the Frequency Divider values and the dominant
+ * partial(s) in the waveform(s). Normally, the Osc.Freq.Div parameter value is chosen to
+ * match the wave-table, so that the perceived pitch corresponds to the MIDI note number.
+ */
+void  SynthNoteChange(uint8 noteNum)
+{
+    VoiceNoteChange(m_LastVoice, noteNum);
+}
+
+
+/*
+ * Function:     Apply the PRESET Pitch Transpose parameter to a MIDI note number and
+ *               bring the result within the synth range (12 ~ 120).
+ */
+PRIVATE  int  TransposeNote(uint8 noteNum)
+{
+    int   noteTransposed;
+    int   preset = g_Config.PresetLastSelected;
+
+    noteTransposed = (int) noteNum + g_Preset.Descr[preset].PitchTranspose;
+
+    noteTransposed &= 0x7F;
+    if (noteTransposed > 120)  noteTransposed -= 12;   // too high
+    if (noteTransposed < 12)   noteTransposed += 12;   // too low
+
+    return  noteTransposed;
+}
+
+
+/*
+ * Function:     Set the oscillator frequencies of a given voice to play a given note.
+ *
+ * Entry args:   pVoice  = pointer to voice in pool
+ *               noteNum = MIDI standard note number (before transpose)
+ */
+PRIVATE  void  VoiceNoteChange(SynthVoice_t *pVoice, uint8 noteNum)
+{
+    float   osc1Freq, osc2Freq;
+    fixed_t osc1Step, osc2Step;
+    float   osc2detune;      // ratio:  osc2Freq / osc1Freq;
+    fixed_t detuneNorm;
+    int     cents;
+
+    noteNum = TransposeNote(noteNum);
+    pVoice->NotePlaying = noteNum;
+
+    // Convert MIDI note number to frequency (Hz);  apply OSC1 freq.divider param.
+    osc1Freq = m_NoteFrequency[noteNum - 12] / g_Osc1FreqDiv;
+
+    // Calculate detune factor as a fraction of an octave
+    cents = g_Patch.Osc2Detune % 1200;     // Limit +/- 1 octave
+    detuneNorm = (IntToFixedPt(1) * cents) / 1200;  // range +/-1.000
+    osc2detune = FixedToFloat(Base2Exp(detuneNorm));
+    osc2Freq = osc1Freq * osc2detune;      // Apply OSC2 detune factor
+    osc2Freq = osc2Freq / g_Osc2FreqDiv;   // Apply OSC2 Freq.Divider parameter
+
+    // Select band-limited wave-table levels to suit the oscillator frequencies
+    pVoice->Osc1Level = WaveMipmapLevelSelect(m_Osc1Mipmap, osc1Freq);
+    pVoice->Osc2Level = WaveMipmapLevelSelect(m_Osc2Mipmap, osc2Freq);
+
+    // Initialize oscillator variables for use by the block renderer
+    osc1Step = (int32) ((osc1Freq * pVoice->Osc1Level->Period) / m_SampleRate);
+    osc2Step = (int32) ((osc2Freq * pVoice->Osc2Level->Period) / m_SampleRate);
+    
+    if (g_Patch.Osc1WaveTable >= m_NumberOfWavetables)  // Pure sawtooth or square
+        osc1Step = (int32) ((m_FundamentalPeriod * osc1Freq) / m_SampleRate);
+    
+    pVoice->Osc1StepMedian = osc1Step;  // for Osc FM (vibrato, pitch-bend, etc)
+    pVoice->Osc2StepMedian = osc2Step;
+    pVoice->Osc1Step = osc1Step;
+    pVoice->Osc2Step = osc2Step;
+}
+
+
+/*
+ * Function:     End the note playing, if it matches the given note number.
+ *
+ * Entry args:   noteNum = MIDI standard note number of note to be ended.
+ * 
+ * If noteNum == 0, all notes will be terminated regardless of note number.  
+ * This deviation from the MIDI standard is provided to support the REMI 2 handset.
+ *
+ * The function puts the amplitude envelope of the voice(s) playing the note into the
+ * 'Release' phase. The voice will be freed by the synth process (B/G task) when the
+ * release time expires, or if the voice is stolen to play a new note.
+ * The release is started by the block renderer, so it begins at the event sample.
+ */
+void  SynthNoteOff(uint8 noteNum)
+{
+    SynthVoice_t  *pVoice;
+    int   noteTransposed = TransposeNote(noteNum);
+    int   v;
+
+    m_Note_ON = FALSE;
+
+    for (v = 0, pVoice = m_Voice;  v < SYNTH_VOICES_MAX;  v++, pVoice++)
+    {
+        if (!pVoice->Gate)  continue;
+
+        if (noteNum == 0 || noteTransposed == pVoice->NotePlaying)
+        {
+            pVoice->TriggerRelease = 1;
+            pVoice->Gate = FALSE;
+            AudioLevelController(pVoice);
+        }
+        else  m_Note_ON = TRUE;  // other note(s) still gated
+    }
+}
+
+
+/*
+ * Function:     Set the "Pressure Level" according to a given data value.
+ *               Equivalent to MIDI Control Change message (CC# = 02, 07 or 11).
+ *
+ * Entry args:   data14 = MIDI expression/pressure value (14 bits, unsigned).
+ *
+ * Outputs:      (fixed_t) m_PressureLevel = normalized pressure level (0..+1.0)
+ *                             capped at 0.99 FS, linear response
+ *                                                ```````````````
+ *               (fixed_t) m_ExpressionLevel = normalized pressure level (0..+1.0)
+ *                             capped at 0.99 FS, square-law response
+ *                                                ```````````````````
+ * Note:         A square-law is applied to the data value to approximate an exponential
+ *               response curve. The output pressure level is fixed point, normalized.
+ */
+void   SynthExpression(unsigned data14)
+{
+    uint32  ulval;
+    fixed_t level;
+    fixed_t levelMax = (IntToFixedPt(1) * 99) / 100;
+    
+    ulval = data14 << 6;  // scale to 20 bits (fractional part)
+    level = (fixed_t) ulval;  
+    level = (level * m_ExprnCalibr_pc) / 100;  // adjust level
+    if (level > levelMax) level = levelMax;  // cap at 0.99
+    m_PressureLevel = level;
+
+    ulval = ((uint32) data14 * data14) / 16384;  // apply square law
+    ulval = ulval << 6;   // scale to 20 bits (fractional part)
+    level = (fixed_t) ulval; 
+    level = (level * m_ExprnCalibr_pc) / 100;  // adjust level
+    if (level > levelMax) level = levelMax;  // cap at 0.99
+    if (level > g_ExpressionPeak)  g_ExpressionPeak = level;  // diagnostic
+    m_ExpressionLevel = level;  
+}
+
+
+/*
+ * Function:     Modify pitch of note in progress according to Pitch-Bend data value.
+ *
+ * Entry args:   bipolarPosn = signed integer representing Pitch Bend lever position,
+ *                        in the range +/-8000 (14 LS bits).  Centre pos'n is 0.
+ *
+ * Affected:     m_PitchBendLevel, a source of the modulation matrix, which is applied to
+ *               the oscillator pitch while a note is in progress.  The pitch-bend range
+ *               (config param 'PitchBendRange', up to 1200 cents) is the route depth.
+ */
+void   SynthPitchBend(int bipolarPosn)
+{
+    // Convert to 20-bit *signed* fixed-point fraction  (13 + 7 = 20 bits)
+    m_PitchBendLevel = (fixed_t) (bipolarPosn << 7);
+}
+
+
+/*
+ * Function:     Control synth effect(s) according to MIDI Modulation data (CC#1);
+ *               e.g. vibrato depth, noise level, filter freq., etc.
+ *               The effect(s) to be controlled is a function of the synth patch^.
+ *
+ * Entry args:   data14 = unsigned integer representing Modulation Lever position;
+ *                        range 0..16383 (= 2^14 - 1).
+ *
+ * Output:       m_ModulationLevel, normalized fixed-pt number in the range 0..+1.0.
+ *
+ */
+void   SynthModulation(unsigned data14)
+{
+    if (data14 < (16 * 1024))  
+        m_ModulationLevel = (fixed_t) ((uint32) data14 << 6);  
+    else   m_ModulationLevel = FIXED_MAX_LEVEL;
+}
 
 
 /*`````````````````````````````````````````````````````````````````````````````````````````````````
@@ -531,10 +1378,17 @@ void   SynthModulation(unsigned data14)
  *
  * Overview:  Periodic background task called at 1ms intervals which performs most of the
  *            real-time sound synthesis computations, except those which need to be executed
- *            at the PCM audio sampling rate; these are done by the Timer_2 ISR.
+ *            at the PCM audio sampling rate; these are done by the block renderer,
+ *            SynthRenderBlock(), which is called by the audio render ISR.
  *
- * This task implements the envelope shapers, oscillator pitch bend and vibrato (LFO), mixer
- * input ratio control, DSP filter frequency control, audio output amplitude control, etc.
+ * This task implements the contour envelope shaper, the LFOs and the modulation matrix,
+ * which routes the LFOs, envelopes and MIDI controllers to the oscillator pitch, mixer input
+ * ratio, DSP filter frequency, noise level and output gain, and the audio output amplitude
+ * control.  The LFOs and vibrato ramp are common to all voices;  the contour envelope, the
+ * modulation matrix and the output level control are applied to each active voice.
+ * The amplitude envelope is advanced once per block by the block renderer, which
+ * interpolates the output level linearly across the block (see SynthRenderBlock());
+ * its segment coefficients are refreshed here if the patch param's change.
  *
  * Some processing is done at 1ms intervals (1000Hz), while other parts are done at longer
  * intervals, e.g. 5ms/200Hz, where timing resolution is not so critical and/or more intensive
@@ -543,178 +1397,214 @@ void   SynthModulation(unsigned data14)
  *
  * While diagnostic mode is active, the synth process is suspended to allow low-level tests
  * to run without being disrupted by continuous synth functions.
+ *
+ * Scheduled note events are applied by the block renderer (ISR), which may change the
+ * state of any voice, so the render IRQ is held off while each voice is being updated.
  */
 void   SynthProcess()
 {
     static  int   count5ms;
+    SynthVoice_t  *pVoice;
+    uint32  entryTime, CC_Reg;
+    int   v;
     
-    if (!v_SynthEnable)  return;  // Synth process and audio ISR inactive
-    
-    LowFrequencyOscillator();
-    AmpldEnvelopeShaper();
-    AudioLevelController();
+    if (!v_SynthEnable)  return;  // Synth suspended -- render ISR outputs silence
+
+    READ_CPU_CORE_COUNT_REG(entryTime);
+
+    // Patch transition -- instate the new patch when the voice mix has faded out
+    if (m_PatchFadeState == PATCH_FADE_SWITCH)  PatchTransitionSwitch();
+
+    for (v = 0, pVoice = m_Voice;  v < SYNTH_VOICES_MAX;  v++, pVoice++)
+    {
+        AUDIO_RENDER_IRQ_DISABLE();
+        if (pVoice->Active)  AudioLevelController(pVoice);
+        AUDIO_RENDER_IRQ_ENABLE();
+    }
+    ClippingIndicator();
 
     if (++count5ms == 5)     // 5ms process interval (200Hz)
     {
         count5ms = 0;
-        ContourEnvelopeShaper();
+        AmpldEnvelopePrepare();    // Pick up any change in envelope param's
+        ModMatrixPrepare();        // ... and in modulation routing param's
+        RenderParamsPublish();     // ... and in param's used by the render ISR
+        LowFrequencyOscillator();
         VibratoRampGenerator();
-        OscFreqModulation();       // Process pitch-bend or vibrato
-        OscMixRatioModulation();   // Wave-table morphing routine
-        NoiseLevelControl();       // Noise level control routine
-        FilterFrequencyControl();  // Bi-quad filter freq. control
+
+        for (v = 0, pVoice = m_Voice;  v < SYNTH_VOICES_MAX;  v++, pVoice++)
+        {
+            AUDIO_RENDER_IRQ_DISABLE();
+            if (pVoice->Active)
+            {
+                ContourEnvelopeShaper(pVoice);
+                VoiceControlUpdate(pVoice);
+            }
+            AUDIO_RENDER_IRQ_ENABLE();
+        }
     }
+
+    READ_CPU_CORE_COUNT_REG(CC_Reg);
+    ProfileRecord(PROFILE_SYNTH_PROCESS, CC_Reg - entryTime);  // incl. render ISR time
 }
 
 
 /*
- * Function:  AmpldEnvelopeShaper()
- *
- * Overview:  Audio amplitude envelope shaper.
- *            Routine called by the Synth Process at 1ms intervals.
- *
- * Output:    (fixed_t) m_AmpldEnvOutput = Envelope output level, norm. (0 ~ 0.9995)
+ * Function:  VoiceControlUpdate()
  *
+ * Overview:  Updates the real-time control variables of a voice which are accessed by the
+ *            block renderer.  Called by the Synth Process at 5ms intervals for each active
+ *            voice, and by SynthNoteOn() when a note is initiated or changed.
+ *            The modulation matrix is evaluated for the voice, then each destination
+ *            control is updated from the matrix output.
  */
-PRIVATE  void   AmpldEnvelopeShaper()
+PRIVATE  void   VoiceControlUpdate(SynthVoice_t *pVoice)
 {
-    static  uint8    envSegment;          // Envelope segment (aka "phase")
-    static  uint32   envPhaseTimer;       // Time elapsed in envelope phase (ms)
-    static  fixed_t  ampldSustainLevel;   // Ampld Env. sustain level (0 ~ 0.9995)
-    static  fixed_t  timeConstant;        // 20% of Decay or Release time (ms))
-    static  fixed_t  ampldDelta;          // Step change in Env Ampld per 1ms
-    static  fixed_t  ampldMaximum;        // Peak value of Envelope Ampld
+    fixed_t  modOut[MOD_NUM_DESTS];   // modulation matrix outputs
+    fixed_t  gain;
 
-    if (m_TriggerAttack)
-    {
-        m_TriggerAttack = 0;
-        m_TriggerRelease = 0;
-        envPhaseTimer = 0;
-        ampldSustainLevel = IntToFixedPt((int) g_Patch.AmpldEnvSustain) / 100;  // normalized
-        ampldMaximum = FIXED_MAX_LEVEL;  // for Peak-Hold phase
-        if (g_Patch.AmpldEnvPeak_ms == 0)  ampldMaximum = ampldSustainLevel;  // No Peak-Hold phase
-        ampldDelta = ampldMaximum / g_Patch.AmpldEnvAttack_ms;  // step change in 1ms
-        envSegment = ENV_ATTACK;
-    }
+    ModMatrixEvaluate(pVoice, modOut);
 
-    if (m_TriggerRelease)
-    {
-        m_TriggerRelease = 0;
-        timeConstant = g_Patch.AmpldEnvRelease_ms / 5;
-        envPhaseTimer = 0;
-        envSegment = ENV_RELEASE;
-    }
+    OscStepModulation(pVoice, modOut[MOD_DST_PITCH]);           // Pitch-bend, vibrato, etc
+    OscMixRatioModulation(pVoice, modOut[MOD_DST_MIX_LEVEL]);   // Wave-table morphing
+    NoiseLevelControl(pVoice, modOut[MOD_DST_NOISE_LEVEL]);     // Noise level control
+    FilterFrequencyControl(pVoice, modOut[MOD_DST_FILTER_FREQ]);  // Filter corner freq.
 
-    switch (envSegment)
-    {
-    case ENV_IDLE:          // Idle - zero output level
-    {
-        m_AmpldEnvOutput = 0;
-        break;
-    }
-    case ENV_ATTACK:        // Attack - linear ramp up to peak - or to the sustain level
-    {
-        if (m_AmpldEnvOutput < ampldMaximum) m_AmpldEnvOutput += ampldDelta;
-        if (++envPhaseTimer >= g_Patch.AmpldEnvAttack_ms)  // attack time ended
-        {
-            m_AmpldEnvOutput = ampldMaximum;
-            envPhaseTimer = 0;
-            if (g_Patch.AmpldEnvPeak_ms == 0)  envSegment = ENV_SUSTAIN;  // skip peak and decay
-            else  envSegment = ENV_PEAK_HOLD;    // run all phases
-        }
-        break;
-    }
-    case ENV_PEAK_HOLD:     // Peak - constant output level (0.999)
-    {
-        if (++envPhaseTimer >= g_Patch.AmpldEnvPeak_ms)  // Peak time ended
-        {
-            timeConstant = g_Patch.AmpldEnvDecay_ms / 5;  // for Decay phase
-            envPhaseTimer = 0;
-            envSegment = ENV_DECAY;
-        }
-        break;
-    }
-    case ENV_DECAY:         // Decay - exponential ramp down to sustain level
-    {
-        ampldDelta = (m_AmpldEnvOutput - ampldSustainLevel) / timeConstant;
-        if (ampldDelta == 0)  ampldDelta = FIXED_MIN_LEVEL;
-        if (m_AmpldEnvOutput > ampldSustainLevel)  m_AmpldEnvOutput -= ampldDelta;
-        // Allow 10 x time-constant for decay phase to complete
-        if (++envPhaseTimer >= (g_Patch.AmpldEnvDecay_ms * 2))  envSegment = ENV_SUSTAIN;
-        break;
-    }
-    case ENV_SUSTAIN:       // Sustain constant level - waiting for m_TriggerRelease
-    {
-        m_AmpldEnvOutput = ampldSustainLevel;
-        break;
-    }
-    case ENV_RELEASE:       // Release - exponential ramp down to zero level
-    {
-        // timeConstant and envPhaseTimer are set by the trigger condition above.
-        ampldDelta = m_AmpldEnvOutput / timeConstant;  // step change in 1ms
-        if (ampldDelta == 0)  ampldDelta = FIXED_MIN_LEVEL;
-        if (m_AmpldEnvOutput >= ampldDelta)  m_AmpldEnvOutput -= ampldDelta;
-        // Allow 10 x time-constant for release phase to complete
-        if (++envPhaseTimer >= (g_Patch.AmpldEnvRelease_ms * 2))
-        {
-            m_AmpldEnvOutput = 0;
-            envPhaseTimer = 0;
-            envSegment = ENV_IDLE;
-        }
-        break;
-    }
-    };  // end switch
+    gain = modOut[MOD_DST_AMPLD];   // Output gain (tremolo, etc)
+    if (gain > IntToFixedPt(1))  gain = IntToFixedPt(1);
+    if (gain < 0)  gain = 0;
+    pVoice->AmpldModGain = gain;    // applied by audio level controller or renderer
+}
+
+
+/*
+ * Function:  AmpldEnvelopePrepare()
+ *
+ * Overview:  Computes the amplitude envelope segment durations (samples) and coefficients
+ *            from the patch envelope param's.  Called by SynthPrepare() and by the Synth
+ *            Process at 5ms intervals;  the coefficients are re-computed only if one of
+ *            the param's has changed, e.g. by the control panel pots.
+ *
+ * The attack is a linear ramp;  the decay and release segments are exponential, with a time
+ * constant of 20% of the patch decay or release time, as in the original 1ms envelope
+ * shaper.  An exponential segment is advanced by one multiply-add per block (or per sample,
+ * for a partial block):  level += (target - level) * coeff,  where coeff = 1 - exp(-n / tc)
+ * for a step of n samples.  Segment durations allow 10 x time-constant to complete.
+ */
+PRIVATE  void   AmpldEnvelopePrepare(void)
+{
+    static  uint16  attack_ms, peak_ms, decay_ms, release_ms;
+    static  uint8   sustain;
+    static  uint32  sampleRate;
+    static  bool    prepDone;
+    float   timeConst;   // samples
+
+    if (prepDone && attack_ms == g_Patch.AmpldEnvAttack_ms && peak_ms == g_Patch.AmpldEnvPeak_ms
+    && decay_ms == g_Patch.AmpldEnvDecay_ms && release_ms == g_Patch.AmpldEnvRelease_ms
+    && sustain == g_Patch.AmpldEnvSustain && sampleRate == m_SampleRate)  return;  // no change
+
+    attack_ms = g_Patch.AmpldEnvAttack_ms;
+    peak_ms = g_Patch.AmpldEnvPeak_ms;
+    decay_ms = (g_Patch.AmpldEnvDecay_ms != 0) ? g_Patch.AmpldEnvDecay_ms : 1;
+    release_ms = (g_Patch.AmpldEnvRelease_ms != 0) ? g_Patch.AmpldEnvRelease_ms : 1;
+    sustain = g_Patch.AmpldEnvSustain;
+    sampleRate = m_SampleRate;
+
+    m_AmpldAttackSamples = (uint32) attack_ms * m_SamplesPerMs;
+    if (m_AmpldAttackSamples == 0)  m_AmpldAttackSamples = 1;
+    m_AmpldAttackStep = (int32) ((1UL << 30) / m_AmpldAttackSamples);
+    m_AmpldPeakSamples = (uint32) peak_ms * m_SamplesPerMs;
+    m_AmpldDecaySamples = (uint32) decay_ms * 2 * m_SamplesPerMs;
+    m_AmpldReleaseSamples = (uint32) release_ms * 2 * m_SamplesPerMs;
+
+    m_AmpldSustainLevel = (int32) (((uint64) sustain << 30) / 100);
+    if (peak_ms != 0)  m_AmpldPeakLevel = (FIXED_MAX_LEVEL << 10);
+    else  m_AmpldPeakLevel = m_AmpldSustainLevel;  // No Peak-Hold phase
+
+    timeConst = ((float) decay_ms * m_SampleRate) / 5000;
+    m_AmpldDecayCoeff = (int32) ((1.0f - expf(-1.0f / timeConst)) * 2147483648.0f);
+    m_AmpldDecayBlkCoeff = (int32) ((1.0f - expf(-AUDIO_BLOCK_SIZE / timeConst)) * 2147483647.0f);
+    timeConst = ((float) release_ms * m_SampleRate) / 5000;
+    m_AmpldReleaseCoeff = (int32) ((1.0f - expf(-1.0f / timeConst)) * 2147483648.0f);
+    m_AmpldReleaseBlkCoeff = (int32) ((1.0f - expf(-AUDIO_BLOCK_SIZE / timeConst)) * 2147483647.0f);
+
+    decay_ms = g_Patch.AmpldEnvDecay_ms;     // as compared above
+    release_ms = g_Patch.AmpldEnvRelease_ms;
+    prepDone = TRUE;
 }
 
 
 /*
  * Function:  AudioLevelController()
  *
- * Overview:  This routine is called by the Synth Process at 1ms intervals.
- *            The output level is controlled (modulated) by one of a choice of options
- *            determined by the configuration parameter g_Config.AudioAmpldControlMode.
+ * Overview:  This routine is called by the Synth Process at 1ms intervals for each
+ *            active voice.  The voice output level is controlled (modulated) by one of a
+ *            choice of options determined by g_Config.AudioAmpldControlMode.
  *
- * Output:    (fixed_t) v_OutputLevel : normalized output level (0..+1.0)
- *            The output variable is used by the audio ISR to control the audio ampld,
+ * Output:    (fixed_t) pVoice->OutputLevel : normalized output level (0..+1.0)
+ *            The output variable is used by the block renderer to control the voice ampld,
  *            except for the reverberated signal which may continue to sound.
+ *            In the Envelope x Velocity mode, the renderer applies the amplitude envelope
+ *            directly (pVoice->AmpldEnvControl), so OutputLevel follows the envelope output.
+ *            In other modes, the output gain from the modulation matrix is applied here.
+ *
+ * When a voice is no longer gated and its output level has fallen to zero, the voice is
+ * made inactive (freed), so it may be allocated to play another note.
  */
-PRIVATE  void   AudioLevelController()
+PRIVATE  void   AudioLevelController(SynthVoice_t *pVoice)
 {
-    static  fixed_t  outputAmpld;         // Audio output level, normalized
-    static  fixed_t  smoothExprnLevel;    // Expression level, normalized, smoothed
-    static  uint8    clipLEDstate;
-    static  uint32   clipLEDduty_ms;
+    fixed_t  outputAmpld;         // Audio output level, normalized
     fixed_t  exprnLevel;
 
     if ((g_Config.AudioAmpldControlMode == AMPLD_CTRL_EXPRESS)  // modes 2 & 3
     || ((g_Config.AudioAmpldControlMode == AMPLD_CTRL_AUTO) && isHandsetConnected()))
     {
         // After Note-Off, MIDI Pressure/Expression Level is assumed to be zero
-        if (m_Note_ON)  exprnLevel = m_ExpressionLevel;
+        if (pVoice->Gate)  exprnLevel = m_ExpressionLevel;
         else  exprnLevel = 0;
+        pVoice->AmpldEnvControl = FALSE;
         
         // Apply IIR smoothing filter to eliminate abrupt changes (K = 1/8)
-        smoothExprnLevel -= smoothExprnLevel >> 3;
-        smoothExprnLevel += exprnLevel >> 3;
-        outputAmpld = smoothExprnLevel;
+        pVoice->SmoothExprnLevel -= pVoice->SmoothExprnLevel >> 3;
+        pVoice->SmoothExprnLevel += exprnLevel >> 3;
+        outputAmpld = pVoice->SmoothExprnLevel;
     }
     else if ((g_Config.AudioAmpldControlMode == AMPLD_CTRL_ENV_VELO)  // modes 1 & 3
     || ((g_Config.AudioAmpldControlMode == AMPLD_CTRL_AUTO) && !isHandsetConnected()))
     {
-        outputAmpld = MultiplyFixed(m_AmpldEnvOutput, m_AttackVelocity);
+        pVoice->AmpldEnvControl = TRUE;  // Envelope x Velocity, generated by renderer
+        outputAmpld = pVoice->AmpldEnvOutput;
     }
     else    // default  ...................................... // mode 0
     {
-        if (m_Note_ON)  outputAmpld = FIXED_MAX_LEVEL;
+        pVoice->AmpldEnvControl = FALSE;
+        if (pVoice->Gate)  outputAmpld = FIXED_MAX_LEVEL;
         else  outputAmpld = 0;
     }
+
+    if (!pVoice->AmpldEnvControl)  // else mod'n gain is applied with envelope by renderer
+        outputAmpld = MultiplyFixed(outputAmpld, pVoice->AmpldModGain);
     
     if (outputAmpld > FIXED_MAX_LEVEL)  outputAmpld = FIXED_MAX_LEVEL;
     if (outputAmpld < AUDIO_FLOOR_LEVEL) outputAmpld = 0;  // below 0.00002
 
-    v_OutputLevel = outputAmpld;  // accessed by audio ISR
-    
-    // Check mixer output for clipping -- if so, pulse LED indicator for 50ms
+    pVoice->OutputLevel = outputAmpld;  // accessed by block renderer
+
+    if (!pVoice->Gate && outputAmpld == 0)  pVoice->Active = FALSE;  // free the voice
+}
+
+
+/*
+ * Function:  ClippingIndicator()
+ *
+ * Overview:  Called by the Synth Process at 1ms intervals.  If the block renderer has
+ *            detected clipping in the mixer output, the LED indicator is pulsed for 50ms.
+ */
+PRIVATE  void   ClippingIndicator()
+{
+    static  uint8    clipLEDstate;
+    static  uint32   clipLEDduty_ms;
+
     if (v_Clipping)
     {
         v_Clipping = 0;     // reset flag
@@ -734,30 +1624,25 @@ PRIVATE  void   AudioLevelController()
 /*
  * Function:  ContourEnvelopeShaper()
  *
- * Overview:  Routine called by the Synth Process at 5ms intervals.
+ * Overview:  Routine called by the Synth Process at 5ms intervals for each active voice.
  *            All segments of the Contour Envelope are linear time-varying.
  *            The contour output may be used to control the oscillator mix ratio,
  *            noise level, filter corner frequency (Fc), or whatever.
  *
- * Output:    (fixed_t) m_ContourEnvOutput = output signal, normalized (0..+0.999)
+ * Output:    (fixed_t) pVoice->ContourEnvOutput = output signal, normalized (0..+0.999)
  */
-PRIVATE  void   ContourEnvelopeShaper()
+PRIVATE  void   ContourEnvelopeShaper(SynthVoice_t *pVoice)
 {
-    static  short    contourSegment;  // Contour envelope segment (aka phase)
-    static  uint32   contourTimer;    // Time elapsed in active phase (ms)
-    static  fixed_t  outputDelta;     // Step change in output level per 5ms
-    static  fixed_t  holdLevel;       // Output level held at finish of ramp
-
-    if (m_TriggerContour)  // Note-On event
+    if (pVoice->TriggerContour)  // Note-On event
     {
-        m_TriggerContour = 0;
-        m_ContourEnvOutput = IntToFixedPt(g_Patch.ContourStartLevel) / 100;
-        holdLevel = IntToFixedPt(g_Patch.ContourHoldLevel) / 100;
-        contourTimer = 0;
-        contourSegment = CONTOUR_ENV_DELAY;
+        pVoice->TriggerContour = 0;
+        pVoice->ContourEnvOutput = IntToFixedPt(g_Patch.ContourStartLevel) / 100;
+        pVoice->ContourHoldLevel = IntToFixedPt(g_Patch.ContourHoldLevel) / 100;
+        pVoice->ContourTimer = 0;
+        pVoice->ContourSegment = CONTOUR_ENV_DELAY;
     }
 
-    switch (contourSegment)
+    switch (pVoice->ContourSegment)
     {
     case CONTOUR_ENV_IDLE:  // Waiting for trigger signal
     {
@@ -765,57 +1650,83 @@ PRIVATE  void   ContourEnvelopeShaper()
     }
     case CONTOUR_ENV_DELAY:  // Delay before ramp up/down segment
     {
-        if (contourTimer >= g_Patch.ContourDelay_ms)  // Delay segment ended
+        if (pVoice->ContourTimer >= g_Patch.ContourDelay_ms)  // Delay segment ended
         {
-            outputDelta = ((holdLevel - m_ContourEnvOutput) * 5) / g_Patch.ContourRamp_ms;
-            contourTimer = 0;
-            contourSegment = CONTOUR_ENV_RAMP;
+            pVoice->ContourDelta = ((pVoice->ContourHoldLevel - pVoice->ContourEnvOutput) * 5)
+                                 / g_Patch.ContourRamp_ms;
+            pVoice->ContourTimer = 0;
+            pVoice->ContourSegment = CONTOUR_ENV_RAMP;
         }
         break;
     }
     case CONTOUR_ENV_RAMP:  // Linear ramp up/down from Start to Hold level
     {
-        if (contourTimer >= g_Patch.ContourRamp_ms)  // Ramp segment ended
-            contourSegment = CONTOUR_ENV_HOLD;
+        if (pVoice->ContourTimer >= g_Patch.ContourRamp_ms)  // Ramp segment ended
+            pVoice->ContourSegment = CONTOUR_ENV_HOLD;
         else
-            m_ContourEnvOutput += outputDelta;
+            pVoice->ContourEnvOutput += pVoice->ContourDelta;
         break;
     }
     case CONTOUR_ENV_HOLD:  // Hold constant level - waiting for Note-Off event
     {
-        m_ContourEnvOutput = holdLevel;
+        pVoice->ContourEnvOutput = pVoice->ContourHoldLevel;
         break;
     }
     };  // end switch
 
-    contourTimer += 5;  // ms
+    pVoice->ContourTimer += 5;  // ms
 }
 
 
 /*
  * Function:     Synth LFO implementation.
  *
- * Called by SynthProcess() at 1ms intervals, this function generates a sinusoidal
- * waveform in real time.  LFO frequency is a patch parameter, g_Patch.VibratoFreq,
+ * Called by SynthProcess() at 5ms intervals, this function advances each of the LFOs and
+ * computes its output according to the LFO waveform:  sine (from g_sinewave[]), triangle,
+ * square, or sample-and-hold, which takes a new random level at the start of each cycle.
+ * LFO frequency is set by SynthLfoSetup();  LFO1 follows the patch parameter LFO_Freq_x10,
  * unsigned 8-bit value representing LFO freq * 10 Hz; range 1..250 => 0.1 to 25 Hz.
  *
- * Effective sample rate (Fs) is 1000 Hz.
+ * Effective sample rate (Fs) is 200 Hz.
  * 
- * The output of the LFO is m_LFO_output, a normalized fixed-point variable (+|-1.0)
+ * The output of each LFO is m_LFO[n].Output, a normalized fixed-point variable (+|-1.0)
  */
 PRIVATE  void   LowFrequencyOscillator()
 {
-    static  int32  oscAngleLFO;  // 24:8 bit fixed-point
-    fixed_t sample;
-    int     waveIdx;
+    SynthLFO_t  *pLFO;
+    int32   cycle = SINE_WAVE_TABLE_SIZE << 8;  // LFO period (2*pi radians) [24:8]
+    int32   angle;
+    fixed_t triangle;
+    int     n;
 
-    waveIdx = oscAngleLFO >> 8;  // integer part of oscAngleLFO
-    sample = (fixed_t) g_sinewave[waveIdx] << 5;  // normalized
-    oscAngleLFO += m_LFO_Step;
-    if (oscAngleLFO >= SINE_WAVE_TABLE_SIZE << 8)
-        oscAngleLFO -= SINE_WAVE_TABLE_SIZE << 8;
+    for (n = 0, pLFO = m_LFO;  n < MOD_LFO_COUNT;  n++, pLFO++)
+    {
+        pLFO->Angle += pLFO->Step;
+        if (pLFO->Angle >= cycle)  // Start of a new cycle
+        {
+            pLFO->Angle -= cycle;
+            m_LfoRandom = m_LfoRandom * 1103515245 + 12345;
+            pLFO->HoldLevel = ((int32) m_LfoRandom) >> 11;  // random level (+/-1.0)
+        }
 
-    m_LFO_output = (fixed_t) sample;
+        if (pLFO->Waveform == LFO_WAVE_TRIANGLE)  // in phase with sine:  0 -> +1 -> -1 -> 0
+        {
+            angle = pLFO->Angle + cycle / 4;
+            if (angle >= cycle)  angle -= cycle;
+            triangle = ((4 * angle - 2 * cycle) << 10) / (SINE_WAVE_TABLE_SIZE / 4);  // +/-2.0
+            if (triangle < 0)  triangle = 0 - triangle;
+            pLFO->Output = IntToFixedPt(1) - triangle;
+        }
+        else if (pLFO->Waveform == LFO_WAVE_SQUARE)
+        {
+            if (pLFO->Angle < cycle / 2)  pLFO->Output = FIXED_MAX_LEVEL;
+            else  pLFO->Output = 0 - FIXED_MAX_LEVEL;
+        }
+        else if (pLFO->Waveform == LFO_WAVE_SAMPLE_HOLD)
+            pLFO->Output = pLFO->HoldLevel;
+        else  // LFO_WAVE_SINE
+            pLFO->Output = (fixed_t) g_sinewave[pLFO->Angle >> 8] << 5;  // normalized
+    }
 }
 
 
@@ -865,168 +1776,309 @@ PRIVATE  void   VibratoRampGenerator()
 
 
 /*
- * Function:     Oscillator Frequency Modulation  (Pitch-bend, vibrato, etc)
- *
- * Called by SynthProcess() at 5ms intervals, this function modulates the pitch of
- * the wave-table oscillators according to a multiplier variable, smoothFreqMult,
- * which is continuously updated while a note is in progress.
- * 
- * The linear m_PitchBendFactor is transformed into a multiplier in the range 0.5 ~ 2.0.
- * Centre (zero) m_PitchBendFactor value should give a multplier value of 1.00.
+ * Function:  ModMatrixPrepare()
  *
- * Note:  This function is used for low frequency modulation, up to about 25Hz,
- *        intended for Pitch Bend OR Vibrato (mutually exclusive).
+ * Overview:  Called by SynthPrepare() and by the Synth Process at 5ms intervals.  If a new
+ *            patch has been selected, or any of the patch, preset or config param's which
+ *            determine the modulation routing has changed (e.g. by the control panel pots),
+ *            the routing table is rebuilt from the param's by ModMatrixBuild().
+ *            Routes set by the CLI 'mod' command are retained until then.
  */
-PRIVATE  void   OscFreqModulation()
+PRIVATE  void   ModMatrixPrepare()
 {
-    static  fixed_t  smoothFreqMult = IntToFixedPt(1);
-
-    fixed_t  LFO_scaled, modnLevel;  // normalized quantities (range 0..+/-1.0)
-    fixed_t  freqMult;
+    static  uint8   mixerCtrl, osc2Level, noiseMode, noiseCtrl, filterCtrl;
+    static  uint8   lfoFreq, lfoDepth, vibratoCtrl, pitchBendCtrl;
+    static  uint16  pitchBendRange;
+
+    if (m_ModMatrixValid && mixerCtrl == g_Patch.MixerControl
+    && osc2Level == g_Patch.MixerOsc2Level && noiseMode == g_Patch.NoiseMode
+    && noiseCtrl == g_Patch.NoiseLevelCtrl && filterCtrl == g_Patch.FilterControl
+    && lfoFreq == g_Patch.LFO_Freq_x10 && lfoDepth == g_Patch.LFO_FM_Depth
+    && vibratoCtrl == m_VibratoControl && pitchBendCtrl == m_PitchBendControl
+    && pitchBendRange == g_Config.PitchBendRange)  return;   // no change
+
+    mixerCtrl = g_Patch.MixerControl;
+    osc2Level = g_Patch.MixerOsc2Level;
+    noiseMode = g_Patch.NoiseMode;
+    noiseCtrl = g_Patch.NoiseLevelCtrl;
+    filterCtrl = g_Patch.FilterControl;
+    lfoFreq = g_Patch.LFO_Freq_x10;
+    lfoDepth = g_Patch.LFO_FM_Depth;
+    vibratoCtrl = m_VibratoControl;
+    pitchBendCtrl = m_PitchBendControl;
+    pitchBendRange = g_Config.PitchBendRange;
+
+    ModMatrixBuild();
+    m_ModMatrixValid = TRUE;
+}
 
-    if (m_VibratoControl == VIBRATO_BY_MODN_CC)  // Use Mod Lever position
-        modnLevel = (m_ModulationLevel * g_Patch.LFO_FM_Depth) / 1200;
-    
-    if (m_VibratoControl == VIBRATO_AUTOMATIC)  // Use LFO ramp generator
-        modnLevel = (m_RampOutput * g_Patch.LFO_FM_Depth) / 1200;
 
-    if (m_VibratoControl && !m_PitchBendControl)  
+/*
+ * Function:  ModMatrixBuild()
+ *
+ * Overview:  Sets up the modulation matrix routing table and destination base values to
+ *            implement the patch control modes (MixerControl, NoiseLevelCtrl, FilterControl),
+ *            the preset vibrato mode and the config pitch-bend mode.  LFO1 runs at the
+ *            patch LFO frequency;  the patch LFO depth param sets the depth of the routes
+ *            from LFO1, in cents (pitch) or % (other destinations).
+ *
+ * The scaling of each route is that of the original control mode, e.g. with the mixer in
+ * LFO mode, the OSC2 mix level is 0.5 + 0.5 * LFO * VibRamp * (depth / 1200).
+ */
+PRIVATE  void   ModMatrixBuild()
+{
+    fixed_t  lfoDepth = IntToFixedPt((int) g_Patch.LFO_FM_Depth);
+    fixed_t  pbRange = IntToFixedPt((int) g_Config.PitchBendRange) / 1200;  // octaves
+    uint8    noiseMode = g_Patch.NoiseMode & 3;
+
+    AUDIO_RENDER_IRQ_DISABLE();  // The render ISR may evaluate the matrix (Note-On)
+
+    m_ModRouteCount = 0;
+    m_PitchModEnabled = FALSE;
+    m_ModBase[MOD_DST_PITCH] = 0;
+    m_ModBase[MOD_DST_MIX_LEVEL] = 0;
+    m_ModBase[MOD_DST_FILTER_FREQ] = 0;
+    m_ModBase[MOD_DST_NOISE_LEVEL] = 0;
+    m_ModBase[MOD_DST_AMPLD] = IntToFixedPt(1);
+
+    SynthLfoSetup(1, m_LFO[0].Waveform, g_Patch.LFO_Freq_x10);
+
+    // Oscillator pitch -- Pitch-bend and vibrato are mutually exclusive
+    if (m_PitchBendControl == PITCH_BEND_BY_MIDI_PB)
+        ModRouteAdd(MOD_SRC_PITCH_BEND, MOD_SRC_NONE, MOD_DST_PITCH, pbRange);
+    else if (m_PitchBendControl == PITCH_BEND_BY_EXPRN_CC)
+        ModRouteAdd(MOD_SRC_PRESSURE, MOD_SRC_NONE, MOD_DST_PITCH, pbRange);
+    else if (m_VibratoControl == VIBRATO_BY_MODN_CC)  // Vibrato depth by Mod Lever
+        ModRouteAdd(MOD_SRC_LFO1, MOD_SRC_MODULN, MOD_DST_PITCH, lfoDepth / 1200);
+    else if (m_VibratoControl == VIBRATO_AUTOMATIC)   // Vibrato depth by ramp generator
+        ModRouteAdd(MOD_SRC_LFO1, MOD_SRC_VIB_RAMP, MOD_DST_PITCH, lfoDepth / 1200);
+
+    // Wave mixer OSC2 level (0..1.0)
+    if (g_Patch.MixerControl == MIXER_CTRL_CONTOUR)
+        ModRouteAdd(MOD_SRC_CONTOUR, MOD_SRC_NONE, MOD_DST_MIX_LEVEL, IntToFixedPt(1));
+    else if (g_Patch.MixerControl == MIXER_CTRL_LFO)
     {
-        LFO_scaled = MultiplyFixed(m_LFO_output, modnLevel); 
-        freqMult = Base2Exp(LFO_scaled);   // range 0.5 ~ 2.0.
+        m_ModBase[MOD_DST_MIX_LEVEL] = FIXED_PT_HALF;
+        ModRouteAdd(MOD_SRC_LFO1, MOD_SRC_VIB_RAMP, MOD_DST_MIX_LEVEL, lfoDepth / 2400);
     }
-    else if (m_PitchBendControl == PITCH_BEND_BY_MIDI_PB)  
+    else if (g_Patch.MixerControl == MIXER_CTRL_EXPRESS)
+        ModRouteAdd(MOD_SRC_PRESSURE, MOD_SRC_NONE, MOD_DST_MIX_LEVEL, IntToFixedPt(1));
+    else if (g_Patch.MixerControl == MIXER_CTRL_MODULN)
+        ModRouteAdd(MOD_SRC_MODULN, MOD_SRC_NONE, MOD_DST_MIX_LEVEL, IntToFixedPt(1));
+    else  // assume MIXER_CTRL_FIXED -- default
+        m_ModBase[MOD_DST_MIX_LEVEL] = IntToFixedPt((int) g_Patch.MixerOsc2Level) / 100;
+
+    // Noise level (0..1.0)
+    switch (g_Patch.NoiseLevelCtrl & 7)
     {
-         freqMult = Base2Exp(m_PitchBendFactor);
+    case NOISE_LVL_FIXED:
+        if (noiseMode == NOISE_WAVE_ADDED || noiseMode == NOISE_WAVE_MIXED)
+            m_ModBase[MOD_DST_NOISE_LEVEL] = IntToFixedPt((int) g_Patch.MixerOsc2Level) / 100;
+        else  m_ModBase[MOD_DST_NOISE_LEVEL] = FIXED_MAX_LEVEL;  // Noise only
+        break;
+    case NOISE_LVL_AMPLD_ENV:
+        ModRouteAdd(MOD_SRC_AMPLD_ENV, MOD_SRC_NONE, MOD_DST_NOISE_LEVEL, IntToFixedPt(1));
+        break;
+    case NOISE_LVL_LFO:  // (1 + LFO) * depth / 2
+        m_ModBase[MOD_DST_NOISE_LEVEL] = lfoDepth / 200;
+        ModRouteAdd(MOD_SRC_LFO1, MOD_SRC_NONE, MOD_DST_NOISE_LEVEL, lfoDepth / 200);
+        break;
+    case NOISE_LVL_EXPRESS:
+        ModRouteAdd(MOD_SRC_EXPRESS, MOD_SRC_NONE, MOD_DST_NOISE_LEVEL, IntToFixedPt(1) / 4);
+        break;
+    case NOISE_LVL_MODULN:
+        ModRouteAdd(MOD_SRC_MODULN, MOD_SRC_NONE, MOD_DST_NOISE_LEVEL, FIXED_PT_HALF);
+        break;
+    default:  break;  // invalid option (Noise OFF)
     }
-    else if (m_PitchBendControl == PITCH_BEND_BY_EXPRN_CC) 
+
+    // Filter frequency offset (semitones)
+    if (g_Patch.FilterControl == FILTER_CTRL_CONTOUR)  // -27 ~ +27
     {
-        modnLevel = (m_PressureLevel * g_Config.PitchBendRange) / 1200;
-        freqMult = Base2Exp(modnLevel);
+        m_ModBase[MOD_DST_FILTER_FREQ] = IntToFixedPt(-27);
+        ModRouteAdd(MOD_SRC_CONTOUR, MOD_SRC_NONE, MOD_DST_FILTER_FREQ, IntToFixedPt(54));
     }
-//    else if (m_PitchBendControl == PITCH_BEND_BY_ANALOG_CV) 
-//    {
-//        ;  // *****  todo !  *****
-//    }
-    else  freqMult = IntToFixedPt( 1 );  // No pitch modulation
+    else if (g_Patch.FilterControl == FILTER_CTRL_LFO)  // +/- depth % of 54
+        ModRouteAdd(MOD_SRC_LFO1, MOD_SRC_NONE, MOD_DST_FILTER_FREQ, (lfoDepth / 200) * 108);
+    else if (g_Patch.FilterControl == FILTER_CTRL_EXPRESS)  // 0 ~ +27
+        ModRouteAdd(MOD_SRC_PRESSURE, MOD_SRC_NONE, MOD_DST_FILTER_FREQ, IntToFixedPt(27));
+    else if (g_Patch.FilterControl == FILTER_CTRL_MODULN)  // 0 ~ -54
+        ModRouteAdd(MOD_SRC_MODULN, MOD_SRC_NONE, MOD_DST_FILTER_FREQ, IntToFixedPt(-54));
+
+    AUDIO_RENDER_IRQ_ENABLE();
+}
+
+
+/*
+ * Function:     Append a route to the modulation matrix routing table, if not full.
+ *               Called by ModMatrixBuild() with the render IRQ disabled.
+ */
+PRIVATE  void   ModRouteAdd(uint8 source, uint8 scaler, uint8 dest, fixed_t depth)
+{
+    ModRoute_t  *pRoute = &m_ModRoute[m_ModRouteCount];
+
+    if (m_ModRouteCount >= MOD_ROUTES_MAX)  return;
 
-    if (m_VibratoControl || m_PitchBendControl)
+    pRoute->Source = source;
+    pRoute->Scaler = scaler;
+    pRoute->Dest = dest;
+    pRoute->Depth = depth;
+    if (dest == MOD_DST_PITCH)  m_PitchModEnabled = TRUE;
+    m_ModRouteCount++;
+}
+
+
+/*
+ * Function:  ModMatrixEvaluate()
+ *
+ * Overview:  Computes the modulation matrix outputs for a voice, one per destination, in
+ *            destination units (see MOD_DST_xxx).  Called by VoiceControlUpdate().
+ *
+ * The present value of every source is gathered into an array, indexed by MOD_SRC_xxx,
+ * so the routing table is evaluated by one loop:  each route adds (source x scaler x depth)
+ * to the base value of its destination.  The scaler is another source, e.g. the vibrato
+ * ramp or the modulation lever, which controls the depth;  MOD_SRC_NONE means x1.0.
+ */
+PRIVATE  void   ModMatrixEvaluate(SynthVoice_t *pVoice, fixed_t *modOut)
+{
+    fixed_t  source[MOD_NUM_SOURCES];
+    fixed_t  value;
+    ModRoute_t  *pRoute;
+    int      i;
+
+    source[MOD_SRC_NONE] = 0;
+    source[MOD_SRC_LFO1] = m_LFO[0].Output;
+    source[MOD_SRC_LFO2] = m_LFO[1].Output;
+    source[MOD_SRC_VIB_RAMP] = m_RampOutput;
+    source[MOD_SRC_CONTOUR] = pVoice->ContourEnvOutput;
+    source[MOD_SRC_VELOCITY] = pVoice->AttackVelocity;
+    source[MOD_SRC_MODULN] = m_ModulationLevel;
+    source[MOD_SRC_PRESSURE] = m_PressureLevel;
+    source[MOD_SRC_EXPRESS] = m_ExpressionLevel;
+    source[MOD_SRC_PITCH_BEND] = m_PitchBendLevel;
+
+    // The envelope level is scaled by velocity (see AmpldEnvelopeAdvance) -- remove it
+    value = 0;
+    if (pVoice->AttackVelocity > FIXED_MIN_LEVEL)
+        value = (fixed_t) (((int64) pVoice->AmpldEnvLevel << 10) / pVoice->AttackVelocity);
+    if (value > FIXED_MAX_LEVEL)  value = FIXED_MAX_LEVEL;
+    source[MOD_SRC_AMPLD_ENV] = value;
+
+    for (i = 0;  i < MOD_NUM_DESTS;  i++)  modOut[i] = m_ModBase[i];
+
+    for (i = 0, pRoute = m_ModRoute;  i < m_ModRouteCount;  i++, pRoute++)
     {
-        smoothFreqMult -= smoothFreqMult >> 2;  // Tc = 4 * 5ms = 20ms (approx)
-        smoothFreqMult += freqMult >> 2; 
-        // Update real-time oscillator variables (accessed by audio ISR)
-        v_Osc1Step = MultiplyFixed(m_Osc1StepMedian, smoothFreqMult);
-        v_Osc2Step = MultiplyFixed(m_Osc2StepMedian, smoothFreqMult);
+        value = source[pRoute->Source];
+        if (pRoute->Scaler != MOD_SRC_NONE)  value = MultiplyFixed(value, source[pRoute->Scaler]);
+        modOut[pRoute->Dest] += MultiplyFixed(value, pRoute->Depth);
     }
-    
-    // Sawtooth amplitude increment (step) = (peak_ampld) / number_of_steps_in_period
-    v_Osc1SawtoothIncr = (m_SawtoothPeakAmpld) / (m_FundamentalPeriod / v_Osc1Step);
-    v_Osc2SawtoothIncr = (m_SawtoothPeakAmpld) / (m_FundamentalPeriod / v_Osc2Step);
 }
 
 
 /*
- * Oscillator Mix Ratio Modulation
- *
- * Called by the SynthProcess() routine at 5ms intervals, this function controls the ratio
- * of the 2 oscillator signals input to the wave mixer, according to a variable, mixRatio_pK,
- * which is the fraction (x1024) of the output of OSC2 relative to OSC1 fed into the mixer.
+ * Function:     Apply the pitch modulation from the modulation matrix to a voice.
  *
- * The instantaneous value of the time-varying quantity mixRatio_pK is determined by the 
- * patch mixer control mode parameter, g_Patch.MixerControl.
- * The actual mixing operation is performed by the audio ISR, using the output variables.
+ * Entry args:   pitchMod = pitch deviation, octaves (range +/-1.0)
  *
- * Output variable:   v_Mix2Level   (range 0..1000)
+ * The pitch deviation is transformed into a multiplier in the range 0.5 ~ 2.0, which is
+ * smoothed to avoid abrupt steps in pitch.  The real-time oscillator variables (accessed
+ * by the block renderer) are derived from the median values set at Note-On.
  */
-PRIVATE  void  OscMixRatioModulation()
+PRIVATE  void   OscStepModulation(SynthVoice_t *pVoice, fixed_t pitchMod)
 {
-    fixed_t  LFO_scaled;
-    fixed_t  modnLevel;
-    fixed_t  mixRatioLFO;   // normalized
-    int      mixRatio_pK;   // fraction of OSC2 in the mix x1000
+    fixed_t  freqMult;
 
-    if (g_Patch.MixerControl == MIXER_CTRL_CONTOUR)
-    {
-        mixRatio_pK = IntegerPart(m_ContourEnvOutput * 1000);
-    }
-    else if (g_Patch.MixerControl == MIXER_CTRL_LFO)
-    {
-        // Use LFO depth param (0..1200) to set LFO modulation depth.
-        modnLevel = (m_RampOutput * g_Patch.LFO_FM_Depth) / 1200;
-        LFO_scaled = MultiplyFixed(m_LFO_output, modnLevel);  // range -1.0 ~ +1.0
-        mixRatioLFO = (IntToFixedPt(1) + LFO_scaled) / 2;     // range  0.0 ~ +1.0
-        mixRatio_pK = IntegerPart(mixRatioLFO * 1000);        // convert to 'per K' units
-    }
-    else if (g_Patch.MixerControl == MIXER_CTRL_EXPRESS)
+    if (m_PitchModEnabled)
     {
-        mixRatio_pK = IntegerPart(m_PressureLevel * 1000);
-    }
-    else if (g_Patch.MixerControl == MIXER_CTRL_MODULN)
-    {
-        mixRatio_pK = IntegerPart(m_ModulationLevel * 1000);
+        if (pitchMod > IntToFixedPt(1))  pitchMod = IntToFixedPt(1);
+        if (pitchMod < IntToFixedPt(-1))  pitchMod = IntToFixedPt(-1);
+        freqMult = Base2Exp(pitchMod);
+
+        if (pVoice->FreqModMult == 0)  pVoice->FreqModMult = freqMult;  // New note
+        else
+        {
+            pVoice->FreqModMult -= pVoice->FreqModMult >> 2;  // Tc = 4 * 5ms = 20ms (approx)
+            pVoice->FreqModMult += freqMult >> 2;
+        }
+        pVoice->Osc1Step = MultiplyFixed(pVoice->Osc1StepMedian, pVoice->FreqModMult);
+        pVoice->Osc2Step = MultiplyFixed(pVoice->Osc2StepMedian, pVoice->FreqModMult);
     }
-    else  // assume (g_Patch.MixerControl == MIXER_CTRL_FIXED) -- default
+    else  // No pitch modulation
     {
-        mixRatio_pK = (1000 * (int) g_Patch.MixerOsc2Level) / 100;  // fixed %
+        pVoice->Osc1Step = pVoice->Osc1StepMedian;
+        pVoice->Osc2Step = pVoice->Osc2StepMedian;
     }
 
-    v_Mix2Level = mixRatio_pK;  // accessed by audio ISR
+    // Sawtooth amplitude increment (step) = (peak_ampld) / number_of_steps_in_period
+    pVoice->Osc1SawIncr = (m_SawtoothPeakAmpld) / (m_FundamentalPeriod / pVoice->Osc1Step);
+    pVoice->Osc2SawIncr = (m_SawtoothPeakAmpld) / (m_FundamentalPeriod / pVoice->Osc2Step);
+}
+
+
+/*
+ * Oscillator Mix Ratio Modulation
+ *
+ * Called by VoiceControlUpdate() for each active voice, this function controls the ratio
+ * of the 2 oscillator signals input to the wave mixer, according to the fraction of the
+ * output of OSC2 relative to OSC1 fed into the mixer (0..1.0), from the modulation matrix.
+ * The mix is determined by the patch mixer control mode parameter, g_Patch.MixerControl,
+ * unless the routing has been modified.
+ * The actual mixing operation is performed by the block renderer, using the output variable.
+ *
+ * Output variable:   pVoice->Mix2Level   (range 0..1000)
+ */
+PRIVATE  void  OscMixRatioModulation(SynthVoice_t *pVoice, fixed_t mixMod)
+{
+    if (mixMod > IntToFixedPt(1))  mixMod = IntToFixedPt(1);
+    if (mixMod < 0)  mixMod = 0;
+
+    pVoice->Mix2Level = IntegerPart(mixMod * 1000 + FIXED_PT_HALF);  // accessed by renderer
 }
 
 
 /*
  * Noise Generator Output level Control
  *
- * Called by the SynthProcess() routine at 5ms intervals, this function sets the noise
- * generator output level in real-time according to the noise control source (patch param).
- * The actual level control operation is performed by the audio ISR.
+ * Called by VoiceControlUpdate() for each active voice, this function sets the noise
+ * generator output level in real-time from the modulation matrix output.  The default
+ * routing is determined by the noise control source (patch param).
+ * The actual level control operation is performed by the block renderer.
  *
- * Output variable:  v_NoiseLevel  (normalized fixed-point)
+ * Output variable:  pVoice->NoiseLevel  (normalized fixed-point)
  */
-PRIVATE  void   NoiseLevelControl()
+PRIVATE  void   NoiseLevelControl(SynthVoice_t *pVoice, fixed_t noiseMod)
 {
-    int  noiseCtrlSource = g_Patch.NoiseLevelCtrl & 7;  
-    
-    if (noiseCtrlSource == NOISE_LVL_FIXED)           // option 0 (Fixed %)
-    {
-        if ((g_Patch.NoiseMode & 3) == NOISE_WAVE_ADDED 
-        ||  (g_Patch.NoiseMode & 3) == NOISE_WAVE_MIXED )
-            v_NoiseLevel = (IntToFixedPt( 1 ) * g_Patch.MixerOsc2Level) / 100;
-        else  v_NoiseLevel = FIXED_MAX_LEVEL;  // Noise only
-    }
-    else if (noiseCtrlSource == NOISE_LVL_AMPLD_ENV)  // option 1
-        v_NoiseLevel = m_AmpldEnvOutput;
-    else if (noiseCtrlSource == NOISE_LVL_LFO)        // option 2
-        v_NoiseLevel = ((m_LFO_output + IntToFixedPt(1)) * g_Patch.LFO_FM_Depth) / 200;
-    else if (noiseCtrlSource == NOISE_LVL_EXPRESS)    // option 3
-        v_NoiseLevel = (m_ExpressionLevel >> 2);
-    else if (noiseCtrlSource == NOISE_LVL_MODULN)     // option 4
-        v_NoiseLevel = (m_ModulationLevel >> 1);
-    else  v_NoiseLevel = 0;  // invalid option (Noise OFF)
+    if (noiseMod > FIXED_MAX_LEVEL)  noiseMod = FIXED_MAX_LEVEL;
+    if (noiseMod < 0)  noiseMod = 0;
+
+    pVoice->NoiseLevel = noiseMod;
 }
 
 
 /*
- * Bi-quad resonant filter centre frequency control (modulation)
+ * State-variable filter frequency control (modulation)
  *
- * Called by the SynthProcess() routine at 5ms intervals, this function updates the
- * bi-quad IIR filter coefficient a1 in real-time according to the note pitch and the
- * filter frequency control (modulation) parameter(s).
- * The filter resonance cannot be changed while a note is in progress, hence other
- * filter coeff's do not need to be updated here.
- * The actual DSP filter algorithm is incorporated in the audio ISR.
+ * Called by VoiceControlUpdate() for each active voice, this function updates the
+ * state-variable filter coeff's f and q in real-time according to the note pitch and the
+ * filter frequency offset (semitones) from the modulation matrix.  The cut-off (or centre)
+ * frequency is continuously variable;  the offset is not rounded to a whole semitone.
+ * The filter resonance cannot be changed while a note is in progress, hence the damping
+ * factor (m_FilterDamping) is set by SynthPrepare().
+ * The actual DSP filter algorithm is incorporated in the block renderer.
  * 
- * Output variable:  v_coeff_a1  = real-time filter coeff (fixed-point value)
+ * Output variables:  pVoice->FilterCoeff_f  = real-time filter freq. coeff (fixed-point)
+ *                    pVoice->FilterCoeff_q  = real-time filter damping coeff (fixed-point)
  */
-PRIVATE  void   FilterFrequencyControl()
+PRIVATE  void   FilterFrequencyControl(SynthVoice_t *pVoice, fixed_t freqMod)
 {
-    fixed_t  devn;     // deviation from quiescent value (+/-0.5 max)
-    int  filterIndex;  // index into filter coeff (a1 = -c) look-up table
-    int  fc_idx;       //  ..     ..     ..    ..
-    
-    // Determine LUT index (filterIndex) for variable filter corner frequency
+    int      filterIndex;  // filter freq. as note number, C0 = 0 (integer)
+    fixed_t  pitch;        // filter freq. as note number, C0 = 0 (fixed-pt)
+    fixed_t  coeff_f, coeff_q;
+    fixed_t  f_squared, q_max;
+
+    // Determine base filter freq. (note number) for variable filter corner frequency
     if (g_Patch.FilterNoteTrack)  // Note Tracking enabled
-        filterIndex = (m_NotePlaying - 12) + g_Patch.FilterFrequency;  // 0..108
+        filterIndex = (pVoice->NotePlaying - 12) + g_Patch.FilterFrequency;  // 0..108
     else  filterIndex = (int) g_Patch.FilterFrequency;  // 0..108
     
     if (filterIndex < 0)  filterIndex = 0;      // Min at C0 (~16Hz)
@@ -1035,45 +2087,458 @@ PRIVATE  void   FilterFrequencyControl()
     if (g_Patch.NoiseMode)  // Bypass filter modulation if noise is enabled
     {
         if (g_Patch.NoiseMode & NOISE_PITCHED)  filterIndex = 0;  // ~ 16Hz
-        v_coeff_a1 = 0 - m_FiltCoeff_c[filterIndex];  // update the coeff a1 = -c
-        return;  
+        pitch = IntToFixedPt(filterIndex);
+    }
+    else  // ------------ Filter frequency modulation -----------------------
+    {
+        if (freqMod > IntToFixedPt(108))  freqMod = IntToFixedPt(108);
+        if (freqMod < IntToFixedPt(-108))  freqMod = IntToFixedPt(-108);
+        pitch = IntToFixedPt(filterIndex) + freqMod;
+
+        if (pitch > IntToFixedPt(108))  pitch = IntToFixedPt(108);   // max. ~ 8kHz
+        if (pitch < 0)  pitch = 0;       // min. ~ 16Hz
+    }
+
+    coeff_f = FilterFreqCoeff(pitch);
+
+    if (g_Patch.FilterMode == FILTER_MODE_BANDPASS)  // q = damping / f
+        coeff_q = (fixed_t) (((int64) m_FilterDamping << 20) / coeff_f);
+    else  coeff_q = m_FilterDamping;
+
+    // Limit q for stability at high Fc:  f^2 + 2 * f * q < 4  (with some margin)
+    f_squared = MultiplyFixed(coeff_f, coeff_f);
+    q_max = (fixed_t) (((int64) (IntToFixedPt(4) - f_squared) << 19) / coeff_f);
+    q_max -= q_max / 8;
+    if (coeff_q > q_max)  coeff_q = q_max;
+
+    pVoice->FilterCoeff_f = coeff_f;  // accessed by renderer
+    pVoice->FilterCoeff_q = coeff_q;
+}
+
+
+/*
+ * Function:     Compute the frequency coefficient of the state-variable filter for a given
+ *               corner frequency, i.e. f = 2 * sin(pi * Fc / Fs).
+ *
+ * Entry arg:    pitch = filter corner freq. as a note number, C0 = 0 (fixed-pt, 0..108)
+ *
+ * Returns:      (fixed_t) f, range 0.0026 (C0) ~ 1.23 (C9)
+ *
+ * The corner freq. is found as an exponent of the freq. at C0, using the function Base2Exp()
+ * for the fraction of an octave;  the sine is approximated by a 5th-order polynomial,
+ * which is accurate to better than 0.001% for (pi * Fc / Fs) < 0.7 (Fc < 8.9kHz).
+ */
+PRIVATE  fixed_t  FilterFreqCoeff(fixed_t pitch)
+{
+    int      octave = IntegerPart(pitch) / 12;
+    fixed_t  pitchInOctave = pitch - IntToFixedPt(octave * 12);  // semitones (0 ~ 12)
+    fixed_t  octaveFrac = pitchInOctave / 12;    // fraction of an octave (0 ~ 1.0)
+    fixed_t  omega;        // pi * Fc / Fs
+    fixed_t  omega_sq;     // omega ^ 2
+    fixed_t  term;
+
+    omega = (fixed_t) ((((int64) m_FilterOmegaC0 << octave) * Base2Exp(octaveFrac)) >> 30);
+
+    // sin(x) = x * (1 - x^2/6 * (1 - x^2/20))
+    omega_sq = MultiplyFixed(omega, omega);
+    term = IntToFixedPt(1) - omega_sq / 20;
+    term = MultiplyFixed(omega_sq, term) / 6;
+    term = IntToFixedPt(1) - term;
+
+    return  (fixed_t) MultiplyFixed(omega, term) * 2;
+}
+
+
+/*`````````````````````````````````````````````````````````````````````````````````````````````````
+ * Function:     SynthRenderBlock()
+ *
+ * Overview:     Audio block renderer.  Computes a block of nSamples PCM output samples
+ *               (normalized fixed-point) in one call, writing them into outBuf[].
+ *
+ * Entry args:   outBuf   = pointer to output sample buffer (nSamples long)
+ *               nSamples = number of samples to render, typ. AUDIO_BLOCK_SIZE
+ *
+ * The renderer performs DSP synthesis computations which need to be executed at the PCM
+ * audio sampling rate, as set by config param SampleRate_kHz (typ. 40).  It is called by the
+ * audio "render" ISR (see pic32_low_level.c) whenever the DMA controller has emptied one
+ * half of the output double-buffer, i.e. once every AUDIO_BLOCK_SIZE sample periods.
+ * The function has no hardware dependencies, so it can also be run on a host PC.
+ *
+ * Each active voice in the pool is rendered in turn by RenderVoice(), which adds the
+ * voice output into a mix buffer.  The master stage then scales the mix by the voice mix
+ * gain (1 / number of active voices, ramped) and applies the limiter, patch audio level
+ * adjustment and reverb effect to the mixed signal.  If nSamples exceeds
+ * AUDIO_BLOCK_SIZE, the block is rendered in segments of AUDIO_BLOCK_SIZE samples.
+ *
+ * Scheduled events (see SynthPostEvent) are applied at the sample for which they are due;
+ * the block is split into segments at the event samples.  Events which are overdue, i.e.
+ * posted too late for their scheduled sample, are applied at the start of the block.
+ * The sample clock, v_SampleClock, is advanced by nSamples.
+ *
+ * The execution time of the last block rendered (core timer counts) is saved in the
+ * variable v_ISRexecTime;  the time spent rendering voices is saved in v_VoiceRenderTime
+ * and the number of voices rendered in v_VoicesRendered.  The time spent in each stage
+ * (events, oscillators, voice DSP, master and reverb) is recorded by ProfileRecord().
+ * The block period is AUDIO_BLOCK_SIZE / sample rate, e.g. with AUDIO_BLOCK_SIZE = 32,
+ * 1000us at 32kHz, 800us at 40kHz or 667us at 48kHz;  the render time should be kept under
+ * AUDIO_RENDER_BUDGET_PC (%) of the block period at the configured rate.
+ */
+void  SynthRenderBlock(fixed_t *outBuf, int nSamples)
+{
+    fixed_t  mixBuf[AUDIO_BLOCK_SIZE];    // sum of voice outputs
+    SynthVoice_t  *pVoice;
+    SynthEvent_t  *pEvent;
+    RenderParams_t  *pParams = m_pRenderParams;  // render params (read once per block)
+    uint32   sampleClock = v_SampleClock; // sample clock at start of segment
+    int32    eventOffset;                 // samples from start of segment to event
+    uint32   CC_Reg;
+    uint32   entryTime;                   // render entry time (core cycle count)
+    uint32   voiceStartTime;              // voice render start time
+    uint32   voiceTime = 0;               // voice render time, all segments
+    uint32   eventTime = 0;               // event processing time, all segments
+    uint32   masterTime = 0;              // master limiter/level time, all segments
+    uint32   reverbTime = 0;              // reverb time, all segments
+    uint32   stageStartTime;              // start time of stage being measured
+    int      voiceCount = 0;              // number of voices rendered (max. in segment)
+    int      segVoices;                   // number of voices rendered in segment
+    int      segSize;                     // number of samples in segment
+    int      isam;                        // sample index within segment
+    int      v;
+    fixed_t  levelAdjust = pParams->LevelAdjust;
+    fixed_t  totalMixOut;                 // output from voice mixer
+    fixed_t  mixGain;                     // voice mix gain, ramped per sample
+    fixed_t  mixGainTarget;               // voice mix gain at end of segment
+    fixed_t  mixGainStep;                 // voice mix gain increment per sample
+    bool     clipping = FALSE;            // Mixer output clipping detected in block
+
+    READ_CPU_CORE_COUNT_REG(CC_Reg);
+    entryTime = CC_Reg;
+    m_OscRenderTime = 0;
+    m_VoiceDspTime = 0;
+
+    if (m_EventDiscardReq)  // Flush requested by SynthPrepare()
+    {
+        m_EventQueueHead = m_EventDiscardIndex;
+        m_EventDiscardReq = FALSE;
+    }
+
+    while (nSamples > 0)
+    {
+        segSize = (nSamples > AUDIO_BLOCK_SIZE) ? AUDIO_BLOCK_SIZE : nSamples;
+        READ_CPU_CORE_COUNT_REG(stageStartTime);
+
+        // Apply events due at (or before) the first sample of the segment;
+        // end the segment at the sample where the next event is due.
+        // Events are held off while a new patch is being instated (patch transition).
+        while (m_EventQueueHead != m_EventQueueTail && m_PatchFadeState != PATCH_FADE_SWITCH)
+        {
+            pEvent = &m_EventQueue[m_EventQueueHead];
+            eventOffset = (int32) (pEvent->SampleTime - sampleClock);
+            if (eventOffset > 0)
+            {
+                if (eventOffset < segSize)  segSize = eventOffset;
+                break;
+            }
+            ApplySynthEvent(pEvent);
+            m_EventQueueHead = (m_EventQueueHead + 1) & (SYNTH_EVENT_QUEUE_SIZE - 1);
+        }
+
+        READ_CPU_CORE_COUNT_REG(CC_Reg);
+        eventTime += CC_Reg - stageStartTime;
+
+        if (!v_SynthEnable)
+        {
+            for (isam = 0;  isam < segSize;  isam++)  outBuf[isam] = 0;
+            outBuf += segSize;
+            nSamples -= segSize;
+            sampleClock += segSize;
+            continue;
+        }
+
+        for (isam = 0;  isam < segSize;  isam++)  mixBuf[isam] = 0;
+
+        READ_CPU_CORE_COUNT_REG(CC_Reg);
+        voiceStartTime = CC_Reg;
+        segVoices = 0;
+
+        // Voices are held (not rendered) while a new patch is being instated
+        for (v = 0, pVoice = m_Voice;  v < SYNTH_VOICES_MAX;  v++, pVoice++)
+        {
+            if (!pVoice->Active)  continue;
+            segVoices++;
+            if (m_PatchFadeState == PATCH_FADE_SWITCH)  continue;
+            RenderVoice(pVoice, pParams, mixBuf, segSize);
+        }
+
+        // Voice mix gain = 1 / (number of active voices), so the sum of the voices has the
+        // same headroom as a single voice.  A fall in gain is ramped over the segment (the
+        // new voice starts from silence);  a rise is limited to the VOICE_MIX_GAIN_RISE_MS
+        // slope, so the remaining voices do not jump in level when a voice is freed.
+        mixGain = m_VoiceMixGain;
+        mixGainTarget = (segVoices > 1) ? IntToFixedPt(1) / segVoices : IntToFixedPt(1);
+        if (mixGainTarget - mixGain > m_VoiceMixRiseStep * segSize)
+        {
+            mixGainStep = m_VoiceMixRiseStep;
+            m_VoiceMixGain = mixGain + mixGainStep * segSize;
+        }
+        else
+        {
+            mixGainStep = (mixGainTarget - mixGain) / segSize;
+            m_VoiceMixGain = mixGainTarget;
+        }
+
+        READ_CPU_CORE_COUNT_REG(CC_Reg);
+        voiceTime += CC_Reg - voiceStartTime;
+        if (segVoices > voiceCount)  voiceCount = segVoices;
+        stageStartTime = CC_Reg;
+
+        for (isam = 0;  isam < segSize;  isam++)
+        {
+            // Master ampld limiter (sum of voices) -- a safety net, given the mix gain
+            totalMixOut = MultiplyFixed(mixBuf[isam], mixGain);
+            mixGain += mixGainStep;
+            if (totalMixOut > FIXED_MAX_LEVEL)  
+            {
+                totalMixOut = FIXED_MAX_LEVEL;
+                clipping = TRUE;  // Trigger LED indicator
+            }
+            if (totalMixOut < -FIXED_MAX_LEVEL)  totalMixOut = -FIXED_MAX_LEVEL;
+
+            // Adjust output level to get consistent amplitude across patches
+            mixBuf[isam] = MultiplyFixed(totalMixOut, levelAdjust);
+        }
+
+        // Fade the voice mix out/in during a patch transition (reverb continues)
+        if (m_PatchFadeState != PATCH_FADE_IDLE)  PatchFadeRender(mixBuf, segSize);
+
+        READ_CPU_CORE_COUNT_REG(CC_Reg);
+        masterTime += CC_Reg - stageStartTime;
+        stageStartTime = CC_Reg;
+
+        if (m_RvbMix != 0)  ReverbRenderBlock(mixBuf, outBuf, segSize);
+        else  for (isam = 0;  isam < segSize;  isam++)  outBuf[isam] = mixBuf[isam];
+
+        READ_CPU_CORE_COUNT_REG(CC_Reg);
+        reverbTime += CC_Reg - stageStartTime;
+
+        outBuf += segSize;
+        nSamples -= segSize;
+        sampleClock += segSize;
+    }
+
+    if (clipping)  v_Clipping = TRUE;
+
+    v_SampleClock = sampleClock;
+    v_BlockStartTime = entryTime;
+
+    if (voiceCount != 0)  // Profile only blocks in which voices were rendered
+    {
+        ProfileRecord(PROFILE_EVENTS, eventTime);
+        ProfileRecord(PROFILE_OSCILLATORS, m_OscRenderTime);
+        ProfileRecord(PROFILE_VOICE_DSP, m_VoiceDspTime);
+        ProfileRecord(PROFILE_MASTER, masterTime);
+        ProfileRecord(PROFILE_REVERB, reverbTime);
     }
 
-    // ------------ Filter frequency modulation -----------------------
-    //
-    if (g_Patch.FilterControl == FILTER_CTRL_CONTOUR)  // mode 1
+    READ_CPU_CORE_COUNT_REG(CC_Reg);
+    v_ISRexecTime = CC_Reg - entryTime;
+    v_VoiceRenderTime = voiceTime;
+    v_VoicesRendered = voiceCount;
+}
+
+
+/*
+ * Function:     Reverberation effect -- feedback delay network (FDN) with 4 delay lines.
+ *
+ * The input signal, scaled by the reverb attenuator setting (m_RvbAtten), is fed into
+ * four delay lines of mutually prime lengths (m_RvbDelayLen[]), so that their echoes
+ * rarely coincide.  The output of each line is scaled by its loop gain, low-pass filtered
+ * (HF damping) and fed back to the line inputs through a 4 x 4 Hadamard matrix, scaled
+ * by 1/2 so that the matrix is orthonormal, i.e. the feedback path is lossless apart from
+ * the loop gains.  The matrix product is formed with adds and shifts only.  The reverb
+ * (wet) signal is the sum of the line outputs, mixed with the dry signal according to the
+ * reverb mix setting (m_RvbMix).  The input is scaled down by 4 (and the wet signal up)
+ * so that the delay line samples stay within +/-4.0, the range of the 16-bit storage,
+ * with sustained tones which build up in the network.
+ *
+ * Entry args:   inBuf = dry signal (mixer output), outBuf = final output (to DAC);
+ *               nSamples = number of samples in block.
+ *
+ * The delay line indices and filter states are held in local variables while the block is
+ * processed.  RAM usage is REVERB_DELAY_MAX_SIZE x sizeof(reverb_t), i.e. 2 bytes per
+ * sample if REVERB_DELAY_16BIT is set (else 4), plus about 64 bytes of state.
+ */
+PRIVATE  void  ReverbRenderBlock(fixed_t *inBuf, fixed_t *outBuf, int nSamples)
+{
+    reverb_t *pLine0 = m_RvbLine[0],  *pLine1 = m_RvbLine[1];
+    reverb_t *pLine2 = m_RvbLine[2],  *pLine3 = m_RvbLine[3];
+    int      idx0 = m_RvbIndex[0],  idx1 = m_RvbIndex[1];
+    int      idx2 = m_RvbIndex[2],  idx3 = m_RvbIndex[3];
+    fixed_t  damp0 = m_RvbDamping[0],  damp1 = m_RvbDamping[1];
+    fixed_t  damp2 = m_RvbDamping[2],  damp3 = m_RvbDamping[3];
+    fixed_t  out0, out1, out2, out3;      // delay line outputs, scaled by loop gain
+    fixed_t  sum01, dif01, sum23, dif23;  // Hadamard matrix partial products
+    fixed_t  fb0, fb1, fb2, fb3;          // delay line inputs (feedback + input)
+    fixed_t  dry, input, wet;
+    int      isam;
+
+    for (isam = 0;  isam < nSamples;  isam++)
     {
-        fc_idx = filterIndex + IntegerPart(m_ContourEnvOutput * 54) - 27;
+        dry = inBuf[isam];
+        input = (dry * m_RvbAtten) >> 9;  // scaled by 1/4 for headroom in delay lines
+
+        out0 = MultiplyFixed(ReverbUnpack(pLine0[idx0]), m_RvbLoopGain[0]);
+        out1 = MultiplyFixed(ReverbUnpack(pLine1[idx1]), m_RvbLoopGain[1]);
+        out2 = MultiplyFixed(ReverbUnpack(pLine2[idx2]), m_RvbLoopGain[2]);
+        out3 = MultiplyFixed(ReverbUnpack(pLine3[idx3]), m_RvbLoopGain[3]);
+
+        damp0 += (out0 - damp0) >> 1;     // 1-pole low-pass filters (HF damping)
+        damp1 += (out1 - damp1) >> 1;
+        damp2 += (out2 - damp2) >> 1;
+        damp3 += (out3 - damp3) >> 1;
+
+        sum01 = damp0 + damp1;            // Feedback = H4 x damped outputs / 2
+        dif01 = damp0 - damp1;
+        sum23 = damp2 + damp3;
+        dif23 = damp2 - damp3;
+        fb0 = ((sum01 + sum23) >> 1) + input;
+        fb1 = ((dif01 + dif23) >> 1) - input;
+        fb2 = ((sum01 - sum23) >> 1) + input;
+        fb3 = ((dif01 - dif23) >> 1) - input;
+        pLine0[idx0] = ReverbPack(fb0);
+        pLine1[idx1] = ReverbPack(fb1);
+        pLine2[idx2] = ReverbPack(fb2);
+        pLine3[idx3] = ReverbPack(fb3);
+
+        if (++idx0 >= m_RvbDelayLen[0])  idx0 = 0;  // wrap
+        if (++idx1 >= m_RvbDelayLen[1])  idx1 = 0;
+        if (++idx2 >= m_RvbDelayLen[2])  idx2 = 0;
+        if (++idx3 >= m_RvbDelayLen[3])  idx3 = 0;
+
+        // Add reverb output (x2, restoring the input scaling) to dry signal
+        // according to reverb mix setting...
+        wet = out0 + out1 + out2 + out3;
+        outBuf[isam] = ((dry * (128 - m_RvbMix)) >> 7) + ((wet * m_RvbMix) >> 6);
     }
-    else if (g_Patch.FilterControl == FILTER_CTRL_LFO)  // mode 2
+
+    m_RvbIndex[0] = idx0;  m_RvbIndex[1] = idx1;
+    m_RvbIndex[2] = idx2;  m_RvbIndex[3] = idx3;
+    m_RvbDamping[0] = damp0;  m_RvbDamping[1] = damp1;
+    m_RvbDamping[2] = damp2;  m_RvbDamping[3] = damp3;
+}
+
+
+/*
+ * Function:     Apply a scheduled event to the synth engine -- called by the block renderer
+ *               at the sample for which the event is due.
+ */
+PRIVATE  void  ApplySynthEvent(SynthEvent_t *pEvent)
+{
+    switch (pEvent->Type)
     {
-        devn = (m_LFO_output * g_Patch.LFO_FM_Depth) / 200;
-        fc_idx = filterIndex + IntegerPart(devn * 108);
+    case SYNTH_EVENT_NOTE_ON:     SynthNoteOn(pEvent->Data1, (uint8) pEvent->Value);  break;
+    case SYNTH_EVENT_NOTE_OFF:    SynthNoteOff(pEvent->Data1);  break;
+    case SYNTH_EVENT_EXPRESSION:  SynthExpression(pEvent->Value);  break;
+    case SYNTH_EVENT_MODULATION:  SynthModulation(pEvent->Value);  break;
+    case SYNTH_EVENT_PITCH_BEND:  SynthPitchBend((int) pEvent->Value - 0x2000);  break;
+    default:  break;
     }
-    else if (g_Patch.FilterControl == FILTER_CTRL_EXPRESS)  // mode 3
+}
+
+
+/*`````````````````````````````````````````````````````````````````````````````````````````````````
+ * Function:     SynthPostEvent()
+ *
+ * Overview:     Schedules a note or controller event to be applied by the block renderer
+ *               at a given sample clock value, so that the event takes effect at the exact
+ *               sample, independent of the 1ms synth process tick.
+ *
+ * Entry args:   type  = event type, SYNTH_EVENT_xxx (see remi_synth_def.h)
+ *               data1 = note number (note events), else unused
+ *               value = note-on velocity, or 14-bit controller value (pitch-bend centre
+ *                       position is 0x2000)
+ *               sampleTime = sample clock value at which the event is due, typically the
+ *                       event arrival time (SynthSampleClock) plus SynthEventLatency()
+ *
+ * Return val:   TRUE if the event was queued;  FALSE if the queue is full (event lost).
+ *
+ * Events must be posted in time order, from one task context only (the producer).
+ * An event which is overdue when the renderer gets to it is applied at the start of the
+ * next block rendered, so the scheduling latency should exceed the worst-case delay
+ * between event arrival and posting, plus one block period.
+ */
+bool  SynthPostEvent(uint8 type, uint8 data1, uint16 value, uint32 sampleTime)
+{
+    uint8  tail = m_EventQueueTail;
+    SynthEvent_t  *pEvent = &m_EventQueue[tail];
+
+    if (((tail + 1) & (SYNTH_EVENT_QUEUE_SIZE - 1)) == m_EventQueueHead)  // queue full
     {
-        devn = (m_PressureLevel * 25) / 100;  // deviation (0.25 max)
-        fc_idx = filterIndex + IntegerPart(devn * 108);
+        m_EventQueueOverflows++;
+        return  FALSE;
     }
-    else if (g_Patch.FilterControl == FILTER_CTRL_MODULN)  // mode 4
+
+    pEvent->SampleTime = sampleTime;
+    pEvent->Value = value;
+    pEvent->Type = type;
+    pEvent->Data1 = data1;
+
+    m_EventQueueTail = (tail + 1) & (SYNTH_EVENT_QUEUE_SIZE - 1);  // publish the event
+    return  TRUE;
+}
+
+
+/*
+ * Function:     Read the synth engine sample clock, i.e. the number of samples rendered
+ *               since start-up, plus the number of sample periods elapsed since the last
+ *               block was rendered.  The clock wraps modulo 2^32.
+ *
+ * The function may be called from any task or ISR context, e.g. to timestamp an incoming
+ * MIDI message.  If a block is rendered while the clock is being read, it is read again.
+ */
+uint32  SynthSampleClock(void)
+{
+    uint32  clock, startTime, countNow, elapsed;
+
+    do
     {
-        devn = (m_ModulationLevel * 50) / 100;  // deviation (0.5 max)
-        fc_idx = filterIndex - IntegerPart(devn * 108);
-    }
-    else  fc_idx = filterIndex;  // filter Fc is constant or note tracking (offset)
+        clock = v_SampleClock;
+        startTime = v_BlockStartTime;
+        READ_CPU_CORE_COUNT_REG(countNow);
+    } while (clock != v_SampleClock);
+
+    elapsed = (countNow - startTime) / m_CoreCountsPerSample;
+    if (elapsed >= AUDIO_BLOCK_SIZE)  elapsed = AUDIO_BLOCK_SIZE - 1;  // render is late
+
+    return  clock + elapsed;
+}
+
+
+/*
+ * Function:     Get the audio sample rate in use (Hz), as set by SynthPrepare() from
+ *               the config param SampleRate_kHz.
+ */
+uint32  SynthSampleRate(void)
+{
+    return  m_SampleRate;
+}
 
-    if (fc_idx > 108)  fc_idx = 108;   // max. ~ 8kHz
-    if (fc_idx < 0)  fc_idx = 0;       // min. ~ 16Hz
 
-    v_coeff_a1 = 0 - m_FiltCoeff_c[fc_idx];  // update coeff a1 = -c
+/*
+ * Function:     Get the event scheduling latency (samples) to be added to the arrival time
+ *               of a note or controller event, i.e. SYNTH_EVENT_LATENCY_US at the sample
+ *               rate in use (e.g. 60 samples at 40kHz).  See SynthPostEvent().
+ */
+uint32  SynthEventLatency(void)
+{
+    return  m_EventLatency;
 }
 
 
 /*`````````````````````````````````````````````````````````````````````````````````````````````````
- * Function:     Timer_2 interrupt service routine (ISR)
+ * Function:     RenderVoice()
  *
- * The ISR performs DSP synthesis computations which need to be executed at the PCM audio
- * sampling rate, as defined by SAMPLE_RATE_HZ (typ. 40 kHz).
+ * Overview:     Renders nSamples of one voice and adds the result into mixBuf[].
  *
  * Signal (sample) computations use 32-bit [12:20] fixed-point arithmetic, except
  * that wave-table samples are stored as 16-bit signed integers. Wave-table samples are
@@ -1081,26 +2546,38 @@ PRIVATE  void   FilterFrequencyControl()
  * 
  * The Wave-table Oscillator algorithms use lower precision fixed-point (16:16 bits) to
  * avoid arithmetic overflow, which could occur with 12:20 bit precision.
+ * The oscillators are rendered first, a whole block at a time, into local buffers which
+ * are then read by the per-sample mixer, noise and filter stages.
+ *
+ * Real-time control variables in the voice record (Osc1Step, Mix2Level, FilterCoeff_f, etc)
+ * are updated by the 1ms synth process.  They are read once at the start of each block,
+ * so the cost of accessing them is shared by all samples in the block.  Patch and config
+ * params are read from the render parameter set (pParams) published by the control path.
+ * The gain factors in pParams are pre-scaled [12:20] fixed-point multipliers, so that the
+ * per-sample path uses only multiply and shift operations -- no (multi-cycle) divisions.
  *
- * With sample rate = 40kHz, the periodic IRQ interval is 25us.  The ISR execution time
- * should be kept under 15us.  With Fclk = 80 MHz, 1us equals 80 core instruction cycles,
- * so the ISR may be up to about 15 * 80 = 1200 instructions, which is quite a lot!
+ * The mixer level, noise level, filter coeff's and output level are not applied as steps;
+ * each is interpolated from its previous value by a ramp (RampParam_t) lasting one control
+ * update period, which costs one add per sample.  This avoids "zipper" noise when the
+ * values are modulated, e.g. by the envelopes, expression or LFO.
+ *
+ * The amplitude envelope is advanced once per block by AmpldEnvelopeAdvance().  Where the
+ * output level is controlled by the envelope (pVoice->AmpldEnvControl), the output level
+ * ramp goes from the envelope level at the start of the block to the level at the end,
+ * multiplied by the output gain from the modulation matrix (normally 1.0).
+ *
+ * The filter is a Chamberlin state-variable filter, which provides low-pass, band-pass
+ * and high-pass outputs from the same two state variables, using 3 multiplications per
+ * sample.  The corner frequency is set by coeff f = 2 * sin(pi * Fc / Fs) and the damping
+ * by coeff q = 1 / Q.  In band-pass mode, the input is scaled by q, so the gain at the
+ * resonant peak is independent of the damping.
  */
-void  __ISR(_TIMER_2_VECTOR, IPL6AUTO)  Timer_2_IRQService(void)
+PRIVATE  void  RenderVoice(SynthVoice_t *pVoice, RenderParams_t *pParams, fixed_t *mixBuf,
+                           int nSamples)
 {
-    static  fixed_t  osc1SawtoothAmpld;   // osc1 sawtooth sample amplitude
-    static  fixed_t  osc2SawtoothAmpld;   // osc2 sawtooth sample amplitude
-    static  fixed_t  filter_in_1;         // bi-quad filter input delayed 1 sample
-    static  fixed_t  filter_in_2;         // bi-quad filter input delayed 2 samples
-    static  fixed_t  filter_out_1;        // bi-quad filter output delayed 1 sample
-    static  fixed_t  filter_out_2;        // bi-quad filter output delayed 2 samples
-    static  uint32   rand_last = 1;       // random number (NB: seed must be odd!)
-    static  fixed_t  reverbPrev;          // previous sample from reverb delay line
-    static  int      rvbIndex;            // index into ReverbDelayLine[]
-
-    uint32   CC_Reg;
-    uint32   entryTime;                   // ISR entry time (core cycle count)
-    int      idx;                         // index into wave-tables
+    int      isam;                        // sample index within block
+    fixed_t  osc1Buf[AUDIO_BLOCK_SIZE];   // output block from OSC1
+    fixed_t  osc2Buf[AUDIO_BLOCK_SIZE];   // output block from OSC2
     fixed_t  osc1Sample, osc2Sample;      // outputs from OSC1 and OSC2
     fixed_t  noiseSample;                 // output from white noise algorithm
     fixed_t  noiseGenOut;                 // output from noise generator 
@@ -1108,62 +2585,143 @@ void  __ISR(_TIMER_2_VECTOR, IPL6AUTO)  Timer_2_IRQService(void)
     fixed_t  mixerIn1, mixerIn2;          // inputs to wave-osc mixer
     fixed_t  waveMixerOut;                // output from wave-osc mixer 
     fixed_t  totalMixOut;                 // output from wave + noise mixers
-    fixed_t  filterIn;                    // input to IIR bi-quad filter 
-    fixed_t  filterOut;                   // output from IIR bi-quad filter 
-    fixed_t  attenOut = 0;                // output from variable-gain attenuator
-    fixed_t  reverbOut;                   // output from reverb delay line
-    fixed_t  reverbLPF;                   // output from reverb loop filter
-    fixed_t  finalOutput = 0;             // output sample (to PWM DAC) 
-    uint16   spiDACdata;                  // SPI DAC register data
+    fixed_t  filterIn;                    // input to state-variable filter
+    fixed_t  filterHigh;                  // high-pass output from filter
+    fixed_t  filterOut;                   // output from filter (selected by mode)
+    uint32   oscStartTime, dspStartTime;  // stage start times (core cycle count)
+    uint32   CC_Reg;
 
-    READ_CPU_CORE_COUNT_REG(CC_Reg);
-    entryTime = CC_Reg;
+    // Block-constant copies of voice state and control variables (read once per block)
+    int32    osc1Angle = pVoice->Osc1Angle;   // oscillator phase [16:16]
+    int32    osc2Angle = pVoice->Osc2Angle;
+    int32    osc1Step = pVoice->Osc1Step;     // oscillator phase step [16:16]
+    int32    osc2Step = pVoice->Osc2Step;
+    fixed_t  osc1SawAmpld = pVoice->Osc1SawAmpld;
+    fixed_t  osc2SawAmpld = pVoice->Osc2SawAmpld;
+    fixed_t  osc1SawIncr = pVoice->Osc1SawIncr;
+    fixed_t  osc2SawIncr = pVoice->Osc2SawIncr;
+    fixed_t  filter_low = pVoice->FilterLow;    // filter state variables
+    fixed_t  filter_band = pVoice->FilterBand;
+    uint32   rand_last = pVoice->RandLast;
+    int      mix2Level;                   // OSC2 mixer input level x1000 (ramped)
+    int32    mix2Ramp, mix2Step;          // OSC2 mixer input level ramp [x1000 << 16]
+    fixed_t  noiseLevel, noiseStep;
+    fixed_t  outputLevel, outputStep;
+    fixed_t  coeff_f, coeff_fStep;        // filter freq. coeff (ramped)
+    fixed_t  coeff_q, coeff_qStep;        // filter damping coeff (ramped)
+    fixed_t  filterInGain;                // filter input gain, incl. q
+    fixed_t  filterOutGain = pParams->FilterOutGain;  // filter output gain
+    fixed_t  noiseOutGain = pParams->NoiseOutGain;    // noise filter output gain
+    bool     osc1IsWave = pParams->Osc1IsWave;
+    bool     osc2IsWave = pParams->Osc2IsWave;
+    WaveTableLevel_t  *osc1Level = pVoice->Osc1Level;
+    WaveTableLevel_t  *osc2Level = pVoice->Osc2Level;
+    int16   *osc1Table = NULL;
+    int16   *osc2Table = NULL;
+    int32    osc1Period = m_FundamentalPeriod;
+    int32    osc2Period = m_FundamentalPeriod;
+    uint8    noiseMode = pParams->NoiseMode;
+    bool     filterEnabled = pParams->FilterEnabled;
+    uint8    filterMode = pParams->FilterMode;
+    uint16   ramp5ms;                     // ramp length, 5ms control vars (samples)
+
+    if (pVoice->RampReset)  // New note on a free voice -- ramps start from control values
+    {
+        ramp5ms = m_SamplesPerMs * 5;
+        RampParamInit(&pVoice->Mix2Ramp, (int32) pVoice->Mix2Level << 16, ramp5ms);
+        RampParamInit(&pVoice->NoiseRamp, pVoice->NoiseLevel, ramp5ms);
+        RampParamInit(&pVoice->FilterFreqRamp, pVoice->FilterCoeff_f, ramp5ms);
+        RampParamInit(&pVoice->FilterDampRamp, pVoice->FilterCoeff_q, ramp5ms);
+        RampParamInit(&pVoice->OutputRamp, 0, m_SamplesPerMs);  // fade in from silence
+        pVoice->AmpldEnvLevel = 0;
+        pVoice->RampReset = FALSE;
+    }
 
-    if (v_SynthEnable)
+    RampParamBegin(&pVoice->Mix2Ramp, (int32) pVoice->Mix2Level << 16, nSamples);
+    RampParamBegin(&pVoice->NoiseRamp, pVoice->NoiseLevel, nSamples);
+    RampParamBegin(&pVoice->FilterFreqRamp, pVoice->FilterCoeff_f, nSamples);
+    RampParamBegin(&pVoice->FilterDampRamp, pVoice->FilterCoeff_q, nSamples);
+    mix2Ramp = pVoice->Mix2Ramp.Value;
+    mix2Step = pVoice->Mix2Ramp.Step;
+    noiseLevel = pVoice->NoiseRamp.Value;
+    noiseStep = pVoice->NoiseRamp.Step;
+    coeff_f = pVoice->FilterFreqRamp.Value;
+    coeff_fStep = pVoice->FilterFreqRamp.Step;
+    coeff_q = pVoice->FilterDampRamp.Value;
+    coeff_qStep = pVoice->FilterDampRamp.Step;
+    filterInGain = pParams->FilterInGain;  // incl. filtAtten
+    if (filterMode == FILTER_MODE_BANDPASS)  // peak gain independent of damping
+        filterInGain = MultiplyFixed(coeff_q, filterInGain);
+
+    // If the synth process has selected a different wave-table level (note change),
+    // re-scale the oscillator phase to the new table size, then adopt the new level.
+    if (osc1IsWave)
     {
-        if (g_Patch.Osc1WaveTable < m_NumberOfWavetables)  // OSC1 using Wave-table
-        {
-            idx = v_Osc1Angle >> 16;  // integer part of v_Osc1Angle
-            osc1Sample = (fixed_t) m_WaveTable1[idx] << 5;  // normalize
-            v_Osc1Angle += v_Osc1Step;
-            if (v_Osc1Angle >= (g_Osc1WaveTableSize << 16))
-                v_Osc1Angle -= (g_Osc1WaveTableSize << 16);
-        }
-        else  // OSC1 is "Pure Sawtooth" oscillator
-        {
-            osc1Sample = osc1SawtoothAmpld;
-            osc1SawtoothAmpld += v_Osc1SawtoothIncr;
-            v_Osc1Angle += v_Osc1Step;
-            if (v_Osc1Angle >= m_FundamentalPeriod)
-            {
-                v_Osc1Angle = 0;
-                osc1SawtoothAmpld = 0 - m_SawtoothPeakAmpld;
-            }
-        }
+        if (pVoice->Osc1LevelInUse != osc1Level && pVoice->Osc1LevelInUse != NULL)
+            osc1Angle = (int32) (((int64) osc1Angle * (osc1Level->Period >> 16))
+                        / (pVoice->Osc1LevelInUse->Period >> 16));
+        pVoice->Osc1LevelInUse = osc1Level;
+        osc1Table = osc1Level->Address;
+        osc1Period = osc1Level->Period;
+        if (osc1Angle >= osc1Period)  osc1Angle = 0;
+    }
+    if (osc2IsWave)
+    {
+        if (pVoice->Osc2LevelInUse != osc2Level && pVoice->Osc2LevelInUse != NULL)
+            osc2Angle = (int32) (((int64) osc2Angle * (osc2Level->Period >> 16))
+                        / (pVoice->Osc2LevelInUse->Period >> 16));
+        pVoice->Osc2LevelInUse = osc2Level;
+        osc2Table = osc2Level->Address;
+        osc2Period = osc2Level->Period;
+        if (osc2Angle >= osc2Period)  osc2Angle = 0;
+    }
+
+    READ_CPU_CORE_COUNT_REG(oscStartTime);
+
+    if (osc1IsWave)  // OSC1 using Wave-table
+        OscWaveRenderBlock(osc1Buf, nSamples, osc1Table, osc1Period, &osc1Angle, osc1Step,
+                           pParams->Osc1InterpMode);
+    else  // OSC1 is "Pure Sawtooth" oscillator
+        OscSawRenderBlock(osc1Buf, nSamples, &osc1SawAmpld, osc1SawIncr, 
+                          &osc1Angle, osc1Step, osc1Period);
+
+    if (osc2IsWave)  // OSC2 using Wave-table
+        OscWaveRenderBlock(osc2Buf, nSamples, osc2Table, osc2Period, &osc2Angle, osc2Step,
+                           pParams->Osc2InterpMode);
+    else  // OSC2 is "Pure Sawtooth" oscillator
+        OscSawRenderBlock(osc2Buf, nSamples, &osc2SawAmpld, osc2SawIncr, 
+                          &osc2Angle, osc2Step, osc2Period);
+
+    READ_CPU_CORE_COUNT_REG(dspStartTime);
+    m_OscRenderTime += dspStartTime - oscStartTime;
+
+    AmpldEnvelopeAdvance(pVoice, nSamples);  // Envelope x Velocity, at end of block
+
+    if (pVoice->AmpldEnvControl)  // Output level ramps to envelope level at end of block
+    {
+        outputLevel = MultiplyFixed(pVoice->AmpldEnvOutput, pVoice->AmpldModGain);
+        pVoice->OutputRamp.Target = outputLevel;
+        pVoice->OutputRamp.Count = 0;
+        if (nSamples == AUDIO_BLOCK_SIZE)  // whole block (usual case)
+            pVoice->OutputRamp.Step = (outputLevel - pVoice->OutputRamp.Value) / AUDIO_BLOCK_SIZE;
+        else  pVoice->OutputRamp.Step = (outputLevel - pVoice->OutputRamp.Value) / nSamples;
+    }
+    else  // Output level from audio level controller (control rate), ramped
+        RampParamBegin(&pVoice->OutputRamp, pVoice->OutputLevel, nSamples);
+
+    outputLevel = pVoice->OutputRamp.Value;
+    outputStep = pVoice->OutputRamp.Step;
+
+    for (isam = 0;  isam < nSamples;  isam++)
+    {
+        osc1Sample = osc1Buf[isam];
+        osc2Sample = osc2Buf[isam];
 
-        if (g_Patch.Osc2WaveTable < m_NumberOfWavetables)  // OSC2 using Wave-table
-        {
-            idx = v_Osc2Angle >> 16;  // integer part of v_Osc2Angle
-            osc2Sample = (fixed_t) m_WaveTable2[idx] << 5;  // normalize
-            v_Osc2Angle += v_Osc2Step;
-            if (v_Osc2Angle >= (g_Osc2WaveTableSize << 16))
-                v_Osc2Angle -= (g_Osc2WaveTableSize << 16);
-        }
-        else  // OSC2 is "Pure Sawtooth" oscillator
-        {
-            osc2Sample = osc2SawtoothAmpld;
-            osc2SawtoothAmpld += v_Osc2SawtoothIncr;
-            v_Osc2Angle += v_Osc2Step;
-            if (v_Osc2Angle >= m_FundamentalPeriod)
-            {
-                v_Osc2Angle = 0;
-                osc2SawtoothAmpld = 0 - m_SawtoothPeakAmpld;
-            }
-        }
-        
         // Wave Mixer -- add OSC1 and OSC2 samples, scaled according to mix ratio
-        mixerIn1 = (osc1Sample * (1000 - v_Mix2Level)) >> 10;
-        mixerIn2 = (osc2Sample * v_Mix2Level) >> 10;
+        mix2Level = mix2Ramp >> 16;
+        mix2Ramp += mix2Step;
+        mixerIn1 = (osc1Sample * (1000 - mix2Level)) >> 10;
+        mixerIn2 = (osc2Sample * mix2Level) >> 10;
         waveMixerOut = mixerIn1 + mixerIn2;
 
         // White noise generator -- Pseudo-random number algorithm...
@@ -1171,63 +2729,59 @@ void  __ISR(_TIMER_2_VECTOR, IPL6AUTO)  Timer_2_IRQService(void)
         noiseSample = (int32) (rand_last << 1);    // signed 32-bit value
         noiseSample = noiseSample >> 11;           // normalized fixed-pt (+/-1.0)
 
-        if (g_Patch.NoiseMode)  // Noise enabled in patch
+        if (noiseMode)  // Noise enabled in patch
         {
-            if (g_Patch.FilterResonance)   // Filter enabled (res != 0)
+            if (filterEnabled)   // Filter enabled (res != 0)
             {
                 // Adjust noiseSample to a level which avoids overdriving the filter
-                filterIn = (noiseSample * m_FilterAtten_pc) / 100;  
+                filterIn = MultiplyFixed(noiseSample, filterInGain);
                 // Apply filter algorithm
-                filterOut =  MultiplyFixed(v_coeff_b0, filterIn);
-                filterOut += MultiplyFixed(v_coeff_b2, filter_in_2);
-                filterOut -= MultiplyFixed(v_coeff_a1, filter_out_1);
-                filterOut -= MultiplyFixed(v_coeff_a2, filter_out_2);
-                filter_in_2 = filter_in_1;  // update delayed samples
-                filter_in_1 = filterIn;
-                filter_out_2 = filter_out_1;
-                filter_out_1 = filterOut;
+                filter_low += MultiplyFixed(coeff_f, filter_band);
+                filterHigh = filterIn - filter_low - MultiplyFixed(coeff_q, filter_band);
+                filter_band += MultiplyFixed(coeff_f, filterHigh);
+                if (filterMode == FILTER_MODE_LOWPASS)  filterOut = filter_low;
+                else if (filterMode == FILTER_MODE_HIGHPASS)  filterOut = filterHigh;
+                else  filterOut = filter_band;
                 // Adjust noise filter output level to compensate for spectral loss
-                filterOut = (filterOut * m_NoiseGain_x10) / 10;  
+                filterOut = MultiplyFixed(filterOut, noiseOutGain);
                 // If enabled, Ring Modulate OSC2 output with filtered noise...
-                if (g_Patch.NoiseMode & NOISE_PITCHED)   
+                if (noiseMode & NOISE_PITCHED)   
                     noiseGenOut = MultiplyFixed(filterOut, osc2Sample);  // Ring Mod.
                 else  noiseGenOut = filterOut;   // unmodulated filtered noise
             }
             else  noiseGenOut = noiseSample;  // unfiltered, unmodulated noise
             
             // Add or mix noise with wave mixer output according to patch mode
-            if ((g_Patch.NoiseMode & 3) == NOISE_WAVE_ADDED)  // Add noise to total mix
+            if ((noiseMode & 3) == NOISE_WAVE_ADDED)  // Add noise to total mix
             {
-                noiseGenOut = MultiplyFixed(noiseGenOut, v_NoiseLevel);
-                totalMixOut = (waveMixerOut + noiseGenOut) / 2;  // avoid clipping
+                noiseGenOut = MultiplyFixed(noiseGenOut, noiseLevel);
+                totalMixOut = (waveMixerOut + noiseGenOut) >> 1;  // avoid clipping
             }
-            else if ((g_Patch.NoiseMode & 3) == NOISE_WAVE_MIXED)  // Ratiometric mix
+            else if ((noiseMode & 3) == NOISE_WAVE_MIXED)  // Ratiometric mix
             {
-                wave2NoiseRatio = IntToFixedPt(1) - v_NoiseLevel;  // 0 ~ 1.0
+                wave2NoiseRatio = IntToFixedPt(1) - noiseLevel;  // 0 ~ 1.0
                 totalMixOut = MultiplyFixed(waveMixerOut, wave2NoiseRatio);
-                totalMixOut += MultiplyFixed(noiseGenOut, v_NoiseLevel);
+                totalMixOut += MultiplyFixed(noiseGenOut, noiseLevel);
             }
-            else  totalMixOut = MultiplyFixed(noiseGenOut, v_NoiseLevel);  // Noise only
+            else  totalMixOut = MultiplyFixed(noiseGenOut, noiseLevel);  // Noise only
         }
-        else if (g_Patch.FilterResonance)   // Filter enabled (res != 0)
+        else if (filterEnabled)   // Filter enabled (res != 0)
         {
             // Adjust waveMixerOut to a level which avoids overdriving the filter
-            filterIn = (waveMixerOut * m_FilterAtten_pc) / 100;
+            filterIn = MultiplyFixed(waveMixerOut, filterInGain);
             // Apply filter algorithm
-            filterOut =  MultiplyFixed(v_coeff_b0, filterIn);
-            filterOut += MultiplyFixed(v_coeff_b2, filter_in_2);
-            filterOut -= MultiplyFixed(v_coeff_a1, filter_out_1);
-            filterOut -= MultiplyFixed(v_coeff_a2, filter_out_2);
-            filter_in_2 = filter_in_1;  // update delayed samples
-            filter_in_1 = filterIn;
-            filter_out_2 = filter_out_1;
-            filter_out_1 = filterOut;
+            filter_low += MultiplyFixed(coeff_f, filter_band);
+            filterHigh = filterIn - filter_low - MultiplyFixed(coeff_q, filter_band);
+            filter_band += MultiplyFixed(coeff_f, filterHigh);
+            if (filterMode == FILTER_MODE_LOWPASS)  filterOut = filter_low;
+            else if (filterMode == FILTER_MODE_HIGHPASS)  filterOut = filterHigh;
+            else  filterOut = filter_band;
             // Adjust filter output level
-            totalMixOut = (filterOut * m_FilterGain_x10) / 100;  
+            totalMixOut = MultiplyFixed(filterOut, filterOutGain);
         }
         else  totalMixOut = waveMixerOut;   // No noise and no filter in patch
         
-        // Apply ampld limiter.. 
+        // Apply voice ampld limiter.. 
         if (totalMixOut > FIXED_MAX_LEVEL)  
         {
             totalMixOut = FIXED_MAX_LEVEL;
@@ -1236,53 +2790,322 @@ void  __ISR(_TIMER_2_VECTOR, IPL6AUTO)  Timer_2_IRQService(void)
         if (totalMixOut < -FIXED_MAX_LEVEL)  totalMixOut = -FIXED_MAX_LEVEL;
 
         // Variable-gain output attenuator -- Apply expression, envelope, etc.
-        attenOut = MultiplyFixed(totalMixOut, v_OutputLevel); 
-        // Adjust output level to get consistent amplitude across patches
-        attenOut = (attenOut * g_Patch.AudioLevelAdjust) / 100;
+        mixBuf[isam] += MultiplyFixed(totalMixOut, outputLevel); 
+
+        // Advance the control parameter ramps
+        noiseLevel += noiseStep;
+        outputLevel += outputStep;
+        coeff_f += coeff_fStep;
+        coeff_q += coeff_qStep;
+    }
+
+    // Save voice state for the next block
+    pVoice->Osc1Angle = osc1Angle;
+    pVoice->Osc2Angle = osc2Angle;
+    pVoice->Osc1SawAmpld = osc1SawAmpld;
+    pVoice->Osc2SawAmpld = osc2SawAmpld;
+    pVoice->FilterLow = filter_low;
+    pVoice->FilterBand = filter_band;
+    pVoice->RandLast = rand_last;
+
+    READ_CPU_CORE_COUNT_REG(CC_Reg);
+    m_VoiceDspTime += CC_Reg - dspStartTime;
+
+    RampParamEnd(&pVoice->Mix2Ramp, mix2Ramp);
+    RampParamEnd(&pVoice->NoiseRamp, noiseLevel);
+    RampParamEnd(&pVoice->FilterFreqRamp, coeff_f);
+    RampParamEnd(&pVoice->FilterDampRamp, coeff_q);
+    RampParamEnd(&pVoice->OutputRamp, outputLevel);
+}
+
+
+/*
+ * Function:     Advance the amplitude envelope of a voice by nSamples, i.e. to the end of the
+ *               block (or segment) to be rendered.  The resulting level, scaled by the attack
+ *               velocity, is left in pVoice->AmpldEnvOutput (normalized fixed-point).
+ *
+ * The envelope timing is kept in samples, so a segment may start or end at any sample, e.g.
+ * a note-on applied at a scheduled sample starts the attack at that sample.  The level at the
+ * end of each run of samples in the same segment is computed directly:  one multiply (attack)
+ * or one multiply-add using the per-block coefficient (decay, release);  there is no division.
+ * A partial block is advanced one sample at a time using the per-sample coefficient.
+ * The renderer interpolates linearly between the block end-points, as it does for the other
+ * control parameter ramps.  The level is held in 2:30 bit fixed-point, so that slow ramps
+ * keep their precision.
+ *
+ * On the attack trigger, the peak and sustain levels and the attack step are scaled by the
+ * velocity.  The attack starts from the present level, so a re-attacked (or stolen) voice
+ * ramps up from where it was, without a click.
+ */
+PRIVATE  void  AmpldEnvelopeAdvance(SynthVoice_t *pVoice, int nSamples)
+{
+    int32    level = pVoice->AmpldEnvLevel;
+    int32    peak = pVoice->AmpldEnvPeak;
+    int32    step = pVoice->AmpldEnvStep;
+    int32    target;                      // level approached by exponential segment
+    int32    coeff;                       // exponential segment coeff. [1:31]
+    uint32   count = pVoice->AmpldEnvCount;
+    uint8    segment = pVoice->AmpldEnvSegment;
+    int      runLength;                   // number of samples in the same segment
+    int      isam;
+
+    if (pVoice->TriggerAttack)
+    {
+        pVoice->TriggerAttack = 0;
+        pVoice->TriggerRelease = 0;
+        peak = (int32) (((int64) m_AmpldPeakLevel * pVoice->AttackVelocity) >> 20);
+        step = (int32) (((int64) m_AmpldAttackStep * peak) >> 30);
+        if (step == 0)  step = 1;
+        pVoice->AmpldEnvSustain = (int32) (((int64) m_AmpldSustainLevel
+                                  * pVoice->AttackVelocity) >> 20);
+        count = m_AmpldAttackSamples;
+        segment = ENV_ATTACK;
+    }
+
+    if (pVoice->TriggerRelease)
+    {
+        pVoice->TriggerRelease = 0;
+        count = m_AmpldReleaseSamples;
+        segment = ENV_RELEASE;
+    }
+
+    while (nSamples > 0)
+    {
+        if (segment == ENV_IDLE || segment == ENV_SUSTAIN)  break;  // constant level
+
+        runLength = nSamples;
+        if (count < (uint32) nSamples)  runLength = (int) count;   // segment ends in block
+
+        if (segment == ENV_ATTACK)  // Attack - linear ramp up to peak
+        {
+            if ((int64) level + (int64) step * runLength > peak)  level = peak;
+            else  level += step * runLength;
+        }
+        else if (segment == ENV_DECAY || segment == ENV_RELEASE)  // exponential ramp down
+        {
+            target = (segment == ENV_DECAY) ? pVoice->AmpldEnvSustain : 0;
+            if (runLength == AUDIO_BLOCK_SIZE)
+            {
+                coeff = (segment == ENV_DECAY) ? m_AmpldDecayBlkCoeff : m_AmpldReleaseBlkCoeff;
+                level += (int32) (((int64) (target - level) * coeff) >> 31);
+            }
+            else  // partial block
+            {
+                coeff = (segment == ENV_DECAY) ? m_AmpldDecayCoeff : m_AmpldReleaseCoeff;
+                for (isam = 0;  isam < runLength;  isam++)
+                    level += (int32) (((int64) (target - level) * coeff) >> 31);
+            }
+        }
+        // else Peak-Hold - constant level
+
+        nSamples -= runLength;
+        count -= (uint32) runLength;
+        if (count != 0)  break;   // segment continues in next block
 
-        // Reverberation effect (Courtesy of Dan Mitchell, ref. "BasicSynth")
-        if (m_RvbMix != 0)  
+        switch (segment)  // Segment time ended -- go to next segment
         {
-            reverbOut = MultiplyFixed(ReverbDelayLine[rvbIndex], m_RvbDecay);
-            reverbLPF = (reverbOut + reverbPrev) >> 1;  // simple low-pass filter
-            reverbPrev = reverbOut;
-            ReverbDelayLine[rvbIndex] = ((attenOut * m_RvbAtten) >> 7) + reverbLPF;
-            if (++rvbIndex >= m_RvbDelayLen)  rvbIndex = 0;  // wrap
-            // Add reverb output to dry signal according to reverb mix setting...
-            finalOutput = (attenOut * (128 - m_RvbMix)) >> 7;  // Dry portion
-            finalOutput += (reverbOut * m_RvbMix) >> 7;   // Wet portion
+        case ENV_ATTACK:
+            level = peak;
+            if (m_AmpldPeakSamples == 0)  segment = ENV_SUSTAIN;  // skip peak and decay
+            else
+            {
+                count = m_AmpldPeakSamples;
+                segment = ENV_PEAK_HOLD;
+            }
+            break;
+        case ENV_PEAK_HOLD:
+            count = m_AmpldDecaySamples;
+            segment = ENV_DECAY;
+            break;
+        case ENV_DECAY:
+            level = pVoice->AmpldEnvSustain;
+            segment = ENV_SUSTAIN;
+            break;
+        case ENV_RELEASE:
+            level = 0;
+            segment = ENV_IDLE;
+            break;
         }
-        else  finalOutput = attenOut;
     }
 
-    // PWM DAC output... Update OC4 duty register (range 1..1999)
-    PWM_AUDIO_DAC_WRITE(1000 + (int)(finalOutput >> 10));
-    
-#ifdef SYNTH_MK3_MX440_MAM  // SPI DAC output (12 bits)
-    spiDACdata = (uint16)(2000 + (int)(finalOutput >> 9));  // range 0..4000
-    SPI_Lock(2);
-    SPI_DAC_CS_LOW();
-    SPI_Transfer(2, 0x30 | HI_BYTE(spiDACdata));
-    SPI_Transfer(2, LO_BYTE(spiDACdata));
-    SPI_DAC_CS_HIGH();
-    SPI_UnLock(2);
-#endif
+    pVoice->AmpldEnvLevel = level;
+    pVoice->AmpldEnvPeak = peak;
+    pVoice->AmpldEnvStep = step;
+    pVoice->AmpldEnvCount = count;
+    pVoice->AmpldEnvSegment = segment;
+    pVoice->AmpldEnvOutput = level >> 10;
+}
 
-    READ_CPU_CORE_COUNT_REG(CC_Reg);
-    v_ISRexecTime = CC_Reg - entryTime;
-    IFS0bits.T2IF = 0;         // Clear the IRQ
+
+/*
+ * Function:     Initialize a control parameter ramp at a given value (ramp complete).
+ *
+ * Entry args:   pRamp  = pointer to ramp
+ *               value  = initial value (also the target)
+ *               length = ramp duration (samples), i.e. the control variable update period
+ */
+PRIVATE  void  RampParamInit(RampParam_t *pRamp, int32 value, uint16 length)
+{
+    pRamp->Value = value;
+    pRamp->Step = 0;
+    pRamp->Target = value;
+    pRamp->Length = length;
+    pRamp->Count = 0;
+}
+
+
+/*
+ * Function:     Set up a control parameter ramp for the next nSamples to be rendered.
+ *
+ * Entry args:   pRamp    = pointer to ramp
+ *               target   = present value of the control variable
+ *               nSamples = number of samples in the block (or segment) to be rendered
+ *
+ * If the control variable has changed since the last call, a new ramp is started from the
+ * current (interpolated) value, lasting one control update period.  If the ramp ends within
+ * the block, the step is adjusted so that the target is reached at the end of the block,
+ * so the renderer can add the same step to the value for every sample in the block.
+ * The division is done only when a ramp starts or ends, not every block.
+ */
+PRIVATE  void  RampParamBegin(RampParam_t *pRamp, int32 target, int nSamples)
+{
+    if (target != pRamp->Target)  // Control variable updated
+    {
+        pRamp->Target = target;
+        pRamp->Count = pRamp->Length;
+        pRamp->Step = (target - pRamp->Value) / (int32) pRamp->Length;
+    }
+
+    if (pRamp->Count > nSamples)  pRamp->Count -= nSamples;
+    else if (pRamp->Count != 0)   // Ramp ends in this block
+    {
+        pRamp->Step = (target - pRamp->Value) / nSamples;
+        pRamp->Count = 0;
+    }
+    else  pRamp->Step = 0;        // Ramp complete -- value is constant
 }
 
 
 /*
- * Function:  Timer_3 interrupt service routine (ISR)
+ * Function:     Save the value of a control parameter ramp at the end of a block.
+ *               When the ramp is complete, the value is set exactly to the target,
+ *               to remove the residual error due to integer division of the step.
+ */
+PRIVATE  void  RampParamEnd(RampParam_t *pRamp, int32 value)
+{
+    if (pRamp->Count == 0)  pRamp->Value = pRamp->Target;
+    else  pRamp->Value = value;
+}
+
+
+/*`````````````````````````````````````````````````````````````````````````````````````````````````
+ * Function:  Wave-table oscillator block kernel.
+ *
+ * Renders nSamples of a wave-table oscillator into oscBuf[] (normalized fixed-point).
+ * The phase accumulator (*pAngle) and step are 16:16 fixed-point table indexes; period
+ * is the table size (samples) in the same format.  The updated phase is returned via pAngle.
+ *
+ * The interpolation mode is tested once per block, so that each inner loop is a simple,
+ * branch-free (except for phase wrap) sequence which the compiler can unroll.
+ *   OSC_INTERP_TRUNCATE:  Table index is truncated -- cheapest; adds distortion where the
+ *                         table is small relative to the pitch period (low notes).
+ *   OSC_INTERP_LINEAR:    Linear interpolation between adjacent samples (15-bit fraction).
+ *   OSC_INTERP_HERMITE:   4-point, 3rd-order Hermite (Catmull-Rom) interpolation using a
+ *                         12-bit fraction, which keeps all intermediate terms within 32 bits.
+ */
+PRIVATE  void  OscWaveRenderBlock(fixed_t *oscBuf, int nSamples, int16 *table, int32 period,
+                                  int32 *pAngle, int32 step, uint8 interpMode)
+{
+    int32   angle = *pAngle;
+    int     size = period >> 16;    // table size (samples)
+    int     isam, idx, idxPrev, idxNext, idxNext2;
+    int32   frac;                   // fractional part of angle
+    int32   xm1, x0, x1, x2;        // table samples at idx-1, idx, idx+1, idx+2
+    int32   c1, c2, c3;             // Hermite polynomial coefficients
+    int32   poly;                   // Hermite polynomial, less constant term
+
+    if (interpMode == OSC_INTERP_LINEAR)
+    {
+        for (isam = 0;  isam < nSamples;  isam++)
+        {
+            idx = angle >> 16;
+            idxNext = idx + 1;
+            if (idxNext == size)  idxNext = 0;
+            frac = (angle & 0xFFFF) >> 1;   // 15-bit fraction
+            x0 = table[idx];
+            x1 = table[idxNext];
+            oscBuf[isam] = (x0 << 5) + (((x1 - x0) * frac) >> 10);  // normalize
+            angle += step;
+            if (angle >= period)  angle -= period;
+        }
+    }
+    else if (interpMode == OSC_INTERP_HERMITE)
+    {
+        for (isam = 0;  isam < nSamples;  isam++)
+        {
+            idx = angle >> 16;
+            idxPrev = (idx == 0) ? (size - 1) : (idx - 1);
+            idxNext = idx + 1;
+            if (idxNext == size)  idxNext = 0;
+            idxNext2 = idxNext + 1;
+            if (idxNext2 == size)  idxNext2 = 0;
+            frac = (angle & 0xFFFF) >> 4;   // 12-bit fraction
+            xm1 = table[idxPrev];
+            x0 = table[idx];
+            x1 = table[idxNext];
+            x2 = table[idxNext2];
+            c1 = (x1 - xm1) >> 1;
+            c2 = xm1 - ((5 * x0) >> 1) + (x1 << 1) - (x2 >> 1);
+            c3 = ((x2 - xm1) >> 1) + ((3 * (x0 - x1)) >> 1);
+            poly = ((((c3 * frac) >> 12) + c2) * frac) >> 12;
+            oscBuf[isam] = (x0 << 5) + (((poly + c1) * frac) >> 7);  // normalize
+            angle += step;
+            if (angle >= period)  angle -= period;
+        }
+    }
+    else  // OSC_INTERP_TRUNCATE
+    {
+        for (isam = 0;  isam < nSamples;  isam++)
+        {
+            idx = angle >> 16;  // integer part of angle
+            oscBuf[isam] = (fixed_t) table[idx] << 5;  // normalize
+            angle += step;
+            if (angle >= period)  angle -= period;
+        }
+    }
+
+    *pAngle = angle;
+}
+
+
+/*`````````````````````````````````````````````````````````````````````````````````````````````````
+ * Function:  "Pure Sawtooth" oscillator block kernel.
  *
- * Overview:  The ISR handles any task(s) which must be executed
- *            synchronously with the Timer_3 rollover (period).
+ * Renders nSamples of a ramp waveform into oscBuf[].  The ramp is restarted at the negative
+ * peak amplitude whenever the phase accumulator reaches the end of its period.
+ * The updated ramp amplitude and phase are returned via pAmpld and pAngle.
  */
-void __ISR(_TIMER_3_VECTOR, IPL5AUTO)  Timer_3_IRQService(void)
+PRIVATE  void  OscSawRenderBlock(fixed_t *oscBuf, int nSamples, fixed_t *pAmpld, fixed_t incr,
+                                 int32 *pAngle, int32 step, int32 period)
 {
-    IFS0bits.T3IF = 0;
+    fixed_t  ampld = *pAmpld;
+    int32    angle = *pAngle;
+    int      isam;
+
+    for (isam = 0;  isam < nSamples;  isam++)
+    {
+        oscBuf[isam] = ampld;
+        ampld += incr;
+        angle += step;
+        if (angle >= period)
+        {
+            angle = 0;
+            ampld = 0 - m_SawtoothPeakAmpld;
+        }
+    }
+
+    *pAmpld = ampld;
+    *pAngle = angle;
 }
 
 
@@ -1297,6 +3120,34 @@ bool  isNoteOn()
     return  (m_Note_ON != 0);
 }
 
+/*
+ * Function:     Get the number of voices currently active (sounding), incl. voices
+ *               in the release phase.
+ */
+int  GetActiveVoiceCount(void)
+{
+    int  v, count = 0;
+
+    for (v = 0;  v < SYNTH_VOICES_MAX;  v++)
+    {
+        if (m_Voice[v].Active)  count++;
+    }
+
+    return  count;
+}
+
+/*
+ * Function:     Get audio output level of a given voice (normalized fixed-point).
+ *               Returns 0 if the voice number is invalid or the voice is inactive.
+ */
+fixed_t  GetVoiceOutputLevel(int voice)
+{
+    if (voice < 0 || voice >= SYNTH_VOICES_MAX)  return 0;
+    if (!m_Voice[voice].Active)  return 0;
+
+    return  m_Voice[voice].OutputLevel;
+}
+
 /*
  * Function:     Get pointer to active patch table.
  */
@@ -1318,13 +3169,9 @@ int  GetActivePatchID()
  */
 int  GetTableIndexOfPatchID(uint16 patchID)
 {
-    short  i;
-    int    patch_idx = 0;
+    int    patch_idx = PatchIndexFind(patchID);
     
-    for (i = 0;  i < GetNumberOfPatchesDefined();  i++)
-    {
-        if (g_PatchProgram[i].PatchNumber == patchID)  { patch_idx = i;  break; }
-    }
+    if (patch_idx < 0)  patch_idx = 0;
     
     return  patch_idx;
 }
@@ -1351,6 +3198,20 @@ int  GetActiveWaveTable(void)
 void  WaveTableSizeSet(uint16 size)
 {
     g_Osc1WaveTableSize = size;
+    m_UserWaveValid = FALSE;
+    WaveMipmapPrepare();   // Rebuild band-limited versions of the modified table
+}
+
+/*
+ * Function:     Signal that the user wave-table buffer may have been over-written, so that
+ *               it is regenerated from the user waveform descriptor by the next call to
+ *               SynthPatchSelect() for a patch which uses it.
+ *
+ * Note:         Function intended for use by wave-table creator utility only.
+ */
+void  UserWaveTableInvalidate(void)
+{
+    m_UserWaveValid = FALSE;
 }
 
 /*
@@ -1418,6 +3279,73 @@ int  GetReverbMixSetting(void)
     return  m_RvbMix;
 }
 
+/*
+ * Function:     Get the number of scheduled synth events lost because the event queue
+ *               was full.  Intended primarily for test and debug purposes.
+ */
+int  GetSynthEventOverflows(void)
+{
+    return  m_EventQueueOverflows;
+}
+
+
+/*`````````````````````````````````````````````````````````````````````````````````````````````````
+ * Function:     ProfileRecord()
+ *
+ * Overview:     Adds an execution time measurement to the statistics of a profiling stage:
+ *               running minimum, maximum and mean, plus a log2 histogram, so that rare
+ *               worst-case times (e.g. render overruns) can be found in normal operation.
+ *
+ * Entry args:   stage  = profiling stage, PROFILE_xxx (see remi_synth_def.h)
+ *               counts = execution time measured (core timer counts, 40 per us)
+ *
+ * Each stage must be recorded from one task or ISR context only.  The audio render ISR
+ * records the render stages;  SynthProcess() records its own execution time, which
+ * includes the time taken by any render ISR which pre-empted it.
+ */
+void  ProfileRecord(uint8 stage, uint32 counts)
+{
+    ProfileStage_t  *pStage;
+    uint32  value = counts;
+    int     bin = 0;
+
+    if (stage >= PROFILE_NUM_STAGES)  return;
+    pStage = &m_Profile[stage];
+
+    while ((value >>= 1) != 0 && bin < (PROFILE_HIST_BINS - 1))  bin++;  // floor(log2)
+
+    if (pStage->Count == 0 || counts < pStage->Min)  pStage->Min = counts;
+    if (counts > pStage->Max)  pStage->Max = counts;
+    pStage->Total += counts;
+    pStage->Count++;
+    pStage->Hist[bin]++;
+}
+
+
+/*
+ * Function:     Clear the statistics of all profiling stages.
+ *
+ * The caller should hold off the audio render IRQ while the profile is reset.
+ */
+void  ProfileReset(void)
+{
+    memset(m_Profile, 0, sizeof(m_Profile));
+}
+
+
+/*
+ * Function:     Copy the statistics of a given profiling stage into a caller's structure.
+ *
+ * The caller should hold off the audio render IRQ while the copy is made, so that the
+ * statistics are consistent.
+ */
+void  ProfileGetStage(uint8 stage, ProfileStage_t *pStats)
+{
+    if (stage >= PROFILE_NUM_STAGES)  return;
+
+    memcpy(pStats, &m_Profile[stage], sizeof(ProfileStage_t));
+}
+
 /*
  * Function:     Set Vibrato (Osc. FM) control mode temporarily.
  * 
@@ -1437,27 +3365,146 @@ uint8  GetVibratoMode(void)
     return  (uint8) m_VibratoControl;
 }
 
+
 /*
- * Function:     Set bi-quad filter resonant frequency (filterIndex) temporarily.
- *               Called by diagnostic routines only.
- * 
- * Note:    <!>  filterIndex is restored to that defined by the active Preset
- *               whenever an Instrument Preset is selected.
- * 
- * Input arg:    freqIndex = index into filter coeff. LUT (0..108)
+ * Function:     Set the waveform and frequency of an LFO.
+ *
+ * Entry args:   lfo = LFO number (1..MOD_LFO_COUNT)
+ *               waveform = LFO_WAVE_xxx (0:Sine, 1:Triangle, 2:Square, 3:Sample-Hold)
+ *               freq_x10 = LFO freq * 10 Hz;  range 1..250 => 0.1 to 25 Hz
+ *
+ * Return val:   ERROR if any arg is out of range, else SUCCESS.
+ *
+ * Note:    <!>  LFO1 frequency is restored to the patch param (LF) whenever the
+ *               modulation routing is rebuilt from the patch.
+ */
+int  SynthLfoSetup(int lfo, uint8 waveform, uint8 freq_x10)
+{
+    SynthLFO_t  *pLFO;
+
+    if (lfo < 1 || lfo > MOD_LFO_COUNT || waveform > LFO_WAVE_SAMPLE_HOLD || freq_x10 == 0)
+        return  ERROR;
+
+    pLFO = &m_LFO[lfo - 1];
+    pLFO->Waveform = waveform;
+    pLFO->Freq_x10 = freq_x10;
+    pLFO->Step = (((int32) freq_x10 << 8) * SINE_WAVE_TABLE_SIZE) / 2000;  // LFO Fs = 200Hz
+
+    return  SUCCESS;
+}
+
+/*
+ * Function:     Return a pointer to the state of an LFO (1..MOD_LFO_COUNT), or NULL.
+ */
+SynthLFO_t  *GetSynthLfo(int lfo)
+{
+    if (lfo < 1 || lfo > MOD_LFO_COUNT)  return  NULL;
+
+    return  &m_LFO[lfo - 1];
+}
+
+/*
+ * Function:     Set (modify or append) a route in the modulation matrix.
+ *
+ * Entry args:   slot   = route index (0..MOD_ROUTES_MAX-1);  if slot is beyond the last
+ *                        route in use, the route is appended to the table.
+ *               source = modulation source (MOD_SRC_xxx)
+ *               scaler = source by which the modulation is multiplied (MOD_SRC_NONE: x1)
+ *               dest   = destination (MOD_DST_xxx)
+ *               depth  = output per unit of source, in destination units (fixed-pt)
+ *
+ * Return val:   ERROR if any arg is out of range, else SUCCESS.
+ *
+ * Note:    <!>  Routes set by this function are replaced whenever the modulation routing
+ *               is rebuilt from the patch, e.g. when a patch is selected.
+ */
+int  ModMatrixSetRoute(int slot, uint8 source, uint8 scaler, uint8 dest, fixed_t depth)
+{
+    int  i;
+
+    if (slot < 0 || slot >= MOD_ROUTES_MAX || source >= MOD_NUM_SOURCES
+    ||  scaler >= MOD_NUM_SOURCES || dest >= MOD_NUM_DESTS)  return  ERROR;
+
+    AUDIO_RENDER_IRQ_DISABLE();
+    if (slot > m_ModRouteCount)  slot = m_ModRouteCount;
+    if (slot == m_ModRouteCount)  m_ModRouteCount++;
+    m_ModRoute[slot].Source = source;
+    m_ModRoute[slot].Scaler = scaler;
+    m_ModRoute[slot].Dest = dest;
+    m_ModRoute[slot].Depth = depth;
+
+    m_PitchModEnabled = FALSE;
+    for (i = 0;  i < m_ModRouteCount;  i++)
+    {
+        if (m_ModRoute[i].Dest == MOD_DST_PITCH)  m_PitchModEnabled = TRUE;
+    }
+    AUDIO_RENDER_IRQ_ENABLE();
+
+    return  SUCCESS;
+}
+
+/*
+ * Function:     Delete a route from the modulation matrix.  Following routes move down.
+ *
+ * Return val:   ERROR if the given slot is not in use, else SUCCESS.
+ */
+int  ModMatrixDeleteRoute(int slot)
+{
+    int  i;
+
+    if (slot < 0 || slot >= m_ModRouteCount)  return  ERROR;
+
+    AUDIO_RENDER_IRQ_DISABLE();
+    m_ModRouteCount--;
+    for (i = slot;  i < m_ModRouteCount;  i++)  m_ModRoute[i] = m_ModRoute[i + 1];
+
+    m_PitchModEnabled = FALSE;
+    for (i = 0;  i < m_ModRouteCount;  i++)
+    {
+        if (m_ModRoute[i].Dest == MOD_DST_PITCH)  m_PitchModEnabled = TRUE;
+    }
+    AUDIO_RENDER_IRQ_ENABLE();
+
+    return  SUCCESS;
+}
+
+/*
+ * Function:     Return a pointer to a route in the modulation matrix, or NULL if the
+ *               given slot is not in use.
+ */
+ModRoute_t  *ModMatrixGetRoute(int slot)
+{
+    if (slot < 0 || slot >= m_ModRouteCount)  return  NULL;
+
+    return  &m_ModRoute[slot];
+}
+
+/*
+ * Function:     Set the base value of a modulation matrix destination, i.e. the value of
+ *               the destination control with no modulation (destination units, fixed-pt).
+ */
+void  ModMatrixSetBase(uint8 dest, fixed_t value)
+{
+    if (dest < MOD_NUM_DESTS)  m_ModBase[dest] = value;
+}
+
+/*
+ * Function:     Get the base value of a modulation matrix destination.
  */
-void  SetFilterFreqIndex(uint8 freqIndex)
+fixed_t  ModMatrixGetBase(uint8 dest)
 {
-//  if (freqIndex <= 108)  filterIndex = freqIndex;  //>
+    if (dest >= MOD_NUM_DESTS)  return  0;
+
+    return  m_ModBase[dest];
 }
 
 /*
- * Function:     Get bi-quad filter resonant frequency (filterIndex)
- *               Called by diagnostic routines only.
+ * Function:     Restore the default modulation routing, as determined by the patch.
  */
-uint8  GetFilterFreqIndex()
+void  ModMatrixRestore(void)
 {
-//  return  filterIndex;
+    m_ModMatrixValid = FALSE;
+    ModMatrixPrepare();
 }
 
 
@@ -21,8 +21,8 @@
  */
 #include "remi_synth_main.h"
 
-PRIVATE  void   ProcessMidiMessage(uint8 *midiMessage, short msgLength); 
-PRIVATE  void   ProcessControlChange(uint8 *midiMessage);
+PRIVATE  void   ProcessMidiMessage(uint8 *midiMessage, short msgLength, uint32 sampleTime); 
+PRIVATE  void   ProcessControlChange(uint8 *midiMessage, uint32 sampleTime);
 PRIVATE  void   ProcessMidiSystemExclusive(uint8 *midiMessage, short msgLength);
 PRIVATE  void   MidiInputMonitor(uint8 *midiMessage, short msgLength);
 
@@ -108,6 +108,7 @@ void  Init_Application(void)
         putstr("! Error reading EEPROM Config data - Loading defaults.\n");
         DefaultConfigData();
     }
+    ValidateConfigData();
 
     if (CheckPresetData() == FALSE)    // Read Preset data from EEPROM
     {
@@ -168,18 +169,30 @@ int  main(void)
  *      2. while CLI "watch" function is executing (see Cmnd_watch() in "console_cli.c").
  *
  * Some (asynchronous) background task functions are called as frequently as possible;
- * e.g. MidiInputService(), ReadAnalogInputs().  
+ * e.g. ReadAnalogInputs().  MidiInputService() runs at the start of each 1ms tick.
+ * PersistentDataService() runs at the end of the tick, when the synth control work
+ * is done;  it writes at most one EEPROM page per tick and never waits for the EEPROM.
+ * When MIDI OUT is enabled (by CLI or GUI), the MIDI OUT queue and running status are
+ * reset, so the first message sent is complete.
  */
 void  BackgroundTaskExec()
 {
-    MidiInputService();
+    static  bool  midiOutWasEnabled = FALSE;
+
     ReadAnalogInputs();
        
-    if (g_Config.MidiOutEnabled)  MidiOutputQueueHandler();
+    if (g_Config.MidiOutEnabled)
+    {
+        if (!midiOutWasEnabled)  MIDI_OutputFlush();
+        MIDI_OutputService();
+    }
+    midiOutWasEnabled = (g_Config.MidiOutEnabled != 0);
         
     if (isTaskPending_1ms())  // Do 1ms periodic task(s)
     {
+        MidiInputService();  // Drain MIDI IN event queue
         SynthProcess();
+        PersistentDataService();  // Deferred EEPROM writes (non-blocking)
         g_TaskRunningCount++;
     }
 
@@ -206,6 +219,8 @@ void  BackgroundTaskExec()
  *               number to external MIDI device (via MIDI OUT).
  *               The Preset defines the REMI synth Patch number and MIDI control modes.
  *               Preset parameters are stored in the I2C EEPROM.
+ *               The Preset selection is saved by a deferred (write-behind) EEPROM write,
+ *               so the function does not wait for the EEPROM.
  *
  * Entry args:   preset = PRESET number (0..7 or 8 == 0)
  *               NB: The user interface displays preset 0 as preset 8.
@@ -219,8 +234,8 @@ void  InstrumentPresetSelect(uint8 preset)
     g_Config.PresetLastSelected = preset;  
     StoreConfigData();   // Save this Preset for next power-on/reset
 
-    // Load and activate the REMI synth patch assigned to this Preset:
-    SynthPatchSelect(g_Preset.Descr[preset].PatchNumber);
+    // Load and activate the REMI synth patch assigned to this Preset (crossfaded):
+    SynthPatchTransition(g_Preset.Descr[preset].PatchNumber);
     
     // If this Preset's MIDI program # is non-zero, send it to the MIDI OUT port:
     if (g_Config.MidiOutEnabled)
@@ -232,93 +247,113 @@ void  InstrumentPresetSelect(uint8 preset)
 
 
 /*^
- * Function:  MidiInputService()
+ * Function:  MidiInputReadyHandler()
+ *
+ * Called when data received on the MIDI IN port is ready to be read from the UART1 RX
+ * buffer (see UART1_RX_READY_HANDLER in UART_drv.h) -- by the UART1 RX ISR, or with RX
+ * DMA, by the 1ms RTI if any bytes are unread, or by the DMA ISR during a long burst.
+ * The data is read in place (no copy).  If the MIDI IN monitor (diagnostic) is active,
+ * the bytes are written in the monitor buffer.  The bytes are then passed to the MIDI IN
+ * parser, which puts each complete message into the MIDI IN event queue, timestamped
+ * with the synth engine sample clock.  If any data has been lost (UART overrun, framing
+ * error or RX buffer full), the parser is resynchronized first (running status cleared).
  *
- * MIDI IN service routine, executed frequently from within main loop.
- * This routine monitors the MIDI INPUT stream and whenever a complete message is 
- * received, it is processed.
+ * With RX DMA, the bytes are passed on up to 1ms after arrival, so each byte is dated
+ * back from now by one MIDI byte time (12.8 samples at 40kHz, 31250 baud) for each byte
+ * received after it, i.e. as if the last byte had just arrived.  This keeps the timing
+ * within a burst, but an isolated message may be dated up to 1ms late.
  */
-void  MidiInputService()
+void  MidiInputReadyHandler(void)
 {
-    static  uint8  midiMessage[MIDI_MSG_MAX_LENGTH];
-    static  short  msgBytesExpected;
-    static  short  msgByteCount;
-    static  short  msgIndex;
-    static  uint8  msgStatus;     // last command/status byte rx'd
-    static  bool   msgComplete;   // flag: got msg status & data set
-    
-    uint8   msgByte;
-    uint8   msgChannel;  // 1..16 !
-    BOOL    gotSysExMsg = FALSE;
-    
-    if (UART1_RxDataAvail())    // unread byte(s) available in Rx buffer
+    const uint8  *rxData;
+    uint32  timestamp = SynthSampleClock();
+    int     count, i;
+#if UART1_RX_USING_DMA
+    uint32  now = timestamp;
+    uint32  byteTime_x16 = SynthSampleRate() * 160 / g_Config.MidiInBaudrate;  // 10 bits
+    int     unread = UART1_RxUnreadCount();  // bytes received up to now
+#endif
+
+    if (UART1_RxErrorCheck())  MIDI_ParserResync();  // Bytes lost -- discard stale status
+
+    while ((count = UART1_RxPeekSpan(&rxData)) != 0)
     {
-        msgByte = UART1_getch();
-        
-        // If MIDI IN monitor (diagnostic) is active, write msgByte in circular buffer.
-        // Ignore real-time system messages (0xF8..0xFF)
-        if (g_MidiInputMonitorActive && msgByte <= SYSTEM_MSG_EOX)  
-        {
-            g_MidiInputBuffer[g_MidiInWriteIndex++] = msgByte;
-            if (g_MidiInWriteIndex >= MIDI_MON_BUFFER_SIZE) 
-                g_MidiInWriteIndex = 0;  // wrap
-            g_MidiInputByteCount++;  
-        }
-        
-        if (msgByte & 0x80)  // command/status byte received (bit7 High)
+#if UART1_RX_USING_DMA
+        if (count > unread)  count = unread;  // leave bytes received since entry
+        if (count == 0)  break;
+#endif
+
+        if (g_MidiInputMonitorActive)  
         {
-            if (msgByte == SYSTEM_MSG_EOX)  
+            for (i = 0;  i < count;  i++)
             {
-                msgComplete = TRUE;
-                gotSysExMsg = TRUE;
-                midiMessage[msgIndex++] = SYSTEM_MSG_EOX;
-                msgByteCount++;
+                if (rxData[i] > SYSTEM_MSG_EOX)  continue;  // Ignore real-time messages
+                g_MidiInputBuffer[g_MidiInWriteIndex++] = rxData[i];
+                if (g_MidiInWriteIndex >= MIDI_MON_BUFFER_SIZE) 
+                    g_MidiInWriteIndex = 0;  // wrap
+                g_MidiInputByteCount++;  
             }
-            else if (msgByte <= SYS_EXCLUSIVE_MSG)  // Regular command (not RTC, etc)
-            {
-                msgStatus = msgByte;
-                msgComplete = FALSE;  // expecting data byte(s))
-                midiMessage[0] = msgStatus;
-                msgIndex = 1;
-                msgByteCount = 1;  // have cmd already
-                msgBytesExpected = MIDI_GetMessageLength(msgStatus);
-            }
-            // otherwise ignore command/status byte
         }
-        else    // data byte received (bit7 LOW)
+
+#if UART1_RX_USING_DMA
+        for (i = 0;  i < count;  i++)  // one byte at a time, each with its own timestamp
         {
-            if (msgComplete && msgStatus != SYS_EXCLUSIVE_MSG)  
-            {
-                // already processed complete message -- data repeating without command
-                if (msgByteCount == 0)  // start of new data set 
-                {
-                    msgIndex = 1;
-                    msgByteCount = 1;
-                    msgBytesExpected = MIDI_GetMessageLength(msgStatus);
-                }
-            }
-            if (msgIndex < MIDI_MSG_MAX_LENGTH)
-            {
-                midiMessage[msgIndex++] = msgByte;
-                msgByteCount++;
-            }
+            unread--;  // = number of bytes received after this one
+            timestamp = now - (unread * byteTime_x16) / 16;
+            MIDI_ParserInput(&rxData[i], 1, timestamp);
         }
-        
-        if ((msgByteCount != 0 && msgByteCount == msgBytesExpected) || gotSysExMsg)    
+#else
+        MIDI_ParserInput(rxData, count, timestamp);
+#endif
+        UART1_RxConsume(count);
+    }
+}
+
+
+/*^
+ * Function:  MidiInputService()
+ *
+ * MIDI IN service routine, executed at the start of each 1ms synth control tick, just
+ * ahead of SynthProcess().  All events in the MIDI IN event queue are processed, in the
+ * order received.  Messages are parsed in interrupt context (MidiInputReadyHandler),
+ * so a burst of MIDI IN data (e.g. breath controller CC's) does not hold up the main loop.
+ *
+ * Note and controller events for the synth are scheduled to be applied by the block
+ * renderer at the sample given by the message timestamp plus a fixed latency,
+ * SynthEventLatency() (1.5ms), which covers the delay until the message is serviced here.
+ * Hence the timing of MIDI IN events is reproduced to the resolution of the timestamp,
+ * i.e. one MIDI byte time with a UART RX interrupt (default), or up to 1ms for an
+ * isolated message with UART RX DMA (see MidiInputReadyHandler).
+ */
+void  MidiInputService()
+{
+    MidiEvent_t  event;
+    uint8   midiMessage[MIDI_MSG_MAX_LENGTH];
+    uint8   msgChannel;  // 1..16 !
+    short   msgLength;
+
+    while (MIDI_GetEvent(&event))
+    {
+        if (event.Status == SYS_EXCLUSIVE_MSG)
         {
-            msgComplete = TRUE;
-            msgChannel = (midiMessage[0] & 0x0F) + 1;  // 1..16
-            
-            if (msgChannel == g_Config.MidiInChannel 
-            ||  g_Config.MidiInMode == OMNI_ON_MONO
-            ||  msgStatus == SYS_EXCLUSIVE_MSG)
-            {
-                ProcessMidiMessage(midiMessage, msgByteCount); 
-                msgBytesExpected = 0;   // maybe redundant ?
-                msgByteCount = 0;
-                msgIndex = 0;
-            }
+            msgLength = MIDI_GetSysExMessage(midiMessage);
+            if (msgLength == 0)  continue;
+        }
+        else  // Channel message
+        {
+            msgChannel = (event.Status & 0x0F) + 1;  // 1..16
+
+            if (msgChannel != g_Config.MidiInChannel 
+            &&  g_Config.MidiInMode != OMNI_ON_MONO
+            &&  g_Config.MidiInMode != OMNI_ON_POLY)  continue;  // not for us
+
+            midiMessage[0] = event.Status;
+            midiMessage[1] = event.Data1;
+            midiMessage[2] = event.Data2;
+            msgLength = event.Length;
         }
+
+        ProcessMidiMessage(midiMessage, msgLength, event.Timestamp + SynthEventLatency());
     }
 }
 
@@ -329,8 +364,9 @@ void  MidiInputService()
  * This function processes a complete MIDI message when received.
  * The message is analysed to determine what actions are required.
  * Both the REMI built-in synth and external 'MIDI OUT' device(s) are controlled.
+ * Synth note and controller events are scheduled at the given sample clock value.
  */
-PRIVATE  void  ProcessMidiMessage(uint8 *midiMessage, short msgLength)
+PRIVATE  void  ProcessMidiMessage(uint8 *midiMessage, short msgLength, uint32 sampleTime)
 {
     uint8  statusByte = midiMessage[0] & 0xF0;
     uint8  channel = g_Config.MidiOutChannel;
@@ -340,7 +376,7 @@ PRIVATE  void  ProcessMidiMessage(uint8 *midiMessage, short msgLength)
         case NOTE_OFF_CMD:
         {
             uint8  noteNumber = midiMessage[1];
-            SynthNoteOff(noteNumber);
+            SynthPostEvent(SYNTH_EVENT_NOTE_OFF, noteNumber, 0, sampleTime);
             if (g_Config.MidiOutEnabled) MIDI_SendNoteOff(channel, noteNumber);
             m_NotePlaying = FALSE;
             break;
@@ -351,12 +387,12 @@ PRIVATE  void  ProcessMidiMessage(uint8 *midiMessage, short msgLength)
             uint8  velocity = midiMessage[2];
             if (velocity == 0)  
             {
-                SynthNoteOff(noteNumber);
+                SynthPostEvent(SYNTH_EVENT_NOTE_OFF, noteNumber, 0, sampleTime);
                 m_NotePlaying = FALSE;
             }
             else 
             {
-                SynthNoteOn(noteNumber, velocity);
+                SynthPostEvent(SYNTH_EVENT_NOTE_ON, noteNumber, velocity, sampleTime);
                 m_NotePlaying = TRUE;
             }
 
@@ -366,7 +402,7 @@ PRIVATE  void  ProcessMidiMessage(uint8 *midiMessage, short msgLength)
         }
         case CONTROL_CHANGE_CMD:  // same for MODE CHANGE CMD
         {
-            ProcessControlChange(midiMessage);
+            ProcessControlChange(midiMessage, sampleTime);
             break;
         }
         case PROGRAM_CHANGE_CMD:
@@ -381,10 +417,10 @@ PRIVATE  void  ProcessMidiMessage(uint8 *midiMessage, short msgLength)
         {
             uint8  leverPosn_Lo = midiMessage[1];  // PB lever position, 7 LS bits
             uint8  leverPosn_Hi = midiMessage[2];  // PB lever position, 7 MS bits
-            int16  bipolarPosn;
+            uint16  leverPosn;
             
-            bipolarPosn = ((int16)(leverPosn_Hi << 7) | leverPosn_Lo) - 0x2000;
-            SynthPitchBend(bipolarPosn);
+            leverPosn = ((uint16)(leverPosn_Hi << 7) | leverPosn_Lo);  // centre is 0x2000
+            SynthPostEvent(SYNTH_EVENT_PITCH_BEND, 0, leverPosn, sampleTime);
             break;
         }
         case SYS_EXCLUSIVE_MSG: 
@@ -399,7 +435,7 @@ PRIVATE  void  ProcessMidiMessage(uint8 *midiMessage, short msgLength)
 }
 
 
-PRIVATE  void  ProcessControlChange(uint8 *midiMessage)
+PRIVATE  void  ProcessControlChange(uint8 *midiMessage, uint32 sampleTime)
 {
     static  uint8  modulationHi = 0;  // High byte of CC data (7 bits)
     static  uint8  modulationLo = 0;  // Low byte  ..   ..
@@ -414,7 +450,7 @@ PRIVATE  void  ProcessControlChange(uint8 *midiMessage)
         pressureHi = midiMessage[2];
         pressureLo = 0;  // compliant with MIDI spec v4.2 (1995)
         data14 = (((int) pressureHi) << 7);
-        SynthExpression(data14);
+        SynthPostEvent(SYNTH_EVENT_EXPRESSION, 0, data14, sampleTime);
         midiCCnum = g_Config.MidiOutExpressionCCnum;
         if (g_Config.MidiOutEnabled) 
             MIDI_SendControlChange(channel, midiCCnum, pressureHi);
@@ -423,7 +459,7 @@ PRIVATE  void  ProcessControlChange(uint8 *midiMessage)
     {
         pressureLo = midiMessage[2];
         data14 = (((int) pressureHi) << 7) + pressureLo;
-        SynthExpression(data14);
+        SynthPostEvent(SYNTH_EVENT_EXPRESSION, 0, data14, sampleTime);
         midiCCnum = g_Config.MidiOutExpressionCCnum + 0x20;
         if (g_Config.MidiOutEnabled)
             MIDI_SendControlChange(channel, midiCCnum, pressureLo);
@@ -433,7 +469,7 @@ PRIVATE  void  ProcessControlChange(uint8 *midiMessage)
         modulationHi = midiMessage[2];
         modulationLo = 0;  // compliant with MIDI spec v4.2 (1995)
         data14 = (((int) modulationHi) << 7);
-        SynthModulation(data14);
+        SynthPostEvent(SYNTH_EVENT_MODULATION, 0, data14, sampleTime);
         if (g_Config.MidiOutEnabled)
             MIDI_SendControlChange(channel, 0x01, modulationHi);
     }
@@ -441,7 +477,7 @@ PRIVATE  void  ProcessControlChange(uint8 *midiMessage)
     {
         modulationLo = midiMessage[2];
         data14 = (((int) modulationHi) << 7) + modulationLo;
-        SynthModulation(data14);
+        SynthPostEvent(SYNTH_EVENT_MODULATION, 0, data14, sampleTime);
         if (g_Config.MidiOutEnabled)
             MIDI_SendControlChange(channel, 0x21, modulationLo);
     }
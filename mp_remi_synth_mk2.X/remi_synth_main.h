@@ -43,12 +43,6 @@
 #include <ctype.h>
 #include <math.h>
 
-#if UART1_TX_USING_QUEUE
-#define MidiOutputQueueHandler()  UART1_TxQueueHandler() 
-#else
-#define MidiOutputQueueHandler()  {}
-#endif
-
 #ifdef SYNTH_MK2_MX340_LITE
 #define POT_MODULE_CONNECTED  (FALSE)
 #else
@@ -91,6 +85,7 @@ enum  Self_test_categories
 // Public functions defined in "main_remi_synth2.c" ----------------------
 //
 void   MidiInputService();
+void   MidiInputReadyHandler(void);
 void   InstrumentPresetSelect(uint8 preset);
 bool   isLCDModulePresent();
 bool   isHandsetConnected();
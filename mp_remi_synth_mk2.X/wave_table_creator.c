@@ -18,6 +18,7 @@
 #include "wave_table_creator.h"
 
 #include <math.h>
+#include <ctype.h>
 
 // Supported wave shapes
 #define  SINE_WAVE       1
@@ -42,8 +43,6 @@ PRIVATE  void   DumpWaveTable(void);
 PRIVATE  int16  CalcWaveSample(uint8 wave_shape, int sample_point, int period);
 PRIVATE  void   ApplyAntiAliasFilter();
 PRIVATE  void   GenerateWaveTableFromDrawbars(int argCount, char *argVal[]);
-PRIVATE  void   GeneratePseudoRandomWave(int srlen, int fbbits, int init);
-PRIVATE  uint16 PseudoRandomSequence(uint8 srlen, uint16 seed, uint16 fbmask);
 
 
 // Private data...
@@ -56,7 +55,6 @@ static  uint16 AliasFilter_K;        // Filter time-constant (unit = sample intr
 static  bool   isTableEmpty;         // True when wave-table buffer is cleared
 static  bool   isPrepDone;           // True when 'wav' utility has been initialized
 static  bool   isHammond;            // True if last wave-table created by Hammond cmd
-static  int    previousWaveTable;    // Wave-table in use prior to using 'wav' utility
 static  int    previousPatch;        // Patch selected prior to using 'wav' utility
 static  uint8  drawbar_setting[10];  // Hammond drawbar settings (9 values each 0..8)
 
@@ -160,6 +158,8 @@ void  Cmnd_wav(int argCount, char * argVal[])
     if (argVal[1][0] == '-') option = tolower(argVal[1][1]);  // argCount > 1
     else  option = '$';
 
+    if (option != '$')  UserWaveTableInvalidate();  // Buffer may be over-written
+
     // One-time initialization on first use of 'wav' command, except option '-x'
     if (!isPrepDone && option != 'x' && option != '$')
     {
@@ -360,7 +360,7 @@ void  Cmnd_wav(int argCount, char * argVal[])
             g_Config.UserWaveform.Partial[i] = PartialAmpldHist[i];
         }
 
-        if (StoreConfigData())
+        if (StoreConfigData() && FlushPersistentData())
             putstr("* User Wave-table param's saved OK.\n");
         else  putstr("! Error: EEPROM write failed.\n");
         break;
@@ -708,7 +708,7 @@ PRIVATE  void  DumpWaveTable(void)
 {
     char   outBuf[80];
     int16  sample;
-    int    i, order, column = 0;
+    int    i, column = 0;
 
     // Print wave-table info as C comment block
     putstr("\n\n/* \n");
@@ -794,76 +794,6 @@ PRIVATE  void   GenerateWaveTableFromDrawbars(int argCount, char * argVal[])
 }
 
 
-/*`````````````````````````````````````````````````````````````````````````````````````````````````
- * Populate wave-table with pseudo-random sample valuess.
- */
-PRIVATE  void  GeneratePseudoRandomWave(int srlen, int fbbits, int init)
-{
-    int     i;
-	uint16  so;     // SR serial out (bit_0)
-	int16   sample;
-
-	if (srlen < 5) srlen = 5;
-	if (srlen > 15) srlen = 15;
-    if (init <= 0) init = 1;
-
-	PseudoRandomSequence(srlen, init, fbbits);  // Initialize the sequence
-
-    for (i = 0;  i < TableSize;  i++)
-    {
-		so = PseudoRandomSequence(srlen, 0, fbbits) & 1;
-		if (so == 0)  sample = -16000;  else sample = 16000;
-        WaveTableBuffer[i] = sample;
-    }
-}
-
-
-/*`````````````````````````````````````````````````````````````````````````````````````````````````
- * Pseudo-Random Sequence Generator using Shift-Register with Feedback.
- * Register length is variable, 5 to 15 bits, set by arg1 (srlen).
- * The register is "clocked" (shifted 1 bit posn) on each call.
- * To generate a binary sequence, use only bit_0 of the return value.
- *
- * Entry arg's: (uint8)  srlen  = shift-register length (5..15 bits)
- *
- *              (uint16) seed   = initial shiftreg data if non-zero (0..0x7FFF)
- *                                ... shiftreg unchanged if seed is zero.
- * 
- *              (uint16) fbmask = feedback bit mask (0..0x3FFF)
- *
- * Return val:  (uint16) Next number in sequence, unsigned integer
- */
-PRIVATE  uint16  PseudoRandomSequence(uint8 srlen, uint16 seed, uint16 fbmask)
-{
-    static  uint32  shiftreg;  // shift register (5..15 LS bits)
-    int     i;
-    uint32  exorbits;  // bits to be XOR'd together to feed shiftreg input (si)
-    uint32  si = 1;    // shiftreg serial input bit
-	uint32  carrybit = (1 << srlen);  // bit position of si in shiftreg
-
-    if (seed != 0)  // one-time initialization
-    {
-        shiftreg = (uint32) seed;
-    }
-    else  // normal running
-    {
-        exorbits = shiftreg & fbmask;
-
-        for (i = 0;  i < srlen;  i++)   // calculate si = XOR of feedback bits
-        {
-            si = si ^ (exorbits & 1);
-            exorbits = exorbits >> 1;
-        }
-
-        shiftreg &= ~carrybit;   // Clear carry bit
-        if (si == 1) shiftreg |= carrybit;  // Set carry bit
-        shiftreg = shiftreg >> 1;  // Shift right 1 bit (unsigned)
-    }
-
-    return  (uint16) shiftreg;
-}
-
-
 /*=============================  LICENSE AGREEMENT  ===================================*\
  *
  *  THIS SOURCE CODE MAY BE USED FREELY FOR PERSONAL NON-COMMERCIAL APPLICATIONS.